@@ -0,0 +1,186 @@
+#include <random>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <GL/gl3w.h>
+#include <glk/mesh.hpp>
+#include <glk/mesh_utils.hpp>
+#include <glk/mesh_optimization.hpp>
+#include <glk/io/ply_io.hpp>
+#include <glk/pointcloud_buffer.hpp>
+#include <glk/primitives/icosahedron.hpp>
+#include <guik/viewer/light_viewer.hpp>
+
+#include "benchmark.hpp"
+
+namespace {
+
+// read back the index buffer of a mesh
+std::vector<int> read_indices(const glk::Mesh& mesh) {
+  std::vector<int> indices(mesh.get_num_indices());
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo_id());
+  if (mesh.get_index_type() == GL_UNSIGNED_SHORT) {
+    std::vector<std::uint16_t> short_indices(indices.size());
+    glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(std::uint16_t) * short_indices.size(), short_indices.data());
+    std::copy(short_indices.begin(), short_indices.end(), indices.begin());
+  } else {
+    glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(int) * indices.size(), indices.data());
+  }
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  return indices;
+}
+
+}  // namespace
+
+// Benchmarks of data loading and uploading
+//  - load_ply (binary / ascii)
+//  - PointCloudBuffer construction and upload
+//  - Mesh construction with and without optimization (ACMR of the uploaded index order)
+int main(int argc, char** argv) {
+  namespace po = boost::program_options;
+  po::options_description desc("bench_io");
+  // clang-format off
+  desc.add_options()
+    ("help", "produce help message")
+    ("output,o", po::value<std::string>()->default_value(""), "output JSON file (stdout if empty)")
+    ("num_points,n", po::value<std::vector<int>>()->multitoken()->default_value({1000000, 10000000, 100000000}, "1000000 10000000 100000000"), "numbers of points")
+    ("max_ascii_points", po::value<int>()->default_value(10000000), "skip ascii PLY benchmarks with more points than this")
+    ("mesh_levels", po::value<std::vector<int>>()->multitoken()->default_value({4, 6, 8}, "4 6 8"), "subdivision levels of icospheres for the mesh benchmarks")
+    ("warmup", po::value<int>()->default_value(1), "number of warmup iterations")
+    ("iterations", po::value<int>()->default_value(5), "number of measured iterations")
+    ("tmp_dir", po::value<std::string>()->default_value(boost::filesystem::temp_directory_path().string()), "directory to write temporary PLY files")
+  ;
+  // clang-format on
+
+  po::variables_map vm;
+  po::store(po::parse_command_line(argc, argv, desc), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return 0;
+  }
+
+  const int warmup = vm["warmup"].as<int>();
+  const int iterations = vm["iterations"].as<int>();
+
+  // a hidden window is created to obtain a GL context (works on Mesa llvmpipe with LIBGL_ALWAYS_SOFTWARE=1)
+  auto viewer = guik::LightViewer::instance(Eigen::Vector2i(640, 480), true);
+
+  bench::Results results;
+  results.add_context("benchmark", "bench_io");
+  results.add_context("gl_vendor", reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+  results.add_context("gl_renderer", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+  results.add_context("gl_version", reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+
+  for (const int num_points : vm["num_points"].as<std::vector<int>>()) {
+    std::cerr << "num_points=" << num_points << std::endl;
+
+    // fixed seed for reproducibility
+    std::mt19937 mt(num_points);
+    std::uniform_real_distribution<float> udist(-100.0f, 100.0f);
+    std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f>> points(num_points);
+    for (auto& pt : points) {
+      pt = Eigen::Vector3f(udist(mt), udist(mt), udist(mt));
+    }
+
+    // PointCloudBuffer construction + upload
+    {
+      auto times = bench::measure(warmup, iterations, [&] {
+        auto buffer = std::make_shared<glk::PointCloudBuffer>(points);
+        glFinish();
+      });
+
+      auto& entry = results.add("point_cloud_buffer_upload", times);
+      entry.params.emplace_back("num_points", std::to_string(num_points));
+      entry.metrics.emplace_back("mpoints_per_sec", num_points / entry.stats.median / 1e3);
+      entry.metrics.emplace_back("mbytes_per_sec", num_points * sizeof(Eigen::Vector3f) / entry.stats.median / 1e3);
+    }
+
+    // load_ply
+    glk::PLYData ply;
+    ply.vertices = points;
+    points.clear();
+    points.shrink_to_fit();
+
+    for (const std::string format : {"binary", "ascii"}) {
+      if (format == "ascii" && num_points > vm["max_ascii_points"].as<int>()) {
+        continue;
+      }
+
+      const std::string filename = (boost::filesystem::path(vm["tmp_dir"].as<std::string>()) / ("iridescence_bench_" + std::to_string(num_points) + ".ply")).string();
+      const bool saved = format == "binary" ? glk::save_ply_binary(filename, ply) : glk::save_ply_ascii(filename, ply);
+      if (!saved) {
+        std::cerr << "error: failed to write " << filename << std::endl;
+        continue;
+      }
+
+      const double file_size = boost::filesystem::file_size(filename);
+      auto times = bench::measure(warmup, iterations, [&] {
+        auto loaded = glk::load_ply(filename);
+        if (!loaded || loaded->vertices.size() != num_points) {
+          std::cerr << "error: failed to load " << filename << std::endl;
+        }
+      });
+      boost::filesystem::remove(filename);
+
+      auto& entry = results.add("load_ply", times);
+      entry.params.emplace_back("num_points", std::to_string(num_points));
+      entry.params.emplace_back("format", format);
+      entry.metrics.emplace_back("mpoints_per_sec", num_points / entry.stats.median / 1e3);
+      entry.metrics.emplace_back("mbytes_per_sec", file_size / entry.stats.median / 1e3);
+    }
+  }
+
+  for (const int level : vm["mesh_levels"].as<std::vector<int>>()) {
+    std::cerr << "mesh_level=" << level << std::endl;
+
+    glk::Icosahedron icosahedron;
+    for (int i = 0; i < level; i++) {
+      icosahedron.subdivide();
+    }
+    icosahedron.spherize();
+
+    // flatized meshes have a vertex per face corner
+    const glk::Flatize flat(icosahedron.vertices, icosahedron.indices);
+
+    for (const std::string mesh_type : {"smooth", "flat"}) {
+      const auto& vertices = mesh_type == "smooth" ? icosahedron.vertices : flat.vertices;
+      const auto& normals = mesh_type == "smooth" ? icosahedron.normals : flat.normals;
+      const auto& indices = mesh_type == "smooth" ? icosahedron.indices : flat.indices;
+      const int num_triangles = indices.size() / 3;
+
+      for (const bool optimize : {false, true}) {
+        std::shared_ptr<glk::Mesh> mesh;
+        auto times = bench::measure(warmup, iterations, [&] {
+          mesh = std::make_shared<glk::Mesh>(vertices, normals, indices, false, optimize);
+          glFinish();
+        });
+
+        auto& entry = results.add("mesh_upload", times);
+        entry.params.emplace_back("mesh", mesh_type);
+        entry.params.emplace_back("num_triangles", std::to_string(num_triangles));
+        entry.params.emplace_back("optimize", optimize ? "true" : "false");
+        entry.metrics.emplace_back("mtriangles_per_sec", num_triangles / entry.stats.median / 1e3);
+        entry.metrics.emplace_back("num_vertices", mesh->get_num_vertices());
+        entry.metrics.emplace_back("index_bytes", mesh->get_num_indices() * (mesh->get_index_type() == GL_UNSIGNED_SHORT ? 2 : 4));
+        entry.metrics.emplace_back("acmr_before", glk::compute_acmr(indices));
+        entry.metrics.emplace_back("acmr_after", glk::compute_acmr(read_indices(*mesh)));
+      }
+    }
+  }
+
+  const std::string output = vm["output"].as<std::string>();
+  if (output.empty()) {
+    results.write(std::cout);
+  } else {
+    std::ofstream ofs(output);
+    results.write(ofs);
+  }
+
+  guik::LightViewer::destroy();
+  return 0;
+}
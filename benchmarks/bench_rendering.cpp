@@ -0,0 +1,229 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <fstream>
+#include <iostream>
+#include <boost/format.hpp>
+#include <boost/program_options.hpp>
+
+#include <GL/gl3w.h>
+#include <glk/pointcloud_buffer.hpp>
+#include <glk/primitives/primitives.hpp>
+#include <glk/effects/plain_rendering.hpp>
+#include <glk/effects/screen_space_lighting.hpp>
+#include <glk/effects/screen_space_splatting.hpp>
+#include <glk/effects/screen_space_ambient_occlusion.hpp>
+#include <guik/viewer/light_viewer.hpp>
+
+#include "benchmark.hpp"
+
+namespace {
+
+// points on a wavy surface so that screen space effects have some structure to work on
+std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f>> generate_surface(int num_points, int seed, float extent) {
+  std::mt19937 mt(seed);
+  std::uniform_real_distribution<float> udist(-extent, extent);
+
+  std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f>> points(num_points);
+  for (auto& pt : points) {
+    const float x = udist(mt);
+    const float y = udist(mt);
+    pt = Eigen::Vector3f(x, y, std::sin(x * 0.5f) * std::cos(y * 0.5f));
+  }
+  return points;
+}
+
+bool parse_resolution(const std::string& str, Eigen::Vector2i& resolution) {
+  return std::sscanf(str.c_str(), "%dx%d", &resolution[0], &resolution[1]) == 2 && (resolution.array() > 0).all();
+}
+
+std::string to_string(const Eigen::Vector2i& resolution) {
+  return (boost::format("%dx%d") % resolution[0] % resolution[1]).str();
+}
+
+}  // namespace
+
+// Benchmarks of the viewer rendering pipeline
+//  - draw_gl frame time with N drawables
+//  - screen effects (SSAO, SSLI, ScreenSpaceSplatting) at several resolutions
+//  - picking latency (pick_info / pick_depth)
+int main(int argc, char** argv) {
+  namespace po = boost::program_options;
+  po::options_description desc("bench_rendering");
+  // clang-format off
+  desc.add_options()
+    ("help", "produce help message")
+    ("output,o", po::value<std::string>()->default_value(""), "output JSON file (stdout if empty)")
+    ("num_drawables", po::value<std::vector<int>>()->multitoken()->default_value({1, 10, 100, 1000}, "1 10 100 1000"), "numbers of drawables")
+    ("points_per_drawable", po::value<int>()->default_value(10000), "number of points of each drawable")
+    ("scene_points", po::value<int>()->default_value(1000000), "number of points of the screen effect benchmark scene")
+    ("resolutions", po::value<std::vector<std::string>>()->multitoken()->default_value({"640x480", "1280x720", "1920x1080"}, "640x480 1280x720 1920x1080"), "canvas resolutions")
+    ("warmup", po::value<int>()->default_value(10), "number of warmup frames")
+    ("frames", po::value<int>()->default_value(100), "number of measured frames")
+    ("picks", po::value<int>()->default_value(1000), "number of picking queries")
+  ;
+  // clang-format on
+
+  po::variables_map vm;
+  po::store(po::parse_command_line(argc, argv, desc), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return 0;
+  }
+
+  std::vector<Eigen::Vector2i> resolutions;
+  for (const auto& str : vm["resolutions"].as<std::vector<std::string>>()) {
+    Eigen::Vector2i resolution;
+    if (!parse_resolution(str, resolution)) {
+      std::cerr << "error: invalid resolution " << str << " (expected WxH)" << std::endl;
+      return 1;
+    }
+    resolutions.push_back(resolution);
+  }
+
+  const int warmup = vm["warmup"].as<int>();
+  const int frames = vm["frames"].as<int>();
+
+  // a hidden window is created to obtain a GL context (works on Mesa llvmpipe with LIBGL_ALWAYS_SOFTWARE=1)
+  auto viewer = guik::LightViewer::instance(resolutions.front(), true);
+  viewer->disable_vsync();
+
+  bench::Results results;
+  results.add_context("benchmark", "bench_rendering");
+  results.add_context("gl_vendor", reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+  results.add_context("gl_renderer", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+  results.add_context("gl_version", reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+
+  // hidden windows may not receive framebuffer size callbacks, so the canvas is resized explicitly
+  const auto set_resolution = [&](const Eigen::Vector2i& resolution) {
+    viewer->resize(resolution);
+    viewer->set_size(resolution);
+  };
+
+  // glFinish() is called so that the measured time includes the GPU work of the frame
+  const auto measure_frames = [&] {
+    return bench::measure(warmup, frames, [&] {
+      viewer->spin_once();
+      glFinish();
+    });
+  };
+
+  // draw_gl with N drawables
+  set_resolution(resolutions.front());
+  const int points_per_drawable = vm["points_per_drawable"].as<int>();
+  for (const int num_drawables : vm["num_drawables"].as<std::vector<int>>()) {
+    std::cerr << "num_drawables=" << num_drawables << std::endl;
+    viewer->clear_drawables();
+
+    const int grid = std::ceil(std::sqrt(num_drawables));
+    for (int i = 0; i < num_drawables; i++) {
+      const Eigen::Vector3f offset(10.0f * (i % grid - grid / 2), 10.0f * (i / grid - grid / 2), 0.0f);
+      auto points = generate_surface(points_per_drawable, i, 5.0f);
+      for (auto& pt : points) {
+        pt += offset;
+      }
+
+      viewer->update_drawable("drawable_" + std::to_string(i), std::make_shared<glk::PointCloudBuffer>(points), guik::Rainbow());
+    }
+
+    auto& entry = results.add("draw_gl", measure_frames());
+    entry.params.emplace_back("num_drawables", std::to_string(num_drawables));
+    entry.params.emplace_back("points_per_drawable", std::to_string(points_per_drawable));
+    entry.params.emplace_back("resolution", to_string(resolutions.front()));
+    entry.metrics.emplace_back("fps", 1e3 / entry.stats.median);
+  }
+
+  // screen effects
+  viewer->clear_drawables();
+  viewer->update_drawable("scene", std::make_shared<glk::PointCloudBuffer>(generate_surface(vm["scene_points"].as<int>(), 0, 50.0f)), guik::Rainbow());
+  viewer->update_drawable("bunny", glk::Primitives::bunny(), guik::Rainbow(Eigen::AngleAxisf(M_PI_2, Eigen::Vector3f::UnitX()) * Eigen::UniformScaling<float>(15.0f)));
+
+  const std::vector<std::pair<std::string, std::function<std::shared_ptr<glk::ScreenEffect>(const Eigen::Vector2i&)>>> effects = {
+    {"PLAIN", [](const Eigen::Vector2i& size) { return std::make_shared<glk::PlainRendering>(); }},
+    {"SSAO", [](const Eigen::Vector2i& size) { return std::make_shared<glk::ScreenSpaceAmbientOcclusion>(size); }},
+    {"SSAO_HALF_TEMPORAL",
+     [](const Eigen::Vector2i& size) {
+       auto ssao = std::make_shared<glk::ScreenSpaceAmbientOcclusion>(size);
+       ssao->set_occlusion_downsample(2);
+       ssao->set_temporal_occlusion(true);
+       return ssao;
+     }},
+    {"SSAO_QUARTER_TEMPORAL",
+     [](const Eigen::Vector2i& size) {
+       auto ssao = std::make_shared<glk::ScreenSpaceAmbientOcclusion>(size);
+       ssao->set_occlusion_downsample(4);
+       ssao->set_temporal_occlusion(true);
+       return ssao;
+     }},
+    {"SSLI", [](const Eigen::Vector2i& size) { return std::make_shared<glk::ScreenSpaceLighting>(size); }},
+    {"SSLI_SPLAT", [](const Eigen::Vector2i& size) { return std::make_shared<glk::ScreenSpaceLighting>(size, true); }},
+    {"SSLI_1024_LIGHTS",
+     [](const Eigen::Vector2i& size) {
+       // point lights with finite ranges scattered over the scene (culled into screen tiles)
+       auto ssli = std::make_shared<glk::ScreenSpaceLighting>(size);
+       std::mt19937 mt(0);
+       std::uniform_real_distribution<float> udist(-25.0f, 25.0f);
+       for (int i = 0; i < 1024; i++) {
+         ssli->set_light(ssli->num_lights(), Eigen::Vector3f(udist(mt), udist(mt), 2.0f), Eigen::Vector4f::Constant(0.2f), Eigen::Vector2f(0.0f, 0.1f), 5.0f);
+       }
+       return ssli;
+     }},
+    {"SPLATTING", [](const Eigen::Vector2i& size) { return std::make_shared<glk::ScreenSpaceSplatting>(size); }},
+    {"SPLATTING_COMPUTE",
+     [](const Eigen::Vector2i& size) {
+       auto splatting = std::make_shared<glk::ScreenSpaceSplatting>(size);
+       splatting->set_knn_mode(glk::ScreenSpaceSplatting::KNN_MODE::COMPUTE);
+       return splatting;
+     }},
+  };
+
+  for (const auto& resolution : resolutions) {
+    set_resolution(resolution);
+
+    for (const auto& effect : effects) {
+      std::cerr << "effect=" << effect.first << " resolution=" << to_string(resolution) << std::endl;
+      viewer->set_screen_effect(effect.second(resolution));
+
+      auto& entry = results.add("screen_effect", measure_frames());
+      entry.params.emplace_back("effect", effect.first);
+      entry.params.emplace_back("resolution", to_string(resolution));
+      entry.metrics.emplace_back("fps", 1e3 / entry.stats.median);
+    }
+  }
+  viewer->set_screen_effect(std::make_shared<glk::PlainRendering>());
+
+  // picking latency
+  viewer->enable_info_buffer();
+  for (const auto& resolution : resolutions) {
+    set_resolution(resolution);
+    for (int i = 0; i < warmup; i++) {
+      viewer->spin_once();
+    }
+    glFinish();
+
+    std::mt19937 mt(0);
+    std::uniform_int_distribution<> xdist(0, resolution[0] - 1);
+    std::uniform_int_distribution<> ydist(0, resolution[1] - 1);
+
+    auto info_times = bench::measure(0, vm["picks"].as<int>(), [&] { viewer->pick_info(Eigen::Vector2i(xdist(mt), ydist(mt))); });
+    auto& info_entry = results.add("pick_info", info_times);
+    info_entry.params.emplace_back("resolution", to_string(resolution));
+
+    auto depth_times = bench::measure(0, vm["picks"].as<int>(), [&] { viewer->pick_depth(Eigen::Vector2i(xdist(mt), ydist(mt))); });
+    auto& depth_entry = results.add("pick_depth", depth_times);
+    depth_entry.params.emplace_back("resolution", to_string(resolution));
+  }
+
+  const std::string output = vm["output"].as<std::string>();
+  if (output.empty()) {
+    results.write(std::cout);
+  } else {
+    std::ofstream ofs(output);
+    results.write(ofs);
+  }
+
+  guik::LightViewer::destroy();
+  return 0;
+}
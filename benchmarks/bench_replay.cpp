@@ -0,0 +1,103 @@
+#include <fstream>
+#include <iostream>
+#include <boost/program_options.hpp>
+
+#include <GL/gl3w.h>
+#include <guik/viewer/light_viewer.hpp>
+#include <guik/viewer/command_trace.hpp>
+
+#include "benchmark.hpp"
+
+// Replays a command trace recorded by LightViewerContext::start_recording() at max speed and measures frame times
+int main(int argc, char** argv) {
+  namespace po = boost::program_options;
+  po::options_description desc("bench_replay");
+  // clang-format off
+  desc.add_options()
+    ("help", "produce help message")
+    ("trace", po::value<std::string>(), "input command trace file")
+    ("output,o", po::value<std::string>()->default_value(""), "output JSON file (stdout if empty)")
+    ("begin", po::value<long>()->default_value(0), "first frame to be measured (preceding frames are applied without rendering)")
+    ("end", po::value<long>()->default_value(-1), "last frame to be measured (-1 for the end of the trace)")
+    ("width", po::value<int>()->default_value(-1), "canvas width (the recorded size if negative)")
+    ("height", po::value<int>()->default_value(-1), "canvas height (the recorded size if negative)")
+    ("per_frame", "emit the frame time of each frame")
+  ;
+  // clang-format on
+
+  po::positional_options_description p;
+  p.add("trace", 1);
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).positional(p).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help") || !vm.count("trace")) {
+    std::cout << "usage: bench_replay trace_file [options]" << std::endl;
+    std::cout << desc << std::endl;
+    return 0;
+  }
+
+  const std::string trace_file = vm["trace"].as<std::string>();
+  const long begin = vm["begin"].as<long>();
+  const long end = vm["end"].as<long>();
+
+  auto viewer = guik::LightViewer::instance(Eigen::Vector2i(1920, 1080), true);
+  viewer->disable_vsync();
+
+  guik::CommandReplayer replayer(trace_file);
+  // apply commands up to the frame boundary of "begin"
+  if (!replayer.ok() || !replayer.seek(viewer.get(), begin + 1)) {
+    std::cerr << "error: failed to seek to frame " << begin << " of " << trace_file << std::endl;
+    return 1;
+  }
+
+  Eigen::Vector2i size = replayer.recorded_canvas_size();
+  if (vm["width"].as<int>() > 0 && vm["height"].as<int>() > 0) {
+    size = Eigen::Vector2i(vm["width"].as<int>(), vm["height"].as<int>());
+  }
+  if ((size.array() > 0).all()) {
+    viewer->resize(size);
+    viewer->set_size(size);
+  }
+
+  std::vector<long> frame_ids;
+  std::vector<double> times;
+  do {
+    auto t = bench::measure(0, 1, [&] {
+      viewer->spin_once();
+      glFinish();
+    });
+    frame_ids.push_back(replayer.num_frames() - 1);
+    times.push_back(t.front());
+  } while ((end < 0 || replayer.num_frames() <= end) && replayer.next_frame(viewer.get()));
+
+  bench::Results results;
+  results.add_context("benchmark", "bench_replay");
+  results.add_context("trace", trace_file);
+  results.add_context("gl_renderer", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+  results.add_context("unsupported_drawables", std::to_string(replayer.num_unsupported_drawables()));
+
+  auto& entry = results.add("replay", times);
+  entry.params.emplace_back("begin", std::to_string(frame_ids.front()));
+  entry.params.emplace_back("end", std::to_string(frame_ids.back()));
+  entry.params.emplace_back("resolution", std::to_string(size[0]) + "x" + std::to_string(size[1]));
+  entry.metrics.emplace_back("fps", 1e3 / entry.stats.median);
+
+  if (vm.count("per_frame")) {
+    for (int i = 0; i < times.size(); i++) {
+      results.add("replay_frame", {times[i]}).params.emplace_back("frame", std::to_string(frame_ids[i]));
+    }
+  }
+
+  const std::string output = vm["output"].as<std::string>();
+  if (output.empty()) {
+    results.write(std::cout);
+  } else {
+    std::ofstream ofs(output);
+    results.write(ofs);
+  }
+
+  guik::LightViewer::destroy();
+  return 0;
+}
@@ -0,0 +1,126 @@
+#ifndef IRIDESCENCE_BENCHMARK_HPP
+#define IRIDESCENCE_BENCHMARK_HPP
+
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <numeric>
+#include <ostream>
+#include <algorithm>
+#include <functional>
+#include <boost/format.hpp>
+#include <glk/io/json.hpp>
+
+namespace bench {
+
+/**
+ * @brief Summary statistics of measured times [msec]
+ */
+struct Stats {
+  Stats(const std::vector<double>& times) : num_samples(times.size()) {
+    if (times.empty()) {
+      mean = median = min = max = stddev = 0.0;
+      return;
+    }
+
+    std::vector<double> sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+
+    mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+    median = sorted[sorted.size() / 2];
+    min = sorted.front();
+    max = sorted.back();
+
+    double sq_sum = 0.0;
+    for (const double t : sorted) {
+      sq_sum += (t - mean) * (t - mean);
+    }
+    stddev = std::sqrt(sq_sum / sorted.size());
+  }
+
+  int num_samples;
+  double mean;
+  double median;
+  double min;
+  double max;
+  double stddev;
+};
+
+/**
+ * @brief Run a function (warmup + iterations) times and return the elapsed times [msec] of the measured iterations
+ */
+inline std::vector<double> measure(int warmup, int iterations, const std::function<void()>& func) {
+  for (int i = 0; i < warmup; i++) {
+    func();
+  }
+
+  std::vector<double> times(iterations);
+  for (int i = 0; i < iterations; i++) {
+    const auto t1 = std::chrono::high_resolution_clock::now();
+    func();
+    const auto t2 = std::chrono::high_resolution_clock::now();
+    times[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count() / 1e6;
+  }
+
+  return times;
+}
+
+/**
+ * @brief Benchmark results that are written as a JSON document
+ *        {"context": {...}, "benchmarks": [{"name": ..., "params": {...}, "time_msec": {...}, "metrics": {...}}]}
+ */
+class Results {
+public:
+  struct Entry {
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> params;
+    Stats stats;
+    std::vector<std::pair<std::string, double>> metrics;
+  };
+
+  void add_context(const std::string& key, const std::string& value) { context.emplace_back(key, value); }
+
+  Entry& add(const std::string& name, const std::vector<double>& times) {
+    entries.push_back(Entry{name, {}, Stats(times), {}});
+    return entries.back();
+  }
+
+  void write(std::ostream& ost) const {
+    ost << "{\n  \"context\": {";
+    for (int i = 0; i < context.size(); i++) {
+      ost << (i ? ", " : "") << "\"" << escape(context[i].first) << "\": \"" << escape(context[i].second) << "\"";
+    }
+    ost << "},\n  \"benchmarks\": [";
+
+    for (int i = 0; i < entries.size(); i++) {
+      const auto& entry = entries[i];
+      ost << (i ? "," : "") << "\n    {\"name\": \"" << escape(entry.name) << "\", \"params\": {";
+      for (int j = 0; j < entry.params.size(); j++) {
+        ost << (j ? ", " : "") << "\"" << escape(entry.params[j].first) << "\": \"" << escape(entry.params[j].second) << "\"";
+      }
+
+      const auto& s = entry.stats;
+      ost << "}, \"time_msec\": {\"samples\": " << s.num_samples;
+      ost << boost::format(", \"mean\": %.6f, \"median\": %.6f, \"min\": %.6f, \"max\": %.6f, \"stddev\": %.6f}") % s.mean % s.median % s.min % s.max % s.stddev;
+
+      ost << ", \"metrics\": {";
+      for (int j = 0; j < entry.metrics.size(); j++) {
+        ost << (j ? ", " : "") << "\"" << escape(entry.metrics[j].first) << "\": " << boost::format("%.6f") % entry.metrics[j].second;
+      }
+      ost << "}}";
+    }
+    ost << "\n  ]\n}" << std::endl;
+  }
+
+private:
+  static std::string escape(const std::string& str) { return glk::escape_json(str); }
+
+private:
+  std::vector<std::pair<std::string, std::string>> context;
+  std::vector<Entry> entries;
+};
+
+}  // namespace bench
+
+#endif
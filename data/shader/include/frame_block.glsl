@@ -0,0 +1,12 @@
+// per-frame uniforms shared by all programs (see glk::FrameUniformBlock)
+layout(std140) uniform FrameBlock {
+  mat4 view_matrix;
+  mat4 inv_view_matrix;
+  mat4 projection_matrix;
+  mat4 inv_projection_matrix;
+  mat4 projection_view_matrix;
+  mat4 inv_projection_view_matrix;
+  vec4 viewport;         // xy: frame buffer size, zw: 1 / frame buffer size
+  vec4 view_point_time;  // xyz: view point, w: time [sec]
+  vec4 render_params;    // x: render scale (frame buffer resolution / window resolution), y: partial rendering budget scale, zw: reserved
+};
@@ -1,8 +1,6 @@
 #version 330
 uniform mat4 model_matrix;
-uniform mat4 view_matrix;
-uniform mat4 inv_view_matrix;
-uniform mat4 projection_matrix;
+#include "include/frame_block.glsl"
 
 uniform vec3 light_pos;
 uniform vec4 light_color;
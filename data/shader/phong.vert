@@ -1,9 +1,7 @@
 #version 330
 uniform mat4 model_matrix;
 
-uniform mat4 view_matrix;
-uniform mat4 inv_view_matrix;
-uniform mat4 projection_matrix;
+#include "include/frame_block.glsl"
 
 in vec3 vert_position;
 in vec3 vert_normal;
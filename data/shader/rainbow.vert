@@ -1,12 +1,17 @@
-#version 330
+#version 430
 uniform bool normal_enabled;
 
 uniform float point_size;
 uniform float point_scale;
 uniform float point_size_offset;
 uniform mat4 model_matrix;
-uniform mat4 view_matrix;
-uniform mat4 projection_matrix;
+
+// glk::PointCloudBatch : per-cloud model matrices selected by the base instance of each indirect draw command
+uniform bool batch_enabled;
+layout(std430, binding = 0) readonly buffer BatchModelMatrices {
+  mat4 batch_model_matrices[];
+};
+#include "include/frame_block.glsl"
 
 // colormode = 0 : rainbow (height encoding)
 // colormode = 1 : material_color
@@ -24,6 +29,7 @@ in vec3 vert_position;
 in vec4 vert_color;
 in vec2 vert_texcoord;
 in vec3 vert_normal;
+in uint vert_batch_index;
 
 out vec4 frag_color;
 out vec2 frag_texcoord;
@@ -35,7 +41,8 @@ vec4 rainbow(vec3 position) {
 }
 
 void main() {
-    vec4 world_position = model_matrix * vec4(vert_position, 1.0);
+    mat4 model = batch_enabled ? model_matrix * batch_model_matrices[vert_batch_index] : model_matrix;
+    vec4 world_position = model * vec4(vert_position, 1.0);
     vec3 frag_world_position = world_position.xyz;
     gl_Position = projection_matrix * view_matrix * world_position;
 
@@ -59,7 +66,7 @@ void main() {
     }
 
     if(normal_enabled) {
-        mat3 normal_matrix = transpose(inverse(mat3(model_matrix)));
+        mat3 normal_matrix = transpose(inverse(mat3(model)));
         frag_normal = normal_matrix * vert_normal;
     } else {
         frag_normal = vec3(0.0, 0.0, 0.0);
@@ -67,5 +74,5 @@ void main() {
 
     vec3 ndc = gl_Position.xyz / gl_Position.w;
     float z_dist = 1.0 - ndc.z;
-    gl_PointSize = point_scale * point_size * z_dist + point_size_offset;
+    gl_PointSize = (point_scale * point_size * z_dist + point_size_offset) * (render_params.x > 0.0 ? render_params.x : 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#version 330
+uniform sampler2D color_sampler;
+uniform sampler2D depth_sampler;
+
+uniform mat4 inv_projection_matrix;
+uniform float depth_sigma;
+
+in vec2 texcoord;
+
+layout(location = 0) out vec4 frag_color;
+
+float linear_depth(ivec2 pix) {
+  float z = texelFetch(depth_sampler, pix, 0).x * 2.0 - 1.0;
+  vec4 v = inv_projection_matrix * vec4(0.0, 0.0, z, 1.0);
+  return abs(v.z / v.w);
+}
+
+// resamples the canvas frame buffer to the screen resolution
+// upscaling : depth-aware bilinear filter (taps across depth discontinuities from the nearest texel are rejected)
+// downscaling : box filter over the footprint of the output pixel (supersampling)
+void main() {
+  ivec2 src_size = textureSize(color_sampler, 0);
+  vec2 footprint = fwidth(texcoord) * vec2(src_size);
+
+  if(footprint.x > 1.0 + 1e-3 || footprint.y > 1.0 + 1e-3) {
+    vec2 lower = texcoord * vec2(src_size) - 0.5 * footprint;
+    vec2 upper = texcoord * vec2(src_size) + 0.5 * footprint;
+
+    vec4 sum = vec4(0.0);
+    float sum_w = 0.0;
+    for(int y = int(floor(lower.y)); y < int(ceil(upper.y)); y++) {
+      for(int x = int(floor(lower.x)); x < int(ceil(upper.x)); x++) {
+        vec2 overlap = max(min(upper, vec2(x + 1, y + 1)) - max(lower, vec2(x, y)), vec2(0.0));
+        float w = overlap.x * overlap.y;
+        sum += w * texelFetch(color_sampler, clamp(ivec2(x, y), ivec2(0), src_size - 1), 0);
+        sum_w += w;
+      }
+    }
+
+    frag_color = sum / max(sum_w, 1e-6);
+    return;
+  }
+
+  vec2 p = texcoord * vec2(src_size) - 0.5;
+  vec2 base = floor(p);
+  vec2 f = p - base;
+
+  ivec2 nearest = clamp(ivec2(round(p)), ivec2(0), src_size - 1);
+  float ref_depth = linear_depth(nearest);
+
+  vec4 sum = vec4(0.0);
+  float sum_w = 0.0;
+  for(int y = 0; y <= 1; y++) {
+    for(int x = 0; x <= 1; x++) {
+      ivec2 pix = clamp(ivec2(base) + ivec2(x, y), ivec2(0), src_size - 1);
+
+      float d = (linear_depth(pix) - ref_depth) / (depth_sigma * max(ref_depth, 1e-3));
+      float wb = (x == 0 ? 1.0 - f.x : f.x) * (y == 0 ? 1.0 - f.y : f.y);
+      float w = wb * exp(-d * d) + (pix == nearest ? 1e-6 : 0.0);
+
+      sum += w * texelFetch(color_sampler, pix, 0);
+      sum_w += w;
+    }
+  }
+
+  frag_color = sum / sum_w;
+}
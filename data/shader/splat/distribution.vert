@@ -7,8 +7,7 @@ uniform sampler2D finalized_radius_sampler;
 uniform vec2 screen_size;
 uniform vec2 inv_screen_size;
 
-uniform mat4 view_matrix;
-uniform mat4 projection_matrix;
+#include "../include/frame_block.glsl"
 
 in vec3 vert_position;
 
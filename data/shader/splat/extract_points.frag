@@ -1,7 +1,7 @@
 #version 330
 uniform sampler2D depth_sampler;
 
-uniform mat4 inv_projection_view_matrix;
+#include "../include/frame_block.glsl"
 
 in vec3 vert_out;
 
@@ -7,13 +7,27 @@ uniform sampler2D color_sampler;
 
 in vec2 texcoord;
 
-out vec3 position;
-out vec3 normal;
+// octahedral normal encoding (stored in a two-channel 16bit unorm texture)
+vec2 encode_normal(vec3 n) {
+  n /= (abs(n.x) + abs(n.y) + abs(n.z));
+  vec2 e = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+  return e * 0.5 + 0.5;
+}
+
+out vec4 position;  // w = 1 for pixels not covered by any splat (same as the background of ScreenSpaceAttributeEstimation::position())
+out vec2 normal;
 out vec3 color;
 
 void main() {
   float w = texture(weight_sampler, texcoord).x;
-  position = texture(position_sampler, texcoord).xyz / w;
-  normal = normalize(texture(normal_sampler, texcoord).xyz / w);
+  if(w <= 0.0) {
+    position = vec4(0.0, 0.0, 0.0, 1.0);
+    normal = vec2(0.5);
+    color = vec3(0.0);
+    return;
+  }
+
+  position = vec4(texture(position_sampler, texcoord).xyz / w, 0.0);
+  normal = encode_normal(normalize(texture(normal_sampler, texcoord).xyz / w));
   color = texture(color_sampler, texcoord).xyz / w;
 }
\ No newline at end of file
@@ -8,7 +8,7 @@ uniform sampler2D sum_cross2_sampler;
 
 uniform int k_neighbors;
 uniform int k_tolerance;
-uniform vec3 view_point;
+#include "../include/frame_block.glsl"
 
 in vec3 uvd;
 in vec2 screen_pos;
@@ -56,7 +56,7 @@ void main() {
   lengths = r_splat * eval / eval.z;
   normal = evec[0];
 
-  if(dot(view_point - mean, normal) < 0.0) {
+  if(dot(view_point_time.xyz - mean, normal) < 0.0) {
     normal = -normal;
   }
 
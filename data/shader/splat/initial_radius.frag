@@ -12,7 +12,7 @@ uniform int grid_area;
 uniform int k_neighbors;
 
 uniform vec2 inv_screen_size;
-uniform mat4 inv_projection_matrix;
+#include "../include/frame_block.glsl"
 
 in vec3 uvd;
 in vec2 screen_pos;
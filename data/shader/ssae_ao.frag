@@ -4,12 +4,14 @@ uniform sampler2D position_sampler;
 uniform sampler2D normal_sampler;
 uniform sampler2D randomization_sampler;
 
-const int num_samples = 16;
+const int max_samples = 16;
 
+uniform int num_samples;
 uniform float ao_radius;
-uniform vec3 random_vectors[num_samples];
-uniform mat4 projection_view_matrix;
+uniform vec3 random_vectors[max_samples];
+#include "include/frame_block.glsl"
 uniform vec2 randomization_coord_scale;
+uniform vec2 randomization_offset;
 
 in vec2 texcoord;
 
@@ -25,17 +27,31 @@ vec3 project(vec3 xyz) {
   return uvd.xyz / uvd.w;
 }
 
+// octahedral normal decoding
+vec3 decode_normal(vec2 e) {
+  e = e * 2.0 - 1.0;
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
+
 void main() {
-  float depth = texture(depth_sampler, texcoord).x * 2.0 - 1.0;
+  // snap to the center of a full resolution pixel (occlusion may be rendered at a lower resolution)
+  vec2 frame_size = textureSize(position_sampler, 0);
+  vec2 coord = (floor(texcoord * frame_size) + 0.5) / frame_size;
+
+  float depth = texture(depth_sampler, coord).x * 2.0 - 1.0;
   if(depth > 1.0 - 1e-5) {
     frag_occlusion = 0.0;
     frag_color = vec4(1.0);
     return;
   }
 
-  vec3 xyz = texture(position_sampler, texcoord).xyz;
-  vec3 normal = texture(normal_sampler, texcoord).xyz;
-  vec3 noise = normalize(texture(randomization_sampler, texcoord * randomization_coord_scale).xyz);
+  vec3 xyz = texture(position_sampler, coord).xyz;
+  vec3 normal = decode_normal(texture(normal_sampler, coord).xy);
+  vec3 noise = normalize(texture(randomization_sampler, texcoord * randomization_coord_scale + randomization_offset).xyz);
 
   float occluded = 0.0;
   for(int i = 0; i < num_samples; i++) {
@@ -58,7 +74,7 @@ void main() {
     occluded += w;
   }
 
-  frag_occlusion = occluded / num_samples;
+  frag_occlusion = occluded / float(num_samples);
   frag_color = vec4(1 - frag_occlusion);
   return;
 }
\ No newline at end of file
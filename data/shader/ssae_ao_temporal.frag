@@ -0,0 +1,43 @@
+#version 330
+uniform sampler2D position_sampler;
+uniform sampler2D occlusion_sampler;
+uniform sampler2D history_sampler;
+
+uniform mat4 prev_projection_view_matrix;
+uniform vec3 view_point;
+uniform vec3 prev_view_point;
+
+uniform float blend_weight;
+uniform float depth_tolerance;
+
+in vec2 texcoord;
+
+// x: accumulated occlusion, y: distance to the view point
+layout(location = 0) out vec2 frag_history;
+
+void main() {
+  vec2 frame_size = textureSize(position_sampler, 0);
+  vec4 position = texture(position_sampler, (floor(texcoord * frame_size) + 0.5) / frame_size);
+  if(position.w > 1.0 - 1e-5) {
+    frag_history = vec2(0.0);
+    return;
+  }
+
+  float occlusion = texture(occlusion_sampler, texcoord).x;
+
+  // reproject the point onto the previous frame
+  vec4 prev_uvd = prev_projection_view_matrix * vec4(position.xyz, 1.0);
+  vec2 prev_coord = (prev_uvd.xy / prev_uvd.w) * 0.5 + 0.5;
+
+  if(prev_uvd.w > 0.0 && all(greaterThanEqual(prev_coord, vec2(0.0))) && all(lessThanEqual(prev_coord, vec2(1.0)))) {
+    vec2 history = texture(history_sampler, prev_coord).xy;
+
+    // reject the history if the point was not visible in the previous frame
+    float expected_dist = length(position.xyz - prev_view_point);
+    if(history.y > 0.0 && abs(history.y - expected_dist) < depth_tolerance * expected_dist) {
+      occlusion = mix(history.x, occlusion, blend_weight);
+    }
+  }
+
+  frag_history = vec2(occlusion, length(position.xyz - view_point));
+}
@@ -3,12 +3,19 @@ uniform sampler2D depth_sampler;
 uniform sampler2D position_sampler;
 uniform sampler2D normal_sampler;
 
-uniform vec3 view_point;
+#include "include/frame_block.glsl"
 uniform vec2 inv_frame_size;
 
 in vec2 texcoord;
 
-layout(location = 0) out vec3 frag_normal;
+layout(location = 0) out vec2 frag_normal;
+
+// octahedral normal encoding (stored in a two-channel 16bit unorm texture)
+vec2 encode_normal(vec3 n) {
+  n /= (abs(n.x) + abs(n.y) + abs(n.z));
+  vec2 e = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+  return e * 0.5 + 0.5;
+}
 
 void main() {
   if(texture(depth_sampler, texcoord).x > 1.0 - 1e-5) {
@@ -17,7 +24,7 @@ void main() {
 
   vec3 pix_normal = texture(normal_sampler, texcoord).xyz;
   if(length(pix_normal) > 0.5) {
-    frag_normal = pix_normal;
+    frag_normal = encode_normal(normalize(pix_normal));
     return;
   }
 
@@ -35,7 +42,7 @@ void main() {
 
   mat3 inv_cov = inverse(cov + mat3(1e-6));
 
-  vec3 pt2view = view_point - position.xyz;
+  vec3 pt2view = view_point_time.xyz - position.xyz;
   vec3 normal = normalize(pt2view);
   for(int i = 0; i < 3; i++) {
     normal = normalize(inv_cov * normal);
@@ -45,5 +52,5 @@ void main() {
     normal = -normal;
   }
 
-  frag_normal = normal;
+  frag_normal = encode_normal(normal);
 }
@@ -0,0 +1,45 @@
+#version 330
+uniform sampler2D occlusion_sampler;
+uniform sampler2D position_sampler;
+
+uniform float sigma_d;
+
+in vec2 texcoord;
+
+layout(location = 0) out float frag_occlusion;
+
+// depth-aware bilateral upsampling of low resolution occlusion
+void main() {
+  vec4 center = texture(position_sampler, texcoord);
+  if(center.w > 1.0 - 1e-5) {
+    frag_occlusion = 0.0;
+    return;
+  }
+
+  ivec2 frame_size = textureSize(position_sampler, 0);
+  ivec2 low_size = textureSize(occlusion_sampler, 0);
+
+  vec2 p = texcoord * vec2(low_size) - 0.5;
+  vec2 base = floor(p);
+  vec2 f = p - base;
+
+  float sum = 0.0;
+  float sum_w = 0.0;
+  for(int y = 0; y <= 1; y++) {
+    for(int x = 0; x <= 1; x++) {
+      ivec2 low_pix = clamp(ivec2(base) + ivec2(x, y), ivec2(0), low_size - 1);
+      // full resolution pixel that the low resolution sample was computed at
+      ivec2 pix = min(ivec2((vec2(low_pix) + 0.5) / vec2(low_size) * vec2(frame_size)), frame_size - 1);
+      vec3 pos = texelFetch(position_sampler, pix, 0).xyz;
+
+      float d = length(pos - center.xyz);
+      float wb = (x == 0 ? 1.0 - f.x : f.x) * (y == 0 ? 1.0 - f.y : f.y);
+      float w = wb * exp(-(d * d) / (2.0 * sigma_d)) + 1e-6;
+
+      sum += w * texelFetch(occlusion_sampler, low_pix, 0).x;
+      sum_w += w;
+    }
+  }
+
+  frag_occlusion = sum / sum_w;
+}
@@ -8,10 +8,20 @@ in vec2 texcoord;
 
 layout(location = 0) out vec4 final_color;
 
+// octahedral normal decoding
+vec3 decode_normal(vec2 e) {
+  e = e * 2.0 - 1.0;
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
+
 void main() {
   vec4 frag_color = texture(color_sampler, texcoord);
   vec4 frag_position = texture(position_sampler, texcoord);
-  vec3 frag_normal = normalize(texture(normal_sampler, texcoord).xyz);
+  vec3 frag_normal = decode_normal(texture(normal_sampler, texcoord).xy);
   float frag_occlusion = texture(occlusion_sampler, texcoord).x;
 
   if(frag_position.w > 1.0 - 1e-5) {
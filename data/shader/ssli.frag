@@ -8,17 +8,18 @@ uniform sampler2D normal_sampler;
 uniform sampler2D occlusion_sampler;
 uniform sampler2D iridescence_sampler;
 
-uniform vec3 view_point;
+#include "include/frame_block.glsl"
 
 uniform float albedo;
 uniform float roughness;
 
-uniform int num_lights;
-uniform int light_directional[max_num_lights];
-uniform float light_range[max_num_lights];
-uniform vec2 light_attenuation[max_num_lights];
-uniform vec3 light_pos[max_num_lights];
-uniform vec4 light_color[max_num_lights];
+// lights uploaded only when they are changed (see ScreenSpaceLighting)
+layout(std140) uniform LightBlock {
+  int num_lights;
+  vec4 light_pos_range[max_num_lights];         // xyz: position (direction for directional lights), w: range
+  vec4 light_color[max_num_lights];
+  vec4 light_attenuation_type[max_num_lights];  // xy: attenuation, z: directional (1) or point (0)
+};
 
 uniform vec4 ambient_light_color;
 
@@ -32,14 +33,14 @@ float occlusion(float frag_occlusion);
 vec4 iridescence(vec3 N, vec3 L, vec3 V);
 
 vec4 lighting(int i, vec3 frag_position, vec3 frag_normal, vec3 view_point) {
-  vec3 light_vec = -light_pos[i];
+  vec3 light_vec = -light_pos_range[i].xyz;
   float distance = 0.0;
 
-  if(light_directional[i] == 0) {
-    light_vec = light_pos[i] - frag_position;
+  if(light_attenuation_type[i].z < 0.5) {
+    light_vec = light_pos_range[i].xyz - frag_position;
     distance = length(light_vec);
 
-    if(distance > light_range[i]) {
+    if(distance > light_pos_range[i].w) {
       return vec4(0.0);
     }
   }
@@ -52,14 +53,24 @@ vec4 lighting(int i, vec3 frag_position, vec3 frag_normal, vec3 view_point) {
   float specular = clamp(specular_brdf(albedo, roughness, N, L, V), 0.0, 1.0);
 
   float cosine = clamp(dot(N, L), 0.0, 1.0);
-  float attenuation = 1.0 / (1.0 + light_attenuation[i][0] * distance + light_attenuation[i][1] * distance * distance);
+  float attenuation = 1.0 / (1.0 + light_attenuation_type[i].x * distance + light_attenuation_type[i].y * distance * distance);
   return cosine * attenuation * (diffuse + specular) * light_color[i] * iridescence(N, L, V);
 }
 
+// octahedral normal decoding
+vec3 decode_normal(vec2 e) {
+  e = e * 2.0 - 1.0;
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
+
 void main() {
   vec4 frag_color = texture(color_sampler, texcoord);
   vec4 frag_position = texture(position_sampler, texcoord);
-  vec3 frag_normal = normalize(texture(normal_sampler, texcoord).xyz);
+  vec3 frag_normal = decode_normal(texture(normal_sampler, texcoord).xy);
   float frag_occlusion = texture(occlusion_sampler, texcoord).x;
 
   /*
@@ -71,7 +82,7 @@ void main() {
 
   vec4 color = vec4(0.0);
   for(int i = 0; i < num_lights; i++) {
-    color += lighting(i, frag_position.xyz, frag_normal, view_point);
+    color += lighting(i, frag_position.xyz, frag_normal, view_point_time.xyz);
   }
 
   float openness = 1.0 - occlusion(frag_occlusion);
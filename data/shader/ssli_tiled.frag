@@ -0,0 +1,110 @@
+#version 430
+const float PI = 3.1415926535;
+const int tile_size = 16;
+
+uniform sampler2D color_sampler;
+uniform sampler2D position_sampler;
+uniform sampler2D normal_sampler;
+uniform sampler2D occlusion_sampler;
+uniform sampler2D iridescence_sampler;
+
+#include "include/frame_block.glsl"
+
+uniform float albedo;
+uniform float roughness;
+
+uniform int max_lights_per_tile;
+
+struct Light {
+  vec4 pos_range;         // xyz: position (direction for directional lights), w: range
+  vec4 color;
+  vec4 attenuation_type;  // xy: attenuation, z: directional (1) or point (0)
+};
+
+layout(std430, binding = 0) readonly buffer Lights {
+  Light lights[];
+};
+
+// per-tile light lists generated by ssli_light_culling.comp
+layout(std430, binding = 1) readonly buffer TileLightCounts {
+  uint tile_light_counts[];
+};
+
+layout(std430, binding = 2) readonly buffer TileLightIndices {
+  uint tile_light_indices[];
+};
+
+uniform vec4 ambient_light_color;
+
+in vec2 texcoord;
+
+layout(location = 0) out vec4 final_color;
+
+float diffuse_brdf(float albedo, float roughness, vec3 N, vec3 L, vec3 V);
+float specular_brdf(float albedo, float roughness, vec3 N, vec3 L, vec3 V);
+float occlusion(float frag_occlusion);
+vec4 iridescence(vec3 N, vec3 L, vec3 V);
+
+vec4 lighting(uint i, vec3 frag_position, vec3 frag_normal, vec3 view_point) {
+  vec3 light_vec = -lights[i].pos_range.xyz;
+  float distance = 0.0;
+
+  if(lights[i].attenuation_type.z < 0.5) {
+    light_vec = lights[i].pos_range.xyz - frag_position;
+    distance = length(light_vec);
+
+    if(distance > lights[i].pos_range.w) {
+      return vec4(0.0);
+    }
+  }
+
+  vec3 N = frag_normal;
+  vec3 L = normalize(light_vec);
+  vec3 V = normalize(view_point - frag_position);
+
+  float diffuse = clamp(diffuse_brdf(albedo, roughness, N, L, V), 0.0, 1.0);
+  float specular = clamp(specular_brdf(albedo, roughness, N, L, V), 0.0, 1.0);
+
+  float cosine = clamp(dot(N, L), 0.0, 1.0);
+  vec2 light_attenuation = lights[i].attenuation_type.xy;
+  float attenuation = 1.0 / (1.0 + light_attenuation[0] * distance + light_attenuation[1] * distance * distance);
+  return cosine * attenuation * (diffuse + specular) * lights[i].color * iridescence(N, L, V);
+}
+
+// octahedral normal decoding
+vec3 decode_normal(vec2 e) {
+  e = e * 2.0 - 1.0;
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
+
+void main() {
+  vec4 frag_color = texture(color_sampler, texcoord);
+  vec4 frag_position = texture(position_sampler, texcoord);
+  vec3 frag_normal = decode_normal(texture(normal_sampler, texcoord).xy);
+  float frag_occlusion = texture(occlusion_sampler, texcoord).x;
+
+  /*
+  if(frag_position.w > 1.0 - 1e-5) {
+    final_color = frag_color;
+    return;
+  }
+  */
+
+  ivec2 num_tiles = (textureSize(position_sampler, 0) + tile_size - 1) / tile_size;
+  ivec2 tile_xy = min(ivec2(texcoord * vec2(textureSize(position_sampler, 0))) / tile_size, num_tiles - 1);
+  uint tile = uint(tile_xy.y * num_tiles.x + tile_xy.x);
+
+  vec4 color = vec4(0.0);
+  uint num_tile_lights = tile_light_counts[tile];
+  for(uint i = 0; i < num_tile_lights; i++) {
+    uint light_index = tile_light_indices[tile * uint(max_lights_per_tile) + i];
+    color += lighting(light_index, frag_position.xyz, frag_normal, view_point_time.xyz);
+  }
+
+  float openness = 1.0 - occlusion(frag_occlusion);
+  final_color = color * frag_color * openness + ambient_light_color;
+}
\ No newline at end of file
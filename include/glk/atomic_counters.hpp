@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <GL/gl3w.h>
+#include <glk/gpu_memory_tracker.hpp>
 
 namespace glk {
 
@@ -15,9 +16,11 @@ public:
     glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, atomic_buffer);
     glBufferData(GL_ATOMIC_COUNTER_BUFFER, sizeof(GLuint) * num_counters, nullptr, usage);
     glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, 0);
+    GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, sizeof(GLuint) * num_counters);
   }
   ~AtomicCounters() {
     glDeleteBuffers(1, &atomic_buffer);
+    GpuMemoryTracker::instance()->remove_all(this);
   }
 
   void reset(GLuint* values = nullptr) {
@@ -55,6 +58,10 @@ public:
     return values;
   }
 
+  GLuint id() const {
+    return atomic_buffer;
+  }
+
   void bind(GLuint index = 0) const {
     glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, index, atomic_buffer);
   }
@@ -6,6 +6,7 @@
 
 #include <GL/gl3w.h>
 #include <glk/glsl_shader.hpp>
+#include <glk/gpu_memory_tracker.hpp>
 
 namespace glk {
 
@@ -17,6 +18,16 @@ public:
   virtual ~Drawable() {}
 
   virtual void draw(glk::GLSLShader& shader) const {}
+
+  // GPU memory held by this drawable [bytes]
+  virtual size_t memory_usage() const { return GpuMemoryTracker::instance()->usage(this); }
+
+  // Release the GPU memory while keeping a CPU copy that is re-uploaded on the next draw call
+  // They are semantically const but not logically const (return false if eviction is not supported)
+  virtual bool evict() const { return false; }
+  virtual bool evicted() const { return false; }
+  // True if evict() can release the GPU memory of this drawable
+  virtual bool evictable() const { return false; }
 };
 
 }  // namespace glk
@@ -12,12 +12,30 @@ namespace glk {
 
 class TextureRenderer;
 
+/**
+ * @brief Quality knobs of screen effects (adjusted by guik::AdaptiveQualityController)
+ */
+struct ScreenEffectQuality {
+  ScreenEffectQuality(int occlusion_samples = 16, int splatting_iterations = 6, int splatting_k_neighbors = 15)
+  : occlusion_samples(occlusion_samples),
+    splatting_iterations(splatting_iterations),
+    splatting_k_neighbors(splatting_k_neighbors) {}
+
+  int occlusion_samples;      // number of ambient occlusion samples per pixel (1 - 16)
+  int splatting_iterations;   // number of k-NN radius bisection iterations of splatting
+  int splatting_k_neighbors;  // number of neighbors used for splatting radius estimation
+};
+
 class ScreenEffect {
 public:
   ScreenEffect() {}
   virtual ~ScreenEffect() {}
 
   virtual void set_size(const Eigen::Vector2i& size) {}
+  // Effects that have no quality knobs ignore this
+  virtual void set_quality(const ScreenEffectQuality& quality) {}
+  // Current quality (knobs that the effect does not have are left at the defaults)
+  virtual ScreenEffectQuality get_quality() const { return ScreenEffectQuality(); }
   virtual void draw(const TextureRenderer& renderer, const glk::Texture& color_texture, const glk::Texture& depth_texture, const TextureRendererInput::Ptr& input, glk::FrameBuffer* frame_buffer = nullptr) = 0;
 };
 
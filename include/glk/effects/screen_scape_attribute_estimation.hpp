@@ -2,40 +2,78 @@
 #define GLK_SCREEN_SPACE_ATTRIBUTE_ESTIMATION_HPP
 
 #include <glk/frame_buffer.hpp>
+#include <glk/render_target_pool.hpp>
 #include <glk/effects/screen_effect.hpp>
 
 namespace glk {
 
 class ScreenSpaceAttributeEstimation : public ScreenEffect {
 public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
   enum class BufferType { NONE, DEPTH, POSITION, SMOOTHED_POSITION_X, SMOOTHED_POSITION, NORMAL, SSAO, SMOOTHED_SSAO_X, SMOOTHED_SSAO };
 
   ScreenSpaceAttributeEstimation(const Eigen::Vector2i& size = Eigen::Vector2i(1920, 1080), BufferType rendering_type = BufferType::NONE);
   virtual ~ScreenSpaceAttributeEstimation() override;
 
   virtual void set_size(const Eigen::Vector2i& size) override;
+  // Changes the number of occlusion samples per pixel
+  virtual void set_quality(const ScreenEffectQuality& quality) override;
+  virtual ScreenEffectQuality get_quality() const override;
 
   void set_smooth_normal(bool smooth_normal);
   void set_rendering_buffer(BufferType buffer_type);
 
+  /**
+   * @brief Set the resolution of ambient occlusion estimation
+   * @param downsample  1 (full resolution), 2 (half resolution), or 4 (quarter resolution).
+   *                    Low resolution occlusion is upsampled with a depth-aware bilateral filter.
+   */
+  void set_occlusion_downsample(int downsample);
+  /**
+   * @brief Enable temporal accumulation of ambient occlusion.
+   *        The occlusion of the previous frame is reprojected with the last view and projection matrices
+   *        and blended with the current estimate (disoccluded pixels are rejected based on depth).
+   */
+  void set_temporal_occlusion(bool temporal_occlusion);
+
   const glk::Texture& position() const;
+  /**
+   * @brief Screen-space normals in an octahedral encoding (GL_RG16, two unorm channels in [0, 1]).
+   *        Decode with e = rg * 2 - 1, n = (e.x, e.y, 1 - |e.x| - |e.y|), t = max(-n.z, 0), n.xy -= sign(n.xy) * t, normalize(n)
+   *        (see decode_normal() in data/shader/ssao.frag).
+   */
   const glk::Texture& normal() const;
   const glk::Texture& occlusion() const;
 
   virtual void draw(const TextureRenderer& renderer, const glk::Texture& color_texture, const glk::Texture& depth_texture, const TextureRendererInput::Ptr& input, glk::FrameBuffer* frame_buffer = nullptr) override;
 
+private:
+  void release_targets();
+
 private:
   bool smooth_normal;
   BufferType rendering_type;
 
+  int occlusion_downsample;
+  bool temporal_occlusion;
+
   glk::GLSLShader texture_shader;
   glk::GLSLShader pos_shader;
   glk::GLSLShader normal_shader;
   glk::GLSLShader occlusion_shader;
   glk::GLSLShader bilateral_shader;
+  glk::GLSLShader temporal_shader;
+  glk::GLSLShader upsample_shader;
 
   std::unique_ptr<glk::Texture> randomization_texture;
 
+  // Frame buffers are bound to render targets borrowed from glk::RenderTargetPool.
+  // position, normal (octahedral encoded), and the final occlusion are kept across frames; the others are returned after use
+  std::shared_ptr<glk::Texture> position_texture;
+  std::shared_ptr<glk::Texture> normal_texture;
+  std::shared_ptr<glk::Texture> occlusion_texture;
+
   std::unique_ptr<glk::FrameBuffer> position_buffer;
   std::unique_ptr<glk::FrameBuffer> position_smoothing_x_buffer;
   std::unique_ptr<glk::FrameBuffer> position_smoothing_y_buffer;
@@ -44,6 +82,17 @@ private:
   std::unique_ptr<glk::FrameBuffer> occlusion_buffer;
   std::unique_ptr<glk::FrameBuffer> bilateral_x_buffer;
   std::unique_ptr<glk::FrameBuffer> bilateral_y_buffer;
+  std::unique_ptr<glk::FrameBuffer> upsample_buffer;
+
+  // temporal accumulation (x: occlusion, y: distance to the view point)
+  std::shared_ptr<glk::Texture> occlusion_history[2];
+  std::unique_ptr<glk::FrameBuffer> temporal_buffer;
+
+  int history_index;
+  bool history_valid;
+  long frame_count;
+  Eigen::Matrix4f last_projection_view_matrix;
+  Eigen::Vector3f last_view_point;
 };
 
 }  // namespace glk
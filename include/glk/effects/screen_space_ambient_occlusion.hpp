@@ -13,6 +13,12 @@ public:
   virtual ~ScreenSpaceAmbientOcclusion() override;
 
   virtual void set_size(const Eigen::Vector2i& size) override;
+  virtual void set_quality(const ScreenEffectQuality& quality) override;
+  virtual ScreenEffectQuality get_quality() const override;
+
+  // see ScreenSpaceAttributeEstimation::set_occlusion_downsample() and set_temporal_occlusion()
+  void set_occlusion_downsample(int downsample);
+  void set_temporal_occlusion(bool temporal_occlusion);
 
   virtual void draw(const TextureRenderer& renderer, const glk::Texture& color_texture, const glk::Texture& depth_texture, const TextureRendererInput::Ptr& input, glk::FrameBuffer* frame_buffer = nullptr) override;
 
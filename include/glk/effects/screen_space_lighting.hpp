@@ -1,6 +1,8 @@
 #ifndef GLK_SCREEN_SPACE_LIGHTING_HPP
 #define GLK_SCREEN_SPACE_LIGHTING_HPP
 
+#include <glk/uniform_buffer.hpp>
+#include <glk/shader_storage_buffer.hpp>
 #include <glk/effects/screen_effect.hpp>
 
 namespace glk {
@@ -19,6 +21,11 @@ public:
   virtual ~ScreenSpaceLighting() override;
 
   const glk::Texture& position() const;
+  /**
+   * @brief Screen-space normals in an octahedral encoding (GL_RG16, two unorm channels in [0, 1]).
+   *        Decode with e = rg * 2 - 1, n = (e.x, e.y, 1 - |e.x| - |e.y|), t = max(-n.z, 0), n.xy -= sign(n.xy) * t, normalize(n)
+   *        (see decode_normal() in data/shader/ssao.frag).
+   */
   const glk::Texture& normal() const;
   const glk::Texture& occlusion() const;
 
@@ -27,6 +34,22 @@ public:
   void set_occlusion_model(OCCLUSION_MODEL model);
   void set_iridescence_model(IRIDESCENCE_MODEL model);
 
+  // see ScreenSpaceAttributeEstimation::set_occlusion_downsample() and set_temporal_occlusion() (ignored when splatting is used)
+  void set_occlusion_downsample(int downsample);
+  void set_temporal_occlusion(bool temporal_occlusion);
+
+  /**
+   * @brief Enable tiled light culling (enabled by default if compute shaders are available).
+   *        Lights are binned into 16x16 pixel screen tiles by a compute pass based on their ranges,
+   *        and each pixel evaluates only the lights of its tile. Without culling, the number of lights is limited to 128.
+   *        A tile holds up to 256 lights. Lights are ranked by importance (directional lights first, then range times intensity),
+   *        and the least important lights of a tile that overflows are dropped (see num_overflow_tiles()).
+   */
+  void set_tiled_light_culling(bool enable);
+  bool tiled_light_culling_enabled() const;
+  /// Number of tiles that had more visible lights than a tile can hold (in the frame rendered a few frames ago)
+  int num_overflow_tiles() const;
+
   float get_albedo() const;
   float get_roughness() const;
 
@@ -53,10 +76,15 @@ public:
   void set_light_color(int i, const Eigen::Vector4f& color);
 
   virtual void set_size(const Eigen::Vector2i& size) override;
+  virtual void set_quality(const ScreenEffectQuality& quality) override;
+  virtual ScreenEffectQuality get_quality() const override;
   virtual void draw(const TextureRenderer& renderer, const glk::Texture& color_texture, const glk::Texture& depth_texture, const TextureRendererInput::Ptr& input, glk::FrameBuffer* frame_buffer = nullptr) override;
 
 private:
   bool load_shader();
+  void allocate_tile_buffers(const Eigen::Vector2i& size);
+  void cull_lights(const glk::Texture& position_texture);
+  void upload_light_block();
 
 private:
   std::unique_ptr<glk::ScreenSpaceSplatting> splatting;
@@ -79,6 +107,25 @@ private:
   std::vector<Eigen::Vector2f, Eigen::aligned_allocator<Eigen::Vector2f>> light_attenuation;
   std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f>> light_pos;
   std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f>> light_color;
+  std::unique_ptr<glk::UniformBuffer> light_block;  // lights of the non-tiled path (LightBlock in ssli.frag)
+
+  // tiled light culling
+  bool light_culling_available;
+  bool tiled_light_culling;
+  int max_lights_per_tile;
+  Eigen::Vector2i num_tiles;
+  glk::GLSLShader light_culling_shader;
+  int lights_buffer_capacity;
+  std::unique_ptr<glk::ShaderStorageBuffer> lights_buffer;
+  std::unique_ptr<glk::ShaderStorageBuffer> tile_light_counts_buffer;
+  std::unique_ptr<glk::ShaderStorageBuffer> tile_light_indices_buffer;
+
+  // overflow statistics (a ring of buffers read back a few frames later so as not to stall the pipeline)
+  std::vector<std::unique_ptr<glk::ShaderStorageBuffer>> light_culling_stats_buffers;
+  std::vector<GLsync> light_culling_stats_fences;
+  int light_culling_stats_cursor;
+  int overflow_tiles;
+  bool overflow_warned;
 };
 
 }  // namespace glk
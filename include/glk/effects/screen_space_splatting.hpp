@@ -2,6 +2,8 @@
 #define GLK_SCREEN_SPACE_SPLATTING_HPP
 
 #include <glk/query.hpp>
+#include <glk/atomic_counters.hpp>
+#include <glk/shader_storage_buffer.hpp>
 #include <glk/pointcloud_buffer.hpp>
 #include <glk/transform_feedback.hpp>
 #include <glk/effects/screen_effect.hpp>
@@ -12,20 +14,43 @@ class GLProfiler;
 
 class ScreenSpaceSplatting : public ScreenEffect {
 public:
+  /**
+   * @brief k-NN radius estimation method
+   *        RASTERIZATION : iterative bisection of radius bounds with rasterization passes (num_iterations x 4 passes)
+   *        COMPUTE       : points are binned into 8x8 pixel cells in an SSBO and the k-NN radius is searched over neighboring cells (2 compute dispatches)
+   */
+  enum class KNN_MODE { RASTERIZATION, COMPUTE };
+
   ScreenSpaceSplatting(const Eigen::Vector2i& size = Eigen::Vector2i(1920, 1080));
   virtual ~ScreenSpaceSplatting() override;
 
   virtual void set_size(const Eigen::Vector2i& size) override;
+  // Changes the number of k-NN radius estimation iterations and the number of neighbors
+  virtual void set_quality(const ScreenEffectQuality& quality) override;
+  virtual ScreenEffectQuality get_quality() const override;
   virtual void draw(const TextureRenderer& renderer, const glk::Texture& color_texture, const glk::Texture& depth_texture, const TextureRendererInput::Ptr& input, glk::FrameBuffer* frame_buffer = nullptr) override;
 
+  // World space positions (w = 1 for pixels not covered by any splat)
   const glk::Texture& position() const;
+  /**
+   * @brief Screen-space normals in an octahedral encoding (GL_RG16, two unorm channels in [0, 1]).
+   *        Decode with e = rg * 2 - 1, n = (e.x, e.y, 1 - |e.x| - |e.y|), t = max(-n.z, 0), n.xy -= sign(n.xy) * t, normalize(n)
+   *        (see decode_normal() in data/shader/ssao.frag).
+   */
   const glk::Texture& normal() const;
   const glk::Texture& color() const;
 
+  void set_knn_mode(KNN_MODE mode);
+  KNN_MODE get_knn_mode() const;
+
+  // Number of points whose k-NN radius was found in the last frame (COMPUTE mode only; reads back a GPU counter)
+  int num_resolved_points() const;
+
 private:
   void extract_points_on_screen(const glk::Texture& depth_texture);
   void estimate_initial_radius(const glk::Texture& depth_texture);
   void estimate_knn_radius();
+  void estimate_knn_radius_compute(const glk::Texture& depth_texture);
   void estimate_gaussian(GLProfiler& prof, const TextureRenderer& renderer);
   void render_splatting(GLProfiler& prof, const glk::Texture& color_texture);
 
@@ -66,6 +91,17 @@ private:
   glk::GLSLShader radius_finalization_shader;
   std::unique_ptr<glk::FrameBuffer> finalized_radius_buffer;
 
+  // compute k-NN radius estimation
+  KNN_MODE knn_mode;
+  bool knn_compute_available;
+  int max_search_rings;
+  glk::GLSLShader knn_binning_shader;
+  glk::GLSLShader knn_radius_shader;
+  Eigen::Vector2i num_cells;
+  std::unique_ptr<glk::ShaderStorageBuffer> cell_counts_buffer;
+  std::unique_ptr<glk::ShaderStorageBuffer> cell_points_buffer;
+  std::unique_ptr<glk::AtomicCounters> resolved_points_counter;
+
   // gaussian estimation
   glk::GLSLShader gaussian_gathering_shader;
   glk::GLSLShader gaussian_finalization_shader;
@@ -20,6 +20,8 @@ public:
 
   int num_color_buffers() const;
   glk::Texture& add_color_buffer(int layout, GLuint internal_format, GLuint format, GLuint type);
+  // attach an externally allocated texture (e.g., a target borrowed from glk::RenderTargetPool) to the given layout
+  glk::Texture& attach_color_buffer(int layout, const std::shared_ptr<Texture>& texture);
   glk::Texture& add_depth_buffer(GLuint internal_format = GL_DEPTH_COMPONENT32F, GLuint format = GL_DEPTH_COMPONENT, GLuint type = GL_FLOAT);
 
   void bind_ext_depth_buffer(const glk::Texture& depth_texture);
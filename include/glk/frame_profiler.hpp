@@ -0,0 +1,147 @@
+#ifndef GLK_FRAME_PROFILER_HPP
+#define GLK_FRAME_PROFILER_HPP
+
+#include <deque>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <GL/gl3w.h>
+
+namespace glk {
+
+/**
+ * @brief Continuous per-frame CPU/GPU profiler.
+ *        Unlike GLProfiler, it never blocks on query results. GL_TIMESTAMP queries of each frame are kept in a ring of
+ *        frame slots and they are collected a few frames later once GL_QUERY_RESULT_AVAILABLE becomes true.
+ */
+class FrameProfiler {
+public:
+  using Clock = std::chrono::high_resolution_clock;
+
+  /// Timing result of a profiling scope
+  struct ScopeRecord {
+    std::string label;
+    int depth;
+    double cpu_begin_msec;  // relative to the profiler start
+    double cpu_msec;
+    double gpu_begin_msec;  // relative to the frame begin on the GPU timeline
+    double gpu_msec;        // negative if GPU timing is not available
+  };
+
+  /// Results of a frame
+  struct FrameRecord {
+    long frame_id;
+    double cpu_begin_msec;
+    double cpu_msec;
+    std::vector<ScopeRecord> scopes;
+  };
+
+  /// RAII helper that profiles a scope with the global profiler instance
+  class Scope {
+  public:
+    Scope(const std::string& label, bool gpu = true);
+    ~Scope();
+
+  private:
+    bool active;
+  };
+
+  FrameProfiler(int num_frames_in_flight = 4, int history_length = 512);
+  ~FrameProfiler();
+
+  static FrameProfiler* instance();
+
+  bool enabled() const { return enabled_; }
+  void set_enabled(bool enabled);
+
+  // frame control
+  void new_frame();
+
+  // scopes must be properly nested
+  void push(const std::string& label, bool gpu = true);
+  // push a scope labeled "prefix/name" (the label is built only when the profiler is enabled)
+  void push(const std::string& prefix, const char* name, bool gpu = true);
+  void pop();
+
+  void clear();
+
+  // results
+  long num_dropped_frames() const { return dropped_frames; }
+  const std::vector<std::string>& labels() const { return label_order; }
+  const std::deque<FrameRecord>& frames() const { return history; }
+
+  // ring buffers of (cpu/gpu) time in msec. The oldest element is at history_offset()
+  const std::vector<float>& frame_time_history() const { return frame_time_ring; }
+  const std::vector<float>& cpu_time_history(const std::string& label) const;
+  const std::vector<float>& gpu_time_history(const std::string& label) const;
+  int history_offset() const { return ring_offset; }
+  int history_size() const { return ring_size; }
+
+  double average_cpu_time(const std::string& label) const;
+  double average_gpu_time(const std::string& label) const;
+
+  // export
+  bool save_json(const std::string& filename) const;
+  bool save_chrome_trace(const std::string& filename) const;
+
+private:
+  struct PendingScope {
+    std::string label;
+    int depth;
+    bool gpu;
+    int begin_query;
+    int end_query;
+    Clock::time_point cpu_begin;
+    Clock::time_point cpu_end;
+  };
+
+  struct FrameSlot {
+    FrameSlot() : frame_id(-1), pending(false), num_used_queries(0) {}
+
+    long frame_id;
+    bool pending;
+    Clock::time_point cpu_begin;
+    Clock::time_point cpu_end;
+
+    int num_used_queries;
+    std::vector<GLuint> queries;
+    std::vector<PendingScope> scopes;
+  };
+
+  struct LabelHistory {
+    std::vector<float> cpu_msec;
+    std::vector<float> gpu_msec;
+  };
+
+  int issue_timestamp(FrameSlot& slot);
+  void end_frame();
+  bool collect(FrameSlot& slot);
+  void record(const FrameRecord& frame);
+
+private:
+  static FrameProfiler* instance_;
+
+  bool enabled_;
+  const int history_length;
+
+  long frame_count;
+  long dropped_frames;
+  Clock::time_point start_time;
+
+  int current_slot;
+  std::vector<FrameSlot> slots;
+  std::vector<int> scope_stack;
+
+  int ring_offset;
+  int ring_size;
+  std::vector<float> frame_time_ring;
+  std::vector<std::string> label_order;
+  std::unordered_map<std::string, LabelHistory> label_histories;
+  std::deque<FrameRecord> history;
+};
+
+}  // namespace glk
+
+#endif
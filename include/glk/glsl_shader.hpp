@@ -20,6 +20,7 @@ public:
   GLSLShader();
   ~GLSLShader();
 
+  // #include "path" directives in the source are expanded (paths are relative to the including file)
   bool attach_source(const std::string& filename, GLuint shader_type);
   bool attach_source(const std::vector<std::string>& filenames, GLuint shader_type);
 
@@ -45,6 +46,8 @@ public:
   GLint uniform(const std::string& name);
   GLint subroutine(GLenum shader_type, const std::string& name);
   GLint subroutine_uniform(GLenum shader_type, const std::string& name);
+  // Bind a uniform block to a binding point (returns false if the program does not have the block)
+  bool bind_uniform_block(const std::string& name, GLuint binding);
 
   int get_uniformi(const std::string& name) {
     int value;
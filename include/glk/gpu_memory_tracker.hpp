@@ -0,0 +1,90 @@
+#ifndef GLK_GPU_MEMORY_TRACKER_HPP
+#define GLK_GPU_MEMORY_TRACKER_HPP
+
+#include <array>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <unordered_set>
+#include <unordered_map>
+#include <GL/gl3w.h>
+
+namespace glk {
+
+/**
+ * @brief Bookkeeping of GPU memory allocated by glk buffer and texture classes.
+ *        Allocations are recorded per owner object (e.g., a drawable) so that the memory usage can be broken down per drawable.
+ */
+class GpuMemoryTracker {
+public:
+  enum class Category { BUFFER = 0, TEXTURE = 1 };
+
+  /**
+   * @brief Content of a buffer evicted by evict_buffer().
+   *        The content is first copied to a staging buffer on the GPU and read back to the CPU once a fence signals that
+   *        the copy has completed (see poll_evicted_buffers()), so that eviction does not stall the pipeline.
+   *        All methods must be called on the GL thread.
+   */
+  class EvictedBuffer {
+  public:
+    EvictedBuffer(GLuint buffer, GLenum usage);
+    ~EvictedBuffer();
+
+    size_t size() const { return num_bytes; }
+    // Read back the staging buffer if the copy has completed (wait = true blocks until it completes)
+    // Returns true if the content is on the CPU
+    bool poll(bool wait = false);
+    // Re-upload the content to buffer (copied on the GPU if the content has not been read back yet)
+    void restore(GLuint buffer, GLenum usage) const;
+
+  private:
+    size_t num_bytes;
+    GLuint staging;  // 0 after the content is read back
+    GLsync fence;
+    std::vector<char> data;
+  };
+
+  static GpuMemoryTracker* instance();
+
+  void add(const void* owner, Category category, size_t bytes);
+  void remove(const void* owner, Category category, size_t bytes);
+  void remove_all(const void* owner);
+
+  // Mark the buffers of owner as evictable (they are counted in total_evictable())
+  void set_evictable(const void* owner, bool evictable);
+
+  size_t usage(const void* owner) const;
+  size_t total() const;
+  size_t total(Category category) const;
+  size_t total_evictable() const;
+  size_t num_owners() const;
+
+  // utility
+  static size_t bytes_per_pixel(GLenum internal_format);
+  static size_t buffer_size(GLuint buffer);
+
+  // Release the storage of a buffer and keep its content in an EvictedBuffer (the buffer name is kept valid)
+  static std::shared_ptr<EvictedBuffer> evict_buffer(GLuint buffer, GLenum usage = GL_STATIC_DRAW);
+  // Re-upload the content of a buffer evicted by evict_buffer()
+  static void restore_buffer(GLuint buffer, const EvictedBuffer& data, GLenum usage = GL_STATIC_DRAW);
+  // Read back the evicted buffers whose GPU copies have completed and release their staging buffers (called once per frame)
+  void poll_evicted_buffers();
+  // Reallocate a buffer with a larger size while keeping its content (the size change is tracked for owner)
+  static void grow_buffer(const void* owner, GLuint& buffer, size_t old_size, size_t new_size, GLenum usage = GL_STATIC_DRAW);
+
+private:
+  GpuMemoryTracker();
+
+  mutable std::mutex mutex;
+  size_t totals[2];
+  size_t evictable_bytes;                                         // buffer bytes of evictable owners
+  std::unordered_map<const void*, std::array<size_t, 2>> owners;  // owner -> bytes of each category
+  std::unordered_set<const void*> evictable_owners;
+
+  std::vector<std::weak_ptr<EvictedBuffer>> pending_evictions;  // evicted buffers not read back yet (GL thread only)
+};
+
+}  // namespace glk
+
+#endif
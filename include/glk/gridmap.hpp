@@ -17,6 +17,7 @@ public:
   virtual ~GridMap();
 
   virtual void draw(glk::GLSLShader& shader) const override;
+  virtual size_t memory_usage() const override;
 
 private:
   GridMap(const GridMap&);
@@ -0,0 +1,54 @@
+#ifndef GLK_IO_JSON_HPP
+#define GLK_IO_JSON_HPP
+
+#include <string>
+#include <cstdio>
+
+namespace glk {
+
+/**
+ * @brief Escape a string to be written in a JSON string literal (quotes, backslashes, and control characters)
+ */
+inline std::string escape_json(const std::string& str) {
+  std::string escaped;
+  escaped.reserve(str.size());
+  for (const char c : str) {
+    switch (c) {
+      case '"':
+        escaped += "\\\"";
+        break;
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\b':
+        escaped += "\\b";
+        break;
+      case '\f':
+        escaped += "\\f";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      case '\r':
+        escaped += "\\r";
+        break;
+      case '\t':
+        escaped += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char buffer[8];
+          std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned char>(c));
+          escaped += buffer;
+        } else {
+          escaped.push_back(c);
+        }
+        break;
+    }
+  }
+  return escaped;
+}
+
+}  // namespace glk
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef GLK_MAPPED_FILE_HPP
+#define GLK_MAPPED_FILE_HPP
+
+#include <string>
+#include <cstddef>
+
+namespace glk {
+
+/**
+ * @brief Memory-mapped file (POSIX mmap)
+ */
+class MappedFile {
+public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Map an existing file (read only)
+  bool open(const std::string& filename);
+  // Create (or truncate) a file of the given size and map it (read and write)
+  bool create(const std::string& filename, size_t size);
+  // Unmap the file (a file created with create() is truncated to the given size)
+  void close(size_t truncate_size = static_cast<size_t>(-1));
+
+  bool is_open() const { return mapped != nullptr; }
+  const char* data() const { return mapped; }
+  char* mutable_data() { return writable ? mapped : nullptr; }
+  size_t size() const { return file_size; }
+
+private:
+  int fd;
+  bool writable;
+  char* mapped;
+  size_t file_size;
+};
+
+}  // namespace glk
+
+#endif
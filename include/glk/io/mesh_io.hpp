@@ -5,7 +5,13 @@
 
 namespace glk {
 
-std::shared_ptr<MeshModel> load_mesh_model(const std::string& path);
+/**
+ * @brief Load a mesh model with assimp
+ * @param path           Model path
+ * @param generate_lods  If true, levels of detail of large meshes are generated on a worker thread
+ *                       (meshes are drawn at full resolution until their LODs are ready)
+ */
+std::shared_ptr<MeshModel> load_mesh_model(const std::string& path, bool generate_lods = true);
 
 }  // namespace glk
 
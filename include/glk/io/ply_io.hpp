@@ -26,10 +26,34 @@ struct PLYData {
   std::vector<int> indices;
 };
 
-std::shared_ptr<PLYData> load_ply(const std::string& filename);
+/**
+ * @brief Options of the PLY loader
+ */
+struct PLYLoadOptions {
+  bool estimate_normals = true;  // estimate vertex normals of meshes without normals
+  int num_threads = 0;           // number of threads for parsing and normal estimation (<= 0 : hardware concurrency)
+};
+
+std::shared_ptr<PLYData> load_ply(const std::string& filename, const PLYLoadOptions& options = PLYLoadOptions());
+
+/**
+ * @brief Options of the binary PLY writer
+ */
+struct PLYWriteOptions {
+  bool write_normals = true;     // write normals (nx, ny, nz) if available
+  bool uchar_colors = false;     // write colors as uchar [0, 255] instead of float32
+  bool compact_indices = false;  // write face vertex counts as uchar and indices as ushort (when there are at most 65536 vertices)
+  bool use_mmap = false;         // write into a memory-mapped output file instead of through std::ofstream
+};
 
 bool save_ply_ascii(const std::string& filename, const PLYData& ply);
-bool save_ply_binary(const std::string& filename, const PLYData& ply);
+
+/**
+ * @brief Save PLY data in the binary little endian format.
+ *        Vertices and faces are packed into fixed-size chunks (or directly into the mapped output file)
+ *        without an intermediate copy of the whole data.
+ */
+bool save_ply_binary(const std::string& filename, const PLYData& ply, const PLYWriteOptions& options = PLYWriteOptions());
 
 template<typename T, int D>
 bool save_ply_binary(const std::string& filename, const Eigen::Matrix<T, D, 1>* points, int num_points);
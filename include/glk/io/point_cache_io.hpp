@@ -0,0 +1,134 @@
+#ifndef GLK_POINT_CACHE_IO_HPP
+#define GLK_POINT_CACHE_IO_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <Eigen/Core>
+#include <glk/io/mapped_file.hpp>
+
+namespace glk {
+
+class PointCloudBuffer;
+struct PLYData;
+
+/**
+ * @brief On-disk header of the point cache format (.glkc, little endian)
+ *
+ *  [header (256 bytes)][vertices (float x 3)][normals (float x 3)][colors (float x 4)][intensities (float)][chunks][lod ratios]
+ *
+ * Each block starts at a 64-byte aligned offset (0 if absent), and attribute blocks are tightly packed arrays
+ * that match the vertex layouts of PointCloudBuffer so that they can be passed to glBufferData without conversion.
+ * If a chunk index is present, points are sorted by chunk and shuffled in each chunk so that any prefix of a chunk
+ * is a uniform subsample of it (LOD level l draws the first ceil(count * lod_ratios[l]) points of each chunk).
+ */
+struct PointCacheHeader {
+  char magic[8];  // "GLKCACHE"
+  uint32_t version;
+  uint32_t reserved;
+
+  uint64_t num_points;
+  uint64_t num_chunks;
+  uint64_t num_lod_levels;
+
+  float bbox_min[4];  // xyz: min corner of the bounding box, w: 1 if the bounding box is valid
+  float bbox_max[4];
+
+  uint64_t vertices_offset;
+  uint64_t normals_offset;
+  uint64_t colors_offset;
+  uint64_t intensities_offset;
+  uint64_t chunks_offset;
+  uint64_t lod_ratios_offset;
+
+  char padding[256 - 120];
+};
+
+static_assert(sizeof(PointCacheHeader) == 256, "PointCacheHeader must be 256 bytes");
+
+/**
+ * @brief Spatial chunk (points [first, first + count) in the cache)
+ */
+struct PointCacheChunk {
+  float min[3];
+  float max[3];
+  uint32_t reserved[2];
+  uint64_t first;
+  uint64_t count;
+};
+
+static_assert(sizeof(PointCacheChunk) == 48, "PointCacheChunk must be 48 bytes");
+
+struct PointCacheOptions {
+  double chunk_size = 0.0;                                // size of spatial chunks [m] (<= 0 disables the chunk index)
+  std::vector<float> lod_ratios = {0.25f, 0.05f, 0.01f};  // ratios of points drawn at LOD levels (used only with the chunk index)
+};
+
+/**
+ * @brief Save points in the point cache format
+ * @param normals      Normals (nullptr if not available)
+ * @param colors       RGBA colors (nullptr if not available)
+ * @param intensities  Intensities (nullptr if not available)
+ */
+bool save_point_cache(
+  const std::string& filename,
+  const Eigen::Vector3f* points,
+  const Eigen::Vector3f* normals,
+  const Eigen::Vector4f* colors,
+  const float* intensities,
+  size_t num_points,
+  const PointCacheOptions& options = PointCacheOptions());
+
+bool save_point_cache(const std::string& filename, const PLYData& ply, const PointCacheOptions& options = PointCacheOptions());
+
+/**
+ * @brief Point cache mapped in memory. Attribute pointers refer to the mapped file and are valid while the cache is alive.
+ */
+class PointCache {
+public:
+  using Ptr = std::shared_ptr<PointCache>;
+
+  static Ptr load(const std::string& filename);
+
+  size_t size() const { return header->num_points; }
+
+  const Eigen::Vector3f* vertices() const { return block<Eigen::Vector3f>(header->vertices_offset); }
+  const Eigen::Vector3f* normals() const { return block<Eigen::Vector3f>(header->normals_offset); }
+  const Eigen::Vector4f* colors() const { return block<Eigen::Vector4f>(header->colors_offset); }
+  const float* intensities() const { return block<float>(header->intensities_offset); }
+
+  bool has_bbox() const { return header->bbox_min[3] > 0.0f; }
+  Eigen::Vector3f bbox_min() const { return Eigen::Map<const Eigen::Vector3f>(header->bbox_min); }
+  Eigen::Vector3f bbox_max() const { return Eigen::Map<const Eigen::Vector3f>(header->bbox_max); }
+
+  size_t num_chunks() const { return header->num_chunks; }
+  const PointCacheChunk* chunks() const { return block<PointCacheChunk>(header->chunks_offset); }
+
+  int num_lod_levels() const { return header->num_lod_levels; }
+  float lod_ratio(int level) const { return block<float>(header->lod_ratios_offset)[level]; }
+  // Number of points of a chunk drawn at a LOD level (level < 0 : all points)
+  size_t lod_count(size_t chunk, int level) const;
+
+  /**
+   * @brief Create a PointCloudBuffer from the mapped attributes (vertices, normals and colors are uploaded without conversion).
+   * @note  Intensities are not uploaded (use PointCloudBuffer::add_intensity() with intensities() to color points with a colormap).
+   */
+  std::shared_ptr<PointCloudBuffer> create_buffer() const;
+
+private:
+  PointCache() : header(nullptr) {}
+
+  template <typename T>
+  const T* block(uint64_t offset) const {
+    return offset ? reinterpret_cast<const T*>(file.data() + offset) : nullptr;
+  }
+
+private:
+  MappedFile file;
+  const PointCacheHeader* header;
+};
+
+}  // namespace glk
+
+#endif
@@ -3,29 +3,45 @@
 
 #include <memory>
 #include <vector>
+#include <future>
+#include <cstdint>
 #include <Eigen/Core>
 
 #include <GL/gl3w.h>
 #include <glk/drawable.hpp>
 #include <glk/glsl_shader.hpp>
+#include <glk/gpu_memory_tracker.hpp>
+#include <glk/mesh_optimization.hpp>
+#include <glk/mesh_simplification.hpp>
 
 namespace glk {
 
 class Texture;
 
+/**
+ * @brief Indexed triangle mesh.
+ *        If optimize is true, the mesh is optimized at construction (see glk/mesh_optimization.hpp): identical vertices are merged,
+ *        triangles are reordered for post-transform vertex cache hits, vertices are reordered in the order of their first use,
+ *        and 16-bit indices are used if the number of vertices allows.
+ *        To keep the optimization off the GL thread, run glk::optimize_mesh() on a worker thread and construct the mesh from its result.
+ */
 class Mesh : public Drawable {
 public:
-  Mesh(const void* vertices, int vertex_stride, const void* normals, int normal_stride, int num_vertices, const void* indices, int num_indices, bool wireframe = false);
-  Mesh(const void* vertices, int vertex_stride, const void* normals, int normal_stride, const void* colors, int color_stride, int num_vertices, const void* indices, int num_indices, bool wireframe = false);
-  Mesh(const void* vertices, int vertex_stride, const void* normals, int normal_stride, const void* colors, int color_stride, const void* tex_coords, int tex_coord_stride, int num_vertices, const void* indices, int num_indices, bool wireframe = false);
+  Mesh(const void* vertices, int vertex_stride, const void* normals, int normal_stride, int num_vertices, const void* indices, int num_indices, bool wireframe = false, bool optimize = false);
+  Mesh(const void* vertices, int vertex_stride, const void* normals, int normal_stride, const void* colors, int color_stride, int num_vertices, const void* indices, int num_indices, bool wireframe = false, bool optimize = false);
+  Mesh(const void* vertices, int vertex_stride, const void* normals, int normal_stride, const void* colors, int color_stride, const void* tex_coords, int tex_coord_stride, int num_vertices, const void* indices, int num_indices, bool wireframe = false, bool optimize = false);
+
+  // Upload a mesh optimized in advance (see glk::optimize_mesh())
+  Mesh(const OptimizedMesh& mesh, bool wireframe = false);
 
   template <template <class> class Alloc>
   Mesh(
     const std::vector<Eigen::Vector3f, Alloc<Eigen::Vector3f>>& vertices,
     const std::vector<Eigen::Vector3f, Alloc<Eigen::Vector3f>>& normals,
     const std::vector<int>& indices,
-    bool wireframe = false)
-  : Mesh(vertices.data(), sizeof(float) * 3, normals.data(), sizeof(float) * 3, vertices.size(), indices.data(), indices.size(), wireframe) {}
+    bool wireframe = false,
+    bool optimize = false)
+  : Mesh(vertices.data(), sizeof(float) * 3, normals.data(), sizeof(float) * 3, vertices.size(), indices.data(), indices.size(), wireframe, optimize) {}
 
   template <template <class> class Alloc>
   Mesh(
@@ -33,19 +49,83 @@ public:
     const std::vector<Eigen::Vector3f, Alloc<Eigen::Vector3f>>& normals,
     const std::vector<Eigen::Vector4f, Alloc<Eigen::Vector4f>>& colors,
     const std::vector<int>& indices,
-    bool wireframe = false)
-  : Mesh(vertices.data(), sizeof(float) * 3, normals.data(), sizeof(float) * 3, colors.data(), sizeof(float) * 4, vertices.size(), indices.data(), indices.size(), wireframe) {}
+    bool wireframe = false,
+    bool optimize = false)
+  : Mesh(vertices.data(), sizeof(float) * 3, normals.data(), sizeof(float) * 3, colors.data(), sizeof(float) * 4, vertices.size(), indices.data(), indices.size(), wireframe, optimize) {}
 
   virtual ~Mesh();
 
   virtual void draw(glk::GLSLShader& shader) const override;
 
+  virtual bool evict() const override;
+  virtual bool evicted() const override { return !evicted_data.empty(); }
+  virtual bool evictable() const override { return true; }
+
   void set_texture(const std::shared_ptr<Texture>& texture, GLenum texture_target = GL_TEXTURE1);
 
+  /**
+   * @brief Set levels of detail (see glk::generate_lods). LODs share the vertex buffers of this mesh and only have their own index buffers.
+   * @note  Mesh::draw() draws the level given by set_lod_level() and does not select levels by itself.
+   *        Automatic selection by screen-space error is done only by glk::MeshModel (e.g., models loaded with glk::load_mesh_model()).
+   */
+  void set_lods(const MeshLODChain& lods);
+  /**
+   * @brief Set levels of detail being generated on a worker thread (uploaded in the first draw or num_lods() call after they are ready).
+   * @note  The future should come from a std::promise fulfilled by a worker owned elsewhere (e.g., glk::MeshModel::run_worker()).
+   *        A future of std::async would block the GL thread when the mesh is destroyed or the future is replaced.
+   */
+  void set_lods(std::future<MeshLODChain>&& lods);
+
+  // Number of levels including the original mesh (level 0)
+  int num_lods() const;
+  // Geometric error of a level (0 for the original mesh)
+  float lod_error(int level) const { return level <= 0 || level > lod_errors.size() ? 0.0f : lod_errors[level - 1]; }
+  // Bounding sphere (valid only if LODs are available)
+  const Eigen::Vector4f& lod_bounding_sphere() const { return bounding_sphere; }
+
+  // Select the level to be drawn
+  void set_lod_level(int level) { lod_level = level; }
+  int get_lod_level() const { return lod_level; }
+
+  // buffer accessors (evicted buffers are restored, 0 if the attribute is not given)
+  GLuint vbo_id() const;
+  GLuint nbo_id() const;
+  GLuint cbo_id() const;
+  GLuint tbo_id() const;
+  GLuint ebo_id() const;
+
+  int get_num_vertices() const { return num_vertices; }
+  int get_num_indices() const { return num_indices; }
+  // GL_UNSIGNED_INT, or GL_UNSIGNED_SHORT for optimized meshes with few vertices
+  GLenum get_index_type() const { return index_type; }
+  bool is_wireframe() const { return wireframe; }
+
 private:
   Mesh(const Mesh&);
   Mesh& operator=(const Mesh&);
 
+  void create_buffers(const OptimizedMesh& mesh, bool wireframe);
+  void create_buffers(
+    const void* vertices,
+    int vertex_stride,
+    const void* normals,
+    int normal_stride,
+    const void* colors,
+    int color_stride,
+    const void* tex_coords,
+    int tex_coord_stride,
+    int num_vertices,
+    const void* indices,
+    int num_indices,
+    GLenum index_type,
+    bool wireframe);
+
+  std::vector<GLuint> buffers() const;
+  void restore() const;
+  void upload_lods() const;
+  void create_lod_buffers(const MeshLODChain& lods) const;
+  size_t index_size() const { return index_type == GL_UNSIGNED_SHORT ? sizeof(std::uint16_t) : sizeof(unsigned int); }
+
 private:
   bool wireframe;
 
@@ -56,6 +136,10 @@ private:
 
   int num_vertices;
   int num_indices;
+  GLenum index_type;
+
+  // new index of each input vertex (optimized meshes only, applied to LOD indices)
+  std::vector<int> vertex_remap;
 
   GLuint vao;
   GLuint vbo;
@@ -66,6 +150,16 @@ private:
 
   GLenum texture_target;
   std::shared_ptr<Texture> texture;
+
+  // CPU copies of the buffers while they are evicted
+  mutable std::vector<std::shared_ptr<GpuMemoryTracker::EvictedBuffer>> evicted_data;
+
+  int lod_level;
+  mutable std::future<MeshLODChain> pending_lods;
+  mutable Eigen::Vector4f bounding_sphere;  // [center, radius]
+  mutable std::vector<GLuint> lod_ebos;
+  mutable std::vector<int> lod_num_indices;
+  mutable std::vector<float> lod_errors;
 };
 
 }  // namespace glk
@@ -1,6 +1,9 @@
 #ifndef GLK_MESH_MODEL_HPP
 #define GLK_MESH_MODEL_HPP
 
+#include <atomic>
+#include <thread>
+#include <functional>
 #include <glk/drawable.hpp>
 
 namespace guik {
@@ -14,18 +17,44 @@ class Texture;
 
 class MeshModel : public glk::Drawable {
 public:
+  MeshModel();
+  virtual ~MeshModel() override;
+
   void push_mesh(const int material_id, const std::shared_ptr<glk::Mesh>& mesh);
   void push_material(const guik::ShaderSetting& setting, const std::shared_ptr<glk::Texture>& texture);
   void override_material(const guik::ShaderSetting& setting, const std::shared_ptr<glk::Texture>& texture);
 
+  /**
+   * @brief Set the maximum screen-space error of levels of detail. Each mesh is drawn with the coarsest level
+   *        whose geometric error projects to at most this number of pixels (0 disables LODs).
+   */
+  void set_lod_threshold(float pixels) { lod_threshold = pixels; }
+
+  /**
+   * @brief Run a background task (e.g., LOD generation of the meshes) on a worker thread owned by the model.
+   *        When the model is destroyed, cancel is set to true and the worker is joined, so the task should check cancel regularly.
+   *        A task started before is cancelled and joined first.
+   */
+  void run_worker(const std::function<void(const std::atomic_bool& cancel)>& task);
+
   virtual void draw(glk::GLSLShader& shader) const override;
 
+  virtual size_t memory_usage() const override;
+  virtual bool evict() const override;
+  virtual bool evicted() const override;
+  virtual bool evictable() const override { return !meshes.empty(); }
+
 private:
   std::vector<int> material_ids;
   std::vector<std::shared_ptr<glk::Mesh>> meshes;
 
   std::vector<guik::ShaderSetting> settings;
   std::vector<std::shared_ptr<glk::Texture>> textures;
+
+  float lod_threshold;
+
+  std::atomic_bool worker_cancel;
+  std::thread worker;
 };
 
 }  // namespace glk
@@ -0,0 +1,91 @@
+#ifndef GLK_MESH_OPTIMIZATION_HPP
+#define GLK_MESH_OPTIMIZATION_HPP
+
+#include <vector>
+#include <cstdint>
+
+namespace glk {
+
+/**
+ * @brief Vertex attribute array to be deduplicated and reordered
+ */
+struct VertexAttribute {
+  const void* data;  // attribute of the first vertex
+  int stride;        // stride in bytes
+  int size;          // size of the attribute in bytes (bytes compared in deduplication)
+};
+
+/**
+ * @brief Average cache miss ratio (number of vertex shader invocations per triangle) of a FIFO post-transform vertex cache.
+ *        0.5 is the optimum for a large regular mesh, and 3.0 means no reuse at all.
+ */
+double compute_acmr(const std::vector<int>& indices, int cache_size = 16);
+
+/**
+ * @brief Merge vertices whose attributes are bitwise identical
+ * @param attributes    Vertex attributes
+ * @param num_vertices  Number of vertices
+ * @param remap         [out] New index of each vertex
+ * @return              Number of unique vertices
+ */
+int deduplicate_vertices(const std::vector<VertexAttribute>& attributes, int num_vertices, std::vector<int>& remap);
+
+/**
+ * @brief Reorder triangles for post-transform vertex cache hits (Tipsify, Sander et al., 2007)
+ */
+std::vector<int> optimize_vertex_cache(const std::vector<int>& indices, int num_vertices, int cache_size = 16);
+
+/**
+ * @brief Reorder vertices in the order of their first use for pre-transform cache locality.
+ *        Indices are rewritten in place, and unreferenced vertices are dropped (remap = -1).
+ * @return Number of referenced vertices
+ */
+int optimize_vertex_fetch(std::vector<int>& indices, int num_vertices, std::vector<int>& remap);
+
+/**
+ * @brief Gather a vertex attribute buffer into the new vertex order (vertex i is moved to remap[i])
+ */
+std::vector<char> remap_vertex_buffer(const void* data, int stride, int num_vertices, const std::vector<int>& remap, int new_num_vertices);
+
+/**
+ * @brief Vertex and index buffers of an optimized mesh (see optimize_mesh())
+ */
+struct OptimizedMesh {
+  int num_vertices = 0;
+
+  // reordered vertex attributes (empty if not given) with the strides of the input
+  std::vector<char> vertices;
+  std::vector<char> normals;
+  std::vector<char> colors;
+  std::vector<char> tex_coords;
+  int vertex_stride = 0;
+  int normal_stride = 0;
+  int color_stride = 0;
+  int tex_coord_stride = 0;
+
+  std::vector<int> indices;
+  std::vector<std::uint16_t> short_indices;  // 16-bit copy of indices if the number of vertices allows (empty otherwise)
+  std::vector<int> vertex_remap;             // new index of each input vertex (-1 for unreferenced vertices)
+};
+
+/**
+ * @brief Deduplicate vertices, reorder triangles for the vertex cache, and reorder vertices for fetch locality.
+ *        This does not touch GL and can be run on a worker thread. The result can be uploaded with glk::Mesh(const OptimizedMesh&).
+ *        Vertices (vec3), normals (vec3), colors (vec4), and tex_coords (vec2) are floats, and nullptr if not given.
+ */
+OptimizedMesh optimize_mesh(
+  const void* vertices,
+  int vertex_stride,
+  const void* normals,
+  int normal_stride,
+  const void* colors,
+  int color_stride,
+  const void* tex_coords,
+  int tex_coord_stride,
+  int num_vertices,
+  const int* indices,
+  int num_indices);
+
+}  // namespace glk
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef GLK_MESH_SIMPLIFICATION_HPP
+#define GLK_MESH_SIMPLIFICATION_HPP
+
+#include <atomic>
+#include <vector>
+#include <Eigen/Core>
+
+namespace glk {
+
+/**
+ * @brief Level of detail of a mesh. Simplified meshes refer to the vertices of the original mesh
+ *        (vertices are collapsed onto existing vertices and never moved) so that all levels share the vertex buffers.
+ */
+struct MeshLOD {
+  std::vector<int> indices;  // triangle indices into the original vertices
+  float error;               // RMS distance between the simplified and the original surface (in mesh units)
+};
+
+struct MeshLODChain {
+  Eigen::Vector3f center;       // bounding sphere center
+  float radius;                 // bounding sphere radius
+  std::vector<MeshLOD> levels;  // increasingly coarse levels (the original mesh is not included)
+};
+
+struct MeshLODOptions {
+  int max_levels = 4;            // maximum number of simplified levels
+  double reduction_ratio = 0.25; // ratio of the number of triangles between consecutive levels
+  int min_triangles = 256;       // levels with fewer triangles are not generated
+  const std::atomic_bool* cancel = nullptr;  // (optional) generation stops between edge collapses once this becomes true
+};
+
+/**
+ * @brief Simplify a triangle mesh with quadric error metrics (Garland and Heckbert, 1997) using half-edge collapses.
+ *        Border and non-manifold edges are preserved.
+ * @param vertices            Vertex positions
+ * @param num_vertices        Number of vertices
+ * @param indices             Triangle indices
+ * @param target_num_indices  Target number of indices (the result may have more indices if no more edge can be collapsed)
+ * @param error               (Optional) RMS distance of the simplified surface
+ * @return                    Triangle indices into the original vertices
+ */
+std::vector<int> simplify_mesh(const Eigen::Vector3f* vertices, int num_vertices, const std::vector<int>& indices, int target_num_indices, float* error = nullptr);
+
+/**
+ * @brief Generate a LOD chain of a triangle mesh (levels are taken from a single simplification pass).
+ *        To generate levels in the background, call this in a task given to glk::MeshModel::run_worker() with
+ *        options.cancel pointing to the cancel flag of the task, so that the worker is owned and cancelled by the model.
+ */
+MeshLODChain generate_lods(const Eigen::Vector3f* vertices, int num_vertices, const std::vector<int>& indices, const MeshLODOptions& options = MeshLODOptions());
+
+}  // namespace glk
+
+#endif
@@ -1,31 +1,69 @@
 #ifndef GLK_PRIMITIVES_MESH_UTILS_HPP
 #define GLK_PRIMITIVES_MESH_UTILS_HPP
 
+#include <atomic>
+#include <memory>
+#include <thread>
 #include <vector>
+#include <algorithm>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 
 namespace glk {
 
+/**
+ * @brief Call func(begin, end) for ranges splitting [0, n) in parallel
+ * @param num_threads  Number of threads (<= 0 : hardware concurrency)
+ */
+template <typename Func>
+void parallel_for_ranges(int num_threads, size_t n, const Func& func) {
+  if (num_threads <= 0) {
+    num_threads = std::max<int>(1, std::thread::hardware_concurrency());
+  }
+  num_threads = std::max<size_t>(1, std::min<size_t>(num_threads, n / 4096));
+
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads; i++) {
+    threads.emplace_back([&, i] { func(n * i / num_threads, n * (i + 1) / num_threads); });
+  }
+  func(0, n / num_threads);
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+/**
+ * @brief Unnormalized normal of a triangle (computed with 4D vectors to use SIMD cross products)
+ */
+inline Eigen::Vector3f face_normal(const Eigen::Vector3f& v1, const Eigen::Vector3f& v2, const Eigen::Vector3f& v3) {
+  const Eigen::Vector4f a = (Eigen::Vector4f() << v2 - v1, 0.0f).finished();
+  const Eigen::Vector4f b = (Eigen::Vector4f() << v3 - v2, 0.0f).finished();
+  return a.cross3(b).head<3>();
+}
+
 class Flatize {
 public:
-  Flatize(const std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f>>& vertices_, const std::vector<int>& indices_) {
+  /**
+   * @brief Duplicate vertices per face so that each face has its own normal
+   * @param num_threads  Number of threads (<= 0 : hardware concurrency)
+   */
+  Flatize(const std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f>>& vertices_, const std::vector<int>& indices_, int num_threads = 1) {
     vertices.resize(indices_.size());
     normals.resize(indices_.size());
     indices.resize(indices_.size());
-    for (int i = 0; i < indices_.size(); i += 3) {
-      Eigen::Vector3f v1 = vertices_[indices_[i]];
-      Eigen::Vector3f v2 = vertices_[indices_[i + 1]];
-      Eigen::Vector3f v3 = vertices_[indices_[i + 2]];
 
-      Eigen::Vector3f n = (v2 - v1).cross(v3 - v2);
+    parallel_for_ranges(num_threads, indices_.size() / 3, [&](size_t begin, size_t end) {
+      for (size_t i = begin * 3; i < end * 3; i += 3) {
+        const Eigen::Vector3f n = face_normal(vertices_[indices_[i]], vertices_[indices_[i + 1]], vertices_[indices_[i + 2]]);
 
-      for (int j = 0; j < 3; j++) {
-        vertices[i + j] = vertices_[indices_[i + j]];
-        normals[i + j] = n;
-        indices[i + j] = i + j;
+        for (int j = 0; j < 3; j++) {
+          vertices[i + j] = vertices_[indices_[i + j]];
+          normals[i + j] = n;
+          indices[i + j] = i + j;
+        }
       }
-    }
+    });
   }
 
 public:
@@ -36,23 +74,72 @@ public:
 
 class NormalEstimater {
 public:
-  NormalEstimater(const std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f>>& vertices, const std::vector<int>& indices) {
+  /**
+   * @brief Estimate vertex normals as the sums of the normals of adjacent faces
+   * @param num_threads  Number of threads (<= 0 : hardware concurrency).
+   *                     With multiple threads, normals are gathered through a vertex-face adjacency list instead of being scattered from faces,
+   *                     and face normals are summed in the face order (the result does not depend on the number of threads).
+   */
+  NormalEstimater(const std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f>>& vertices, const std::vector<int>& indices, int num_threads = 1) {
     normals.resize(vertices.size(), Eigen::Vector3f::Zero());
-    for (int i = 0; i < indices.size(); i += 3) {
-      Eigen::Vector3f v1 = vertices[indices[i]];
-      Eigen::Vector3f v2 = vertices[indices[i + 1]];
-      Eigen::Vector3f v3 = vertices[indices[i + 2]];
+    const size_t num_faces = indices.size() / 3;
+
+    if (num_threads == 1) {
+      for (size_t i = 0; i < num_faces * 3; i += 3) {
+        const Eigen::Vector3f n = face_normal(vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]]);
 
-      Eigen::Vector3f n = (v2 - v1).cross(v3 - v2);
+        normals[indices[i]] += n;
+        normals[indices[i + 1]] += n;
+        normals[indices[i + 2]] += n;
+      }
 
-      normals[indices[i]] += n;
-      normals[indices[i + 1]] += n;
-      normals[indices[i + 2]] += n;
+      for (auto& normal : normals) {
+        normal.normalize();
+      }
+      return;
     }
 
-    for (auto& normal : normals) {
-      normal.normalize();
+    // face normals and the number of faces adjacent to each vertex
+    std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f>> face_normals(num_faces);
+    std::unique_ptr<std::atomic_int[]> counts(new std::atomic_int[vertices.size()]());
+    parallel_for_ranges(num_threads, num_faces, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        face_normals[i] = face_normal(vertices[indices[i * 3]], vertices[indices[i * 3 + 1]], vertices[indices[i * 3 + 2]]);
+        for (int j = 0; j < 3; j++) {
+          counts[indices[i * 3 + j]].fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    });
+
+    // vertex-face adjacency list (CSR)
+    std::vector<size_t> offsets(vertices.size() + 1, 0);
+    for (size_t i = 0; i < vertices.size(); i++) {
+      offsets[i + 1] = offsets[i] + counts[i].load(std::memory_order_relaxed);
+      counts[i].store(0, std::memory_order_relaxed);
     }
+
+    std::vector<int> adjacent_faces(offsets.back());
+    parallel_for_ranges(num_threads, num_faces, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        for (int j = 0; j < 3; j++) {
+          const int v = indices[i * 3 + j];
+          adjacent_faces[offsets[v] + counts[v].fetch_add(1, std::memory_order_relaxed)] = i;
+        }
+      }
+    });
+
+    // gather face normals
+    parallel_for_ranges(num_threads, vertices.size(), [&](size_t begin, size_t end) {
+      for (size_t v = begin; v < end; v++) {
+        std::sort(adjacent_faces.begin() + offsets[v], adjacent_faces.begin() + offsets[v + 1]);
+
+        Eigen::Vector3f sum = Eigen::Vector3f::Zero();
+        for (size_t k = offsets[v]; k < offsets[v + 1]; k++) {
+          sum += face_normals[adjacent_faces[k]];
+        }
+        normals[v] = sum.normalized();
+      }
+    });
   }
 
 public:
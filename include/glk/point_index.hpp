@@ -0,0 +1,104 @@
+#ifndef GLK_POINT_INDEX_HPP
+#define GLK_POINT_INDEX_HPP
+
+#include <memory>
+#include <vector>
+#include <Eigen/Core>
+
+namespace glk {
+
+/**
+ * @brief KD-tree over a point set for CPU-side picking and region queries.
+ *        Queries return indices of the original point set that can be directly passed to IndexedPointCloudBuffer.
+ * @note  Points are copied into the index (it does not depend on the original container).
+ */
+class PointIndex {
+public:
+  using Ptr = std::shared_ptr<PointIndex>;
+
+  /**
+   * @brief Build the index
+   * @param points       Points (x, y, z with the given stride in bytes)
+   * @param stride       Stride of points in bytes
+   * @param num_points   Number of points
+   * @param num_threads  Number of threads used to build subtrees (<= 0 : hardware concurrency)
+   */
+  PointIndex(const float* points, int stride, int num_points, int num_threads = 0);
+
+  template <typename Scalar, int Dim, typename Allocator>
+  PointIndex(const std::vector<Eigen::Matrix<Scalar, Dim, 1>, Allocator>& points, int num_threads = 0);
+
+  int size() const { return entries.size(); }
+
+  /**
+   * @brief Find the first point along a ray (e.g., for click picking)
+   * @param origin                Ray origin
+   * @param direction             Ray direction
+   * @param radius                Points closer to the ray than radius are hit
+   * @param radius_per_distance   The radius grows with the distance along the ray (e.g., the size of a pixel at distance 1 for a perspective camera)
+   * @return Index of the hit point with the smallest distance along the ray (-1 if no point is hit)
+   */
+  int pick(const Eigen::Vector3f& origin, const Eigen::Vector3f& direction, float radius, float radius_per_distance = 0.0f) const;
+
+  /// Points in an axis-aligned box
+  std::vector<unsigned int> query_aabb(const Eigen::Vector3f& min, const Eigen::Vector3f& max) const;
+
+  /// Points in an oriented box given as a unit cube [-0.5, 0.5]^3 transformed by model_matrix (e.g., a gizmo-controlled cube)
+  std::vector<unsigned int> query_obb(const Eigen::Matrix4f& model_matrix) const;
+
+  /// Points in the view frustum of projection_view_matrix (i.e., inside of the clip volume)
+  std::vector<unsigned int> query_frustum(const Eigen::Matrix4f& projection_view_matrix) const;
+
+  /**
+   * @brief Points in the view frustum whose projections lie inside of a polygon (lasso selection)
+   * @param projection_view_matrix  Projection * view matrix
+   * @param polygon                 Polygon vertices in normalized device coordinates [-1, 1]
+   */
+  std::vector<unsigned int> query_lasso(const Eigen::Matrix4f& projection_view_matrix, const std::vector<Eigen::Vector2f, Eigen::aligned_allocator<Eigen::Vector2f>>& polygon) const;
+
+  /**
+   * @brief k-nearest neighbor search
+   * @param k_indices   Indices of neighbors (sorted by distance)
+   * @param k_sq_dists  Squared distances to neighbors
+   * @return Number of found neighbors
+   */
+  int knn(const Eigen::Vector3f& query, int k, std::vector<unsigned int>& k_indices, std::vector<float>& k_sq_dists) const;
+
+private:
+  struct Entry {
+    Eigen::Vector3f pt;
+    unsigned int index;
+  };
+
+  struct Node {
+    Eigen::Vector3f min;
+    Eigen::Vector3f max;
+    unsigned int first;
+    unsigned int count;
+  };
+
+  void init(const float* points, int stride, int num_points, int num_threads);
+  void build(int node, int depth, unsigned int first, unsigned int count, int parallel_depth);
+  bool is_leaf(int node) const { return 2 * node + 1 >= static_cast<int>(nodes.size()); }
+
+  // visit(node) returns false to skip the subtree, and leaf(node) processes points of a leaf
+  template <typename Visit, typename Leaf>
+  void traverse(const Visit& visit, const Leaf& leaf) const;
+
+private:
+  std::vector<Entry> entries;  // points sorted in the tree order
+  std::vector<Node> nodes;     // implicit complete binary tree (children of node i are 2i+1 and 2i+2)
+};
+
+template <typename Scalar, int Dim, typename Allocator>
+PointIndex::PointIndex(const std::vector<Eigen::Matrix<Scalar, Dim, 1>, Allocator>& points, int num_threads) {
+  std::vector<Eigen::Vector3f> points_f(points.size());
+  for (size_t i = 0; i < points.size(); i++) {
+    points_f[i] = points[i].template head<3>().template cast<float>();
+  }
+  init(points_f.empty() ? nullptr : points_f.front().data(), sizeof(Eigen::Vector3f), points_f.size(), num_threads);
+}
+
+}  // namespace glk
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef GLK_POINT_SELECTION_BUFFER_HPP
+#define GLK_POINT_SELECTION_BUFFER_HPP
+
+#include <memory>
+#include <vector>
+#include <Eigen/Core>
+#include <glk/drawable.hpp>
+
+namespace glk {
+
+class PointCloudBuffer;
+
+/**
+ * @brief Command layout of glDrawElementsIndirect
+ */
+struct DrawElementsIndirectCommand {
+  GLuint count;
+  GLuint instance_count;
+  GLuint first_index;
+  GLint base_vertex;
+  GLuint base_instance;
+};
+
+/**
+ * @brief GPU point selection. A compute pass (point_selection.comp) tests the points of a PointCloudBuffer against a selection volume
+ *        and appends the indices of selected points to an element buffer with an atomic counter.
+ *        The counter is the count field of an indirect draw command, so the selection is drawn (like IndexedPointCloudBuffer)
+ *        without reading anything back to the CPU.
+ * @note  Requires compute shaders (GL 4.3). The order of selected indices is not deterministic.
+ */
+class PointSelectionBuffer : public glk::Drawable {
+public:
+  using Ptr = std::shared_ptr<PointSelectionBuffer>;
+
+  PointSelectionBuffer(const std::shared_ptr<const glk::PointCloudBuffer>& cloud_buffer);
+  virtual ~PointSelectionBuffer() override;
+
+  // false if the selection shader is not available
+  bool available() const { return selection_shader != nullptr; }
+
+  /**
+   * @brief Select points in an oriented box given as a unit cube [-0.5, 0.5]^3 transformed by model_matrix (e.g., a gizmo-controlled cube)
+   * @param invert  If true, points outside of the volume are selected
+   */
+  void select_obb(const Eigen::Matrix4f& model_matrix, bool invert = false);
+
+  /// Select points in a sphere
+  void select_sphere(const Eigen::Vector3f& center, float radius, bool invert = false);
+
+  /**
+   * @brief Select points in the view frustum whose projections lie inside of a polygon (lasso selection)
+   * @param projection_view_matrix  Projection * view matrix
+   * @param polygon                 Polygon vertices in normalized device coordinates [-1, 1]
+   */
+  void select_lasso(const Eigen::Matrix4f& projection_view_matrix, const std::vector<Eigen::Vector2f, Eigen::aligned_allocator<Eigen::Vector2f>>& polygon, bool invert = false);
+
+  void clear();
+
+  // Number of selected points (reads back the counter and thus stalls the pipeline)
+  int num_selected() const;
+  // Indices of selected points (reads back the element buffer)
+  std::vector<unsigned int> read_indices() const;
+
+  GLuint ebo_id() const { return ebo; }
+  GLuint command_id() const { return command_buffer; }
+
+  virtual void draw(glk::GLSLShader& shader) const override;
+
+private:
+  PointSelectionBuffer(const PointSelectionBuffer&);
+  PointSelectionBuffer& operator=(const PointSelectionBuffer&);
+
+  enum class Mode { OBB = 0, SPHERE = 1, LASSO = 2 };
+  void select(Mode mode, bool invert);
+
+private:
+  std::shared_ptr<const glk::PointCloudBuffer> cloud_buffer;
+  std::unique_ptr<glk::GLSLShader> selection_shader;
+
+  GLuint ebo;             // selected indices
+  GLuint command_buffer;  // DrawElementsIndirectCommand (count is incremented as an atomic counter)
+  GLuint polygon_buffer;  // lasso polygon (vec2)
+  int polygon_capacity;
+};
+
+}  // namespace glk
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef GLK_POINTCLOUD_BATCH_HPP
+#define GLK_POINTCLOUD_BATCH_HPP
+
+#include <vector>
+#include <memory>
+#include <Eigen/Core>
+#include <glk/drawable.hpp>
+#include <glk/atomic_counters.hpp>
+
+namespace glk {
+
+/**
+ * @brief Command layout of glDrawArraysIndirect / glMultiDrawArraysIndirect
+ */
+struct DrawArraysIndirectCommand {
+  GLuint count;
+  GLuint instance_count;
+  GLuint first;
+  GLuint base_instance;
+};
+
+/**
+ * @brief A batch of many small point clouds (e.g., submaps) packed into one buffer and drawn with a single glMultiDrawArraysIndirect.
+ *        Per-cloud model matrices are stored in an SSBO and selected in the vertex shader through the base instance of each command
+ *        (rainbow.vert: batch_enabled, vert_batch_index). Hiding a cloud only edits its indirect command.
+ *
+ *        For spatially chunked maps, GPU culling (enable_gpu_culling()) tests the bounding box of each cloud against the view frustum
+ *        and selects the number of points to draw from its projected size in a compute pass that appends draw commands with an atomic counter,
+ *        so that the CPU cost does not grow with the number of chunks.
+ * @note  With shaders that do not support batching (e.g., phong), clouds are drawn one by one with the model_matrix uniform
+ *        (GPU culling is not applied).
+ */
+class PointCloudBatch : public glk::Drawable {
+public:
+  using Ptr = std::shared_ptr<PointCloudBatch>;
+
+  /**
+   * @brief Constructor
+   * @param with_colors  If true, every cloud must be given per-point colors (vert_color)
+   */
+  PointCloudBatch(bool with_colors = false);
+  virtual ~PointCloudBatch() override;
+
+  /**
+   * @brief Append a point cloud to the batch
+   * @param points        Points (x, y, z with the given stride in bytes)
+   * @param stride        Stride of points in bytes
+   * @param colors        RGBA colors (required if the batch is constructed with with_colors = true)
+   * @param num_points    Number of points
+   * @param model_matrix  Model matrix of the cloud (applied before the model_matrix of the shader setting)
+   * @return Cloud ID
+   * @note   Points are shuffled so that any prefix of the cloud is a uniform subsample (used for LOD when GPU culling is enabled,
+   *         which may be enabled after clouds are added).
+   */
+  int add(const float* points, int stride, const float* colors, int num_points, const Eigen::Matrix4f& model_matrix = Eigen::Matrix4f::Identity());
+
+  template <typename Allocator>
+  int add(const std::vector<Eigen::Vector3f, Allocator>& points, const Eigen::Matrix4f& model_matrix = Eigen::Matrix4f::Identity()) {
+    return add(points.empty() ? nullptr : points.front().data(), sizeof(Eigen::Vector3f), nullptr, points.size(), model_matrix);
+  }
+
+  template <typename Allocator, typename Allocator2>
+  int add(
+    const std::vector<Eigen::Vector3f, Allocator>& points,
+    const std::vector<Eigen::Vector4f, Allocator2>& colors,
+    const Eigen::Matrix4f& model_matrix = Eigen::Matrix4f::Identity()) {
+    return add(points.empty() ? nullptr : points.front().data(), sizeof(Eigen::Vector3f), colors.empty() ? nullptr : colors.front().data(), points.size(), model_matrix);
+  }
+
+  void set_model_matrix(int id, const Eigen::Matrix4f& model_matrix);
+  const Eigen::Matrix4f& get_model_matrix(int id) const { return model_matrices[id]; }
+
+  void set_visible(int id, bool visible);
+  bool is_visible(int id) const { return commands[id].instance_count > 0; }
+
+  int num_clouds() const { return commands.size(); }
+  size_t num_points() const { return total_points; }
+  int num_points(int id) const { return commands[id].count; }
+  int first_point(int id) const { return commands[id].first; }
+
+  /**
+   * @brief Enable GPU frustum culling and LOD selection (requires compute shaders).
+   * @param lod_pixels     Projected radius [pixels] of a cloud above which all of its points are drawn.
+   *                       Smaller clouds are drawn with points in proportion to their projected area (0 disables LOD).
+   * @param min_lod_ratio  Minimum ratio of points drawn for a visible cloud
+   * @return true if GPU culling is available
+   */
+  bool enable_gpu_culling(double lod_pixels = 128.0, double min_lod_ratio = 0.02);
+  void disable_gpu_culling();
+  bool gpu_culling_enabled() const { return culling_shader != nullptr; }
+  // Number of clouds drawn in the last culling pass (reads back the atomic counter and thus stalls the pipeline; for debugging)
+  int num_drawn_clouds() const;
+
+  GLuint vbo_id() const { return vbo; }
+  GLuint cbo_id() const { return cbo; }
+  GLuint matrices_id() const { return matrices_buffer; }
+  GLuint commands_id() const { return commands_buffer; }
+
+  virtual void draw(glk::GLSLShader& shader) const override;
+
+private:
+  PointCloudBatch(const PointCloudBatch&);
+  PointCloudBatch& operator=(const PointCloudBatch&);
+
+  void reserve_points(size_t num_points);
+  void reserve_clouds(size_t num_clouds);
+  void upload() const;
+  void cull(glk::GLSLShader& shader) const;
+
+private:
+  bool with_colors;
+
+  size_t total_points;
+  size_t points_capacity;
+  size_t clouds_capacity;
+
+  std::vector<DrawArraysIndirectCommand> commands;
+  std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f>> model_matrices;
+  std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f>> bounds;  // [min, max] of each cloud in its local frame
+
+  mutable bool commands_dirty;
+  mutable bool matrices_dirty;
+  mutable bool bounds_dirty;
+
+  GLuint vao;
+  GLuint vbo;              // positions (vec3)
+  GLuint cbo;              // colors (vec4)
+  GLuint index_buffer;     // cloud indices [0, 1, ..., N) fetched with the base instance (divisor = 1)
+  GLuint matrices_buffer;  // SSBO of model matrices
+  GLuint commands_buffer;  // indirect commands
+
+  // GPU culling
+  double lod_pixels;
+  double min_lod_ratio;
+  std::unique_ptr<glk::GLSLShader> culling_shader;
+  std::unique_ptr<glk::AtomicCounters> culled_count;  // number of commands written by the culling pass
+  GLuint bounds_buffer;           // SSBO of cloud bounding boxes
+  GLuint culled_commands_buffer;  // commands written by the culling pass
+};
+
+}  // namespace glk
+
+#endif
@@ -7,6 +7,8 @@
 #include <Eigen/Dense>
 #include <glk/drawable.hpp>
 #include <glk/colormap.hpp>
+#include <glk/gpu_memory_tracker.hpp>
+#include <glk/streaming_buffer_arena.hpp>
 
 namespace glk {
 
@@ -15,6 +17,8 @@ struct AuxBufferData {
   int dim;
   int stride;
   GLuint buffer;
+  size_t offset = 0;  // byte offset in the buffer
+  bool owned = true;  // false if the buffer is a StreamingBufferArena range
 };
 
 class PointCloudBuffer : public glk::Drawable {
@@ -23,6 +27,11 @@ public:
 
   PointCloudBuffer(int stride, int num_points);
   PointCloudBuffer(const float* data, int stride, int num_points);
+  /**
+   * @brief Reference per-frame points written in a StreamingBufferArena range (no buffer is allocated).
+   *        The buffer must be re-created every frame because the range is recycled a few frames later.
+   */
+  PointCloudBuffer(const StreamingBufferArena::Range& range, int stride, int num_points);
 
   // Eigen utility constructors
   PointCloudBuffer(const Eigen::Matrix<float, 3, -1>& points);
@@ -63,6 +72,7 @@ public:
   void add_color(const float* data, int stride, int num_points);
   void add_intensity(glk::COLORMAP colormap, const float* data, int stride, int num_points, float scale = 1.0f);
   void add_buffer(const std::string& attribute_name, int dim, const float* data, int stride, int num_points);
+  void add_buffer(const std::string& attribute_name, int dim, const StreamingBufferArena::Range& range, int stride);
 
   void enable_partial_rendering(int points_budget = 8192 * 5);
   void disable_partial_rendering();
@@ -72,14 +82,24 @@ public:
 
   virtual void draw(glk::GLSLShader& shader) const override;
 
+  virtual bool evict() const override;
+  virtual bool evicted() const override { return !evicted_data.empty(); }
+  virtual bool evictable() const override;
+  // Re-upload evicted buffers (called before buffers are accessed directly, e.g., by compute passes)
+  void restore() const;
+
   GLuint vba_id() const;
   GLuint vbo_id() const;
   GLuint ebo_id() const;
+  size_t vbo_offset() const { return vertices_offset; }
+  bool is_streamed() const { return streamed; }
 
   int get_aux_size() const;
+  int get_points_rendering_budget() const { return points_rendering_budget; }
   const AuxBufferData& get_aux_buffer(int i) const;
 
   int size() const { return num_points; }
+  int get_stride() const { return stride; }
 
 private:
   mutable std::atomic_uint rendering_count;
@@ -88,10 +108,18 @@ private:
   GLuint vao;
   GLuint vbo;
   GLuint ebo;
+  size_t vertices_offset;  // byte offset of the points in vbo
+  bool streamed;           // true if vbo is a StreamingBufferArena range (not owned)
   int stride;
   int num_points;
 
   std::vector<AuxBufferData> aux_buffers;
+
+  std::vector<StreamingBufferArena::Range> streamed_ranges;  // arena ranges referenced by vbo and aux_buffers
+  mutable bool expired_warned;                              // true if a warning on expired ranges has been shown
+
+  // CPU copies of [vbo, aux_buffers..., ebo] while the buffers are evicted
+  mutable std::vector<std::shared_ptr<GpuMemoryTracker::EvictedBuffer>> evicted_data;
 };
 
 // template methods
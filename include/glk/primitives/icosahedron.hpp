@@ -1,8 +1,9 @@
 #ifndef GLK_PRIMITIVES_ICOSAHEDRON_HPP
 #define GLK_PRIMITIVES_ICOSAHEDRON_HPP
 
-#include <map>
 #include <vector>
+#include <cstdint>
+#include <unordered_map>
 #include <Eigen/Core>
 
 namespace glk {
@@ -66,7 +67,7 @@ private:
   int insert_middle_point(int v1, int v2) {
     int smaller = std::min(v1, v2);
     int greater = std::max(v1, v2);
-    int key = (smaller << 16) + greater;
+    const std::uint64_t key = (static_cast<std::uint64_t>(smaller) << 32) | static_cast<std::uint32_t>(greater);
 
     auto found = middle_points_cache.find(key);
     if(found != middle_points_cache.end()) {
@@ -85,7 +86,7 @@ public:
   std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f>> normals;
   std::vector<int> indices;
 
-  std::map<int, int> middle_points_cache;
+  std::unordered_map<std::uint64_t, int> middle_points_cache;
 };
 
 }  // namespace glk
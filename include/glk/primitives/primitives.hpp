@@ -1,14 +1,25 @@
 #ifndef GLK_PRIMITIVES_HPP
 #define GLK_PRIMITIVES_HPP
 
+#include <map>
+#include <future>
+#include <vector>
 #include <glk/drawable.hpp>
 
 namespace glk {
 
+struct PrimitiveGeometry;
+
+/**
+ * @brief Shared primitive drawables. Geometry of primitives is generated on the first use, or in advance on background threads
+ *        with prewarm() (guik::LightViewer prewarms all primitives at startup and uploads them as their geometry becomes ready).
+ */
 class Primitives {
 private:
   Primitives() {
     meshes.resize(NUM_PRIMITIVES, nullptr);
+    geometries.resize(NUM_PRIMITIVES);
+    uploads_pending = false;
   }
 
 public:
@@ -30,6 +41,8 @@ public:
     NUM_PRIMITIVES
   };
 
+  static constexpr int MAX_SPHERE_SUBDIVISION_LEVEL = 7;
+
   static Primitives* instance() {
     if(instance_ == nullptr) {
       instance_ = new Primitives();
@@ -53,6 +66,12 @@ public:
     return primitive_ptr(SPHERE);
   }
 
+  /// Icosphere with a given number of subdivisions (SPHERE is level 2). Spheres are cached per level.
+  /// The level is clamped to [0, MAX_SPHERE_SUBDIVISION_LEVEL] (20 * 4^level triangles).
+  static glk::Drawable::ConstPtr sphere(int subdivision_level) {
+    return Primitives::instance()->create_sphere_ptr(subdivision_level, false);
+  }
+
   static glk::Drawable::ConstPtr cube() {
     return primitive_ptr(CUBE);
   }
@@ -81,6 +100,10 @@ public:
     return primitive_ptr(WIRE_SPHERE);
   }
 
+  static glk::Drawable::ConstPtr wire_sphere(int subdivision_level) {
+    return Primitives::instance()->create_sphere_ptr(subdivision_level, true);
+  }
+
   static glk::Drawable::ConstPtr wire_cube() {
     return primitive_ptr(WIRE_CUBE);
   }
@@ -97,14 +120,55 @@ public:
     return primitive_ptr(WIRE_FRUSTUM);
   }
 
+  // Type of a primitive drawable created by this class (NUM_PRIMITIVES if the drawable is not a primitive)
+  static PrimitiveType type_of(const glk::Drawable* drawable) {
+    const auto& meshes = Primitives::instance()->meshes;
+    for (int i = 0; i < meshes.size(); i++) {
+      if (meshes[i] && meshes[i].get() == drawable) {
+        return static_cast<PrimitiveType>(i);
+      }
+    }
+    return NUM_PRIMITIVES;
+  }
+
+  /**
+   * @brief Start generating the geometry of all primitives on background threads
+   * @param wait  If true, wait for the generation and upload all primitives (must be called in the GL thread)
+   */
+  void prewarm(bool wait = false);
+
+  /// Start generating the geometry of a sphere level on a background thread
+  void prewarm_sphere(int subdivision_level);
+
+  /// Create GL objects of primitives whose geometry has been generated in the background (non-blocking, must be called in the GL thread)
+  void upload_prewarmed();
+
+  /// Wait for the background threads started by prewarm() and prewarm_sphere() to finish.
+  /// The instance is never destroyed, so this must be called before exiting (guik::LightViewer calls it on destruction).
+  void wait_prewarm();
+
 private:
+  using GeometryFuture = std::shared_future<std::shared_ptr<const PrimitiveGeometry>>;
+
   const glk::Drawable& create_primitive(PrimitiveType type);
   std::shared_ptr<glk::Drawable> create_primitive_ptr(PrimitiveType type);
 
+  const glk::Drawable& create_sphere(int subdivision_level, bool wireframe);
+  std::shared_ptr<glk::Drawable> create_sphere_ptr(int subdivision_level, bool wireframe);
+
+  GeometryFuture& request_geometry(PrimitiveType type, bool async);
+  GeometryFuture& request_sphere_geometry(int subdivision_level, bool async);
+
 private:
   static Primitives* instance_;
 
   std::vector<std::shared_ptr<glk::Drawable>> meshes;
+  std::vector<GeometryFuture> geometries;  // geometry of each primitive (wireframe primitives share the geometry of solid ones)
+
+  std::map<std::pair<int, bool>, std::shared_ptr<glk::Drawable>> spheres;  // [subdivision_level, wireframe]
+  std::map<int, GeometryFuture> sphere_geometries;
+
+  bool uploads_pending;
 };
 }  // namespace glk
 
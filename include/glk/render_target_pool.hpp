@@ -0,0 +1,52 @@
+#ifndef GLK_RENDER_TARGET_POOL_HPP
+#define GLK_RENDER_TARGET_POOL_HPP
+
+#include <memory>
+#include <vector>
+#include <GL/gl3w.h>
+#include <Eigen/Core>
+
+#include <glk/texture.hpp>
+
+namespace glk {
+
+/**
+ * @brief Pool of render target textures shared by screen effects.
+ *        Effects borrow transient targets for the duration of a pass and return them afterwards
+ *        so that a texture released by a pass can be reused (aliased) by later passes and other effects.
+ *        Free targets that have not been used for a while (e.g., after resizing) are deleted in new_frame().
+ * @note  Targets are matched by size and internal format. The filter mode is reset on every acquisition.
+ */
+class RenderTargetPool {
+public:
+  static RenderTargetPool* instance();
+
+  std::shared_ptr<Texture> acquire(const Eigen::Vector2i& size, GLenum internal_format, GLenum format, GLenum type, GLenum filter_mode = GL_NEAREST);
+  void release(const std::shared_ptr<Texture>& texture);
+
+  // Delete free targets that have not been used in the last max_unused_frames frames
+  void new_frame(int max_unused_frames = 30);
+  void clear();
+
+  int num_targets() const { return targets.size(); }
+  int num_free_targets() const;
+  size_t memory_usage() const;
+
+private:
+  RenderTargetPool();
+  static RenderTargetPool* instance_;
+
+  struct Target {
+    std::shared_ptr<Texture> texture;
+    GLenum internal_format;
+    bool in_use;
+    long last_used;
+  };
+
+  long frame_count;
+  std::vector<Target> targets;
+};
+
+}  // namespace glk
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <GL/gl3w.h>
+#include <glk/gpu_memory_tracker.hpp>
 
 namespace glk {
 
@@ -15,10 +16,12 @@ public:
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
     glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, usage);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, size);
   }
 
   ~ShaderStorageBuffer() {
     glDeleteBuffers(1, &ssbo);
+    GpuMemoryTracker::instance()->remove_all(this);
   }
 
   void reset(size_t size = 0, void* data = nullptr) {
@@ -0,0 +1,141 @@
+#ifndef GLK_STREAMING_BUFFER_ARENA_HPP
+#define GLK_STREAMING_BUFFER_ARENA_HPP
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <GL/gl3w.h>
+
+namespace glk {
+
+/**
+ * @brief Space bookkeeping of StreamingBufferArena (no GL calls).
+ *        Allocations are made in the current frame, and the space of closed frames is released in the order they were closed.
+ *        An allocation that does not fit at the end of the buffer wraps around to the beginning, and the rest of the buffer
+ *        is counted as used by the current frame until the frame is released.
+ */
+class StreamingRing {
+public:
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  StreamingRing(size_t capacity) : ring_capacity(capacity), head(0), used_bytes(0), frame_bytes(0) {}
+
+  size_t capacity() const { return ring_capacity; }
+  size_t used() const { return used_bytes; }         // bytes in flight (including alignment padding)
+  size_t frame_used() const { return frame_bytes; }  // bytes of the current frame
+
+  /// Offset of a new allocation in the current frame (npos if the allocation does not fit until older frames are released)
+  size_t allocate(size_t size, size_t alignment);
+
+  /// Close the current frame and return its bytes (to be passed to release() once the frame is no longer in use)
+  size_t close_frame();
+
+  /// Release the space of the oldest closed frame
+  void release(size_t bytes);
+
+private:
+  size_t ring_capacity;
+  size_t head;         // next write position
+  size_t used_bytes;   // bytes between the oldest in-flight allocation and head
+  size_t frame_bytes;  // bytes allocated in the current frame
+};
+
+/**
+ * @brief Ring buffer for per-frame geometry (e.g., live scans and debug lines that are re-created every frame).
+ *        A large buffer is allocated once with glBufferStorage and persistently mapped (GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT),
+ *        and ranges of it are sub-allocated without any driver allocations. Allocations of a frame are protected with a fence
+ *        inserted in new_frame(), and the space is reused once the GPU has finished the frame.
+ * @note  A range is valid only until its space is recycled (a few frames later), so drawables referencing arena ranges
+ *        must be re-created every frame (drawables refuse to draw expired ranges, see Range::expired()).
+ *        The arena must be used only in the GL thread.
+ */
+class StreamingBufferArena {
+public:
+  /// A sub-allocated range of the arena buffer
+  struct Range {
+    Range() : buffer(0), offset(0), size(0), data(nullptr), arena(nullptr), frame(0) {}
+
+    bool valid() const { return buffer != 0; }
+    /// true if the space of the range has been released and may hold data of later frames
+    bool expired() const;
+
+    GLuint buffer;  // arena buffer
+    size_t offset;  // byte offset in the buffer
+    size_t size;    // size in bytes
+    void* data;     // mapped pointer to the range (writes are visible to the GPU without flushing)
+
+    const StreamingBufferArena* arena;  // arena the range was allocated from
+    std::uint64_t frame;                // frame the range was allocated in (see StreamingBufferArena::new_frame())
+  };
+
+  static StreamingBufferArena* instance();
+
+  /**
+   * @brief Constructor (the buffer is allocated on the first allocation)
+   * @param capacity  Buffer size in bytes
+   */
+  StreamingBufferArena(size_t capacity = 64 * 1024 * 1024);
+  ~StreamingBufferArena();
+
+  // false if glBufferStorage is not supported (GL 4.4 or ARB_buffer_storage is required)
+  bool available() const;
+
+  size_t capacity() const { return ring.capacity(); }
+  size_t used() const { return ring.used(); }  // bytes in flight (including alignment padding)
+
+  std::uint64_t frame() const { return current_frame; }             // frame of new allocations
+  std::uint64_t released_frame() const { return last_released_frame; }  // ranges allocated in this frame or earlier are expired
+
+  /**
+   * @brief Allocate a range. Blocks until the GPU releases space if the ring is full.
+   * @return Allocated range (invalid if the arena is not available or the size exceeds the free space of the current frame)
+   */
+  Range allocate(size_t size, size_t alignment = 16);
+
+  /// Allocate a range and copy data into it
+  Range write(const void* data, size_t size, size_t alignment = 16);
+
+  template <typename T, typename Allocator>
+  Range write(const std::vector<T, Allocator>& data, size_t alignment = 16) {
+    return write(data.data(), sizeof(T) * data.size(), alignment);
+  }
+
+  /// true if any of the ranges has expired
+  static bool expired(const std::vector<Range>& ranges);
+
+  /// Fence the allocations of the current frame and release the space of frames the GPU has finished (called by LightViewer)
+  void new_frame();
+
+private:
+  bool init_buffer();
+  bool retire(bool wait);
+
+private:
+  static StreamingBufferArena* instance_;
+
+  struct Segment {
+    GLsync fence;
+    size_t bytes;
+    std::uint64_t frame;
+  };
+
+  bool init_failed;
+  GLuint buffer;
+  char* mapped;
+
+  StreamingRing ring;
+
+  std::uint64_t current_frame;        // starts at 1 (0 is used by invalid ranges)
+  std::uint64_t last_released_frame;  // newest frame whose space has been released
+
+  std::deque<Segment> segments;  // frames in flight (oldest first)
+};
+
+inline bool StreamingBufferArena::Range::expired() const {
+  return arena && frame <= arena->released_frame();
+}
+
+}  // namespace glk
+
+#endif
@@ -8,6 +8,7 @@
 
 #include <glk/drawable.hpp>
 #include <glk/glsl_shader.hpp>
+#include <glk/streaming_buffer_arena.hpp>
 
 namespace glk {
 
@@ -21,6 +22,14 @@ public:
   ThinLines(const float* vertices, const float* colors, int num_vertices, bool line_strip = false);
   ThinLines(const float* vertices, const float* colors, int num_vertices, const unsigned int* indices, int num_indices, bool line_strip = false);
 
+  /**
+   * @brief Reference per-frame lines written in StreamingBufferArena ranges (no buffer is allocated).
+   *        The object must be re-created every frame because the ranges are recycled a few frames later.
+   * @param vertices  Range of vec3 vertices
+   * @param colors    Range of vec4 colors (can be invalid)
+   */
+  ThinLines(const StreamingBufferArena::Range& vertices, const StreamingBufferArena::Range& colors, int num_vertices, bool line_strip = false);
+
   template <template <class> class Allocator>
   ThinLines(const std::vector<Eigen::Vector3f, Allocator<Eigen::Vector3f>>& vertices, bool line_strip = false);
 
@@ -60,6 +69,13 @@ private:
   GLuint vbo;   // vertices
   GLuint cbo;   // colors
   GLuint ebo;   // indices
+
+  bool streamed;      // true if vbo and cbo are StreamingBufferArena ranges (not owned)
+  size_t vbo_offset;  // byte offset of vertices in vbo
+  size_t cbo_offset;  // byte offset of colors in cbo
+
+  std::vector<StreamingBufferArena::Range> streamed_ranges;  // arena ranges referenced by vbo and cbo
+  mutable bool expired_warned;                              // true if a warning on expired ranges has been shown
 };
 
 // template members
@@ -0,0 +1,132 @@
+#ifndef GLK_UNIFORM_BUFFER_HPP
+#define GLK_UNIFORM_BUFFER_HPP
+
+#include <GL/gl3w.h>
+#include <Eigen/Core>
+#include <glk/gpu_memory_tracker.hpp>
+
+namespace glk {
+
+/**
+ * @brief Fixed binding points of uniform blocks shared by all programs.
+ *        GLSLShader::link_program() binds blocks with the following names to these binding points.
+ */
+enum class UniformBlockBinding : GLuint {
+  FRAME = 0,  // "FrameBlock" : per-frame camera data (see FrameUniformBlock, updated by guik::GLCanvas::bind())
+  LIGHT = 1,  // "LightBlock" : lights of ScreenSpaceLighting
+};
+
+/**
+ * @brief std140 layout of the per-frame uniform block (declared in data/shader/include/frame_block.glsl)
+ *
+ * layout(std140) uniform FrameBlock {
+ *   mat4 view_matrix;
+ *   mat4 inv_view_matrix;
+ *   mat4 projection_matrix;
+ *   mat4 inv_projection_matrix;
+ *   mat4 projection_view_matrix;
+ *   mat4 inv_projection_view_matrix;
+ *   vec4 viewport;         // xy: frame buffer size, zw: 1 / frame buffer size
+ *   vec4 view_point_time;  // xyz: view point, w: time [sec]
+ *   vec4 render_params;    // x: render scale (frame buffer resolution / window resolution), y: partial rendering budget scale, zw: reserved
+ * };
+ */
+struct FrameUniformBlock {
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  Eigen::Matrix4f view_matrix;
+  Eigen::Matrix4f inv_view_matrix;
+  Eigen::Matrix4f projection_matrix;
+  Eigen::Matrix4f inv_projection_matrix;
+  Eigen::Matrix4f projection_view_matrix;
+  Eigen::Matrix4f inv_projection_view_matrix;
+  Eigen::Vector4f viewport;
+  Eigen::Vector4f view_point_time;
+  Eigen::Vector4f render_params;
+};
+
+static_assert(sizeof(FrameUniformBlock) == 64 * 6 + 16 * 3, "FrameUniformBlock must match the std140 layout");
+
+class UniformBuffer {
+public:
+  UniformBuffer(size_t size, const void* data = nullptr, GLenum usage = GL_DYNAMIC_DRAW) {
+    this->size = size;
+
+    glGenBuffers(1, &ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, size, data, usage);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, size);
+  }
+
+  ~UniformBuffer() {
+    glDeleteBuffers(1, &ubo);
+    GpuMemoryTracker::instance()->remove_all(this);
+  }
+
+  GLuint id() const { return ubo; }
+  size_t buffer_size() const { return size; }
+
+  void update(const void* data, size_t size = 0, size_t offset = 0) {
+    if(size == 0) {
+      size = this->size - offset;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+
+  void bind(GLuint index) const {
+    glBindBufferBase(GL_UNIFORM_BUFFER, index, ubo);
+  }
+
+  void bind(UniformBlockBinding binding) const {
+    bind(static_cast<GLuint>(binding));
+  }
+
+  void unbind(GLuint index) const {
+    glBindBufferBase(GL_UNIFORM_BUFFER, index, 0);
+  }
+
+private:
+  size_t size;
+  GLuint ubo;
+};
+
+namespace detail {
+inline FrameUniformBlock& bound_frame_block_copy() {
+  static FrameUniformBlock block = [] {
+    FrameUniformBlock block;
+    block.view_matrix = block.inv_view_matrix = block.projection_matrix = block.inv_projection_matrix = Eigen::Matrix4f::Identity();
+    block.projection_view_matrix = block.inv_projection_view_matrix = Eigen::Matrix4f::Identity();
+    block.viewport.setOnes();
+    block.view_point_time.setZero();
+    block.render_params << 1.0f, 1.0f, 0.0f, 0.0f;
+    return block;
+  }();
+  return block;
+}
+}  // namespace detail
+
+/**
+ * @brief Bind a frame uniform block buffer to UniformBlockBinding::FRAME and record the CPU copy of its content
+ * @param buffer  Uniform buffer holding `block`
+ * @param block   Content of the buffer
+ */
+inline void bind_frame_block(const UniformBuffer& buffer, const FrameUniformBlock& block) {
+  buffer.bind(UniformBlockBinding::FRAME);
+  detail::bound_frame_block_copy() = block;
+}
+
+/**
+ * @brief CPU copy of the frame uniform block currently bound to UniformBlockBinding::FRAME (see bind_frame_block()).
+ *        Drawables that need frame parameters on the CPU side (e.g., draw counts) read them from here.
+ */
+inline const FrameUniformBlock& bound_frame_block() {
+  return detail::bound_frame_block_copy();
+}
+
+}  // namespace glk
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef GLK_VOXELMAP_BUFFER_HPP
+#define GLK_VOXELMAP_BUFFER_HPP
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <Eigen/Core>
+#include <glk/colormap.hpp>
+#include <glk/drawable.hpp>
+
+namespace glk {
+
+/**
+ * @brief Incrementally downsampled point map for streaming scans.
+ *        Points are inserted in batches into a hashed voxel grid that keeps one representative point per voxel,
+ *        and only newly occupied (and updated) voxels are uploaded into growable GPU buffers.
+ */
+class VoxelMapBuffer : public glk::Drawable {
+public:
+  using Ptr = std::shared_ptr<VoxelMapBuffer>;
+
+  /// Representative point of a voxel
+  enum class Representative {
+    FIRST,     // the first point inserted into the voxel (voxels are never re-uploaded)
+    CENTROID,  // the mean of points (and colors and intensities) in the voxel
+    LATEST     // the last point inserted into the voxel
+  };
+
+  /**
+   * @brief Constructor
+   * @param resolution      Voxel size
+   * @param representative  Representative point of each voxel
+   */
+  VoxelMapBuffer(double resolution, Representative representative = Representative::FIRST);
+  virtual ~VoxelMapBuffer() override;
+
+  /**
+   * @brief Insert a batch of points. Non-finite points and points whose voxel coordinates do not fit in int are skipped.
+   * @param points       Points (x, y, z with the given stride in bytes)
+   * @param stride       Stride of points in bytes
+   * @param num_points   Number of points
+   * @param colors       RGBA colors (nullptr if not available)
+   * @param intensities  Intensities (nullptr if not available). Voxels without colors are colored with the intensity colormap.
+   */
+  void insert(const float* points, int stride, int num_points, const float* colors = nullptr, const float* intensities = nullptr);
+
+  template <typename Allocator>
+  void insert(const std::vector<Eigen::Vector3f, Allocator>& points) {
+    insert(points.empty() ? nullptr : points.front().data(), sizeof(Eigen::Vector3f), points.size());
+  }
+
+  template <typename Allocator, typename Allocator2>
+  void insert(const std::vector<Eigen::Vector3f, Allocator>& points, const std::vector<Eigen::Vector4f, Allocator2>& colors) {
+    insert(points.empty() ? nullptr : points.front().data(), sizeof(Eigen::Vector3f), points.size(), colors.empty() ? nullptr : colors.front().data());
+  }
+
+  template <typename Allocator>
+  void insert(const std::vector<Eigen::Vector3f, Allocator>& points, const std::vector<float>& intensities) {
+    insert(points.empty() ? nullptr : points.front().data(), sizeof(Eigen::Vector3f), points.size(), nullptr, intensities.empty() ? nullptr : intensities.data());
+  }
+
+  /// Colormap for voxels with intensities (applied to voxels inserted or updated afterwards)
+  void set_intensity_colormap(glk::COLORMAP colormap, float scale = 1.0f);
+
+  void clear();
+
+  double resolution() const { return voxel_resolution; }
+  int size() const { return voxel_points.size(); }
+  const std::vector<Eigen::Vector3f>& points() const { return voxel_points; }
+
+  virtual void draw(glk::GLSLShader& shader) const override;
+
+private:
+  VoxelMapBuffer(const VoxelMapBuffer&);
+  VoxelMapBuffer& operator=(const VoxelMapBuffer&);
+
+  void mark_dirty(size_t voxel);
+  void upload() const;
+
+private:
+  struct VoxelHash {
+    size_t operator()(const Eigen::Vector3i& x) const {
+      // spatial hashing (Teschner et al., 2003)
+      return (static_cast<size_t>(x[0]) * 73856093) ^ (static_cast<size_t>(x[1]) * 19349669) ^ (static_cast<size_t>(x[2]) * 83492791);
+    }
+  };
+
+  double voxel_resolution;
+  double inv_resolution;
+  Representative representative;
+
+  glk::COLORMAP intensity_colormap;
+  float intensity_scale;
+
+  std::unordered_map<Eigen::Vector3i, int, VoxelHash> voxels;  // voxel coord -> voxel index
+
+  bool with_colors;
+  std::vector<int> num_voxel_points;  // number of points inserted into each voxel
+  std::vector<Eigen::Vector3f> voxel_points;
+  std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f>> voxel_colors;
+  std::vector<float> voxel_intensities;  // NaN for voxels without intensities
+
+  // voxels modified after the last upload (uploaded as merged runs of sorted indices)
+  mutable std::vector<int> dirty_voxels;
+  mutable std::vector<bool> dirty_flags;
+  mutable size_t capacity;
+
+  mutable GLuint vao;  // created on the first draw (inserting points does not require a GL context)
+  mutable GLuint vbo;  // positions (vec3)
+  mutable GLuint cbo;  // colors (vec4)
+};
+
+}  // namespace glk
+
+#endif
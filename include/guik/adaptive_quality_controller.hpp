@@ -0,0 +1,70 @@
+#ifndef GUIK_ADAPTIVE_QUALITY_CONTROLLER_HPP
+#define GUIK_ADAPTIVE_QUALITY_CONTROLLER_HPP
+
+#include <vector>
+#include <GL/gl3w.h>
+#include <glk/effects/screen_effect.hpp>
+
+namespace guik {
+
+/**
+ * @brief Adjusts rendering quality knobs of a canvas to keep its GPU frame time within a budget.
+ *        The GPU time between GLCanvas::bind() and unbind() is measured with GL_TIMESTAMP queries that are
+ *        collected a few frames later (never blocks). The quality level is lowered when the smoothed frame time
+ *        exceeds the target and raised again when it falls well below the target.
+ */
+class AdaptiveQualityController {
+public:
+  /// Knobs of a quality level
+  struct Settings {
+    double render_scale;                     // scale of the canvas frame buffer with respect to the window size
+    glk::ScreenEffectQuality effect_quality;  // screen effect quality
+    double points_budget_scale;              // scale of the partial rendering points budget
+  };
+
+  AdaptiveQualityController(double target_frame_time_msec = 16.6, int num_frames_in_flight = 4);
+  ~AdaptiveQualityController();
+
+  void set_target_frame_time(double msec);
+  double target_frame_time() const { return target_msec; }
+
+  // frame control (called by GLCanvas)
+  void begin_frame();
+  void end_frame();
+
+  /**
+   * @brief Collect finished timer queries and update the quality level
+   * @return true if the quality level has been changed
+   */
+  bool update();
+
+  int level() const { return current_level; }
+  int num_levels() const { return levels.size(); }
+  double gpu_time() const { return smoothed_msec; }  // smoothed GPU frame time [msec] (negative if not measured yet)
+  const Settings& settings() const { return levels[current_level]; }
+
+private:
+  struct FrameSlot {
+    GLuint queries[2];
+    bool pending;
+  };
+
+  double target_msec;
+  double raise_ratio;     // quality is raised when the frame time is below target * raise_ratio
+  double smoothing;       // weight of a new measurement in the exponential moving average
+  int lower_cooldown;     // frames to wait after lowering the quality
+  int raise_cooldown;     // frames to wait after raising the quality
+
+  std::vector<Settings> levels;
+  int current_level;
+  int cooldown;
+
+  std::vector<FrameSlot> slots;
+  long frame_index;
+  bool measuring;
+  double smoothed_msec;
+};
+
+}  // namespace guik
+
+#endif
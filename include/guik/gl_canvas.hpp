@@ -6,6 +6,7 @@
 #include <glk/colormap.hpp>
 #include <glk/glsl_shader.hpp>
 #include <glk/frame_buffer.hpp>
+#include <glk/uniform_buffer.hpp>
 #include <glk/texture_renderer.hpp>
 #include <glk/effects/screen_effect.hpp>
 
@@ -14,11 +15,14 @@
 
 namespace guik {
 
+class AdaptiveQualityController;
+
 class GLCanvas {
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
   GLCanvas(const Eigen::Vector2i& size, const std::string& shader_name = "rainbow");
+  ~GLCanvas();
 
   bool ready() const;
   bool load_shader(const std::string& shader_name);
@@ -30,6 +34,25 @@ public:
   const std::shared_ptr<glk::ScreenEffect>& get_effect() const;
   void set_bg_texture(const std::shared_ptr<glk::Texture>& bg_texture);
 
+  /**
+   * @brief Set the scale of the internal frame buffer (and screen effect targets) with respect to the canvas size.
+   *        The rendering result is upscaled to the canvas size in render_to_screen().
+   * @param scale  Render scale [0.25, 2.0]
+   */
+  void set_render_scale(double scale);
+  double get_render_scale() const;
+  // Size of the internal frame buffer (canvas size x render scale x adaptive quality scale)
+  Eigen::Vector2i render_size() const;
+
+  /**
+   * @brief Adjust the render scale, screen effect quality, and partial rendering budgets to keep the GPU frame time within a budget
+   * @param target_frame_time_msec  Target GPU frame time [msec]
+   */
+  void enable_adaptive_quality(double target_frame_time_msec = 16.6);
+  void disable_adaptive_quality();
+  bool adaptive_quality_enabled() const;
+  const AdaptiveQualityController* adaptive_quality() const;
+
   void enable_normal_buffer();
   void enable_info_buffer();
   void enable_partial_rendering(double clear_thresh = 1e-6);
@@ -52,7 +75,17 @@ public:
   void bind_second();
   void unbind_second();
 
+  /**
+   * @brief Draw a color buffer to the current frame buffer (screen).
+   *        If the render scale is not 1, the main color buffer is upscaled with a depth-aware filter
+   *        (or downscaled with a box filter when supersampling).
+   */
   void render_to_screen(int color_buffer_id = 0);
+  /**
+   * @brief Get the main color buffer resampled to the canvas size (e.g., for screenshots).
+   *        With a render scale larger than 1, this gives a supersampled (anti-aliased) image.
+   */
+  const glk::Texture& resolve_color_buffer();
 
   Eigen::Vector4i pick_info(const Eigen::Vector2i& p, int window = 2) const;
   float pick_depth(const Eigen::Vector2i& p, int window = 2) const;
@@ -60,9 +93,17 @@ public:
 
   void draw_ui();
 
+private:
+  void resize_buffers();
+  void update_frame_block(const Eigen::Matrix4f& view_matrix, const Eigen::Matrix4f& projection_matrix);
+  void draw_resampled();
+  void apply_quality_settings();
+  Eigen::Vector2i window_to_render(const Eigen::Vector2i& p) const;
+
 public:
   Eigen::Vector2i size;
   Eigen::Vector4f clear_color;
+  double render_scale;
 
   int normal_buffer_id;
   int info_buffer_id;
@@ -74,7 +115,11 @@ public:
   std::unique_ptr<glk::GLSLShader> shader;
   std::unique_ptr<glk::GLSLShader> texture_shader;
   std::unique_ptr<glk::GLSLShader> partial_clear_shader;
+  std::unique_ptr<glk::GLSLShader> resample_shader;
   std::unique_ptr<glk::FrameBuffer> frame_buffer;
+  std::unique_ptr<glk::FrameBuffer> resolve_buffer;
+  std::unique_ptr<glk::UniformBuffer> frame_block;  // per-frame uniform block (glk::FrameUniformBlock)
+  glk::FrameUniformBlock frame_block_data;          // content of frame_block
   std::unique_ptr<glk::FrameBuffer> screen_effect_buffer;
   std::shared_ptr<glk::ScreenEffect> screen_effect;
   std::unique_ptr<glk::TextureRenderer> texture_renderer;
@@ -83,6 +128,9 @@ public:
   std::unique_ptr<glk::Texture> colormap;
   std::shared_ptr<guik::CameraControl> camera_control;
   std::shared_ptr<guik::ProjectionControl> projection_control;
+
+  std::unique_ptr<AdaptiveQualityController> quality_controller;
+  glk::ScreenEffectQuality user_effect_quality;  // effect quality to restore when adaptive quality is disabled
 };
 
 }  // namespace guik
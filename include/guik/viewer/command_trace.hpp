@@ -0,0 +1,98 @@
+#ifndef GUIK_COMMAND_TRACE_HPP
+#define GUIK_COMMAND_TRACE_HPP
+
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <unordered_map>
+
+#include <glk/drawable.hpp>
+#include <guik/viewer/shader_setting.hpp>
+
+namespace guik {
+
+class CameraControl;
+class ProjectionControl;
+class LightViewerContext;
+
+/**
+ * @brief Records the drawable command stream of a viewer (update_drawable / remove_drawable / clear),
+ *        the camera state, and frame boundaries into a compact binary trace.
+ *
+ *        Geometry payloads are read back from GPU buffers when a drawable is registered for the first time.
+ *        Supported drawables are glk::PointCloudBuffer, glk::Mesh, and glk::Primitives.
+ *        Other drawable types are recorded as placeholders and skipped on replay.
+ * @note  Record methods read back GPU buffers and thus must be called in the thread that owns the GL context.
+ */
+class CommandRecorder {
+public:
+  CommandRecorder(const std::string& filename);
+  ~CommandRecorder();
+
+  bool ok() const { return static_cast<bool>(ofs); }
+  long num_frames() const { return frame_count; }
+
+  void record_update(const std::string& name, const glk::Drawable::ConstPtr& drawable, const ShaderSetting& shader_setting);
+  void record_remove(const std::string& name);
+  void record_clear();
+  // Marks the beginning of a frame (the camera state is recorded only when it has changed)
+  void record_frame(const Eigen::Vector2i& canvas_size, const CameraControl& camera_control, const ProjectionControl& projection_control);
+
+private:
+  std::uint32_t record_geometry(const glk::Drawable::ConstPtr& drawable);
+  void write_header(std::uint8_t type);
+
+private:
+  std::mutex mutex;
+  std::ofstream ofs;
+  const std::chrono::steady_clock::time_point start_time;
+
+  long frame_count;
+  std::string last_camera_state;
+
+  std::uint32_t geometry_count;
+  // drawable -> (weak reference to detect address reuse, geometry ID)
+  std::unordered_map<const glk::Drawable*, std::pair<std::weak_ptr<const glk::Drawable>, std::uint32_t>> geometry_ids;
+};
+
+/**
+ * @brief Replays a trace recorded by CommandRecorder on a viewer context.
+ */
+class CommandReplayer {
+public:
+  CommandReplayer(const std::string& filename);
+  ~CommandReplayer();
+
+  bool ok() const { return static_cast<bool>(ifs); }
+  long num_frames() const { return frame_count; }
+  int num_unsupported_drawables() const { return unsupported_count; }
+  // canvas size at the last replayed frame
+  const Eigen::Vector2i& recorded_canvas_size() const { return canvas_size; }
+
+  /**
+   * @brief Apply commands until the next frame boundary.
+   * @param context  Viewer context to apply commands to
+   * @return         false if the trace reached the end
+   */
+  bool next_frame(LightViewerContext* context);
+
+  // Apply commands without rendering until num_frames() reaches the given number (used to jump to a frame of interest)
+  bool seek(LightViewerContext* context, long frame);
+
+private:
+  glk::Drawable::ConstPtr read_geometry();
+  void apply_camera(LightViewerContext* context, const std::string& camera_state);
+
+private:
+  std::ifstream ifs;
+  long frame_count;
+  int unsupported_count;
+  Eigen::Vector2i canvas_size;
+  std::unordered_map<std::uint32_t, glk::Drawable::ConstPtr> geometries;
+};
+
+}  // namespace guik
+
+#endif
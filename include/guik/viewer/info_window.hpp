@@ -1,8 +1,9 @@
 #ifndef GUIK_INFO_WINDOW_HPP
 #define GUIK_INFO_WINDOW_HPP
 
-#include <future>
+#include <memory>
 #include <guik/viewer/light_viewer.hpp>
+#include <guik/viewer/system_monitor.hpp>
 
 namespace guik {
 
@@ -14,17 +15,18 @@ public:
   bool draw_ui();
 
 private:
-  std::string get_cpu_info() const;
-  std::string get_gpu_info() const;
+  void draw_cpu_ui();
+  void draw_gpu_ui();
+  void draw_profiler_ui();
 
 private:
-  bool show_cpu_info;
-  std::string cpu_info;
-  std::future<std::string> async_cpu_info;
+  std::unique_ptr<SystemMonitor> monitor;
 
+  bool show_cpu_info;
   bool show_gpu_info;
-  std::string gpu_info;
-  std::future<std::string> async_gpu_info;
+
+  bool show_profiler;
+  bool plot_gpu_time;
 };
 }
 
@@ -14,6 +14,7 @@
 #include <guik/camera/projection_control.hpp>
 #include <guik/viewer/shader_setting.hpp>
 #include <guik/viewer/anonymous.hpp>
+#include <guik/viewer/command_trace.hpp>
 
 namespace guik {
 
@@ -50,10 +51,17 @@ public:
   void enable_normal_buffer();
   void enable_info_buffer();
   void enable_partial_rendering(double clear_thresh = 1e-6);
+  // see GLCanvas::set_render_scale()
+  void set_render_scale(double scale);
+  double get_render_scale() const;
+  // see GLCanvas::enable_adaptive_quality()
+  void enable_adaptive_quality(double target_frame_time_msec = 16.6);
+  void disable_adaptive_quality();
 
   bool normal_buffer_enabled() const;
   bool info_buffer_enabled() const;
   bool partial_rendering_enabled() const;
+  bool adaptive_quality_enabled() const;
 
   const glk::Texture& color_buffer() const;
   const glk::Texture& depth_buffer() const;
@@ -69,6 +77,17 @@ public:
   void remove_drawable(const std::regex& regex);
   void update_drawable(const std::string& name, const glk::Drawable::ConstPtr& drawable, const ShaderSetting& shader_setting = ShaderSetting());
 
+  // GPU memory usage of each drawable [bytes]
+  std::unordered_map<std::string, size_t> drawable_memory_usage() const;
+  // When the total tracked GPU memory exceeds the budget, GPU buffers of drawables that have not been drawn recently are evicted (0 = no budget)
+  void set_gpu_memory_budget(size_t budget_bytes);
+  size_t get_gpu_memory_budget() const { return gpu_memory_budget; }
+
+  // Record drawable updates, camera states, and frame boundaries into a binary trace (see guik::CommandReplayer for replaying)
+  bool start_recording(const std::string& filename);
+  void stop_recording();
+  bool recording() const { return static_cast<bool>(recorder); }
+
   void clear_drawable_filters();
   void register_drawable_filter(const std::string& filter_name, const std::function<bool(const std::string&)>& filter = 0);
 
@@ -94,6 +113,9 @@ public:
   float pick_depth(const Eigen::Vector2i& p, int window = 2) const;
   Eigen::Vector3f unproject(const Eigen::Vector2i& p, float depth) const;
 
+protected:
+  void evict_drawables();
+
 protected:
   std::string context_name;
   Eigen::Vector2i canvas_rect_min;
@@ -106,6 +128,12 @@ protected:
 
   Eigen::Matrix4f last_projection_view_matrix;
 
+  long frame_count;
+  size_t gpu_memory_budget;
+  std::unordered_map<std::string, long> drawable_last_drawn;
+
+  std::unique_ptr<CommandRecorder> recorder;
+
   std::unordered_map<std::string, std::function<bool(const std::string&)>> drawable_filters;
   std::unordered_map<std::string, std::pair<ShaderSetting::Ptr, glk::Drawable::ConstPtr>> drawables;
 
@@ -0,0 +1,64 @@
+#ifndef GUIK_SYSTEM_MONITOR_HPP
+#define GUIK_SYSTEM_MONITOR_HPP
+
+#include <deque>
+#include <chrono>
+#include <cstdint>
+
+namespace guik {
+
+/**
+ * @brief In-process CPU/memory/GPU memory sampler.
+ *        CPU and memory stats are read from /proc/stat, /proc/meminfo, and /proc/self/status.
+ *        GPU memory stats are obtained through GL_NVX_gpu_memory_info or GL_ATI_meminfo if available.
+ * @note  sample() must be called in the thread that owns the GL context.
+ */
+class SystemMonitor {
+public:
+  struct Sample {
+    double time;                  // [sec] since the monitor construction
+    double cpu_usage;             // [%] system-wide CPU usage (negative if unavailable)
+    std::int64_t mem_total_kb;    // system memory
+    std::int64_t mem_used_kb;     // MemTotal - MemAvailable
+    std::int64_t process_rss_kb;  // VmRSS of this process
+    std::int64_t gpu_total_kb;    // dedicated video memory (NVX only, -1 if unavailable)
+    std::int64_t gpu_free_kb;     // currently available video memory (-1 if unavailable)
+  };
+
+  SystemMonitor(double interval_sec = 0.5, int max_history = 240);
+  ~SystemMonitor();
+
+  // take a new sample if the sampling interval has elapsed since the last sample
+  bool update();
+  // take a new sample immediately
+  const Sample& sample();
+
+  bool empty() const { return samples.empty(); }
+  const Sample& latest() const { return samples.back(); }
+  const std::deque<Sample>& history() const { return samples; }
+
+  bool gpu_memory_info_available() const { return gl_nvx_meminfo || gl_ati_meminfo; }
+
+private:
+  bool read_cpu_jiffies(std::uint64_t& busy, std::uint64_t& total) const;
+  void read_meminfo(Sample& sample) const;
+  void read_process_status(Sample& sample) const;
+  void read_gpu_meminfo(Sample& sample) const;
+
+private:
+  const double interval_sec;
+  const int max_history;
+  const std::chrono::steady_clock::time_point start_time;
+
+  bool gl_nvx_meminfo;
+  bool gl_ati_meminfo;
+
+  std::uint64_t last_busy_jiffies;
+  std::uint64_t last_total_jiffies;
+
+  std::deque<Sample> samples;
+};
+
+}  // namespace guik
+
+#endif
@@ -140,7 +140,12 @@ int main(int argc, char** argv) {
   auto effect = std::make_shared<glk::ScreenSpaceLighting>(viewer->canvas_size());
   viewer->set_screen_effect(effect);
 
-  viewer->register_ui_callback("normal_texture", [&] { ImGui::Image((void*)effect->normal().id(), ImVec2(1920 / 4, 1080 / 4), ImVec2(0, 1), ImVec2(1, 0)); });
+  // the normal texture is octahedral encoded (RG = encoded normal), so it is not shown as an RGB normal map
+  viewer->register_ui_callback("normal_texture", [&] {
+    ImGui::Begin("normal (octahedral encoded)", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+    ImGui::Image((void*)effect->normal().id(), ImVec2(1920 / 4, 1080 / 4), ImVec2(0, 1), ImVec2(1, 0));
+    ImGui::End();
+  });
 
   Eigen::Isometry3f pose = Eigen::Isometry3f::Identity();
   for(int i = 1; i < kitti.size() && !viewer->closed(); i++) {
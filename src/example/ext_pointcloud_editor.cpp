@@ -1,4 +1,5 @@
 #include <glk/io/ply_io.hpp>
+#include <glk/point_index.hpp>
 #include <glk/pointcloud_buffer.hpp>
 #include <glk/indexed_pointcloud_buffer.hpp>
 #include <glk/primitives/primitives.hpp>
@@ -36,6 +37,7 @@ private:
       // Show points on the viewer
       if (!points.empty()) {
         cloud_buffer = std::make_shared<glk::PointCloudBuffer>(points);
+        point_index = std::make_shared<glk::PointIndex>(points);
         viewer->update_drawable("points", cloud_buffer, guik::Rainbow());
       }
     }
@@ -55,18 +57,19 @@ private:
     viewer->update_drawable("cube", glk::Primitives::cube(), guik::FlatColor({1.0f, 0.5f, 0.0f, 0.5f}, cube_matrix->model_matrix()).make_transparent());
 
     // Find points in the filtering area
-    if (ImGui::Button("Select points")) {
-      // The inverse of the cube model matrix transforms world points in the cube coordinate system
-      Eigen::Matrix4f inv_cube_matrix = cube_matrix->model_matrix().inverse();
+    if (ImGui::Button("Select points") && point_index) {
+      // Points in the unit cube [(-0.5, -0.5, -0.5), (0.5, 0.5, 0.5)] transformed by the cube model matrix
+      // The KD-tree skips subtrees outside of the cube and takes subtrees inside of it without testing points one by one
+      selected_points = point_index->query_obb(cube_matrix->model_matrix());
+
+      std::vector<bool> selected(points.size(), false);
+      for (const auto i : selected_points) {
+        selected[i] = true;
+      }
 
-      selected_points.clear();
       neg_selected_points.clear();
       for (int i = 0; i < points.size(); i++) {
-        Eigen::Vector3f pt = (Eigen::Affine3f(inv_cube_matrix) * points[i]);
-        // Points in [(-0.5, -0.5, -0.5), (0.5, 0.5, 0.5)] are inside of the cube
-        if ((pt.array() > Eigen::Array3f::Constant(-0.5f)).all() && (pt.array() < Eigen::Array3f::Constant(0.5f)).all()) {
-          selected_points.emplace_back(i);
-        } else {
+        if (!selected[i]) {
           neg_selected_points.emplace_back(i);
         }
       }
@@ -86,6 +89,7 @@ private:
       neg_selected_points.clear();
 
       cloud_buffer = std::make_shared<glk::PointCloudBuffer>(points);
+      point_index = std::make_shared<glk::PointIndex>(points);
       viewer->update_drawable("points", cloud_buffer, guik::Rainbow());
       viewer->remove_drawable("selected");
     }
@@ -98,6 +102,7 @@ private:
 
   std::vector<Eigen::Vector3f> points;                  // Point cloud
   std::shared_ptr<glk::PointCloudBuffer> cloud_buffer;  // CloudBuffer of points
+  std::shared_ptr<glk::PointIndex> point_index;         // KD-tree of points
   std::vector<unsigned int> selected_points;            // Selected points
   std::vector<unsigned int> neg_selected_points;        // Negative of selected points
 };
@@ -1,6 +1,7 @@
 #include <random>
 #include <iostream>
 #include <glk/path.hpp>
+#include <glk/frame_profiler.hpp>
 #include <glk/console_colors.hpp>
 #include <glk/effects/screen_effect.hpp>
 #include <glk/effects/naive_screen_space_ambient_occlusion.hpp>
@@ -33,6 +34,8 @@ NaiveScreenSpaceAmbientOcclusion::NaiveScreenSpaceAmbientOcclusion() {
 NaiveScreenSpaceAmbientOcclusion::~NaiveScreenSpaceAmbientOcclusion() {}
 
 void NaiveScreenSpaceAmbientOcclusion::draw(const TextureRenderer& renderer, const glk::Texture& color_texture, const glk::Texture& depth_texture, const TextureRendererInput::Ptr& input, glk::FrameBuffer* frame_buffer) {
+  FrameProfiler::Scope prof_scope("naive_ssao");
+
   if(frame_buffer) {
     frame_buffer->bind();
   }
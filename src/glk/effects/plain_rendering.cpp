@@ -1,5 +1,6 @@
 #include <iostream>
 #include <glk/path.hpp>
+#include <glk/frame_profiler.hpp>
 #include <glk/effects/screen_effect.hpp>
 #include <glk/effects/plain_rendering.hpp>
 
@@ -22,6 +23,8 @@ void PlainRendering::draw(const TextureRenderer& renderer, const glk::Texture& c
 }
 
 void PlainRendering::draw(const TextureRenderer& renderer, const glk::Texture& color_texture, const glk::Texture& depth_texture, const TextureRendererInput::Ptr& input, glk::FrameBuffer* frame_buffer) {
+  FrameProfiler::Scope prof_scope("plain");
+
   if(frame_buffer) {
     frame_buffer->bind();
   }
@@ -1,6 +1,7 @@
 #include <random>
 #include <iostream>
 #include <glk/path.hpp>
+#include <glk/frame_profiler.hpp>
 #include <glk/frame_buffer.hpp>
 #include <glk/effects/screen_effect.hpp>
 
@@ -22,7 +23,25 @@ void ScreenSpaceAmbientOcclusion::set_size(const Eigen::Vector2i& size) {
   ssae->set_size(size);
 }
 
+void ScreenSpaceAmbientOcclusion::set_quality(const ScreenEffectQuality& quality) {
+  ssae->set_quality(quality);
+}
+
+ScreenEffectQuality ScreenSpaceAmbientOcclusion::get_quality() const {
+  return ssae->get_quality();
+}
+
+void ScreenSpaceAmbientOcclusion::set_occlusion_downsample(int downsample) {
+  ssae->set_occlusion_downsample(downsample);
+}
+
+void ScreenSpaceAmbientOcclusion::set_temporal_occlusion(bool temporal_occlusion) {
+  ssae->set_temporal_occlusion(temporal_occlusion);
+}
+
 void ScreenSpaceAmbientOcclusion::draw(const TextureRenderer& renderer, const glk::Texture& color_texture, const glk::Texture& depth_texture, const TextureRendererInput::Ptr& input, glk::FrameBuffer* frame_buffer) {
+  FrameProfiler::Scope prof_scope("ssao");
+
   ssae->draw(renderer, color_texture, depth_texture, input, frame_buffer);
 
   if(frame_buffer) {
@@ -1,8 +1,11 @@
+#include <cmath>
 #include <random>
 #include <iostream>
+#include <algorithm>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include <glk/path.hpp>
+#include <glk/frame_profiler.hpp>
 #include <glk/frame_buffer.hpp>
 #include <glk/console_colors.hpp>
 #include <glk/effects/screen_scape_attribute_estimation.hpp>
@@ -10,6 +13,14 @@
 namespace glk {
 
 ScreenSpaceAttributeEstimation::ScreenSpaceAttributeEstimation(const Eigen::Vector2i& size, BufferType rendering_type) {
+  occlusion_downsample = 1;
+  temporal_occlusion = false;
+  history_index = 0;
+  history_valid = false;
+  frame_count = 0;
+  last_projection_view_matrix.setIdentity();
+  last_view_point.setZero();
+
   if(!texture_shader.init(get_data_path() + "/shader/texture.vert", get_data_path() + "/shader/texture.frag")) {
     return;
   }
@@ -30,6 +41,14 @@ ScreenSpaceAttributeEstimation::ScreenSpaceAttributeEstimation(const Eigen::Vect
     return;
   }
 
+  if(!temporal_shader.init(get_data_path() + "/shader/texture.vert", get_data_path() + "/shader/ssae_ao_temporal.frag")) {
+    return;
+  }
+
+  if(!upsample_shader.init(get_data_path() + "/shader/texture.vert", get_data_path() + "/shader/ssae_upsample.frag")) {
+    return;
+  }
+
   set_size(size);
   smooth_normal = true;
   this->rendering_type = rendering_type;
@@ -82,6 +101,7 @@ ScreenSpaceAttributeEstimation::ScreenSpaceAttributeEstimation(const Eigen::Vect
   occlusion_shader.set_uniform("randomization_sampler", 3);
   occlusion_shader.set_uniform("ao_radius", 0.05f);
   occlusion_shader.set_uniform("random_vectors", random_vectors);
+  occlusion_shader.set_uniform("num_samples", static_cast<int>(random_vectors.size()));
 
   bilateral_shader.use();
   bilateral_shader.set_uniform("color_sampler", 0);
@@ -89,31 +109,71 @@ ScreenSpaceAttributeEstimation::ScreenSpaceAttributeEstimation(const Eigen::Vect
   bilateral_shader.set_uniform("half_kernel_size", 10);
   bilateral_shader.set_uniform("sigma_x", 10.0f);
   bilateral_shader.set_uniform("sigma_d", 0.01f);
+
+  temporal_shader.use();
+  temporal_shader.set_uniform("position_sampler", 0);
+  temporal_shader.set_uniform("occlusion_sampler", 1);
+  temporal_shader.set_uniform("history_sampler", 2);
+  temporal_shader.set_uniform("depth_tolerance", 0.02f);
+
+  upsample_shader.use();
+  upsample_shader.set_uniform("occlusion_sampler", 0);
+  upsample_shader.set_uniform("position_sampler", 1);
+  upsample_shader.set_uniform("sigma_d", 0.01f);
+}
+ScreenSpaceAttributeEstimation::~ScreenSpaceAttributeEstimation() {
+  release_targets();
+}
+
+void ScreenSpaceAttributeEstimation::release_targets() {
+  auto pool = RenderTargetPool::instance();
+  for(auto texture : {&position_texture, &normal_texture, &occlusion_texture, &occlusion_history[0], &occlusion_history[1]}) {
+    pool->release(*texture);
+    texture->reset();
+  }
 }
-ScreenSpaceAttributeEstimation::~ScreenSpaceAttributeEstimation() {}
 
 void ScreenSpaceAttributeEstimation::set_size(const Eigen::Vector2i& size) {
+  auto pool = RenderTargetPool::instance();
+  release_targets();
+
+  // positions need full precision (w = depth), normals are octahedral encoded into RG16, and occlusion fits in half floats
+  position_texture = pool->acquire(size, GL_RGBA32F, GL_RGBA, GL_FLOAT, GL_LINEAR);
+  normal_texture = pool->acquire(size, GL_RG16, GL_RG, GL_UNSIGNED_SHORT, GL_LINEAR);
+  occlusion_texture = pool->acquire(size, GL_R16F, GL_RED, GL_FLOAT, GL_LINEAR);
+
+  // frame buffers without storage (transient targets are attached in draw())
   position_buffer.reset(new glk::FrameBuffer(size, 0, false));
-  position_buffer->add_color_buffer(0, GL_RGBA32F, GL_RGB, GL_FLOAT);  // position
+  position_buffer->attach_color_buffer(0, position_texture);
 
   position_smoothing_x_buffer.reset(new glk::FrameBuffer(size, 0, false));
-  position_smoothing_x_buffer->add_color_buffer(0, GL_RGBA32F, GL_RGB, GL_FLOAT);
-
   position_smoothing_y_buffer.reset(new glk::FrameBuffer(size, 0, false));
-  position_smoothing_y_buffer->add_color_buffer(0, GL_RGBA32F, GL_RGB, GL_FLOAT);
 
   normal_buffer.reset(new glk::FrameBuffer(size, 0, false));
-  normal_buffer->add_color_buffer(0, GL_RGB32F, GL_RGB, GL_FLOAT);
+  normal_buffer->attach_color_buffer(0, normal_texture);
 
-  occlusion_buffer.reset(new glk::FrameBuffer(size, 0, false));
-  occlusion_buffer->add_color_buffer(0, GL_R32F, GL_RGB, GL_FLOAT);
-  occlusion_buffer->add_color_buffer(1, GL_RGB32F, GL_RGB, GL_FLOAT);
+  // occlusion is estimated and filtered at a lower resolution and then upsampled to occlusion_texture
+  const Eigen::Vector2i occlusion_size = ((size.array() + occlusion_downsample - 1) / occlusion_downsample).matrix();
+  occlusion_buffer.reset(new glk::FrameBuffer(occlusion_size, 0, false));
+  bilateral_x_buffer.reset(new glk::FrameBuffer(occlusion_size, 0, false));
+  bilateral_y_buffer.reset(new glk::FrameBuffer(occlusion_size, 0, false));
 
-  bilateral_x_buffer.reset(new glk::FrameBuffer(size, 0, false));
-  bilateral_x_buffer->add_color_buffer(0, GL_RGBA32F, GL_RGB, GL_FLOAT);
+  if(occlusion_downsample == 1) {
+    bilateral_y_buffer->attach_color_buffer(0, occlusion_texture);
+    upsample_buffer.reset();
+  } else {
+    upsample_buffer.reset(new glk::FrameBuffer(size, 0, false));
+    upsample_buffer->attach_color_buffer(0, occlusion_texture);
+  }
 
-  bilateral_y_buffer.reset(new glk::FrameBuffer(size, 0, false));
-  bilateral_y_buffer->add_color_buffer(0, GL_RGBA32F, GL_RGB, GL_FLOAT);
+  if(temporal_occlusion) {
+    occlusion_history[0] = pool->acquire(occlusion_size, GL_RG16F, GL_RG, GL_FLOAT, GL_NEAREST);
+    occlusion_history[1] = pool->acquire(occlusion_size, GL_RG16F, GL_RG, GL_FLOAT, GL_NEAREST);
+    temporal_buffer.reset(new glk::FrameBuffer(occlusion_size, 0, false));
+  } else {
+    temporal_buffer.reset();
+  }
+  history_valid = false;
 }
 
 void ScreenSpaceAttributeEstimation::set_smooth_normal(bool smooth_normal) {
@@ -124,6 +184,37 @@ void ScreenSpaceAttributeEstimation::set_rendering_buffer(BufferType buffer_type
   this->rendering_type = buffer_type;
 }
 
+void ScreenSpaceAttributeEstimation::set_occlusion_downsample(int downsample) {
+  if(downsample != 1 && downsample != 2 && downsample != 4) {
+    std::cerr << console::bold_yellow << "warning: occlusion downsample must be 1, 2, or 4 (" << downsample << " given)" << console::reset << std::endl;
+    downsample = downsample >= 4 ? 4 : (downsample >= 2 ? 2 : 1);
+  }
+
+  if(occlusion_downsample != downsample) {
+    occlusion_downsample = downsample;
+    set_size(position_buffer->size());
+  }
+}
+
+void ScreenSpaceAttributeEstimation::set_quality(const ScreenEffectQuality& quality) {
+  occlusion_shader.use();
+  occlusion_shader.set_uniform("num_samples", std::max(1, std::min(quality.occlusion_samples, 16)));
+  occlusion_shader.unuse();
+}
+
+ScreenEffectQuality ScreenSpaceAttributeEstimation::get_quality() const {
+  ScreenEffectQuality quality;
+  quality.occlusion_samples = occlusion_shader.get_uniform_cache_safe<int>("num_samples").value_or(quality.occlusion_samples);
+  return quality;
+}
+
+void ScreenSpaceAttributeEstimation::set_temporal_occlusion(bool temporal_occlusion) {
+  if(this->temporal_occlusion != temporal_occlusion) {
+    this->temporal_occlusion = temporal_occlusion;
+    set_size(position_buffer->size());
+  }
+}
+
 const glk::Texture& ScreenSpaceAttributeEstimation::position() const {
   return position_buffer->color();
 }
@@ -133,12 +224,27 @@ const glk::Texture& ScreenSpaceAttributeEstimation::normal() const {
 }
 
 const glk::Texture& ScreenSpaceAttributeEstimation::occlusion() const {
-  return bilateral_y_buffer->color(0);
+  return *occlusion_texture;
 }
 
 void ScreenSpaceAttributeEstimation::draw(const TextureRenderer& renderer, const glk::Texture& color_texture, const glk::Texture& depth_texture, const TextureRendererInput::Ptr& input, glk::FrameBuffer* frame_buffer) {
+  FrameProfiler::Scope prof_scope("ssae");
+
   using namespace glk::console;
 
+  auto pool = RenderTargetPool::instance();
+  const Eigen::Vector2i size = position_buffer->size();
+
+  // transient targets are returned to the pool right after their last use (unless they are shown for debugging)
+  std::vector<std::shared_ptr<glk::Texture>> debug_targets;
+  const auto release = [&](const std::shared_ptr<glk::Texture>& texture, BufferType buffer_type) {
+    if(rendering_type == buffer_type) {
+      debug_targets.push_back(texture);
+    } else {
+      pool->release(texture);
+    }
+  };
+
   glDisable(GL_DEPTH_TEST);
 
   // position
@@ -148,25 +254,32 @@ void ScreenSpaceAttributeEstimation::draw(const TextureRenderer& renderer, const
     std::cerr << bold_red << "error: view and projection matrices must be set" << reset << std::endl;
     return;
   }
+  // camera matrices are given by the frame uniform block (bound by GLCanvas)
   Eigen::Matrix4f projection_view_matrix = (*projection_matrix) * (*view_matrix);
-  Eigen::Matrix4f inv_projection_view_matrix = projection_view_matrix.inverse();
   Eigen::Vector2f inv_frame_size = 1.0f / position_buffer->size().array().cast<float>();
 
   pos_shader.use();
-  pos_shader.set_uniform("inv_projection_view_matrix", inv_projection_view_matrix);
 
   depth_texture.bind();
   position_buffer->bind();
   renderer.draw_plain(pos_shader);
   position_buffer->unbind();
 
+  std::shared_ptr<glk::Texture> smoothing_y_texture;
   if(smooth_normal) {
     // apply bilateral filter to position buffer
     bilateral_shader.use();
     bilateral_shader.set_uniform("inv_frame_size", inv_frame_size);
+    bilateral_shader.set_uniform("half_kernel_size", 10);
+    bilateral_shader.set_uniform("sigma_x", 10.0f);
     bilateral_shader.set_uniform("filter_direction", Eigen::Vector2f(1.0f, 0.0f));
     bilateral_shader.set_uniform("second_pass", false);
 
+    const auto smoothing_x_texture = pool->acquire(size, GL_RGBA32F, GL_RGBA, GL_FLOAT, GL_LINEAR);
+    smoothing_y_texture = pool->acquire(size, GL_RGBA32F, GL_RGBA, GL_FLOAT, GL_LINEAR);
+    position_smoothing_x_buffer->attach_color_buffer(0, smoothing_x_texture);
+    position_smoothing_y_buffer->attach_color_buffer(0, smoothing_y_texture);
+
     // filter in x-axis
     position_smoothing_x_buffer->bind();
     position_buffer->color(0).bind(GL_TEXTURE0);
@@ -183,13 +296,11 @@ void ScreenSpaceAttributeEstimation::draw(const TextureRenderer& renderer, const
     position_buffer->color().bind(GL_TEXTURE1);
     renderer.draw_plain(bilateral_shader);
     position_smoothing_y_buffer->unbind();
+    release(smoothing_x_texture, BufferType::SMOOTHED_POSITION_X);
   }
 
   // normal
-  Eigen::Vector3f view_point = view_matrix->inverse().block<3, 1>(0, 3);
-
   normal_shader.use();
-  normal_shader.set_uniform("view_point", view_point);
   normal_shader.set_uniform("inv_frame_size", inv_frame_size);
 
   normal_buffer->bind();
@@ -201,9 +312,9 @@ void ScreenSpaceAttributeEstimation::draw(const TextureRenderer& renderer, const
   }
 
   glActiveTexture(GL_TEXTURE2);
-  auto normal_texture = input->get<GLuint>("normal_texture");
-  if(normal_texture) {
-    glBindTexture(GL_TEXTURE_2D, *normal_texture);
+  auto input_normal_texture = input->get<GLuint>("normal_texture");
+  if(input_normal_texture) {
+    glBindTexture(GL_TEXTURE_2D, *input_normal_texture);
   } else {
     glBindTexture(GL_TEXTURE_2D, 0);
   }
@@ -212,8 +323,21 @@ void ScreenSpaceAttributeEstimation::draw(const TextureRenderer& renderer, const
   renderer.draw_plain(normal_shader);
   normal_buffer->unbind();
 
+  if(smoothing_y_texture) {
+    release(smoothing_y_texture, BufferType::SMOOTHED_POSITION);
+  }
+
   // ambient occlusion
-  Eigen::Vector2f randomization_coord_scale = color_texture.size().cast<float>().array() / randomization_texture->size().cast<float>().array();
+  const Eigen::Vector2i occlusion_size = occlusion_buffer->size();
+  const Eigen::Vector2f inv_occlusion_size = 1.0f / occlusion_size.array().cast<float>();
+  Eigen::Vector2f randomization_coord_scale = occlusion_size.cast<float>().array() / randomization_texture->size().cast<float>().array();
+
+  // shift the randomization pattern every frame (R2 sequence) so that temporal accumulation integrates different sample directions
+  Eigen::Vector2f randomization_offset = Eigen::Vector2f::Zero();
+  if(temporal_occlusion) {
+    randomization_offset = Eigen::Vector2f(std::fmod(0.7548776662 * frame_count, 1.0), std::fmod(0.5698402910 * frame_count, 1.0));
+  }
+  frame_count++;
 
   occlusion_shader.use();
   occlusion_shader.set_uniform("depth_sampler", 0);
@@ -221,8 +345,12 @@ void ScreenSpaceAttributeEstimation::draw(const TextureRenderer& renderer, const
   occlusion_shader.set_uniform("normal_sampler", 2);
   occlusion_shader.set_uniform("randomization_sampler", 3);
 
-  occlusion_shader.set_uniform("projection_view_matrix", projection_view_matrix);
   occlusion_shader.set_uniform("randomization_coord_scale", randomization_coord_scale);
+  occlusion_shader.set_uniform("randomization_offset", randomization_offset);
+
+  // the occlusion buffer has only the occlusion target (the debug color output of the shader is discarded)
+  const auto raw_occlusion_texture = pool->acquire(occlusion_size, GL_R16F, GL_RED, GL_FLOAT, GL_LINEAR);
+  occlusion_buffer->attach_color_buffer(0, raw_occlusion_texture);
 
   occlusion_buffer->bind();
   depth_texture.bind(GL_TEXTURE0);
@@ -232,44 +360,100 @@ void ScreenSpaceAttributeEstimation::draw(const TextureRenderer& renderer, const
   renderer.draw_plain(occlusion_shader);
   occlusion_buffer->unbind();
 
-  // bilateral filter
+  // temporal accumulation
+  const glk::Texture* accumulated_occlusion = raw_occlusion_texture.get();
+  if(temporal_occlusion) {
+    const auto& history = occlusion_history[history_index];
+    const auto& prev_history = occlusion_history[1 - history_index];
+    const Eigen::Vector3f view_point = view_matrix->inverse().block<3, 1>(0, 3);
+
+    temporal_shader.use();
+    temporal_shader.set_uniform("prev_projection_view_matrix", history_valid ? last_projection_view_matrix : projection_view_matrix);
+    temporal_shader.set_uniform("view_point", view_point);
+    temporal_shader.set_uniform("prev_view_point", history_valid ? last_view_point : view_point);
+    temporal_shader.set_uniform("blend_weight", history_valid ? 0.1f : 1.0f);
+
+    temporal_buffer->attach_color_buffer(0, history);
+    temporal_buffer->bind();
+    position_buffer->color().bind(GL_TEXTURE0);
+    raw_occlusion_texture->bind(GL_TEXTURE1);
+    prev_history->bind(GL_TEXTURE2);
+    renderer.draw_plain(temporal_shader);
+    temporal_buffer->unbind();
+
+    accumulated_occlusion = history.get();
+    last_projection_view_matrix = projection_view_matrix;
+    last_view_point = view_point;
+    history_valid = true;
+    history_index = 1 - history_index;
+  }
+
+  // bilateral filter (the kernel is scaled to the occlusion resolution)
   bilateral_shader.use();
-  bilateral_shader.set_uniform("inv_frame_size", inv_frame_size);
+  bilateral_shader.set_uniform("inv_frame_size", inv_occlusion_size);
   bilateral_shader.set_uniform("filter_direction", Eigen::Vector2f(1.0f, 0.0f));
   bilateral_shader.set_uniform("second_pass", false);
+  bilateral_shader.set_uniform("half_kernel_size", std::max(2, 10 / occlusion_downsample));
+  bilateral_shader.set_uniform("sigma_x", 10.0f / (occlusion_downsample * occlusion_downsample));
+
+  // filter in x-axis (the alpha channel holds the sum of weights)
+  const auto bilateral_x_texture = pool->acquire(occlusion_size, GL_RGBA16F, GL_RGBA, GL_FLOAT, GL_LINEAR);
+  bilateral_x_buffer->attach_color_buffer(0, bilateral_x_texture);
 
-  // filter in x-axis
   bilateral_x_buffer->bind();
-  occlusion_buffer->color(0).bind(GL_TEXTURE0);
+  accumulated_occlusion->bind(GL_TEXTURE0);
   position_buffer->color(0).bind(GL_TEXTURE1);
   renderer.draw_plain(bilateral_shader);
   bilateral_x_buffer->unbind();
+  release(raw_occlusion_texture, BufferType::SSAO);
 
   bilateral_shader.set_uniform("filter_direction", Eigen::Vector2f(0.0f, 1.0f));
   bilateral_shader.set_uniform("second_pass", true);
 
   // filter in y-axis
+  std::shared_ptr<glk::Texture> bilateral_y_texture;
+  if(upsample_buffer) {
+    bilateral_y_texture = pool->acquire(occlusion_size, GL_R16F, GL_RED, GL_FLOAT, GL_NEAREST);
+    bilateral_y_buffer->attach_color_buffer(0, bilateral_y_texture);
+  }
+
   bilateral_y_buffer->bind();
   bilateral_x_buffer->color().bind(GL_TEXTURE0);
   position_buffer->color().bind(GL_TEXTURE1);
   renderer.draw_plain(bilateral_shader);
   bilateral_y_buffer->unbind();
+  release(bilateral_x_texture, BufferType::SMOOTHED_SSAO_X);
+
+  // depth-aware upsampling to the full resolution
+  if(upsample_buffer) {
+    upsample_shader.use();
+    upsample_buffer->bind();
+    bilateral_y_texture->bind(GL_TEXTURE0);
+    position_buffer->color().bind(GL_TEXTURE1);
+    renderer.draw_plain(upsample_shader);
+    upsample_buffer->unbind();
+    pool->release(bilateral_y_texture);
+  }
 
   if(rendering_type != BufferType::NONE) {
     if(frame_buffer) {
       frame_buffer->bind();
     }
 
+    // transient targets that have not been rendered in this frame fall back to the depth texture
+    const auto color_of = [&](const std::unique_ptr<glk::FrameBuffer>& buffer) -> const glk::Texture* {
+      return buffer->num_color_buffers() ? &buffer->color() : &depth_texture;
+    };
+
     const glk::Texture* textures[] = {
       &depth_texture,
-      &position_buffer->color(),
-      &position_smoothing_x_buffer->color(),
-      &position_smoothing_y_buffer->color(),
-      &normal_buffer->color(),
-      &occlusion_buffer->color(),
-      &bilateral_x_buffer->color(),
-      &bilateral_y_buffer->color()
-    };
+      color_of(position_buffer),
+      color_of(position_smoothing_x_buffer),
+      color_of(position_smoothing_y_buffer),
+      color_of(normal_buffer),
+      color_of(occlusion_buffer),
+      color_of(bilateral_x_buffer),
+      occlusion_texture.get()};
     const auto texture = textures[static_cast<int>(rendering_type) - 1];
     texture->bind();
 
@@ -281,6 +465,10 @@ void ScreenSpaceAttributeEstimation::draw(const TextureRenderer& renderer, const
     }
   }
 
+  for(const auto& texture : debug_targets) {
+    pool->release(texture);
+  }
+
   glEnable(GL_DEPTH_TEST);
 }
 
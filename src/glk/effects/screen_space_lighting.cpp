@@ -1,6 +1,10 @@
+#include <algorithm>
+#include <limits>
+#include <numeric>
 #include <random>
 #include <iostream>
 #include <glk/path.hpp>
+#include <glk/frame_profiler.hpp>
 #include <glk/console_colors.hpp>
 #include <glk/frame_buffer.hpp>
 #include <glk/io/png_io.hpp>
@@ -14,6 +18,11 @@
 
 namespace glk {
 
+namespace {
+// must match max_num_lights in ssli.frag
+const int max_num_block_lights = 128;
+}  // namespace
+
 ScreenSpaceLighting::ScreenSpaceLighting(const Eigen::Vector2i& size, bool use_splatting) {
   if(use_splatting) {
     splatting.reset(new ScreenSpaceSplatting(size));
@@ -21,6 +30,32 @@ ScreenSpaceLighting::ScreenSpaceLighting(const Eigen::Vector2i& size, bool use_s
     ssae.reset(new ScreenSpaceAttributeEstimation(size));
   }
 
+  // LightBlock {int num_lights; vec4 light_pos_range[128]; vec4 light_color[128]; vec4 light_attenuation_type[128];}
+  light_block.reset(new glk::UniformBuffer(sizeof(Eigen::Vector4f) * (1 + 3 * max_num_block_lights)));
+
+  // tiled light culling requires GL 4.3 compute shaders (fall back to the uniform array path if they are not available)
+  max_lights_per_tile = 256;
+  lights_buffer_capacity = 0;
+  light_culling_stats_cursor = 0;
+  overflow_tiles = 0;
+  overflow_warned = false;
+  light_culling_available =
+    light_culling_shader.attach_source(get_data_path() + "/shader/ssli_light_culling.comp", GL_COMPUTE_SHADER) && light_culling_shader.link_program();
+  tiled_light_culling = light_culling_available;
+  if(light_culling_available) {
+    light_culling_shader.use();
+    light_culling_shader.set_uniform("position_sampler", 0);
+    light_culling_shader.set_uniform("max_lights_per_tile", max_lights_per_tile);
+    light_culling_shader.unuse();
+    allocate_tile_buffers(size);
+    for(int i = 0; i < 3; i++) {
+      light_culling_stats_buffers.emplace_back(new glk::ShaderStorageBuffer(sizeof(GLuint)));
+      light_culling_stats_fences.push_back(nullptr);
+    }
+  } else {
+    std::cerr << console::bold_yellow << "warning: failed to build the light culling compute shader (tiled light culling is disabled)" << console::reset << std::endl;
+  }
+
   int width, height;
   std::vector<unsigned char> bytes;
 
@@ -49,7 +84,13 @@ ScreenSpaceLighting::ScreenSpaceLighting(const Eigen::Vector2i& size, bool use_s
   lighting_shader.set_uniform("roughness", 0.2f);
   lighting_shader.set_uniform("ambient_light_color", Eigen::Vector4f(0.1f, 0.1f, 0.1f, 1.0f));
 }
-ScreenSpaceLighting::~ScreenSpaceLighting() {}
+ScreenSpaceLighting::~ScreenSpaceLighting() {
+  for(const auto fence : light_culling_stats_fences) {
+    if(fence) {
+      glDeleteSync(fence);
+    }
+  }
+}
 
 const glk::Texture& ScreenSpaceLighting::position() const {
   return ssae->position();
@@ -63,6 +104,58 @@ const glk::Texture& ScreenSpaceLighting::occlusion() const {
   return ssae->occlusion();
 }
 
+void ScreenSpaceLighting::set_quality(const ScreenEffectQuality& quality) {
+  if(splatting) {
+    splatting->set_quality(quality);
+  }
+  if(ssae) {
+    ssae->set_quality(quality);
+  }
+}
+
+ScreenEffectQuality ScreenSpaceLighting::get_quality() const {
+  ScreenEffectQuality quality;
+  if(splatting) {
+    quality = splatting->get_quality();
+  }
+  if(ssae) {
+    quality.occlusion_samples = ssae->get_quality().occlusion_samples;
+  }
+  return quality;
+}
+
+void ScreenSpaceLighting::set_occlusion_downsample(int downsample) {
+  if(ssae) {
+    ssae->set_occlusion_downsample(downsample);
+  }
+}
+
+void ScreenSpaceLighting::set_temporal_occlusion(bool temporal_occlusion) {
+  if(ssae) {
+    ssae->set_temporal_occlusion(temporal_occlusion);
+  }
+}
+
+void ScreenSpaceLighting::set_tiled_light_culling(bool enable) {
+  if(enable && !light_culling_available) {
+    std::cerr << console::bold_yellow << "warning: tiled light culling is not available" << console::reset << std::endl;
+    return;
+  }
+
+  if(tiled_light_culling != enable) {
+    tiled_light_culling = enable;
+    load_shader();
+  }
+}
+
+bool ScreenSpaceLighting::tiled_light_culling_enabled() const {
+  return tiled_light_culling;
+}
+
+int ScreenSpaceLighting::num_overflow_tiles() const {
+  return overflow_tiles;
+}
+
 void ScreenSpaceLighting::set_diffuse_model(DIFFUSE_MODEL model) {
   diffuse_model = model;
   load_shader();
@@ -86,7 +179,8 @@ void ScreenSpaceLighting::set_iridescence_model(IRIDESCENCE_MODEL model) {
 bool ScreenSpaceLighting::load_shader() {
   light_updated = true;
   std::vector<std::string> vertex_shaders = {get_data_path() + "/shader/texture.vert"};
-  std::vector<std::string> fragment_shaders = {get_data_path() + "/shader/ssli.frag", get_data_path() + "/shader/brdf/schlick_fresnel.frag"};
+  const std::string lighting_shader_path = get_data_path() + (tiled_light_culling ? "/shader/ssli_tiled.frag" : "/shader/ssli.frag");
+  std::vector<std::string> fragment_shaders = {lighting_shader_path, get_data_path() + "/shader/brdf/schlick_fresnel.frag"};
 
   switch(diffuse_model) {
     default:
@@ -288,9 +382,118 @@ void ScreenSpaceLighting::set_size(const Eigen::Vector2i& size) {
   if(ssae) {
     ssae->set_size(size);
   }
+
+  if(light_culling_available) {
+    allocate_tile_buffers(size);
+  }
+}
+
+void ScreenSpaceLighting::allocate_tile_buffers(const Eigen::Vector2i& size) {
+  const int tile_size = 16;
+  num_tiles = (size.array() + tile_size - 1) / tile_size;
+  tile_light_counts_buffer.reset(new glk::ShaderStorageBuffer(sizeof(GLuint) * num_tiles.prod()));
+  tile_light_indices_buffer.reset(new glk::ShaderStorageBuffer(sizeof(GLuint) * num_tiles.prod() * max_lights_per_tile));
+}
+
+/**
+ * @brief Upload lights (if updated) and bin them into screen tiles
+ * @param [in]position_texture  Position texture of SSAE or splatting (w >= 1 for background pixels)
+ * @param [out]lights_buffer, tile_light_counts_buffer, tile_light_indices_buffer
+ */
+void ScreenSpaceLighting::cull_lights(const glk::Texture& position_texture) {
+  FrameProfiler::Scope prof_scope("light_culling");
+
+  if(light_updated) {
+    // lights are uploaded in order of importance because tiles keep the first lights (in index order) when they overflow
+    std::vector<int> order(light_pos.size());
+    std::iota(order.begin(), order.end(), 0);
+    const auto importance = [this](int i) { return light_directional[i] ? std::numeric_limits<float>::max() : light_range[i] * light_color[i].head<3>().maxCoeff(); };
+    std::stable_sort(order.begin(), order.end(), [&](int lhs, int rhs) { return importance(lhs) > importance(rhs); });
+
+    // std430 layout of Light {vec4 pos_range; vec4 color; vec4 attenuation_type;}
+    std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f>> lights(light_pos.size() * 3);
+    for(int k = 0; k < order.size(); k++) {
+      const int i = order[k];
+      lights[k * 3] << light_pos[i], light_range[i];
+      lights[k * 3 + 1] = light_color[i];
+      lights[k * 3 + 2] << light_attenuation[i], light_directional[i] ? 1.0f : 0.0f, 0.0f;
+    }
+
+    if(lights_buffer_capacity < light_pos.size() || !lights_buffer) {
+      lights_buffer_capacity = std::max<int>(16, light_pos.size() * 2);
+      lights_buffer.reset(new glk::ShaderStorageBuffer(sizeof(Eigen::Vector4f) * 3 * lights_buffer_capacity));
+    }
+    if(!lights.empty()) {
+      lights_buffer->reset(sizeof(Eigen::Vector4f) * lights.size(), lights.data());
+    }
+  }
+
+  // overflow count of the dispatch that used this stats buffer a few frames ago (normally completed long before)
+  auto& stats_buffer = light_culling_stats_buffers[light_culling_stats_cursor];
+  auto& stats_fence = light_culling_stats_fences[light_culling_stats_cursor];
+  light_culling_stats_cursor = (light_culling_stats_cursor + 1) % light_culling_stats_buffers.size();
+
+  if(stats_fence) {
+    glClientWaitSync(stats_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    glDeleteSync(stats_fence);
+    stats_fence = nullptr;
+
+    GLuint num_overflow = 0;
+    stats_buffer->get_values(&num_overflow);
+    overflow_tiles = num_overflow;
+
+    if(overflow_tiles && !overflow_warned) {
+      std::cerr << console::bold_yellow << "warning: " << overflow_tiles << " light culling tiles have more than " << max_lights_per_tile
+                << " visible lights (the least important lights are dropped)" << console::reset << std::endl;
+      overflow_warned = true;
+    }
+  }
+  stats_buffer->reset();
+
+  light_culling_shader.use();
+  light_culling_shader.set_uniform("num_lights", static_cast<int>(light_pos.size()));
+
+  position_texture.bind(GL_TEXTURE0);
+  lights_buffer->bind(0);
+  tile_light_counts_buffer->bind(1);
+  tile_light_indices_buffer->bind(2);
+  stats_buffer->bind(3);
+
+  glDispatchCompute(num_tiles[0], num_tiles[1], 1);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  stats_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  light_culling_shader.unuse();
+}
+
+/**
+ * @brief Upload lights to the uniform block used by the non-tiled lighting path
+ */
+void ScreenSpaceLighting::upload_light_block() {
+  const int num_lights = std::min<int>(light_pos.size(), max_num_block_lights);
+  if(num_lights < light_pos.size()) {
+    std::cerr << console::bold_yellow << "warning: only the first " << max_num_block_lights << " lights are used without tiled light culling" << console::reset << std::endl;
+  }
+
+  // std140 layout (arrays of vec4 have a stride of 16 bytes)
+  std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f>> block(1 + 3 * max_num_block_lights, Eigen::Vector4f::Zero());
+  *reinterpret_cast<int*>(block[0].data()) = num_lights;
+
+  Eigen::Vector4f* pos_range = block.data() + 1;
+  Eigen::Vector4f* color = pos_range + max_num_block_lights;
+  Eigen::Vector4f* attenuation_type = color + max_num_block_lights;
+  for(int i = 0; i < num_lights; i++) {
+    pos_range[i] << light_pos[i], light_range[i];
+    color[i] = light_color[i];
+    attenuation_type[i] << light_attenuation[i], light_directional[i] ? 1.0f : 0.0f, 0.0f;
+  }
+
+  light_block->update(block.data(), sizeof(Eigen::Vector4f) * (1 + 3 * max_num_block_lights));
 }
 
 void ScreenSpaceLighting::draw(const TextureRenderer& renderer, const glk::Texture& color_texture, const glk::Texture& depth_texture, const TextureRendererInput::Ptr& input, glk::FrameBuffer* frame_buffer) {
+  FrameProfiler::Scope prof_scope("ssli");
+
   using namespace glk::console;
 
   if(splatting) {
@@ -304,12 +507,12 @@ void ScreenSpaceLighting::draw(const TextureRenderer& renderer, const glk::Textu
     frame_buffer->bind();
   }
 
+  // the view point is given by the frame uniform block (bound by GLCanvas)
   auto view_matrix = input->get<Eigen::Matrix4f>("view_matrix");
   if(!view_matrix) {
     std::cerr << bold_red << "error: view and projection matrices must be set" << reset << std::endl;
     return;
   }
-  Eigen::Vector3f view_point = view_matrix->inverse().block<3, 1>(0, 3);
 
   glDisable(GL_DEPTH_TEST);
   glDisable(GL_BLEND);
@@ -321,19 +524,24 @@ void ScreenSpaceLighting::draw(const TextureRenderer& renderer, const glk::Textu
   lighting_shader.set_uniform("occlusion_sampler", 3);
   lighting_shader.set_uniform("iridescence_sampler", 4);
 
-  lighting_shader.set_uniform("view_point", view_point);
-
   lighting_shader.set_uniform("albedo", albedo);
   lighting_shader.set_uniform("roughness", roughness);
 
-  if(light_updated) {
-    lighting_shader.set_uniform("num_lights", static_cast<int>(light_pos.size()));
-    lighting_shader.set_uniform("light_directional", light_directional);
-    lighting_shader.set_uniform("light_range", light_range);
-    lighting_shader.set_uniform("light_attenuation", light_attenuation);
-    lighting_shader.set_uniform("light_pos", light_pos);
-    lighting_shader.set_uniform("light_color", light_color);
+  if(tiled_light_culling) {
+    cull_lights(splatting ? splatting->position() : ssae->position());
+
+    lighting_shader.use();
+    lighting_shader.set_uniform("max_lights_per_tile", max_lights_per_tile);
+    lights_buffer->bind(0);
+    tile_light_counts_buffer->bind(1);
+    tile_light_indices_buffer->bind(2);
+  } else {
+    if(light_updated) {
+      upload_light_block();
+    }
+    light_block->bind(glk::UniformBlockBinding::LIGHT);
   }
+  light_updated = false;
 
   if(splatting) {
     splatting->color().bind(GL_TEXTURE0);
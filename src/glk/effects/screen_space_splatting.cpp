@@ -2,9 +2,11 @@
 
 #include <fstream>
 
+#include <glk/frame_profiler.hpp>
 #include <glk/path.hpp>
 #include <glk/query.hpp>
 #include <glk/frame_buffer.hpp>
+#include <glk/render_target_pool.hpp>
 #include <glk/pointcloud_buffer.hpp>
 #include <glk/console_colors.hpp>
 
@@ -21,6 +23,8 @@ ScreenSpaceSplatting::ScreenSpaceSplatting(const Eigen::Vector2i& size) {
   k_tolerance = 2;
   initial_estimation_grid_size = 32;
   num_iterations = 6;
+  knn_mode = KNN_MODE::RASTERIZATION;
+  max_search_rings = 4;
 
   query.reset(new glk::Query());
 
@@ -71,6 +75,13 @@ ScreenSpaceSplatting::ScreenSpaceSplatting(const Eigen::Vector2i& size) {
     abort();
   }
 
+  // compute shaders require GL 4.3 (fall back to the rasterization path if they are not available)
+  knn_compute_available = knn_binning_shader.attach_source(get_data_path() + "/shader/splat/knn_binning.comp", GL_COMPUTE_SHADER) && knn_binning_shader.link_program() &&
+                          knn_radius_shader.attach_source(get_data_path() + "/shader/splat/knn_radius.comp", GL_COMPUTE_SHADER) && knn_radius_shader.link_program();
+  if(!knn_compute_available) {
+    std::cerr << bold_yellow << "warning: failed to build k-NN compute shaders (compute k-NN mode is disabled)" << reset << std::endl;
+  }
+
   if(!gaussian_gathering_shader.init(get_data_path() + "/shader/splat/gathering.vert", get_data_path() + "/shader/splat/gaussian_gathering.frag")) {
     abort();
   }
@@ -136,6 +147,17 @@ ScreenSpaceSplatting::ScreenSpaceSplatting(const Eigen::Vector2i& size) {
   radius_finalization_shader.set_uniform("radius_bounds_sampler", 1);
   radius_finalization_shader.set_uniform("k_neighbors", k_neighbors);
 
+  if(knn_compute_available) {
+    knn_binning_shader.use();
+    knn_binning_shader.set_uniform("depth_sampler", 0);
+
+    knn_radius_shader.use();
+    knn_radius_shader.set_uniform("depth_sampler", 0);
+    knn_radius_shader.set_uniform("k_neighbors", k_neighbors);
+    knn_radius_shader.set_uniform("max_search_rings", max_search_rings);
+    knn_radius_shader.set_uniform("max_radius", 0.5f);
+  }
+
   gaussian_gathering_shader.use();
   gaussian_gathering_shader.set_uniform("position_sampler", 0);
   gaussian_gathering_shader.set_uniform("radius_bounds_sampler", 1);
@@ -219,62 +241,54 @@ void ScreenSpaceSplatting::set_size(const Eigen::Vector2i& size) {
   finalized_radius_buffer->add_color_buffer(0, GL_RG32F, GL_RG, GL_FLOAT).set_filer_mode(GL_NEAREST);
   finalized_radius_buffer->add_depth_buffer(GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT);
 
+  // screen space cells for compute k-NN radius estimation (8x8 pixels per cell, 64 points at most)
+  const int cell_size = 8;
+  const int cell_capacity = cell_size * cell_size;
+  num_cells = (size.array() + cell_size - 1) / cell_size;
+  cell_counts_buffer.reset(new glk::ShaderStorageBuffer(sizeof(GLuint) * num_cells.prod()));
+  cell_points_buffer.reset(new glk::ShaderStorageBuffer(sizeof(Eigen::Vector4f) * num_cells.prod() * cell_capacity));
+  resolved_points_counter.reset(new glk::AtomicCounters(1));
+
+  // The following intermediate buffers have no color storage of their own.
+  // Their color targets are borrowed from glk::RenderTargetPool for each frame (see draw()).
+
   // Low resolution buffer for initial radius estimation
   const Eigen::Vector2i initial_estimation_buffer_size = (size.cast<double>() / initial_estimation_grid_size).array().ceil().cast<int>();
   initial_estimation_buffer.reset(new glk::FrameBuffer(initial_estimation_buffer_size, 0, false));
-  // Because alpha blending doesn't work with integer textures, we use float texture here
-  // (Should we use a stencil buffer instead?)
-  initial_estimation_buffer->add_color_buffer(0, GL_R32F, GL_RED, GL_FLOAT).set_filer_mode(GL_NEAREST);
 
   // knn estimation
   // radius buffer
   radius_buffer_ping.reset(new glk::FrameBuffer(size, 0, false));
-  radius_buffer_ping->add_color_buffer(0, GL_RG32F, GL_RG, GL_FLOAT).set_filer_mode(GL_NEAREST);
   radius_buffer_ping->bind_ext_depth_buffer(position_buffer->depth());
 
   radius_buffer_pong.reset(new glk::FrameBuffer(size, 0, false));
-  radius_buffer_pong->add_color_buffer(0, GL_RG32F, GL_RG, GL_FLOAT).set_filer_mode(GL_NEAREST);
   radius_buffer_pong->bind_ext_depth_buffer(position_buffer->depth());
 
   // neighbor counts buffer
   neighbor_counts_buffer.reset(new glk::FrameBuffer(size, 0, false));
-  neighbor_counts_buffer->add_color_buffer(0, GL_RGBA32F, GL_RGBA, GL_FLOAT).set_filer_mode(GL_NEAREST);
   neighbor_counts_buffer->bind_ext_depth_buffer(finalized_radius_buffer->depth());
 
   // feedback radius
   feedback_radius_buffer.reset(new glk::FrameBuffer(size, 0, false));
-  feedback_radius_buffer->add_color_buffer(0, GL_R32F, GL_RED, GL_FLOAT).set_filer_mode(GL_NEAREST);  // feedback radius
   feedback_radius_buffer->bind_ext_depth_buffer(position_buffer->depth());
 
   // gaussian estimation
   // accumulation buffer
   gaussian_accum_buffer.reset(new glk::FrameBuffer(size, 0, false));
-  gaussian_accum_buffer->add_color_buffer(0, GL_R32F, GL_RED, GL_FLOAT).set_filer_mode(GL_NEAREST);    //
-  gaussian_accum_buffer->add_color_buffer(1, GL_RGB32F, GL_RGB, GL_FLOAT).set_filer_mode(GL_NEAREST);  // mean
-  gaussian_accum_buffer->add_color_buffer(2, GL_RGB32F, GL_RGB, GL_FLOAT).set_filer_mode(GL_NEAREST);  // cov1
-  gaussian_accum_buffer->add_color_buffer(3, GL_RGB32F, GL_RGB, GL_FLOAT).set_filer_mode(GL_NEAREST);  // cov2
   gaussian_accum_buffer->bind_ext_depth_buffer(position_buffer->depth());
 
   // gaussian buffer
   gaussian_dists_buffer.reset(new glk::FrameBuffer(size, 0, false));
-  gaussian_dists_buffer->add_color_buffer(0, GL_RGB32F, GL_RGB, GL_FLOAT).set_filer_mode(GL_NEAREST);  // length
-  gaussian_dists_buffer->add_color_buffer(1, GL_RGB32F, GL_RGB, GL_FLOAT).set_filer_mode(GL_NEAREST);  // normal
-  gaussian_dists_buffer->add_color_buffer(2, GL_RGB32F, GL_RGB, GL_FLOAT).set_filer_mode(GL_NEAREST);  // minor tangent
-  gaussian_dists_buffer->add_color_buffer(3, GL_RGB32F, GL_RGB, GL_FLOAT).set_filer_mode(GL_NEAREST);  // major tangent
   gaussian_dists_buffer->bind_ext_depth_buffer(position_buffer->depth());
 
   // splatting buffer
   splatting_buffer.reset(new glk::FrameBuffer(size, 0, true));
-  splatting_buffer->add_color_buffer(0, GL_R32F, GL_RED, GL_FLOAT).set_filer_mode(GL_NEAREST);    // weight
-  splatting_buffer->add_color_buffer(1, GL_RGB32F, GL_RGB, GL_FLOAT).set_filer_mode(GL_NEAREST);  // position
-  splatting_buffer->add_color_buffer(2, GL_RGB32F, GL_RGB, GL_FLOAT).set_filer_mode(GL_NEAREST);  // normal
-  splatting_buffer->add_color_buffer(3, GL_RGB32F, GL_RGB, GL_FLOAT).set_filer_mode(GL_NEAREST);  // color
 
   // result buffer
   result_buffer.reset(new glk::FrameBuffer(size, 0, false));
-  result_buffer->add_color_buffer(0, GL_RGB32F, GL_RGBA, GL_FLOAT);  // color
-  result_buffer->add_color_buffer(1, GL_RGB32F, GL_RGB, GL_FLOAT);   // position
-  result_buffer->add_color_buffer(2, GL_RGB32F, GL_RGB, GL_FLOAT);   // normal
+  result_buffer->add_color_buffer(0, GL_RGBA32F, GL_RGBA, GL_FLOAT);        // position (w = 1 for uncovered pixels)
+  result_buffer->add_color_buffer(1, GL_RG16, GL_RG, GL_UNSIGNED_SHORT);    // normal (octahedral encoding)
+  result_buffer->add_color_buffer(2, GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT);  // color
 }
 
 const glk::Texture& ScreenSpaceSplatting::position() const {
@@ -289,6 +303,49 @@ const glk::Texture& ScreenSpaceSplatting::color() const {
   return result_buffer->color(2);
 }
 
+void ScreenSpaceSplatting::set_quality(const ScreenEffectQuality& quality) {
+  num_iterations = std::max(1, quality.splatting_iterations);
+  const int k = std::max(k_tolerance + 1, quality.splatting_k_neighbors);
+  if(k_neighbors == k) {
+    return;
+  }
+
+  k_neighbors = k;
+  for(auto shader : {&initial_radius_shader, &bounds_update_shader, &radius_finalization_shader, &gaussian_finalization_shader}) {
+    shader->use();
+    shader->set_uniform("k_neighbors", k_neighbors);
+  }
+
+  if(knn_compute_available) {
+    knn_radius_shader.use();
+    knn_radius_shader.set_uniform("k_neighbors", k_neighbors);
+  }
+  glUseProgram(0);
+}
+
+ScreenEffectQuality ScreenSpaceSplatting::get_quality() const {
+  ScreenEffectQuality quality;
+  quality.splatting_iterations = num_iterations;
+  quality.splatting_k_neighbors = k_neighbors;
+  return quality;
+}
+
+void ScreenSpaceSplatting::set_knn_mode(KNN_MODE mode) {
+  if(mode == KNN_MODE::COMPUTE && !knn_compute_available) {
+    std::cerr << bold_yellow << "warning: compute k-NN mode is not available" << reset << std::endl;
+    return;
+  }
+  knn_mode = mode;
+}
+
+ScreenSpaceSplatting::KNN_MODE ScreenSpaceSplatting::get_knn_mode() const {
+  return knn_mode;
+}
+
+int ScreenSpaceSplatting::num_resolved_points() const {
+  return knn_mode == KNN_MODE::COMPUTE ? resolved_points_counter->get_value() : 0;
+}
+
 /**
  * @brief Extract valid pixels from sampling_buffer and store their uv coordinates and 3D positions
  *        in #position_buffer and #points_on_screen
@@ -485,6 +542,45 @@ void ScreenSpaceSplatting::estimate_knn_radius() {
   glDisable(GL_BLEND);
 }
 
+/**
+ * @brief Estimate knn radius with compute shaders
+ *        1. bin valid pixels into screen space cells (cell_counts_buffer, cell_points_buffer)
+ *        2. search k nearest neighbors over neighboring cells for each pixel
+ * @param [in]depth_texture
+ * @param [out]finalized_radius_buffer
+ */
+void ScreenSpaceSplatting::estimate_knn_radius_compute(const glk::Texture& depth_texture) {
+  const GLfloat black[] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+  finalized_radius_buffer->bind();
+  glClearBufferfv(GL_COLOR, 0, black);
+  finalized_radius_buffer->unbind();
+
+  resolved_points_counter->reset();
+
+  depth_texture.bind(GL_TEXTURE0);
+  cell_counts_buffer->bind(0);
+  cell_points_buffer->bind(1);
+
+  knn_binning_shader.use();
+  glDispatchCompute(num_cells[0], num_cells[1], 1);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+  resolved_points_counter->bind(0);
+  glBindImageTexture(0, finalized_radius_buffer->color().id(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32F);
+
+  knn_radius_shader.use();
+  glDispatchCompute(num_cells[0], num_cells[1], 1);
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_ATOMIC_COUNTER_BARRIER_BIT);
+
+  glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32F);
+  resolved_points_counter->unbind();
+  cell_points_buffer->unbind(1);
+  cell_counts_buffer->unbind(0);
+  depth_texture.unbind(GL_TEXTURE0);
+  knn_radius_shader.unuse();
+}
+
 /**
  * @brief Estimate Gaussian distributions
  */
@@ -630,6 +726,8 @@ void ScreenSpaceSplatting::render_splatting(GLProfiler& prof, const glk::Texture
 }
 
 void ScreenSpaceSplatting::draw(const TextureRenderer& renderer, const glk::Texture& color_texture, const glk::Texture& depth_texture, const TextureRendererInput::Ptr& input, glk::FrameBuffer* frame_buffer) {
+  FrameProfiler::Scope prof_scope("splat");
+
   glDisable(GL_DEPTH_TEST);
 
   color_texture.set_filer_mode(GL_NEAREST);
@@ -646,74 +744,106 @@ void ScreenSpaceSplatting::draw(const TextureRenderer& renderer, const glk::Text
   const Eigen::Vector2f screen_size = position_buffer->size().cast<float>();
   const Eigen::Vector2f inv_screen_size(1.0 / position_buffer->size()[0], 1.0 / position_buffer->size()[1]);
 
-  const Eigen::Vector3f view_point = view_matrix->inverse().block<3, 1>(0, 3);
-  const Eigen::Matrix4f inv_projection_matrix = (*projection_matrix).inverse();
-  const Eigen::Matrix4f projection_view_matrix = (*projection_matrix) * (*view_matrix);
-  const Eigen::Matrix4f inv_projection_view_matrix = projection_view_matrix.inverse();
-
-  // set up uniforms
-  point_extraction_shader.use();
-  point_extraction_shader.set_uniform("inv_projection_view_matrix", inv_projection_view_matrix);
-
+  // camera matrices are given by the frame uniform block (bound by GLCanvas)
   initial_radius_shader.use();
   initial_radius_shader.set_uniform("inv_screen_size", inv_screen_size);
-  initial_radius_shader.set_uniform("inv_projection_matrix", inv_projection_matrix);
 
   distribution_shader.use();
   distribution_shader.set_uniform("screen_size", screen_size);
   distribution_shader.set_uniform("inv_screen_size", inv_screen_size);
-  distribution_shader.set_uniform("view_matrix", *view_matrix);
-  distribution_shader.set_uniform("projection_matrix", *projection_matrix);
 
   gathering_shader.use();
   gathering_shader.set_uniform("screen_size", screen_size);
   gathering_shader.set_uniform("inv_screen_size", inv_screen_size);
-  gathering_shader.set_uniform("view_matrix", *view_matrix);
-  gathering_shader.set_uniform("projection_matrix", *projection_matrix);
 
   gaussian_gathering_shader.use();
   gaussian_gathering_shader.set_uniform("screen_size", screen_size);
   gaussian_gathering_shader.set_uniform("inv_screen_size", inv_screen_size);
-  gaussian_gathering_shader.set_uniform("view_matrix", *view_matrix);
-  gaussian_gathering_shader.set_uniform("projection_matrix", *projection_matrix);
-
-  gaussian_finalization_shader.use();
-  gaussian_finalization_shader.set_uniform("view_point", view_point);
 
   splatting_first_shader.use();
   splatting_first_shader.set_uniform("pass_stage", 0);
-  splatting_first_shader.set_uniform("view_matrix", *view_matrix);
-  splatting_first_shader.set_uniform("projection_matrix", *projection_matrix);
-  splatting_first_shader.set_uniform("projection_view_matrix", projection_view_matrix);
 
   splatting_second_shader.use();
   splatting_second_shader.set_uniform("pass_stage", 1);
-  splatting_second_shader.set_uniform("view_matrix", *view_matrix);
-  splatting_second_shader.set_uniform("projection_matrix", *projection_matrix);
-  splatting_second_shader.set_uniform("projection_view_matrix", projection_view_matrix);
 
   glk::GLProfiler prof("splat", false);
+  auto profiler = FrameProfiler::instance();
+
+  // borrow a transient target from the pool and attach it to the given frame buffer
+  auto pool = RenderTargetPool::instance();
+  const auto acquire = [&](glk::FrameBuffer& buffer, int layout, GLenum internal_format, GLenum format) {
+    auto texture = pool->acquire(buffer.size(), internal_format, format, GL_FLOAT);
+    buffer.attach_color_buffer(layout, texture);
+    return texture;
+  };
+  const auto release = [&](std::initializer_list<std::shared_ptr<glk::Texture>> textures) {
+    for(const auto& texture : textures) {
+      pool->release(texture);
+    }
+  };
 
   // extract valid points with transform feedback and calc vertex positions
   prof.add("extract_points");
+  profiler->push("splat/extract_points");
   extract_points_on_screen(depth_texture);
-
-  // initial radius estimation
-  prof.add("initial_guess");
-  estimate_initial_radius(depth_texture);
-
-  // radius ping pong
-  prof.add("estimate knn");
-  estimate_knn_radius();
+  profiler->pop();
+
+  const auto feedback_radius = acquire(*feedback_radius_buffer, 0, GL_R32F, GL_RED);
+
+  if(knn_mode == KNN_MODE::COMPUTE) {
+    // binning and k-NN search
+    prof.add("estimate knn");
+    profiler->push("splat/estimate_knn_compute");
+    estimate_knn_radius_compute(depth_texture);
+    profiler->pop();
+  } else {
+    // initial radius estimation
+    prof.add("initial_guess");
+    profiler->push("splat/initial_guess");
+    const auto radius_ping = acquire(*radius_buffer_ping, 0, GL_RG32F, GL_RG);
+    const auto radius_pong = acquire(*radius_buffer_pong, 0, GL_RG32F, GL_RG);
+    const auto initial_estimation = acquire(*initial_estimation_buffer, 0, GL_R32F, GL_RED);
+    estimate_initial_radius(depth_texture);
+    release({initial_estimation});
+    profiler->pop();
+
+    // radius ping pong
+    prof.add("estimate knn");
+    profiler->push("splat/estimate_knn");
+    const auto neighbor_counts = acquire(*neighbor_counts_buffer, 0, GL_RGBA32F, GL_RGBA);
+    estimate_knn_radius();
+    release({radius_ping, radius_pong, neighbor_counts});
+    profiler->pop();
+  }
 
   // estimate gaussian
+  // accumulated moments stay in 32bit float while the estimated distributions are stored in 16bit float
   prof.add("estimate gaussian");
+  profiler->push("splat/estimate_gaussian");
+  const auto gaussian_weight = acquire(*gaussian_accum_buffer, 0, GL_R32F, GL_RED);
+  const auto gaussian_mean = acquire(*gaussian_accum_buffer, 1, GL_RGB32F, GL_RGB);
+  const auto gaussian_cov1 = acquire(*gaussian_accum_buffer, 2, GL_RGB32F, GL_RGB);
+  const auto gaussian_cov2 = acquire(*gaussian_accum_buffer, 3, GL_RGB32F, GL_RGB);
+  const auto gaussian_length = acquire(*gaussian_dists_buffer, 0, GL_RGBA16F, GL_RGBA);
+  const auto gaussian_normal = acquire(*gaussian_dists_buffer, 1, GL_RGBA16F, GL_RGBA);
+  const auto gaussian_minor_tangent = acquire(*gaussian_dists_buffer, 2, GL_RGBA16F, GL_RGBA);
+  const auto gaussian_major_tangent = acquire(*gaussian_dists_buffer, 3, GL_RGBA16F, GL_RGBA);
   estimate_gaussian(prof, renderer);
+  release({feedback_radius, gaussian_weight, gaussian_mean, gaussian_cov1, gaussian_cov2});
+  profiler->pop();
 
   prof.add("splatting");
+  profiler->push("splat/splatting");
+  const auto splatting_weight = acquire(*splatting_buffer, 0, GL_R32F, GL_RED);
+  const auto splatting_position = acquire(*splatting_buffer, 1, GL_RGB32F, GL_RGB);
+  const auto splatting_normal = acquire(*splatting_buffer, 2, GL_RGBA16F, GL_RGBA);
+  const auto splatting_color = acquire(*splatting_buffer, 3, GL_RGBA16F, GL_RGBA);
   render_splatting(prof, color_texture);
+  release({gaussian_length, gaussian_normal, gaussian_minor_tangent, gaussian_major_tangent});
+  profiler->pop();
 
   prof.add("finalization");
+  profiler->push("splat/finalization");
   result_buffer->bind();
   glDisable(GL_DEPTH_TEST);
   glClear(GL_COLOR_BUFFER_BIT);
@@ -735,6 +865,8 @@ void ScreenSpaceSplatting::draw(const TextureRenderer& renderer, const glk::Text
   splatting_finalization_shader.unuse();
 
   result_buffer->unbind();
+  release({splatting_weight, splatting_position, splatting_normal, splatting_color});
+  profiler->pop();
 
   prof.add("done");
 
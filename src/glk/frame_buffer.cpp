@@ -41,6 +41,9 @@ void FrameBuffer::set_size(const Eigen::Vector2i& size) {
   glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
 
   for(int i = 0; i < color_buffers.size(); i++) {
+    if(!color_buffers[i]) {
+      continue;
+    }
     color_buffers[i]->set_size(size);
     glFramebufferTexture2D(GL_FRAMEBUFFER, color_attachments[i], GL_TEXTURE_2D, color_buffers[i]->id(), 0);
   }
@@ -110,6 +113,32 @@ glk::Texture& FrameBuffer::add_color_buffer(int layout, GLuint internal_format,
   return *color_buffers.back();
 }
 
+glk::Texture& FrameBuffer::attach_color_buffer(int layout, const std::shared_ptr<Texture>& texture) {
+  while(color_attachments.size() <= layout) {
+    color_attachments.push_back(GL_NONE);
+  }
+  while(color_buffers.size() <= layout) {
+    color_buffers.push_back(nullptr);
+  }
+
+  // skip rebinding if the same texture is already attached
+  if(color_buffers[layout] == texture) {
+    return *texture;
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
+
+  GLenum attachment = GL_COLOR_ATTACHMENT0 + layout;
+  color_attachments[layout] = attachment;
+  color_buffers[layout] = texture;
+  glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture->id(), 0);
+
+  glDrawBuffers(color_attachments.size(), color_attachments.data());
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  return *texture;
+}
+
 glk::Texture& FrameBuffer::add_depth_buffer(GLuint internal_format, GLuint format, GLuint type) {
   glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
   depth_buffer = std::make_shared<Texture>(Eigen::Vector2i(width, height), internal_format, format, type);
@@ -0,0 +1,366 @@
+#include <glk/frame_profiler.hpp>
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <boost/format.hpp>
+
+#include <glk/io/json.hpp>
+#include <glk/console_colors.hpp>
+
+namespace glk {
+
+using namespace glk::console;
+
+namespace {
+
+double to_msec(const FrameProfiler::Clock::duration& duration) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / 1e6;
+}
+
+}  // namespace
+
+FrameProfiler* FrameProfiler::instance_ = nullptr;
+
+FrameProfiler::FrameProfiler(int num_frames_in_flight, int history_length)
+: enabled_(false),
+  history_length(history_length),
+  frame_count(0),
+  dropped_frames(0),
+  start_time(Clock::now()),
+  current_slot(-1),
+  slots(num_frames_in_flight),
+  ring_offset(0),
+  ring_size(0),
+  frame_time_ring(history_length, 0.0f) {}
+
+FrameProfiler::~FrameProfiler() {
+  for (auto& slot : slots) {
+    if (!slot.queries.empty()) {
+      glDeleteQueries(slot.queries.size(), slot.queries.data());
+    }
+  }
+}
+
+FrameProfiler* FrameProfiler::instance() {
+  if (instance_ == nullptr) {
+    instance_ = new FrameProfiler();
+  }
+  return instance_;
+}
+
+void FrameProfiler::set_enabled(bool enabled) {
+  if (enabled_ == enabled) {
+    return;
+  }
+
+  enabled_ = enabled;
+  // Results of unfinished frames are discarded
+  for (auto& slot : slots) {
+    slot.pending = false;
+    slot.num_used_queries = 0;
+    slot.scopes.clear();
+  }
+  scope_stack.clear();
+  current_slot = -1;
+}
+
+void FrameProfiler::clear() {
+  ring_offset = ring_size = 0;
+  dropped_frames = 0;
+  std::fill(frame_time_ring.begin(), frame_time_ring.end(), 0.0f);
+  label_order.clear();
+  label_histories.clear();
+  history.clear();
+}
+
+/**
+ * @brief Finalize the current frame, collect results of past frames whose queries are available, and start a new frame.
+ *        This function never waits for the GPU. If the GPU is more than num_frames_in_flight frames behind, the oldest frame is dropped.
+ */
+void FrameProfiler::new_frame() {
+  if (!enabled_) {
+    return;
+  }
+
+  if (current_slot >= 0) {
+    end_frame();
+  }
+
+  // collect results from the oldest frame
+  for (int i = 1; i <= slots.size(); i++) {
+    auto& slot = slots[(current_slot + i) % slots.size()];
+    if (slot.pending && !collect(slot)) {
+      break;
+    }
+  }
+
+  current_slot = (current_slot + 1) % slots.size();
+  auto& slot = slots[current_slot];
+  if (slot.pending) {
+    dropped_frames++;
+    slot.pending = false;
+  }
+
+  slot.frame_id = frame_count++;
+  slot.num_used_queries = 0;
+  slot.scopes.clear();
+  scope_stack.clear();
+
+  slot.cpu_begin = Clock::now();
+  // the first query gives the origin of the GPU timeline of this frame
+  issue_timestamp(slot);
+}
+
+void FrameProfiler::push(const std::string& label, bool gpu) {
+  if (!enabled_ || current_slot < 0) {
+    return;
+  }
+
+  auto& slot = slots[current_slot];
+
+  PendingScope scope;
+  scope.label = label;
+  scope.depth = scope_stack.size();
+  scope.gpu = gpu;
+  scope.begin_query = gpu ? issue_timestamp(slot) : -1;
+  scope.end_query = -1;
+  scope.cpu_begin = Clock::now();
+
+  scope_stack.push_back(slot.scopes.size());
+  slot.scopes.push_back(scope);
+}
+
+void FrameProfiler::push(const std::string& prefix, const char* name, bool gpu) {
+  if (!enabled_ || current_slot < 0) {
+    return;
+  }
+
+  push(prefix + "/" + name, gpu);
+}
+
+void FrameProfiler::pop() {
+  if (!enabled_ || current_slot < 0 || scope_stack.empty()) {
+    return;
+  }
+
+  auto& slot = slots[current_slot];
+  auto& scope = slot.scopes[scope_stack.back()];
+  scope_stack.pop_back();
+
+  scope.cpu_end = Clock::now();
+  scope.end_query = scope.gpu ? issue_timestamp(slot) : -1;
+}
+
+int FrameProfiler::issue_timestamp(FrameSlot& slot) {
+  if (slot.num_used_queries == slot.queries.size()) {
+    int n = std::max<int>(16, slot.queries.size());
+    slot.queries.resize(slot.queries.size() + n);
+    glGenQueries(n, slot.queries.data() + slot.queries.size() - n);
+  }
+
+  const int index = slot.num_used_queries++;
+  glQueryCounter(slot.queries[index], GL_TIMESTAMP);
+  return index;
+}
+
+void FrameProfiler::end_frame() {
+  while (!scope_stack.empty()) {
+    pop();
+  }
+
+  auto& slot = slots[current_slot];
+  slot.cpu_end = Clock::now();
+  slot.pending = true;
+}
+
+bool FrameProfiler::collect(FrameSlot& slot) {
+  // timestamps are written in order, so the availability of the last query implies that of the others
+  GLint available = 0;
+  glGetQueryObjectiv(slot.queries[slot.num_used_queries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available) {
+    return false;
+  }
+
+  std::vector<GLuint64> timestamps(slot.num_used_queries);
+  for (int i = 0; i < slot.num_used_queries; i++) {
+    glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+  }
+
+  FrameRecord frame;
+  frame.frame_id = slot.frame_id;
+  frame.cpu_begin_msec = to_msec(slot.cpu_begin - start_time);
+  frame.cpu_msec = to_msec(slot.cpu_end - slot.cpu_begin);
+  frame.scopes.reserve(slot.scopes.size());
+
+  for (const auto& scope : slot.scopes) {
+    ScopeRecord rec;
+    rec.label = scope.label;
+    rec.depth = scope.depth;
+    rec.cpu_begin_msec = to_msec(scope.cpu_begin - start_time);
+    rec.cpu_msec = to_msec(scope.cpu_end - scope.cpu_begin);
+    rec.gpu_begin_msec = 0.0;
+    rec.gpu_msec = -1.0;
+
+    if (scope.begin_query >= 0 && scope.end_query >= 0) {
+      rec.gpu_begin_msec = (timestamps[scope.begin_query] - timestamps[0]) / 1e6;
+      rec.gpu_msec = (timestamps[scope.end_query] - timestamps[scope.begin_query]) / 1e6;
+    }
+
+    frame.scopes.push_back(rec);
+  }
+
+  slot.pending = false;
+  record(frame);
+  return true;
+}
+
+void FrameProfiler::record(const FrameRecord& frame) {
+  for (auto& history : label_histories) {
+    history.second.cpu_msec[ring_offset] = 0.0f;
+    history.second.gpu_msec[ring_offset] = 0.0f;
+  }
+
+  frame_time_ring[ring_offset] = frame.cpu_msec;
+  for (const auto& scope : frame.scopes) {
+    auto found = label_histories.find(scope.label);
+    if (found == label_histories.end()) {
+      LabelHistory history;
+      history.cpu_msec.resize(history_length, 0.0f);
+      history.gpu_msec.resize(history_length, 0.0f);
+      found = label_histories.emplace(scope.label, history).first;
+      label_order.push_back(scope.label);
+    }
+
+    // a label may appear several times in a frame (e.g., sub viewers)
+    found->second.cpu_msec[ring_offset] += scope.cpu_msec;
+    found->second.gpu_msec[ring_offset] += std::max(0.0, scope.gpu_msec);
+  }
+
+  ring_offset = (ring_offset + 1) % history_length;
+  ring_size = std::min(ring_size + 1, history_length);
+
+  history.push_back(frame);
+  while (history.size() > history_length) {
+    history.pop_front();
+  }
+}
+
+const std::vector<float>& FrameProfiler::cpu_time_history(const std::string& label) const {
+  static const std::vector<float> empty;
+  auto found = label_histories.find(label);
+  return found == label_histories.end() ? empty : found->second.cpu_msec;
+}
+
+const std::vector<float>& FrameProfiler::gpu_time_history(const std::string& label) const {
+  static const std::vector<float> empty;
+  auto found = label_histories.find(label);
+  return found == label_histories.end() ? empty : found->second.gpu_msec;
+}
+
+double FrameProfiler::average_cpu_time(const std::string& label) const {
+  const auto& values = cpu_time_history(label);
+  if (values.empty() || ring_size == 0) {
+    return 0.0;
+  }
+
+  double sum = 0.0;
+  for (int i = 0; i < ring_size; i++) {
+    sum += values[(ring_offset - 1 - i + history_length) % history_length];
+  }
+  return sum / ring_size;
+}
+
+double FrameProfiler::average_gpu_time(const std::string& label) const {
+  const auto& values = gpu_time_history(label);
+  if (values.empty() || ring_size == 0) {
+    return 0.0;
+  }
+
+  double sum = 0.0;
+  for (int i = 0; i < ring_size; i++) {
+    sum += values[(ring_offset - 1 - i + history_length) % history_length];
+  }
+  return sum / ring_size;
+}
+
+/**
+ * @brief Save the recorded frames in a plain JSON format
+ *        {"frames": [{"frame": id, "cpu_begin": msec, "cpu_time": msec, "scopes": [{"label", "depth", "cpu_begin", "cpu_time", "gpu_begin", "gpu_time"}]}]}
+ */
+bool FrameProfiler::save_json(const std::string& filename) const {
+  std::ofstream ofs(filename);
+  if (!ofs) {
+    std::cerr << bold_red << "error: failed to open " << filename << reset << std::endl;
+    return false;
+  }
+
+  ofs << "{\n  \"frames\": [";
+  for (int i = 0; i < history.size(); i++) {
+    const auto& frame = history[i];
+    ofs << (i ? "," : "") << "\n    {\"frame\": " << frame.frame_id;
+    ofs << boost::format(", \"cpu_begin\": %.6f, \"cpu_time\": %.6f, \"scopes\": [") % frame.cpu_begin_msec % frame.cpu_msec;
+
+    for (int j = 0; j < frame.scopes.size(); j++) {
+      const auto& scope = frame.scopes[j];
+      ofs << (j ? ", " : "") << "{\"label\": \"" << escape_json(scope.label) << "\", \"depth\": " << scope.depth;
+      ofs << boost::format(", \"cpu_begin\": %.6f, \"cpu_time\": %.6f, \"gpu_begin\": %.6f, \"gpu_time\": %.6f}") % scope.cpu_begin_msec % scope.cpu_msec %
+               scope.gpu_begin_msec % scope.gpu_msec;
+    }
+    ofs << "]}";
+  }
+  ofs << "\n  ]\n}" << std::endl;
+
+  return true;
+}
+
+/**
+ * @brief Save the recorded frames in the Chrome trace event format (chrome://tracing, Perfetto)
+ *        CPU scopes are put on thread 0 and GPU scopes are put on thread 1. The GPU timeline of each frame is aligned with its CPU begin time.
+ */
+bool FrameProfiler::save_chrome_trace(const std::string& filename) const {
+  std::ofstream ofs(filename);
+  if (!ofs) {
+    std::cerr << bold_red << "error: failed to open " << filename << reset << std::endl;
+    return false;
+  }
+
+  const auto write_event = [&](const std::string& name, int tid, double begin_msec, double duration_msec) {
+    ofs << ",\n    {\"name\": \"" << escape_json(name) << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << tid;
+    ofs << boost::format(", \"ts\": %.3f, \"dur\": %.3f}") % (begin_msec * 1e3) % (duration_msec * 1e3);
+  };
+
+  ofs << "{\n  \"displayTimeUnit\": \"ms\",\n  \"traceEvents\": [";
+  ofs << "\n    {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": 0, \"args\": {\"name\": \"CPU\"}},";
+  ofs << "\n    {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": 1, \"args\": {\"name\": \"GPU\"}}";
+
+  for (const auto& frame : history) {
+    write_event("frame " + std::to_string(frame.frame_id), 0, frame.cpu_begin_msec, frame.cpu_msec);
+
+    for (const auto& scope : frame.scopes) {
+      write_event(scope.label, 0, scope.cpu_begin_msec, scope.cpu_msec);
+      if (scope.gpu_msec >= 0.0) {
+        write_event(scope.label, 1, frame.cpu_begin_msec + scope.gpu_begin_msec, scope.gpu_msec);
+      }
+    }
+  }
+  ofs << "\n  ]\n}" << std::endl;
+
+  return true;
+}
+
+FrameProfiler::Scope::Scope(const std::string& label, bool gpu) {
+  auto profiler = FrameProfiler::instance();
+  active = profiler->enabled();
+  if (active) {
+    profiler->push(label, gpu);
+  }
+}
+
+FrameProfiler::Scope::~Scope() {
+  if (active) {
+    FrameProfiler::instance()->pop();
+  }
+}
+
+}  // namespace glk
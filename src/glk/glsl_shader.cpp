@@ -4,19 +4,69 @@
 #include <string>
 #include <vector>
 #include <fstream>
-#include <sstream>
 #include <iostream>
 #include <unordered_map>
 
 #include <GL/gl3w.h>
 #include <Eigen/Core>
 
+#include <glk/uniform_buffer.hpp>
 #include <glk/console_colors.hpp>
 
 namespace glk {
 
 using namespace glk::console;
 
+namespace {
+
+/**
+ * @brief Read a shader source and expand #include "path" directives (paths are relative to the including file).
+ *        A #line directive is emitted after each included file to keep compile error line numbers.
+ */
+bool read_shader_source(const std::string& filename, std::string& source, int depth = 0) {
+  if (depth > 8) {
+    std::cerr << bold_red << "error: too deep shader include nesting in " << filename << reset << std::endl;
+    return false;
+  }
+
+  std::ifstream ifs(filename);
+  if (!ifs) {
+    std::cerr << bold_red << "error: failed to open " << filename << reset << std::endl;
+    return false;
+  }
+
+  const size_t slash = filename.find_last_of('/');
+  const std::string directory = slash == std::string::npos ? "" : filename.substr(0, slash + 1);
+
+  int line_number = 0;
+  std::string line;
+  while (std::getline(ifs, line)) {
+    line_number++;
+
+    const size_t directive = line.find_first_not_of(" \t");
+    if (directive == std::string::npos || line.compare(directive, 8, "#include") != 0) {
+      source += line + "\n";
+      continue;
+    }
+
+    const size_t begin = line.find('"', directive);
+    const size_t end = begin == std::string::npos ? begin : line.find('"', begin + 1);
+    if (end == std::string::npos) {
+      std::cerr << bold_red << "error: invalid include directive " << filename << ":" << line_number << reset << std::endl;
+      return false;
+    }
+
+    if (!read_shader_source(directory + line.substr(begin + 1, end - begin - 1), source, depth + 1)) {
+      return false;
+    }
+    source += "#line " + std::to_string(line_number + 1) + "\n";
+  }
+
+  return true;
+}
+
+}  // namespace
+
 GLSLShader::GLSLShader() {
   shader_program = 0;
 }
@@ -91,6 +141,10 @@ bool GLSLShader::link_program() {
     return false;
   }
 
+  // shared uniform blocks are bound to fixed binding points
+  bind_uniform_block("FrameBlock", static_cast<GLuint>(UniformBlockBinding::FRAME));
+  bind_uniform_block("LightBlock", static_cast<GLuint>(UniformBlockBinding::LIGHT));
+
   return true;
 }
 
@@ -125,6 +179,16 @@ GLint GLSLShader::attrib(const std::string& name) {
   return id;
 }
 
+bool GLSLShader::bind_uniform_block(const std::string& name, GLuint binding) {
+  const GLuint index = glGetUniformBlockIndex(shader_program, name.c_str());
+  if (index == GL_INVALID_INDEX) {
+    return false;
+  }
+
+  glUniformBlockBinding(shader_program, index, binding);
+  return true;
+}
+
 GLint GLSLShader::uniform(const std::string& name) {
   auto found = uniform_cache.find(name);
   if (found != uniform_cache.end()) {
@@ -191,19 +255,12 @@ void GLSLShader::set_subroutine(GLenum shader_type, const std::string& loc, cons
 }
 
 GLuint GLSLShader::read_shader_from_file(const std::string& filename, GLuint shader_type) {
-  GLuint shader_id = glCreateShader(shader_type);
-
-  std::stringstream sst;
-
-  std::ifstream ifs(filename);
-  if (!ifs) {
-    std::cerr << bold_red << "error: failed to open " << filename << reset << std::endl;
+  std::string source;
+  if (!read_shader_source(filename, source)) {
     return GL_FALSE;
   }
 
-  sst << ifs.rdbuf();
-
-  std::string source = sst.str();
+  GLuint shader_id = glCreateShader(shader_type);
 
   GLint result = GL_FALSE;
   int info_log_length = 0;
@@ -0,0 +1,276 @@
+#include <glk/gpu_memory_tracker.hpp>
+
+#include <algorithm>
+
+namespace glk {
+
+GpuMemoryTracker::GpuMemoryTracker() {
+  totals[0] = totals[1] = 0;
+  evictable_bytes = 0;
+}
+
+GpuMemoryTracker* GpuMemoryTracker::instance() {
+  // never destroyed so that GL objects released during static destruction can still be untracked
+  static GpuMemoryTracker* instance = new GpuMemoryTracker();
+  return instance;
+}
+
+void GpuMemoryTracker::add(const void* owner, Category category, size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto found = owners.emplace(owner, std::array<size_t, 2>{0, 0}).first;
+  found->second[static_cast<int>(category)] += bytes;
+  totals[static_cast<int>(category)] += bytes;
+
+  if (category == Category::BUFFER && evictable_owners.count(owner)) {
+    evictable_bytes += bytes;
+  }
+}
+
+void GpuMemoryTracker::remove(const void* owner, Category category, size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto found = owners.find(owner);
+  if (found == owners.end()) {
+    return;
+  }
+
+  const int c = static_cast<int>(category);
+  bytes = std::min(bytes, found->second[c]);
+  found->second[c] -= bytes;
+  totals[c] -= bytes;
+
+  if (category == Category::BUFFER && evictable_owners.count(owner)) {
+    evictable_bytes -= bytes;
+  }
+
+  if (found->second[0] == 0 && found->second[1] == 0) {
+    owners.erase(found);
+  }
+}
+
+void GpuMemoryTracker::remove_all(const void* owner) {
+  std::lock_guard<std::mutex> lock(mutex);
+  const bool evictable = evictable_owners.erase(owner);
+
+  auto found = owners.find(owner);
+  if (found == owners.end()) {
+    return;
+  }
+
+  totals[0] -= found->second[0];
+  totals[1] -= found->second[1];
+  if (evictable) {
+    evictable_bytes -= found->second[0];
+  }
+  owners.erase(found);
+}
+
+void GpuMemoryTracker::set_evictable(const void* owner, bool evictable) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (evictable == static_cast<bool>(evictable_owners.count(owner))) {
+    return;
+  }
+
+  auto found = owners.find(owner);
+  const size_t bytes = found == owners.end() ? 0 : found->second[0];
+  if (evictable) {
+    evictable_owners.insert(owner);
+    evictable_bytes += bytes;
+  } else {
+    evictable_owners.erase(owner);
+    evictable_bytes -= bytes;
+  }
+}
+
+size_t GpuMemoryTracker::usage(const void* owner) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto found = owners.find(owner);
+  return found == owners.end() ? 0 : found->second[0] + found->second[1];
+}
+
+size_t GpuMemoryTracker::total() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return totals[0] + totals[1];
+}
+
+size_t GpuMemoryTracker::total(Category category) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return totals[static_cast<int>(category)];
+}
+
+size_t GpuMemoryTracker::total_evictable() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return evictable_bytes;
+}
+
+size_t GpuMemoryTracker::num_owners() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return owners.size();
+}
+
+size_t GpuMemoryTracker::bytes_per_pixel(GLenum internal_format) {
+  switch (internal_format) {
+    case GL_R8:
+    case GL_R8I:
+    case GL_R8UI:
+    case GL_RED:
+      return 1;
+    case GL_RG8:
+    case GL_R16:
+    case GL_R16F:
+    case GL_R16I:
+    case GL_R16UI:
+    case GL_RG:
+      return 2;
+    case GL_RGB8:
+    case GL_RGB:
+      return 3;
+    case GL_RGBA8:
+    case GL_RGBA:
+    case GL_RG16:
+    case GL_RG16F:
+    case GL_R32F:
+    case GL_R32I:
+    case GL_R32UI:
+    case GL_R11F_G11F_B10F:
+    case GL_RGB10_A2:
+    case GL_DEPTH_COMPONENT:
+    case GL_DEPTH_COMPONENT24:
+    case GL_DEPTH_COMPONENT32:
+    case GL_DEPTH_COMPONENT32F:
+    case GL_DEPTH24_STENCIL8:
+      return 4;
+    case GL_RGB16F:
+      return 6;
+    case GL_RGBA16F:
+    case GL_RG32F:
+    case GL_RG32I:
+    case GL_RG32UI:
+      return 8;
+    case GL_RGB32F:
+    case GL_RGB32I:
+    case GL_RGB32UI:
+      return 12;
+    case GL_RGBA32F:
+    case GL_RGBA32I:
+    case GL_RGBA32UI:
+      return 16;
+    default:
+      return 4;
+  }
+}
+
+size_t GpuMemoryTracker::buffer_size(GLuint buffer) {
+  GLint64 size = 0;
+  glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+  glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  return size;
+}
+
+GpuMemoryTracker::EvictedBuffer::EvictedBuffer(GLuint buffer, GLenum usage) : staging(0), fence(nullptr) {
+  // GL_COPY_READ/WRITE_BUFFER are used so as not to modify the element array binding of the current VAO
+  GLint64 size = 0;
+  glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+  glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+  num_bytes = size;
+
+  if (num_bytes) {
+    glGenBuffers(1, &staging);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, staging);
+    glBufferData(GL_COPY_WRITE_BUFFER, num_bytes, nullptr, GL_STREAM_READ);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, num_bytes);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    instance()->add(this, Category::BUFFER, num_bytes);
+  }
+
+  // the copy above is ordered before the storage is released
+  glBufferData(GL_COPY_READ_BUFFER, 0, nullptr, usage);
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+GpuMemoryTracker::EvictedBuffer::~EvictedBuffer() {
+  if (fence) {
+    glDeleteSync(fence);
+  }
+  if (staging) {
+    glDeleteBuffers(1, &staging);
+  }
+  instance()->remove_all(this);
+}
+
+bool GpuMemoryTracker::EvictedBuffer::poll(bool wait) {
+  if (!staging) {
+    return true;
+  }
+
+  const GLenum status = glClientWaitSync(fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? GL_TIMEOUT_IGNORED : 0);
+  if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+    return false;
+  }
+
+  data.resize(num_bytes);
+  glBindBuffer(GL_COPY_READ_BUFFER, staging);
+  glGetBufferSubData(GL_COPY_READ_BUFFER, 0, num_bytes, data.data());
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+  glDeleteSync(fence);
+  glDeleteBuffers(1, &staging);
+  fence = nullptr;
+  staging = 0;
+  instance()->remove_all(this);
+
+  return true;
+}
+
+void GpuMemoryTracker::EvictedBuffer::restore(GLuint buffer, GLenum usage) const {
+  glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+  if (staging) {
+    glBufferData(GL_COPY_WRITE_BUFFER, num_bytes, nullptr, usage);
+    glBindBuffer(GL_COPY_READ_BUFFER, staging);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, num_bytes);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  } else {
+    glBufferData(GL_COPY_WRITE_BUFFER, data.size(), data.data(), usage);
+  }
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+std::shared_ptr<GpuMemoryTracker::EvictedBuffer> GpuMemoryTracker::evict_buffer(GLuint buffer, GLenum usage) {
+  auto evicted = std::make_shared<EvictedBuffer>(buffer, usage);
+  instance()->pending_evictions.push_back(evicted);
+  return evicted;
+}
+
+void GpuMemoryTracker::restore_buffer(GLuint buffer, const EvictedBuffer& data, GLenum usage) {
+  data.restore(buffer, usage);
+}
+
+void GpuMemoryTracker::poll_evicted_buffers() {
+  auto remove_loc = std::remove_if(pending_evictions.begin(), pending_evictions.end(), [](const std::weak_ptr<EvictedBuffer>& pending) {
+    const auto evicted = pending.lock();
+    return !evicted || evicted->poll();
+  });
+  pending_evictions.erase(remove_loc, pending_evictions.end());
+}
+
+void GpuMemoryTracker::grow_buffer(const void* owner, GLuint& buffer, size_t old_size, size_t new_size, GLenum usage) {
+  GLuint new_buffer;
+  glGenBuffers(1, &new_buffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, new_buffer);
+  glBufferData(GL_COPY_WRITE_BUFFER, new_size, nullptr, usage);
+
+  if (buffer) {
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, old_size);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+    instance()->remove(owner, Category::BUFFER, old_size);
+  }
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  instance()->add(owner, Category::BUFFER, new_size);
+  buffer = new_buffer;
+}
+
+}  // namespace glk
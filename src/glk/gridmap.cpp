@@ -72,6 +72,12 @@ GridMap::~GridMap() {
   glDeleteBuffers(1, &vao);
   glDeleteBuffers(1, &vbo);
   glDeleteBuffers(1, &tbo);
+
+  GpuMemoryTracker::instance()->remove_all(this);
+}
+
+size_t GridMap::memory_usage() const {
+  return GpuMemoryTracker::instance()->usage(this) + GpuMemoryTracker::instance()->usage(texture.get());
 }
 
 void GridMap::init_vao(double resolution, int width, int height) {
@@ -94,10 +100,12 @@ void GridMap::init_vao(double resolution, int width, int height) {
   glGenBuffers(1, &vbo);
   glBindBuffer(GL_ARRAY_BUFFER, vbo);
   glBufferData(GL_ARRAY_BUFFER, sizeof(Eigen::Vector3f) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, sizeof(Eigen::Vector3f) * vertices.size());
 
   glGenBuffers(1, &tbo);
   glBindBuffer(GL_ARRAY_BUFFER, tbo);
   glBufferData(GL_ARRAY_BUFFER, sizeof(Eigen::Vector2f) * texcoords.size(), texcoords.data(), GL_STATIC_DRAW);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, sizeof(Eigen::Vector2f) * texcoords.size());
 }
 
 void GridMap::draw(glk::GLSLShader& shader) const {
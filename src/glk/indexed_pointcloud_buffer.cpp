@@ -9,6 +9,7 @@ IndexedPointCloudBuffer::IndexedPointCloudBuffer(const std::shared_ptr<const glk
   glGenBuffers(1, &ebo);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * num_indices, indices, GL_STATIC_DRAW);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, sizeof(unsigned int) * num_indices);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
@@ -19,6 +20,8 @@ IndexedPointCloudBuffer::~IndexedPointCloudBuffer() {
   if (ebo) {
     glDeleteBuffers(1, &ebo);
   }
+
+  GpuMemoryTracker::instance()->remove_all(this);
 }
 
 void IndexedPointCloudBuffer::draw(glk::GLSLShader& shader) const {
@@ -0,0 +1,91 @@
+#include <glk/io/mapped_file.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <iostream>
+#include <glk/console_colors.hpp>
+
+namespace glk {
+
+MappedFile::MappedFile() : fd(-1), writable(false), mapped(nullptr), file_size(0) {}
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+bool MappedFile::open(const std::string& filename) {
+  close();
+
+  fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close();
+    return false;
+  }
+
+  file_size = st.st_size;
+  void* ptr = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (ptr == MAP_FAILED) {
+    close();
+    return false;
+  }
+
+  // the file is read front to back
+  madvise(ptr, file_size, MADV_SEQUENTIAL);
+
+  mapped = static_cast<char*>(ptr);
+  writable = false;
+  return true;
+}
+
+bool MappedFile::create(const std::string& filename, size_t size) {
+  close();
+
+  fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+
+  if (size == 0 || ftruncate(fd, size) != 0) {
+    close();
+    return false;
+  }
+
+  file_size = size;
+  void* ptr = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (ptr == MAP_FAILED) {
+    close();
+    return false;
+  }
+
+  mapped = static_cast<char*>(ptr);
+  writable = true;
+  return true;
+}
+
+void MappedFile::close(size_t truncate_size) {
+  if (mapped) {
+    munmap(mapped, file_size);
+  }
+
+  if (fd >= 0) {
+    if (writable && truncate_size < file_size && ftruncate(fd, truncate_size) != 0) {
+      std::cerr << console::bold_yellow << "warning: failed to truncate the mapped file" << console::reset << std::endl;
+    }
+    ::close(fd);
+  }
+
+  fd = -1;
+  writable = false;
+  mapped = nullptr;
+  file_size = 0;
+}
+
+}  // namespace glk
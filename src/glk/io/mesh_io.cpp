@@ -1,6 +1,9 @@
 #include <glk/io/mesh_io.hpp>
 
+#include <memory>
+#include <future>
 #include <glk/mesh.hpp>
+#include <glk/mesh_simplification.hpp>
 #include <glk/mesh_model.hpp>
 #include <glk/io/image_io.hpp>
 #include <glk/texture.hpp>
@@ -13,7 +16,17 @@
 
 namespace glk {
 
-std::shared_ptr<MeshModel> load_mesh_model(const std::string& path) {
+namespace {
+
+struct LODTask {
+  std::vector<Eigen::Vector3f> vertices;
+  std::vector<int> indices;
+  std::promise<MeshLODChain> lods;
+};
+
+}  // namespace
+
+std::shared_ptr<MeshModel> load_mesh_model(const std::string& path, bool generate_lods) {
   Assimp::Importer importer;
   const auto scene =
     importer.ReadFile(path, aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals | aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType);
@@ -29,6 +42,8 @@ std::shared_ptr<MeshModel> load_mesh_model(const std::string& path) {
   }
 
   auto model = std::make_shared<MeshModel>();
+  std::vector<LODTask> lod_tasks;
+  const MeshLODOptions lod_options;
 
   for (int material_index = 0; material_index < scene->mNumMaterials; material_index++) {
     auto shader_setting = guik::FlatColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -105,20 +120,52 @@ std::shared_ptr<MeshModel> load_mesh_model(const std::string& path) {
       }
     }
 
-    model->push_mesh(
-      mesh->mMaterialIndex,
-      std::make_shared<glk::Mesh>(
-        vertices.data(),
-        sizeof(float) * 3,
-        normals.data(),
-        sizeof(float) * 3,
-        colors.data(),
-        sizeof(float) * 4,
-        tex_coords.data(),
-        sizeof(float) * 2,
-        vertices.size(),
-        faces.data(),
-        faces.size()));
+    auto mesh_buffer = std::make_shared<glk::Mesh>(
+      vertices.data(),
+      sizeof(float) * 3,
+      normals.data(),
+      sizeof(float) * 3,
+      colors.data(),
+      sizeof(float) * 4,
+      tex_coords.data(),
+      sizeof(float) * 2,
+      vertices.size(),
+      faces.data(),
+      faces.size());
+    model->push_mesh(mesh->mMaterialIndex, mesh_buffer);
+
+    // meshes too small to get a simplified level are skipped
+    if (generate_lods && faces.size() / 3 * lod_options.reduction_ratio >= lod_options.min_triangles) {
+      LODTask task;
+      task.vertices = std::move(vertices);
+      task.indices.assign(faces.begin(), faces.end());
+      mesh_buffer->set_lods(task.lods.get_future());
+      lod_tasks.emplace_back(std::move(task));
+    }
+  }
+
+  // a single worker thread owned by the model simplifies all meshes in order (cancelled when the model is destroyed)
+  if (!lod_tasks.empty()) {
+    auto tasks = std::make_shared<std::vector<LODTask>>(std::move(lod_tasks));
+    model->run_worker([tasks, lod_options](const std::atomic_bool& cancel) {
+      MeshLODOptions options = lod_options;
+      options.cancel = &cancel;
+
+      for (auto& task : *tasks) {
+        if (cancel) {
+          // meshes of a cancelled task are drawn without LODs
+          MeshLODChain empty;
+          empty.center.setZero();
+          empty.radius = 0.0f;
+          task.lods.set_value(std::move(empty));
+          continue;
+        }
+
+        task.lods.set_value(glk::generate_lods(task.vertices.data(), task.vertices.size(), task.indices, options));
+        std::vector<Eigen::Vector3f>().swap(task.vertices);
+        std::vector<int>().swap(task.indices);
+      }
+    });
   }
 
   return model;
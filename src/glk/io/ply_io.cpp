@@ -1,12 +1,22 @@
 #include <glk/io/ply_io.hpp>
 
+#include <atomic>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <vector>
+#include <sstream>
 #include <fstream>
+#include <charconv>
 #include <iostream>
+#include <algorithm>
+#include <type_traits>
 #include <Eigen/Core>
 
 #include <glk/mesh_utils.hpp>
 #include <glk/console_colors.hpp>
+#include <glk/io/mapped_file.hpp>
 
 namespace glk {
 
@@ -85,7 +95,7 @@ void transform(const char* vertex_buffer, int vertex_step, int num_vertices, int
   }
 }
 
-std::shared_ptr<PLYData> load_ply_body_binary(std::ifstream& ifs, const PLYMetaData& meta_data) {
+std::shared_ptr<PLYData> load_ply_body_binary(const char* body, const char* body_end, const PLYMetaData& meta_data, const PLYLoadOptions& options) {
   if(meta_data.format.find("big_endian") != std::string::npos) {
     std::cerr << console::bold_red << "error: big endian is not supported!!" << console::reset << std::endl;
     return nullptr;
@@ -96,9 +106,13 @@ std::shared_ptr<PLYData> load_ply_body_binary(std::ifstream& ifs, const PLYMetaD
     property_offsets.push_back(property_offsets.back() + property_bytes(prop.second));
   }
 
+  // the vertex and face sections are read directly from the mapped file
   const int vertex_step = property_offsets.back();
-  std::vector<char> vertex_buffer(vertex_step * meta_data.num_vertices);
-  ifs.read(vertex_buffer.data(), vertex_buffer.size());
+  const char* vertex_buffer = body;
+  if(static_cast<size_t>(body_end - body) < static_cast<size_t>(vertex_step) * meta_data.num_vertices) {
+    std::cerr << console::bold_red << "error: ply vertex data is truncated!!" << console::reset << std::endl;
+    return nullptr;
+  }
 
   std::shared_ptr<PLYData> ply(new PLYData);
   for(int i = 0; i < meta_data.vertex_properties.size(); i++) {
@@ -109,35 +123,35 @@ std::shared_ptr<PLYData> load_ply_body_binary(std::ifstream& ifs, const PLYMetaD
     // xyz
     if(prop_name == "x") {
       ply->vertices.resize(meta_data.num_vertices);
-      transform(vertex_buffer.data(), vertex_step, meta_data.num_vertices, prop_offset, ply->vertices.begin(),
+      transform(vertex_buffer, vertex_step, meta_data.num_vertices, prop_offset, ply->vertices.begin(),
                 [=](const char* data, Eigen::Vector3f& pt) { pt.x() = property_cast<float>(data, prop_type); });
     } else if(prop_name == "y") {
       ply->vertices.resize(meta_data.num_vertices);
-      transform(vertex_buffer.data(), vertex_step, meta_data.num_vertices, prop_offset, ply->vertices.begin(),
+      transform(vertex_buffer, vertex_step, meta_data.num_vertices, prop_offset, ply->vertices.begin(),
                 [=](const char* data, Eigen::Vector3f& pt) { pt.y() = property_cast<float>(data, prop_type); });
     } else if(prop_name == "z") {
       ply->vertices.resize(meta_data.num_vertices);
-      transform(vertex_buffer.data(), vertex_step, meta_data.num_vertices, prop_offset, ply->vertices.begin(),
+      transform(vertex_buffer, vertex_step, meta_data.num_vertices, prop_offset, ply->vertices.begin(),
                 [=](const char* data, Eigen::Vector3f& pt) { pt.z() = property_cast<float>(data, prop_type); });
     }
     // normals
     else if(prop_name == "nx") {
       ply->normals.resize(meta_data.num_vertices);
-      transform(vertex_buffer.data(), vertex_step, meta_data.num_vertices, prop_offset, ply->normals.begin(),
+      transform(vertex_buffer, vertex_step, meta_data.num_vertices, prop_offset, ply->normals.begin(),
                 [=](const char* data, Eigen::Vector3f& pt) { pt.x() = property_cast<float>(data, prop_type); });
     } else if(prop_name == "ny") {
       ply->normals.resize(meta_data.num_vertices);
-      transform(vertex_buffer.data(), vertex_step, meta_data.num_vertices, prop_offset, ply->normals.begin(),
+      transform(vertex_buffer, vertex_step, meta_data.num_vertices, prop_offset, ply->normals.begin(),
                 [=](const char* data, Eigen::Vector3f& pt) { pt.y() = property_cast<float>(data, prop_type); });
     } else if(prop_name == "nz") {
       ply->normals.resize(meta_data.num_vertices);
-      transform(vertex_buffer.data(), vertex_step, meta_data.num_vertices, prop_offset, ply->normals.begin(),
+      transform(vertex_buffer, vertex_step, meta_data.num_vertices, prop_offset, ply->normals.begin(),
                 [=](const char* data, Eigen::Vector3f& pt) { pt.z() = property_cast<float>(data, prop_type); });
     }
     // color
     else if(prop_name == "r" || prop_name == "red") {
       ply->colors.resize(meta_data.num_vertices, Eigen::Vector4f::UnitW());
-      transform(vertex_buffer.data(), vertex_step, meta_data.num_vertices, prop_offset, ply->colors.begin(),
+      transform(vertex_buffer, vertex_step, meta_data.num_vertices, prop_offset, ply->colors.begin(),
                 [=](const char* data, Eigen::Vector4f& pt) { pt[0] = property_cast<float>(data, prop_type); });
       if(prop_type == PLYMetaData::PropertyType::UCHAR) {
         std::for_each(ply->colors.begin(), ply->colors.end(), [](Eigen::Vector4f& pt) { pt[0] /= 255.0f; });
@@ -145,21 +159,21 @@ std::shared_ptr<PLYData> load_ply_body_binary(std::ifstream& ifs, const PLYMetaD
 
     } else if(prop_name == "g" || prop_name == "green") {
       ply->colors.resize(meta_data.num_vertices, Eigen::Vector4f::UnitW());
-      transform(vertex_buffer.data(), vertex_step, meta_data.num_vertices, prop_offset, ply->colors.begin(),
+      transform(vertex_buffer, vertex_step, meta_data.num_vertices, prop_offset, ply->colors.begin(),
                 [=](const char* data, Eigen::Vector4f& pt) { pt[1] = property_cast<float>(data, prop_type); });
       if(prop_type == PLYMetaData::PropertyType::UCHAR) {
         std::for_each(ply->colors.begin(), ply->colors.end(), [](Eigen::Vector4f& pt) { pt[1] /= 255.0f; });
       }
     } else if(prop_name == "b" || prop_name == "blue") {
       ply->colors.resize(meta_data.num_vertices, Eigen::Vector4f::UnitW());
-      transform(vertex_buffer.data(), vertex_step, meta_data.num_vertices, prop_offset, ply->colors.begin(),
+      transform(vertex_buffer, vertex_step, meta_data.num_vertices, prop_offset, ply->colors.begin(),
                 [=](const char* data, Eigen::Vector4f& pt) { pt[2] = property_cast<float>(data, prop_type); });
       if(prop_type == PLYMetaData::PropertyType::UCHAR) {
         std::for_each(ply->colors.begin(), ply->colors.end(), [](Eigen::Vector4f& pt) { pt[2] /= 255.0f; });
       }
     } else if(prop_name == "a" || prop_name == "alpha") {
       ply->colors.resize(meta_data.num_vertices, Eigen::Vector4f::UnitW());
-      transform(vertex_buffer.data(), vertex_step, meta_data.num_vertices, prop_offset, ply->colors.begin(),
+      transform(vertex_buffer, vertex_step, meta_data.num_vertices, prop_offset, ply->colors.begin(),
                 [=](const char* data, Eigen::Vector4f& pt) { pt[3] = property_cast<float>(data, prop_type); });
       if(prop_type == PLYMetaData::PropertyType::UCHAR) {
         std::for_each(ply->colors.begin(), ply->colors.end(), [](Eigen::Vector4f& pt) { pt[3] /= 255.0f; });
@@ -168,7 +182,7 @@ std::shared_ptr<PLYData> load_ply_body_binary(std::ifstream& ifs, const PLYMetaD
     // intensity
     else if(prop_name == "intensity" || prop_name == "scalar_Intensity" || prop_name == "scalar_intensity") {
       ply->intensities.resize(meta_data.num_vertices);
-      transform(vertex_buffer.data(), vertex_step, meta_data.num_vertices, prop_offset, ply->intensities.begin(),
+      transform(vertex_buffer, vertex_step, meta_data.num_vertices, prop_offset, ply->intensities.begin(),
                 [=](const char* data, float& pt) { pt = property_cast<float>(data, prop_type); });
     }
   }
@@ -184,10 +198,14 @@ std::shared_ptr<PLYData> load_ply_body_binary(std::ifstream& ifs, const PLYMetaD
     const auto index_type = meta_data.face_properties[1];
 
     const int face_size = property_bytes(count_type) + property_bytes(index_type) * 3;
-    std::vector<char> index_buffer(face_size * meta_data.num_faces);
-    ifs.read(index_buffer.data(), index_buffer.size());
+    const char* index_buffer = vertex_buffer + static_cast<size_t>(vertex_step) * meta_data.num_vertices;
+    if(static_cast<size_t>(body_end - index_buffer) < static_cast<size_t>(face_size) * meta_data.num_faces) {
+      std::cerr << console::bold_red << "error: ply face data is truncated!!" << console::reset << std::endl;
+      ply->indices.clear();
+      return ply;
+    }
 
-    const char* data_itr = index_buffer.data();
+    const char* data_itr = index_buffer;
     for(int i = 0; i < meta_data.num_faces; i++) {
       int num_vertices = property_cast<int>(data_itr, count_type);
       if(num_vertices != 3) {
@@ -204,8 +222,8 @@ std::shared_ptr<PLYData> load_ply_body_binary(std::ifstream& ifs, const PLYMetaD
       }
     }
 
-    if(ply->normals.empty() && !ply->vertices.empty() && !ply->indices.empty()) {
-      NormalEstimater nest(ply->vertices, ply->indices);
+    if(options.estimate_normals && ply->normals.empty() && !ply->vertices.empty() && !ply->indices.empty()) {
+      NormalEstimater nest(ply->vertices, ply->indices, options.num_threads);
       ply->normals = nest.normals;
     }
   }
@@ -213,106 +231,207 @@ std::shared_ptr<PLYData> load_ply_body_binary(std::ifstream& ifs, const PLYMetaD
   return ply;
 }
 
-std::shared_ptr<PLYData> load_ply_body_ascii(std::ifstream& ifs, const PLYMetaData& meta_data) {
+// destination of each column of the ascii vertex section (resolved once from the header)
+enum class PLYColumn { X, Y, Z, NX, NY, NZ, R, G, B, A, INTENSITY, SKIP };
+
+PLYColumn resolve_column(const std::string& name) {
+  if(name == "x") return PLYColumn::X;
+  if(name == "y") return PLYColumn::Y;
+  if(name == "z") return PLYColumn::Z;
+  if(name == "nx") return PLYColumn::NX;
+  if(name == "ny") return PLYColumn::NY;
+  if(name == "nz") return PLYColumn::NZ;
+  if(name == "r" || name == "red") return PLYColumn::R;
+  if(name == "g" || name == "green") return PLYColumn::G;
+  if(name == "b" || name == "blue") return PLYColumn::B;
+  if(name == "a" || name == "alpha") return PLYColumn::A;
+  if(name == "intensity" || name == "scalar_Intensity" || name == "scalar_intensity") return PLYColumn::INTENSITY;
+  return PLYColumn::SKIP;
+}
+
+inline const char* skip_spaces(const char* ptr, const char* end) {
+  while(ptr < end && (*ptr == ' ' || *ptr == '\t' || *ptr == '\r')) {
+    ptr++;
+  }
+  return ptr;
+}
+
+inline const char* skip_token(const char* ptr, const char* end) {
+  while(ptr < end && *ptr != ' ' && *ptr != '\t' && *ptr != '\r') {
+    ptr++;
+  }
+  return ptr;
+}
+
+// parse a number and move ptr to the end of the token (the value is left unchanged on failure)
+template<typename T>
+inline void parse_number(const char*& ptr, const char* end, T& value) {
+  ptr = skip_spaces(ptr, end);
+#if defined(__cpp_lib_to_chars)
+  const auto result = std::from_chars(ptr, end, value);
+  ptr = skip_token(result.ptr, end);
+#else
+  if constexpr(std::is_floating_point<T>::value) {
+    // the mapped body is not NUL-terminated: copy the token into a bounded buffer for strtof/strtod
+    const char* token_end = skip_token(ptr, end);
+    char token[64];
+    const size_t length = std::min<size_t>(token_end - ptr, sizeof(token) - 1);
+    std::memcpy(token, ptr, length);
+    token[length] = '\0';
+
+    char* parsed_end;
+    T parsed;
+    if constexpr(std::is_same<T, float>::value) {
+      parsed = std::strtof(token, &parsed_end);
+    } else {
+      parsed = std::strtod(token, &parsed_end);
+    }
+    if(parsed_end != token) {
+      value = parsed;
+    }
+    ptr = token_end;
+  } else {
+    const auto result = std::from_chars(ptr, end, value);
+    ptr = skip_token(result.ptr, end);
+  }
+#endif
+}
+
+std::shared_ptr<PLYData> load_ply_body_ascii(const char* body, const char* body_end, const PLYMetaData& meta_data, const PLYLoadOptions& options) {
   std::shared_ptr<PLYData> ply(new PLYData);
 
-  const std::vector<std::string> vertex_props = {"x", "y", "z"};
-  const std::vector<std::string> color_props = {"r", "g", "b", "a", "red", "green", "blue", "alpha"};
-  const std::vector<std::string> normal_props = {"nx", "ny", "nz"};
-  const std::vector<std::string> intensity_props = {"intensity", "scalar_Intensity", "scalar_intensity"};
+  std::vector<PLYColumn> columns;
+  std::vector<float> column_scales;
   for(const auto& prop: meta_data.vertex_properties) {
-    if(std::find(vertex_props.begin(), vertex_props.end(), prop.first) != vertex_props.end()) {
-      ply->vertices.resize(meta_data.num_vertices, Eigen::Vector3f::Zero());
+    const PLYColumn column = resolve_column(prop.first);
+    columns.push_back(column);
+
+    // integer colors are normalized to [0, 1]
+    const bool integer = prop.second != PLYMetaData::PropertyType::FLOAT && prop.second != PLYMetaData::PropertyType::DOUBLE;
+    column_scales.push_back(column >= PLYColumn::R && column <= PLYColumn::A && integer ? 1.0f / 255.0f : 1.0f);
+
+    if(column == PLYColumn::NX || column == PLYColumn::NY || column == PLYColumn::NZ) {
+      ply->normals.resize(meta_data.num_vertices, Eigen::Vector3f::Zero());
     }
-    if(std::find(color_props.begin(), color_props.end(), prop.first) != color_props.end()) {
+    if(column >= PLYColumn::R && column <= PLYColumn::A) {
       ply->colors.resize(meta_data.num_vertices, Eigen::Vector4f::Ones());
     }
-    if(std::find(normal_props.begin(), normal_props.end(), prop.first) != normal_props.end()) {
-      ply->normals.resize(meta_data.num_vertices, Eigen::Vector3f::Zero());
-    }
-    if(std::find(intensity_props.begin(), intensity_props.end(), prop.first) != intensity_props.end()) {
+    if(column == PLYColumn::INTENSITY) {
       ply->intensities.resize(meta_data.num_vertices, 0.0f);
     }
   }
+  ply->vertices.resize(meta_data.num_vertices, Eigen::Vector3f::Zero());
+  ply->indices.resize(meta_data.num_faces * 3);
 
-  ply->vertices.resize(meta_data.num_vertices);
-  for(int i = 0; i < meta_data.num_vertices; i++) {
-    std::string line;
-    std::getline(ifs, line);
+  // split the body into chunks at newline boundaries
+  const size_t body_size = body_end - body;
+  const size_t min_chunk_size = 1 << 20;
+  const int max_threads = options.num_threads > 0 ? options.num_threads : std::thread::hardware_concurrency();
+  const int num_threads = std::max<int>(1, std::min<size_t>(max_threads, body_size / min_chunk_size + 1));
+
+  std::vector<const char*> chunk_begins = {body};
+  for(int i = 1; i < num_threads; i++) {
+    const char* ptr = std::max(chunk_begins.back(), body + body_size * i / num_threads);
+    ptr = static_cast<const char*>(std::memchr(ptr, '\n', body_end - ptr));
+    if(!ptr) {
+      break;
+    }
+    chunk_begins.push_back(ptr + 1);
+  }
+  chunk_begins.push_back(body_end);
+  const int num_chunks = chunk_begins.size() - 1;
 
-    std::stringstream sst(line);
+  const auto run_parallel = [&](const std::function<void(int)>& task) {
+    std::vector<std::thread> threads;
+    for(int i = 1; i < num_chunks; i++) {
+      threads.emplace_back(task, i);
+    }
+    task(0);
+    for(auto& thread : threads) {
+      thread.join();
+    }
+  };
+
+  // count lines in each chunk to get the index of the first line of each chunk
+  std::vector<size_t> chunk_first_lines(num_chunks + 1, 0);
+  run_parallel([&](int chunk) {
+    chunk_first_lines[chunk + 1] = std::count(chunk_begins[chunk], chunk_begins[chunk + 1], '\n');
+  });
+  for(int i = 0; i < num_chunks; i++) {
+    chunk_first_lines[i + 1] += chunk_first_lines[i];
+  }
 
-    for(const auto& prop: meta_data.vertex_properties) {
-      // position
-      if(prop.first == "x") {
-        sst >> ply->vertices[i][0];
-      }
-      if(prop.first == "y") {
-        sst >> ply->vertices[i][1];
+  // parse lines (vertices followed by faces)
+  std::atomic_bool non_triangle_faces(false);
+  run_parallel([&](int chunk) {
+    size_t line_index = chunk_first_lines[chunk];
+    const char* line_end = nullptr;
+    for(const char* line = chunk_begins[chunk]; line < chunk_begins[chunk + 1]; line = line_end + 1, line_index++) {
+      line_end = static_cast<const char*>(std::memchr(line, '\n', chunk_begins[chunk + 1] - line));
+      if(!line_end) {
+        line_end = chunk_begins[chunk + 1];
       }
-      if(prop.first == "z") {
-        sst >> ply->vertices[i][2];
-      }
-      // normal
-      if(prop.first == "nx") {
-        sst >> ply->normals[i][0];
-      }
-      if(prop.first == "ny") {
-        sst >> ply->normals[i][1];
-      }
-      if(prop.first == "nz") {
-        sst >> ply->normals[i][2];
-      }
-      // color
-      if(prop.first == "r" || prop.first == "red") {
-        sst >> ply->colors[i][0];
-        if(prop.second != PLYMetaData::PropertyType::FLOAT && prop.second != PLYMetaData::PropertyType::DOUBLE) {
-          ply->colors[i][0] /= 255.0f;
-        }
-      }
-      if(prop.first == "g" || prop.first == "green") {
-        sst >> ply->colors[i][1];
-        if(prop.second != PLYMetaData::PropertyType::FLOAT && prop.second != PLYMetaData::PropertyType::DOUBLE) {
-          ply->colors[i][1] /= 255.0f;
-        }
-      }
-      if(prop.first == "b" || prop.first == "blue") {
-        sst >> ply->colors[i][2];
-        if(prop.second != PLYMetaData::PropertyType::FLOAT && prop.second != PLYMetaData::PropertyType::DOUBLE) {
-          ply->colors[i][2] /= 255.0f;
+
+      if(line_index < meta_data.num_vertices) {
+        const size_t i = line_index;
+        const char* ptr = line;
+        for(int j = 0; j < columns.size(); j++) {
+          float value = 0.0f;
+          switch(columns[j]) {
+            case PLYColumn::X:
+              parse_number(ptr, line_end, ply->vertices[i][0]);
+              break;
+            case PLYColumn::Y:
+              parse_number(ptr, line_end, ply->vertices[i][1]);
+              break;
+            case PLYColumn::Z:
+              parse_number(ptr, line_end, ply->vertices[i][2]);
+              break;
+            case PLYColumn::NX:
+            case PLYColumn::NY:
+            case PLYColumn::NZ:
+              parse_number(ptr, line_end, ply->normals[i][static_cast<int>(columns[j]) - static_cast<int>(PLYColumn::NX)]);
+              break;
+            case PLYColumn::R:
+            case PLYColumn::G:
+            case PLYColumn::B:
+            case PLYColumn::A:
+              parse_number(ptr, line_end, value);
+              ply->colors[i][static_cast<int>(columns[j]) - static_cast<int>(PLYColumn::R)] = value * column_scales[j];
+              break;
+            case PLYColumn::INTENSITY:
+              parse_number(ptr, line_end, ply->intensities[i]);
+              break;
+            case PLYColumn::SKIP:
+              ptr = skip_token(skip_spaces(ptr, line_end), line_end);
+              break;
+          }
         }
-      }
-      if(prop.first == "a" || prop.first == "alpha") {
-        sst >> ply->colors[i][3];
-        if(prop.second != PLYMetaData::PropertyType::FLOAT && prop.second != PLYMetaData::PropertyType::DOUBLE) {
-          ply->colors[i][3] /= 255.0f;
+      } else if(line_index < meta_data.num_vertices + meta_data.num_faces) {
+        const size_t i = line_index - meta_data.num_vertices;
+        const char* ptr = line;
+
+        int faces = 0;
+        parse_number(ptr, line_end, faces);
+        if(faces != 3) {
+          non_triangle_faces = true;
+          continue;
         }
-      }
-      // intensity
-      if(prop.first == "intensity" || prop.first == "scalar_Intensity" || prop.first == "scalar_intensity") {
-        sst >> ply->intensities[i];
+
+        parse_number(ptr, line_end, ply->indices[i * 3 + 2]);
+        parse_number(ptr, line_end, ply->indices[i * 3 + 1]);
+        parse_number(ptr, line_end, ply->indices[i * 3]);
       }
     }
-  }
-
-  ply->indices.resize(meta_data.num_faces * 3);
-  for(int i = 0; i < meta_data.num_faces; i++) {
-    std::string line;
-    std::getline(ifs, line);
+  });
 
-    int faces = 0;
-    std::stringstream sst(line);
-    sst >> faces >> ply->indices[i * 3 + 2] >> ply->indices[i * 3 + 1] >> ply->indices[i * 3];
-
-    if(faces != 3) {
-      std::cerr << bold_red << "error : only faces with three vertices are supported!!" << reset << std::endl;
-      ply->indices.clear();
-      break;
-    }
+  if(non_triangle_faces) {
+    std::cerr << bold_red << "error : only faces with three vertices are supported!!" << reset << std::endl;
+    ply->indices.clear();
   }
 
-  if(ply->normals.empty() && !ply->vertices.empty() && !ply->indices.empty()) {
-    NormalEstimater nest(ply->vertices, ply->indices);
+  if(options.estimate_normals && ply->normals.empty() && !ply->vertices.empty() && !ply->indices.empty()) {
+    NormalEstimater nest(ply->vertices, ply->indices, options.num_threads);
     ply->normals = nest.normals;
   }
 
@@ -321,18 +440,21 @@ std::shared_ptr<PLYData> load_ply_body_ascii(std::ifstream& ifs, const PLYMetaDa
 
 }  // namespace
 
-std::shared_ptr<PLYData> load_ply(const std::string& filename) {
-  std::ifstream ifs(filename, std::ios::binary);
-  if(!ifs) {
+std::shared_ptr<PLYData> load_ply(const std::string& filename, const PLYLoadOptions& options) {
+  MappedFile file;
+  if(!file.open(filename)) {
     std::cerr << bold_red << "error: failed to open " << filename << reset << std::endl;
     return nullptr;
   }
 
   PLYMetaData meta_data;
 
-  while(!ifs.eof()) {
-    std::string line;
-    std::getline(ifs, line);
+  const char* body = file.data();
+  const char* body_end = file.data() + file.size();
+  while(body < body_end) {
+    const char* line_end = std::find(body, body_end, '\n');
+    std::string line(body, line_end);
+    body = line_end < body_end ? line_end + 1 : body_end;
 
     if(line.empty()) {
       continue;
@@ -376,46 +498,156 @@ std::shared_ptr<PLYData> load_ply(const std::string& filename) {
   }
 
   if(meta_data.format.find("ascii") != std::string::npos) {
-    return load_ply_body_ascii(ifs, meta_data);
+    return load_ply_body_ascii(body, body_end, meta_data, options);
   }
 
   if(meta_data.format.find("binary") != std::string::npos) {
-    return load_ply_body_binary(ifs, meta_data);
+    return load_ply_body_binary(body, body_end, meta_data, options);
   }
 
   std::cerr << console::bold_red << "error: unknown ply format " << meta_data.format << console::reset << std::endl;
   return nullptr;
 }
 
-bool write_ply_header(std::ofstream& ofs, const PLYData& ply, const std::string& type = "ascii") {
-  ofs << "ply" << std::endl;
-  ofs << "format " << type << " 1.0" << std::endl;
-  ofs << "element vertex " << ply.vertices.size() << std::endl;
-  ofs << "property float32 x" << std::endl;
-  ofs << "property float32 y" << std::endl;
-  ofs << "property float32 z" << std::endl;
+namespace {
 
-  if(ply.colors.size()) {
-    ofs << "property float32 red" << std::endl;
-    ofs << "property float32 green" << std::endl;
-    ofs << "property float32 blue" << std::endl;
-    ofs << "property float32 alpha" << std::endl;
+// attributes to be written (an attribute is written if it has one element per vertex)
+struct PLYWriteLayout {
+  PLYWriteLayout(const PLYData& ply, const PLYWriteOptions& options) {
+    normals = options.write_normals && !ply.normals.empty();
+    colors = !ply.colors.empty();
+    uchar_colors = options.uchar_colors;
+    intensities = !ply.intensities.empty();
+    compact_indices = options.compact_indices && ply.vertices.size() <= 65536;
+
+    vertex_bytes = sizeof(float) * 3;
+    vertex_bytes += normals ? sizeof(float) * 3 : 0;
+    vertex_bytes += colors ? (uchar_colors ? 4 : sizeof(float) * 4) : 0;
+    vertex_bytes += intensities ? sizeof(float) : 0;
+
+    face_bytes = compact_indices ? 1 + sizeof(uint16_t) * 3 : sizeof(int32_t) * 4;
   }
 
-  if(ply.intensities.size()) {
-    ofs << "property float32 intensity" << std::endl;
+  bool validate(const PLYData& ply) const {
+    const size_t n = ply.vertices.size();
+    if((normals && ply.normals.size() != n) || (colors && ply.colors.size() != n) || (intensities && ply.intensities.size() != n)) {
+      std::cerr << bold_red << "error: the numbers of ply vertex attributes are inconsistent!!" << reset << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  bool normals;
+  bool colors;
+  bool uchar_colors;
+  bool intensities;
+  bool compact_indices;
+
+  size_t vertex_bytes;
+  size_t face_bytes;
+};
+
+std::string ply_header(const PLYData& ply, const std::string& type, const PLYWriteLayout& layout) {
+  std::stringstream sst;
+  sst << "ply" << std::endl;
+  sst << "format " << type << " 1.0" << std::endl;
+  sst << "element vertex " << ply.vertices.size() << std::endl;
+  sst << "property float32 x" << std::endl;
+  sst << "property float32 y" << std::endl;
+  sst << "property float32 z" << std::endl;
+
+  if(layout.normals) {
+    sst << "property float32 nx" << std::endl;
+    sst << "property float32 ny" << std::endl;
+    sst << "property float32 nz" << std::endl;
+  }
+
+  if(layout.colors) {
+    const std::string color_type = layout.uchar_colors ? "uchar" : "float32";
+    sst << "property " << color_type << " red" << std::endl;
+    sst << "property " << color_type << " green" << std::endl;
+    sst << "property " << color_type << " blue" << std::endl;
+    sst << "property " << color_type << " alpha" << std::endl;
+  }
+
+  if(layout.intensities) {
+    sst << "property float32 intensity" << std::endl;
   }
 
   if(ply.indices.size()) {
-    ofs << "element face " << ply.indices.size() / 3 << std::endl;
-    ofs << "property list int32 int32 vertex_indices" << std::endl;
+    sst << "element face " << ply.indices.size() / 3 << std::endl;
+    sst << (layout.compact_indices ? "property list uchar uint16 vertex_indices" : "property list int32 int32 vertex_indices") << std::endl;
   }
-  ofs << "end_header" << std::endl;
+  sst << "end_header" << std::endl;
+
+  return sst.str();
+}
+
+template<typename T>
+inline char* pack(char* dst, const T& value) {
+  std::memcpy(dst, &value, sizeof(T));
+  return dst + sizeof(T);
+}
+
+// pack vertices [begin, end) into dst and return the end of the written data
+char* pack_vertices(const PLYData& ply, const PLYWriteLayout& layout, size_t begin, size_t end, char* dst) {
+  for(size_t i = begin; i < end; i++) {
+    dst = pack(dst, ply.vertices[i]);
+
+    if(layout.normals) {
+      dst = pack(dst, ply.normals[i]);
+    }
+
+    if(layout.colors) {
+      if(layout.uchar_colors) {
+        for(int j = 0; j < 4; j++) {
+          *(dst++) = static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, ply.colors[i][j] * 255.0f + 0.5f)));
+        }
+      } else {
+        dst = pack(dst, ply.colors[i]);
+      }
+    }
 
+    if(layout.intensities) {
+      dst = pack(dst, ply.intensities[i]);
+    }
+  }
+
+  return dst;
+}
+
+// pack faces [begin, end) into dst and return the end of the written data
+char* pack_faces(const PLYData& ply, const PLYWriteLayout& layout, size_t begin, size_t end, char* dst) {
+  for(size_t i = begin; i < end; i++) {
+    if(layout.compact_indices) {
+      *(dst++) = 3;
+      for(int j = 0; j < 3; j++) {
+        dst = pack(dst, static_cast<uint16_t>(ply.indices[i * 3 + j]));
+      }
+    } else {
+      dst = pack(dst, static_cast<int32_t>(3));
+      for(int j = 0; j < 3; j++) {
+        dst = pack(dst, static_cast<int32_t>(ply.indices[i * 3 + j]));
+      }
+    }
+  }
+
+  return dst;
+}
+
+}  // namespace
+
+bool write_ply_header(std::ofstream& ofs, const PLYData& ply, const std::string& type = "ascii") {
+  ofs << ply_header(ply, type, PLYWriteLayout(ply, PLYWriteOptions()));
   return true;
 }
 
 bool save_ply_ascii(const std::string& filename, const PLYData& ply) {
+  const PLYWriteLayout layout(ply, PLYWriteOptions());
+  if(!layout.validate(ply)) {
+    return false;
+  }
+
   std::ofstream ofs(filename);
   if(!ofs) {
     std::cerr << bold_red << "error: failed to open " << filename << std::endl;
@@ -427,6 +659,10 @@ bool save_ply_ascii(const std::string& filename, const PLYData& ply) {
   for(int i = 0; i < ply.vertices.size(); i++) {
     ofs << ply.vertices[i][0] << " " << ply.vertices[i][1] << " " << ply.vertices[i][2];
 
+    if(layout.normals) {
+      ofs << " " << ply.normals[i][0] << " " << ply.normals[i][1] << " " << ply.normals[i][2];
+    }
+
     if(ply.colors.size()) {
       ofs << " " << ply.colors[i][0] << " " << ply.colors[i][1] << " " << ply.colors[i][2] << " " << ply.colors[i][3];
     }
@@ -445,60 +681,61 @@ bool save_ply_ascii(const std::string& filename, const PLYData& ply) {
   return true;
 }
 
-struct PLYFace {
-  int32_t num_indices;
-  int32_t indices[3];
-};
-
-bool save_ply_binary(const std::string& filename, const PLYData& ply) {
-  std::ofstream ofs(filename, std::ios::binary);
-  if(!ofs) {
-    std::cerr << bold_red << "error: failed to open " << filename << std::endl;
+bool save_ply_binary(const std::string& filename, const PLYData& ply, const PLYWriteOptions& options) {
+  const PLYWriteLayout layout(ply, options);
+  if(!layout.validate(ply)) {
     return false;
   }
 
-  write_ply_header(ofs, ply, "binary_little_endian");
+  const std::string header = ply_header(ply, "binary_little_endian", layout);
+  const size_t num_vertices = ply.vertices.size();
+  const size_t num_faces = ply.indices.size() / 3;
 
-  int num_fields = 3;
-  if(ply.colors.size()) {
-    num_fields += 4;
-  }
-  if(ply.intensities.size()) {
-    num_fields += 1;
-  }
+  // write directly into the mapped output file
+  if(options.use_mmap) {
+    const size_t file_size = header.size() + layout.vertex_bytes * num_vertices + layout.face_bytes * num_faces;
 
-  Eigen::Matrix<float, -1, -1, Eigen::RowMajor> data(ply.vertices.size(), num_fields);
-  for(int i = 0; i < ply.vertices.size(); i++) {
-    int begin = 0;
-    for(int j = 0; j < 3; j++) {
-      data(i, begin + j) = ply.vertices[i][j];
+    MappedFile file;
+    if(!file.create(filename, file_size)) {
+      std::cerr << bold_red << "error: failed to open " << filename << reset << std::endl;
+      return false;
     }
-    begin += 3;
 
-    if(ply.colors.size()) {
-      for(int j = 0; j < 4; j++) {
-        data(i, begin + j) = ply.colors[i][j];
-      }
-      begin += 4;
-    }
+    char* dst = file.mutable_data();
+    dst = std::copy(header.begin(), header.end(), dst);
+    dst = pack_vertices(ply, layout, 0, num_vertices, dst);
+    dst = pack_faces(ply, layout, 0, num_faces, dst);
+    return true;
+  }
 
-    if(ply.intensities.size()) {
-      data(i, begin) = ply.intensities[i];
-      begin += 1;
-    }
+  std::ofstream ofs(filename, std::ios::binary);
+  if(!ofs) {
+    std::cerr << bold_red << "error: failed to open " << filename << reset << std::endl;
+    return false;
   }
 
-  ofs.write(reinterpret_cast<const char*>(data.data()), sizeof(float) * num_fields * ply.vertices.size());
+  ofs << header;
 
-  std::vector<PLYFace> faces(ply.indices.size() / 3);
-  for(int i = 0; i < ply.indices.size() / 3; i++) {
-    faces[i].num_indices = 3;
-    for(int j = 0; j < 3; j++) {
-      faces[i].indices[j] = ply.indices[i * 3 + j];
-    }
+  // stream fixed-size chunks of packed records
+  const size_t chunk_size = 1 << 16;
+  std::vector<char> buffer(chunk_size * std::max(layout.vertex_bytes, layout.face_bytes));
+
+  for(size_t begin = 0; begin < num_vertices; begin += chunk_size) {
+    const size_t end = std::min(num_vertices, begin + chunk_size);
+    const char* buffer_end = pack_vertices(ply, layout, begin, end, buffer.data());
+    ofs.write(buffer.data(), buffer_end - buffer.data());
+  }
+
+  for(size_t begin = 0; begin < num_faces; begin += chunk_size) {
+    const size_t end = std::min(num_faces, begin + chunk_size);
+    const char* buffer_end = pack_faces(ply, layout, begin, end, buffer.data());
+    ofs.write(buffer.data(), buffer_end - buffer.data());
   }
 
-  ofs.write(reinterpret_cast<const char*>(faces.data()), sizeof(PLYFace) * faces.size());
+  if(!ofs) {
+    std::cerr << bold_red << "error: failed to write " << filename << reset << std::endl;
+    return false;
+  }
 
   return true;
 }
@@ -0,0 +1,250 @@
+#include <glk/io/point_cache_io.hpp>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <cstring>
+#include <numeric>
+#include <iostream>
+#include <algorithm>
+
+#include <glk/io/ply_io.hpp>
+#include <glk/pointcloud_buffer.hpp>
+#include <glk/console_colors.hpp>
+
+namespace glk {
+
+using namespace glk::console;
+
+namespace {
+
+const char point_cache_magic[8] = {'G', 'L', 'K', 'C', 'A', 'C', 'H', 'E'};
+const uint32_t point_cache_version = 1;
+
+size_t align64(size_t offset) {
+  return (offset + 63) & ~static_cast<size_t>(63);
+}
+
+// sort points by chunk and shuffle points in each chunk
+std::vector<size_t> chunk_points(const Eigen::Vector3f* points, size_t num_points, double chunk_size, std::vector<PointCacheChunk>& chunks) {
+  std::vector<std::pair<Eigen::Vector3i, size_t>> keys(num_points);
+  for (size_t i = 0; i < num_points; i++) {
+    keys[i].first = (points[i].cast<double>() / chunk_size).array().floor().cast<int>();
+    keys[i].second = i;
+  }
+
+  std::sort(keys.begin(), keys.end(), [](const auto& lhs, const auto& rhs) {
+    return std::lexicographical_compare(lhs.first.data(), lhs.first.data() + 3, rhs.first.data(), rhs.first.data() + 3);
+  });
+
+  std::vector<size_t> order(num_points);
+  std::mt19937 mt(8192);
+
+  for (size_t begin = 0; begin < num_points;) {
+    size_t end = begin;
+    while (end < num_points && keys[end].first == keys[begin].first) {
+      end++;
+    }
+
+    PointCacheChunk chunk;
+    std::memset(&chunk, 0, sizeof(chunk));
+    Eigen::Map<Eigen::Vector3f> min(chunk.min);
+    Eigen::Map<Eigen::Vector3f> max(chunk.max);
+    min.setConstant(std::numeric_limits<float>::max());
+    max.setConstant(std::numeric_limits<float>::lowest());
+
+    for (size_t i = begin; i < end; i++) {
+      order[i] = keys[i].second;
+      min = min.cwiseMin(points[order[i]]);
+      max = max.cwiseMax(points[order[i]]);
+    }
+    std::shuffle(order.begin() + begin, order.begin() + end, mt);
+
+    chunk.first = begin;
+    chunk.count = end - begin;
+    chunks.push_back(chunk);
+
+    begin = end;
+  }
+
+  return order;
+}
+
+template <typename T>
+void write_block(char* dst, const T* src, const std::vector<size_t>& order, size_t num_points) {
+  if (order.empty()) {
+    std::memcpy(dst, src, sizeof(T) * num_points);
+    return;
+  }
+
+  for (size_t i = 0; i < num_points; i++) {
+    std::memcpy(dst + sizeof(T) * i, src + order[i], sizeof(T));
+  }
+}
+
+}  // namespace
+
+bool save_point_cache(
+  const std::string& filename,
+  const Eigen::Vector3f* points,
+  const Eigen::Vector3f* normals,
+  const Eigen::Vector4f* colors,
+  const float* intensities,
+  size_t num_points,
+  const PointCacheOptions& options) {
+  PointCacheHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, point_cache_magic, sizeof(header.magic));
+  header.version = point_cache_version;
+  header.num_points = num_points;
+
+  Eigen::Map<Eigen::Vector4f> bbox_min(header.bbox_min);
+  Eigen::Map<Eigen::Vector4f> bbox_max(header.bbox_max);
+  if (num_points) {
+    bbox_min.head<3>().setConstant(std::numeric_limits<float>::max());
+    bbox_max.head<3>().setConstant(std::numeric_limits<float>::lowest());
+    for (size_t i = 0; i < num_points; i++) {
+      bbox_min.head<3>() = bbox_min.head<3>().cwiseMin(points[i]);
+      bbox_max.head<3>() = bbox_max.head<3>().cwiseMax(points[i]);
+    }
+    bbox_min[3] = bbox_max[3] = 1.0f;
+  }
+
+  std::vector<size_t> order;
+  std::vector<PointCacheChunk> chunks;
+  if (options.chunk_size > 0.0 && num_points) {
+    order = chunk_points(points, num_points, options.chunk_size, chunks);
+    header.num_chunks = chunks.size();
+    header.num_lod_levels = options.lod_ratios.size();
+  }
+
+  // block layout
+  size_t offset = sizeof(PointCacheHeader);
+  const auto reserve = [&](bool present, size_t bytes) -> uint64_t {
+    if (!present) {
+      return 0;
+    }
+    const size_t block_offset = align64(offset);
+    offset = block_offset + bytes;
+    return block_offset;
+  };
+
+  header.vertices_offset = reserve(true, sizeof(Eigen::Vector3f) * num_points);
+  header.normals_offset = reserve(normals, sizeof(Eigen::Vector3f) * num_points);
+  header.colors_offset = reserve(colors, sizeof(Eigen::Vector4f) * num_points);
+  header.intensities_offset = reserve(intensities, sizeof(float) * num_points);
+  header.chunks_offset = reserve(!chunks.empty(), sizeof(PointCacheChunk) * chunks.size());
+  header.lod_ratios_offset = reserve(header.num_lod_levels, sizeof(float) * header.num_lod_levels);
+
+  MappedFile file;
+  if (!file.create(filename, offset)) {
+    std::cerr << bold_red << "error: failed to open " << filename << reset << std::endl;
+    return false;
+  }
+
+  char* data = file.mutable_data();
+  std::memcpy(data, &header, sizeof(header));
+
+  write_block(data + header.vertices_offset, points, order, num_points);
+  if (normals) {
+    write_block(data + header.normals_offset, normals, order, num_points);
+  }
+  if (colors) {
+    write_block(data + header.colors_offset, colors, order, num_points);
+  }
+  if (intensities) {
+    write_block(data + header.intensities_offset, intensities, order, num_points);
+  }
+  if (!chunks.empty()) {
+    std::memcpy(data + header.chunks_offset, chunks.data(), sizeof(PointCacheChunk) * chunks.size());
+  }
+  if (header.num_lod_levels) {
+    std::memcpy(data + header.lod_ratios_offset, options.lod_ratios.data(), sizeof(float) * header.num_lod_levels);
+  }
+
+  return true;
+}
+
+bool save_point_cache(const std::string& filename, const PLYData& ply, const PointCacheOptions& options) {
+  const size_t n = ply.vertices.size();
+  return save_point_cache(
+    filename,
+    ply.vertices.data(),
+    ply.normals.size() == n ? ply.normals.data() : nullptr,
+    ply.colors.size() == n ? ply.colors.data() : nullptr,
+    ply.intensities.size() == n ? ply.intensities.data() : nullptr,
+    n,
+    options);
+}
+
+PointCache::Ptr PointCache::load(const std::string& filename) {
+  Ptr cache(new PointCache);
+  if (!cache->file.open(filename)) {
+    std::cerr << bold_red << "error: failed to open " << filename << reset << std::endl;
+    return nullptr;
+  }
+
+  if (cache->file.size() < sizeof(PointCacheHeader)) {
+    std::cerr << bold_red << "error: " << filename << " is not a point cache" << reset << std::endl;
+    return nullptr;
+  }
+
+  cache->header = reinterpret_cast<const PointCacheHeader*>(cache->file.data());
+  const PointCacheHeader& header = *cache->header;
+  if (std::memcmp(header.magic, point_cache_magic, sizeof(header.magic)) != 0) {
+    std::cerr << bold_red << "error: " << filename << " is not a point cache" << reset << std::endl;
+    return nullptr;
+  }
+
+  if (header.version != point_cache_version) {
+    std::cerr << bold_red << "error: unsupported point cache version " << header.version << " (" << filename << ")" << reset << std::endl;
+    return nullptr;
+  }
+
+  // make sure that all blocks are in the file
+  const size_t n = header.num_points;
+  const std::pair<uint64_t, size_t> blocks[] = {
+    {header.vertices_offset, sizeof(Eigen::Vector3f) * n},
+    {header.normals_offset, sizeof(Eigen::Vector3f) * n},
+    {header.colors_offset, sizeof(Eigen::Vector4f) * n},
+    {header.intensities_offset, sizeof(float) * n},
+    {header.chunks_offset, sizeof(PointCacheChunk) * header.num_chunks},
+    {header.lod_ratios_offset, sizeof(float) * header.num_lod_levels}};
+
+  for (const auto& block : blocks) {
+    if (block.first && (block.first % 64 || block.first + block.second > cache->file.size())) {
+      std::cerr << bold_red << "error: point cache " << filename << " is truncated or corrupted" << reset << std::endl;
+      return nullptr;
+    }
+  }
+
+  if (!header.vertices_offset || (header.num_chunks && !header.chunks_offset) || (header.num_lod_levels && !header.lod_ratios_offset)) {
+    std::cerr << bold_red << "error: point cache " << filename << " is truncated or corrupted" << reset << std::endl;
+    return nullptr;
+  }
+
+  return cache;
+}
+
+size_t PointCache::lod_count(size_t chunk, int level) const {
+  const size_t count = chunks()[chunk].count;
+  if (level < 0 || level >= num_lod_levels()) {
+    return count;
+  }
+
+  return std::min<size_t>(count, std::ceil(count * lod_ratio(level)));
+}
+
+std::shared_ptr<PointCloudBuffer> PointCache::create_buffer() const {
+  auto buffer = std::make_shared<PointCloudBuffer>(vertices()->data(), sizeof(Eigen::Vector3f), size());
+  if (normals()) {
+    buffer->add_normals(normals()->data(), sizeof(Eigen::Vector3f), size());
+  }
+  if (colors()) {
+    buffer->add_color(colors()->data(), sizeof(Eigen::Vector4f), size());
+  }
+
+  return buffer;
+}
+
+}  // namespace glk
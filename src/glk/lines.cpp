@@ -63,6 +63,7 @@ Lines::Lines(float line_width, const Eigen::Vector3f* vertices_, const Eigen::Ve
   glGenBuffers(1, &vbo);
   glBindBuffer(GL_ARRAY_BUFFER, vbo);
   glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices_ext.size() * 3, vertices_ext.data(), GL_STATIC_DRAW);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, sizeof(float) * vertices_ext.size() * 3);
 
   if (!colors.empty()) {
     std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f>> colors_ext(colors.size() * 4);
@@ -75,6 +76,7 @@ Lines::Lines(float line_width, const Eigen::Vector3f* vertices_, const Eigen::Ve
     glGenBuffers(1, &cbo);
     glBindBuffer(GL_ARRAY_BUFFER, cbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(float) * colors_ext.size() * 4, colors_ext.data(), GL_STATIC_DRAW);
+    GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, sizeof(float) * colors_ext.size() * 4);
   }
 
   if (!infos.empty()) {
@@ -88,6 +90,7 @@ Lines::Lines(float line_width, const Eigen::Vector3f* vertices_, const Eigen::Ve
     glGenBuffers(1, &ibo);
     glBindBuffer(GL_ARRAY_BUFFER, ibo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(int) * infos_ext.size() * 4, infos_ext.data(), GL_STATIC_DRAW);
+    GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, sizeof(int) * infos_ext.size() * 4);
   }
 
   /*
@@ -115,6 +118,7 @@ Lines::Lines(float line_width, const Eigen::Vector3f* vertices_, const Eigen::Ve
   glGenBuffers(1, &ebo);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(int) * indices.size(), indices.data(), GL_STATIC_DRAW);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, sizeof(int) * indices.size());
 
   glBindVertexArray(0);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -135,6 +139,8 @@ Lines::~Lines() {
 
   glDeleteBuffers(1, &ebo);
   glDeleteVertexArrays(1, &vao);
+
+  GpuMemoryTracker::instance()->remove_all(this);
 }
 
 void Lines::draw(glk::GLSLShader& shader) const {
@@ -1,12 +1,16 @@
 #include <glk/mesh.hpp>
 
+#include <chrono>
 #include <vector>
+#include <cstdint>
+#include <algorithm>
 #include <Eigen/Core>
 
 #include <GL/gl3w.h>
 #include <glk/texture.hpp>
 #include <glk/drawable.hpp>
 #include <glk/glsl_shader.hpp>
+#include <glk/mesh_optimization.hpp>
 
 namespace glk {
 
@@ -22,6 +26,84 @@ Mesh::Mesh(
   int num_vertices,
   const void* indices,
   int num_indices,
+  bool wireframe,
+  bool optimize) {
+  //
+  if (optimize && indices && num_indices >= 3) {
+    const auto optimized = optimize_mesh(
+      vertices,
+      vertex_stride,
+      normals,
+      normal_stride,
+      colors,
+      color_stride,
+      tex_coords,
+      tex_coord_stride,
+      num_vertices,
+      static_cast<const int*>(indices),
+      num_indices);
+    create_buffers(optimized, wireframe);
+    return;
+  }
+
+  create_buffers(vertices, vertex_stride, normals, normal_stride, colors, color_stride, tex_coords, tex_coord_stride, num_vertices, indices, num_indices, GL_UNSIGNED_INT, wireframe);
+}
+
+Mesh::Mesh(const OptimizedMesh& mesh, bool wireframe) {
+  create_buffers(mesh, wireframe);
+}
+
+Mesh::Mesh(const void* vertices, int vertex_stride, const void* normals, int normal_stride, int num_vertices, const void* indices, int num_indices, bool wireframe, bool optimize)
+: Mesh(vertices, vertex_stride, normals, normal_stride, nullptr, 0, num_vertices, indices, num_indices, wireframe, optimize) {}
+
+Mesh::Mesh(
+  const void* vertices,
+  int vertex_stride,
+  const void* normals,
+  int normal_stride,
+  const void* colors,
+  int color_stride,
+  int num_vertices,
+  const void* indices,
+  int num_indices,
+  bool wireframe,
+  bool optimize)
+: Mesh(vertices, vertex_stride, normals, normal_stride, colors, color_stride, nullptr, 0, num_vertices, indices, num_indices, wireframe, optimize) {}
+
+void Mesh::create_buffers(const OptimizedMesh& mesh, bool wireframe) {
+  const auto data = [](const std::vector<char>& buffer) { return buffer.empty() ? nullptr : buffer.data(); };
+  const bool short_indices = !mesh.short_indices.empty();
+
+  vertex_remap = mesh.vertex_remap;
+  create_buffers(
+    data(mesh.vertices),
+    mesh.vertex_stride,
+    data(mesh.normals),
+    mesh.normal_stride,
+    data(mesh.colors),
+    mesh.color_stride,
+    data(mesh.tex_coords),
+    mesh.tex_coord_stride,
+    mesh.num_vertices,
+    short_indices ? static_cast<const void*>(mesh.short_indices.data()) : static_cast<const void*>(mesh.indices.data()),
+    mesh.indices.size(),
+    short_indices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+    wireframe);
+}
+
+void Mesh::create_buffers(
+  const void* vertices,
+  int vertex_stride,
+  const void* normals,
+  int normal_stride,
+  const void* colors,
+  int color_stride,
+  const void* tex_coords,
+  int tex_coord_stride,
+  int num_vertices,
+  const void* indices,
+  int num_indices,
+  GLenum index_type,
   bool wireframe) {
   //
   this->wireframe = wireframe;
@@ -32,6 +114,9 @@ Mesh::Mesh(
   this->color_stride = color_stride;
   this->tex_coord_stride = tex_coord_stride;
   this->texture_target = GL_TEXTURE1;
+  this->index_type = index_type;
+  this->lod_level = 0;
+  this->bounding_sphere.setZero();
 
   vbo = nbo = cbo = tbo = ebo = 0;
 
@@ -41,50 +126,40 @@ Mesh::Mesh(
   glGenBuffers(1, &vbo);
   glBindBuffer(GL_ARRAY_BUFFER, vbo);
   glBufferData(GL_ARRAY_BUFFER, vertex_stride * num_vertices, vertices, GL_STATIC_DRAW);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, vertex_stride * num_vertices);
 
   if (normals) {
     glGenBuffers(1, &nbo);
     glBindBuffer(GL_ARRAY_BUFFER, nbo);
     glBufferData(GL_ARRAY_BUFFER, normal_stride * num_vertices, normals, GL_STATIC_DRAW);
+    GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, normal_stride * num_vertices);
   }
 
   if (colors) {
     glGenBuffers(1, &cbo);
     glBindBuffer(GL_ARRAY_BUFFER, cbo);
     glBufferData(GL_ARRAY_BUFFER, color_stride * num_vertices, colors, GL_STATIC_DRAW);
+    GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, color_stride * num_vertices);
   }
 
   if (tex_coords) {
     glGenBuffers(1, &tbo);
     glBindBuffer(GL_ARRAY_BUFFER, tbo);
     glBufferData(GL_ARRAY_BUFFER, tex_coord_stride * num_vertices, tex_coords, GL_STATIC_DRAW);
+    GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, tex_coord_stride * num_vertices);
   }
 
   glGenBuffers(1, &ebo);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * num_indices, indices, GL_STATIC_DRAW);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_size() * num_indices, indices, GL_STATIC_DRAW);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, index_size() * num_indices);
+  GpuMemoryTracker::instance()->set_evictable(this, true);
 
   glBindVertexArray(0);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
-Mesh::Mesh(const void* vertices, int vertex_stride, const void* normals, int normal_stride, int num_vertices, const void* indices, int num_indices, bool wireframe)
-: Mesh(vertices, vertex_stride, normals, normal_stride, nullptr, 0, num_vertices, indices, num_indices, wireframe) {}
-
-Mesh::Mesh(
-  const void* vertices,
-  int vertex_stride,
-  const void* normals,
-  int normal_stride,
-  const void* colors,
-  int color_stride,
-  int num_vertices,
-  const void* indices,
-  int num_indices,
-  bool wireframe)
-: Mesh(vertices, vertex_stride, normals, normal_stride, colors, color_stride, nullptr, 0, num_vertices, indices, num_indices, wireframe) {}
-
 Mesh ::~Mesh() {
   glDeleteBuffers(1, &vbo);
   if (nbo) {
@@ -98,7 +173,12 @@ Mesh ::~Mesh() {
   }
 
   glDeleteBuffers(1, &ebo);
+  if (!lod_ebos.empty()) {
+    glDeleteBuffers(lod_ebos.size(), lod_ebos.data());
+  }
   glDeleteVertexArrays(1, &vao);
+
+  GpuMemoryTracker::instance()->remove_all(this);
 }
 
 void Mesh::set_texture(const std::shared_ptr<Texture>& texture, GLenum texture_target) {
@@ -106,7 +186,76 @@ void Mesh::set_texture(const std::shared_ptr<Texture>& texture, GLenum texture_t
   this->texture_target = texture_target;
 }
 
+void Mesh::set_lods(const MeshLODChain& lods) {
+  pending_lods = std::future<MeshLODChain>();
+  create_lod_buffers(lods);
+}
+
+void Mesh::set_lods(std::future<MeshLODChain>&& lods) {
+  pending_lods = std::move(lods);
+}
+
+void Mesh::create_lod_buffers(const MeshLODChain& lods) const {
+  restore();
+
+  if (!lod_ebos.empty()) {
+    glDeleteBuffers(lod_ebos.size(), lod_ebos.data());
+    for (const int n : lod_num_indices) {
+      GpuMemoryTracker::instance()->remove(this, GpuMemoryTracker::Category::BUFFER, index_size() * n);
+    }
+  }
+
+  bounding_sphere << lods.center, lods.radius;
+  lod_ebos.resize(lods.levels.size());
+  lod_num_indices.resize(lods.levels.size());
+  lod_errors.resize(lods.levels.size());
+
+  if (!lod_ebos.empty()) {
+    glGenBuffers(lod_ebos.size(), lod_ebos.data());
+  }
+
+  std::vector<int> remapped_indices;
+  std::vector<std::uint16_t> short_indices;
+  for (int i = 0; i < lods.levels.size(); i++) {
+    lod_num_indices[i] = lods.levels[i].indices.size();
+    lod_errors[i] = lods.levels[i].error;
+
+    // LOD indices refer to the input vertices
+    const void* indices = lods.levels[i].indices.data();
+    if (!vertex_remap.empty()) {
+      remapped_indices.resize(lod_num_indices[i]);
+      std::transform(lods.levels[i].indices.begin(), lods.levels[i].indices.end(), remapped_indices.begin(), [this](int index) { return vertex_remap[index]; });
+      indices = remapped_indices.data();
+    }
+    if (index_type == GL_UNSIGNED_SHORT) {
+      short_indices.assign(static_cast<const int*>(indices), static_cast<const int*>(indices) + lod_num_indices[i]);
+      indices = short_indices.data();
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lod_ebos[i]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_size() * lod_num_indices[i], indices, GL_STATIC_DRAW);
+    GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, index_size() * lod_num_indices[i]);
+  }
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void Mesh::upload_lods() const {
+  if (!pending_lods.valid() || pending_lods.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+    return;
+  }
+
+  create_lod_buffers(pending_lods.get());
+}
+
+int Mesh::num_lods() const {
+  upload_lods();
+  return lod_ebos.size() + 1;
+}
+
 void Mesh::draw(glk::GLSLShader& shader) const {
+  restore();
+  upload_lods();
+
   if (texture) {
     texture->bind(texture_target);
   }
@@ -146,8 +295,9 @@ void Mesh::draw(glk::GLSLShader& shader) const {
     glVertexAttribPointer(tex_coord_loc, 2, GL_FLOAT, GL_FALSE, tex_coord_stride, 0);
   }
 
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-  glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_INT, 0);
+  const int level = std::min<int>(lod_level, lod_ebos.size());
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, level > 0 ? lod_ebos[level - 1] : ebo);
+  glDrawElements(GL_TRIANGLES, level > 0 ? lod_num_indices[level - 1] : num_indices, index_type, 0);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
   glDisableVertexAttribArray(position_loc);
@@ -176,4 +326,71 @@ void Mesh::draw(glk::GLSLShader& shader) const {
   }
 }
 
-}  // namespace glk
\ No newline at end of file
+GLuint Mesh::vbo_id() const {
+  restore();
+  return vbo;
+}
+
+GLuint Mesh::nbo_id() const {
+  restore();
+  return nbo;
+}
+
+GLuint Mesh::cbo_id() const {
+  restore();
+  return cbo;
+}
+
+GLuint Mesh::tbo_id() const {
+  restore();
+  return tbo;
+}
+
+GLuint Mesh::ebo_id() const {
+  restore();
+  return ebo;
+}
+
+std::vector<GLuint> Mesh::buffers() const {
+  std::vector<GLuint> buffers;
+  for (const GLuint buffer : {vbo, nbo, cbo, tbo, ebo}) {
+    if (buffer) {
+      buffers.push_back(buffer);
+    }
+  }
+  buffers.insert(buffers.end(), lod_ebos.begin(), lod_ebos.end());
+  return buffers;
+}
+
+bool Mesh::evict() const {
+  if (evicted()) {
+    return false;
+  }
+
+  size_t bytes = 0;
+  for (const GLuint buffer : buffers()) {
+    evicted_data.push_back(GpuMemoryTracker::evict_buffer(buffer));
+    bytes += evicted_data.back()->size();
+  }
+  GpuMemoryTracker::instance()->remove(this, GpuMemoryTracker::Category::BUFFER, bytes);
+
+  return true;
+}
+
+void Mesh::restore() const {
+  if (!evicted()) {
+    return;
+  }
+
+  size_t bytes = 0;
+  const auto buffers = this->buffers();
+  for (int i = 0; i < buffers.size(); i++) {
+    GpuMemoryTracker::restore_buffer(buffers[i], *evicted_data[i]);
+    bytes += evicted_data[i]->size();
+  }
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, bytes);
+
+  evicted_data.clear();
+}
+
+}  // namespace glk
@@ -1,10 +1,58 @@
 #include <glk/mesh_model.hpp>
 
+#include <cmath>
+#include <algorithm>
 #include <glk/mesh.hpp>
 #include <guik/viewer/shader_setting.hpp>
 
 namespace glk {
 
+namespace {
+
+/**
+ * @brief Select the coarsest level whose geometric error projects to at most max_pixels
+ */
+int select_lod(const glk::Mesh& mesh, const Eigen::Matrix4f& projection_matrix, const Eigen::Matrix4f& model_view_matrix, float viewport_height, float max_pixels) {
+  const Eigen::Vector4f& sphere = mesh.lod_bounding_sphere();
+  const float scale = model_view_matrix.block<3, 3>(0, 0).colwise().norm().maxCoeff();
+  const Eigen::Vector4f center = projection_matrix * model_view_matrix * Eigen::Vector4f(sphere.x(), sphere.y(), sphere.z(), 1.0f);
+
+  // clip-space w of the nearest point of the bounding sphere (constant for orthographic projections)
+  const float w = center.w() - scale * sphere.w() * std::abs(projection_matrix(3, 2));
+  if (w <= 0.0f) {
+    return 0;
+  }
+
+  const float pixels_per_unit = 0.5f * viewport_height * std::abs(projection_matrix(1, 1)) * scale / w;
+
+  int level = 0;
+  for (int i = 1; i < mesh.num_lods() && mesh.lod_error(i) * pixels_per_unit <= max_pixels; i++) {
+    level = i;
+  }
+  return level;
+}
+
+}  // namespace
+
+MeshModel::MeshModel() : lod_threshold(1.0f), worker_cancel(false) {}
+
+MeshModel::~MeshModel() {
+  worker_cancel = true;
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+void MeshModel::run_worker(const std::function<void(const std::atomic_bool& cancel)>& task) {
+  worker_cancel = true;
+  if (worker.joinable()) {
+    worker.join();
+  }
+
+  worker_cancel = false;
+  worker = std::thread([this, task] { task(worker_cancel); });
+}
+
 void MeshModel::push_mesh(const int material_id, const std::shared_ptr<glk::Mesh>& mesh) {
   material_ids.emplace_back(material_id);
   meshes.emplace_back(mesh);
@@ -25,6 +73,16 @@ void MeshModel::override_material(const guik::ShaderSetting& setting, const std:
 }
 
 void MeshModel::draw(glk::GLSLShader& shader) const {
+  const auto projection_matrix = shader.get_uniform_cache_safe<Eigen::Matrix4f>("projection_matrix");
+  const auto view_matrix = shader.get_uniform_cache_safe<Eigen::Matrix4f>("view_matrix");
+  const auto model_matrix = shader.get_uniform_cache_safe<Eigen::Matrix4f>("model_matrix");
+  const bool lod_enabled = lod_threshold > 0.0f && projection_matrix && view_matrix && model_matrix;
+
+  GLint viewport[4] = {0, 0, 0, 0};
+  if (lod_enabled) {
+    glGetIntegerv(GL_VIEWPORT, viewport);
+  }
+
   for (int i = 0; i < meshes.size(); i++) {
     const auto material_id = material_ids[i];
     if (material_id < settings.size()) {
@@ -42,8 +100,37 @@ void MeshModel::draw(glk::GLSLShader& shader) const {
       }
     }
 
+    int lod_level = 0;
+    if (lod_enabled && meshes[i]->num_lods() > 1) {
+      lod_level = select_lod(*meshes[i], *projection_matrix, (*view_matrix) * (*model_matrix), viewport[3], lod_threshold);
+    }
+    meshes[i]->set_lod_level(lod_level);
+
     meshes[i]->draw(shader);
   }
 }
 
+size_t MeshModel::memory_usage() const {
+  size_t bytes = 0;
+  for (const auto& mesh : meshes) {
+    bytes += mesh->memory_usage();
+  }
+  for (const auto& texture : textures) {
+    bytes += GpuMemoryTracker::instance()->usage(texture.get());
+  }
+  return bytes;
+}
+
+bool MeshModel::evict() const {
+  bool evicted = false;
+  for (const auto& mesh : meshes) {
+    evicted |= mesh->evict();
+  }
+  return evicted;
+}
+
+bool MeshModel::evicted() const {
+  return !meshes.empty() && std::all_of(meshes.begin(), meshes.end(), [](const std::shared_ptr<glk::Mesh>& mesh) { return mesh->evicted(); });
+}
+
 }  // namespace glk
@@ -0,0 +1,249 @@
+#include <glk/mesh_optimization.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+namespace glk {
+
+double compute_acmr(const std::vector<int>& indices, int cache_size) {
+  if (indices.size() < 3) {
+    return 0.0;
+  }
+
+  std::vector<int> cache(cache_size, -1);
+  int head = 0;
+  size_t num_misses = 0;
+
+  for (const int index : indices) {
+    if (std::find(cache.begin(), cache.end(), index) != cache.end()) {
+      continue;
+    }
+
+    num_misses++;
+    cache[head] = index;
+    head = (head + 1) % cache_size;
+  }
+
+  return static_cast<double>(num_misses) / (indices.size() / 3);
+}
+
+int deduplicate_vertices(const std::vector<VertexAttribute>& attributes, int num_vertices, std::vector<int>& remap) {
+  const auto attribute = [&](const VertexAttribute& attrib, int i) { return reinterpret_cast<const char*>(attrib.data) + static_cast<size_t>(attrib.stride) * i; };
+
+  const auto hash = [&](int i) {
+    // FNV-1a
+    std::uint64_t h = 14695981039346656037ull;
+    for (const auto& attrib : attributes) {
+      const char* bytes = attribute(attrib, i);
+      for (int j = 0; j < attrib.size; j++) {
+        h = (h ^ static_cast<unsigned char>(bytes[j])) * 1099511628211ull;
+      }
+    }
+    return h;
+  };
+
+  const auto equal = [&](int i, int j) {
+    return std::all_of(attributes.begin(), attributes.end(), [&](const VertexAttribute& attrib) { return std::memcmp(attribute(attrib, i), attribute(attrib, j), attrib.size) == 0; });
+  };
+
+  // open addressing table of the first vertex of each unique attribute set
+  size_t table_size = 16;
+  while (table_size < static_cast<size_t>(num_vertices) * 2) {
+    table_size *= 2;
+  }
+  std::vector<int> table(table_size, -1);
+
+  int num_unique = 0;
+  remap.resize(num_vertices);
+  for (int i = 0; i < num_vertices; i++) {
+    size_t slot = hash(i) & (table_size - 1);
+    while (table[slot] >= 0 && !equal(table[slot], i)) {
+      slot = (slot + 1) & (table_size - 1);
+    }
+
+    if (table[slot] < 0) {
+      table[slot] = i;
+      remap[i] = num_unique++;
+    } else {
+      remap[i] = remap[table[slot]];
+    }
+  }
+
+  return num_unique;
+}
+
+std::vector<int> optimize_vertex_cache(const std::vector<int>& indices, int num_vertices, int cache_size) {
+  const int num_triangles = indices.size() / 3;
+
+  // vertex-triangle adjacency
+  std::vector<int> live_triangles(num_vertices, 0);
+  for (int i = 0; i < num_triangles * 3; i++) {
+    live_triangles[indices[i]]++;
+  }
+
+  std::vector<int> offsets(num_vertices + 1, 0);
+  for (int i = 0; i < num_vertices; i++) {
+    offsets[i + 1] = offsets[i] + live_triangles[i];
+  }
+
+  std::vector<int> adjacency(offsets.back());
+  std::vector<int> cursors(offsets.begin(), offsets.end() - 1);
+  for (int i = 0; i < num_triangles * 3; i++) {
+    adjacency[cursors[indices[i]]++] = i / 3;
+  }
+
+  std::vector<int> cache_time(num_vertices, 0);
+  std::vector<char> emitted(num_triangles, 0);
+  std::vector<int> dead_end;
+  std::vector<int> candidates;
+
+  std::vector<int> optimized;
+  optimized.reserve(num_triangles * 3);
+
+  int time = cache_size + 1;
+  int scan_cursor = 0;
+  int fanning = num_vertices ? 0 : -1;
+
+  while (fanning >= 0) {
+    // emit all triangles around the fanning vertex
+    candidates.clear();
+    for (int k = offsets[fanning]; k < offsets[fanning + 1]; k++) {
+      const int t = adjacency[k];
+      if (emitted[t]) {
+        continue;
+      }
+
+      for (int j = 0; j < 3; j++) {
+        const int v = indices[t * 3 + j];
+        dead_end.push_back(v);
+        candidates.push_back(v);
+        live_triangles[v]--;
+        if (time - cache_time[v] > cache_size) {
+          cache_time[v] = time++;
+        }
+      }
+
+      emitted[t] = 1;
+      optimized.insert(optimized.end(), indices.begin() + t * 3, indices.begin() + t * 3 + 3);
+    }
+
+    // the next fanning vertex is the one with live triangles that will still be in the cache after emitting them
+    fanning = -1;
+    int best_priority = -1;
+    for (const int v : candidates) {
+      if (live_triangles[v] <= 0) {
+        continue;
+      }
+
+      const int age = time - cache_time[v];
+      const int priority = age + 2 * live_triangles[v] <= cache_size ? age : 0;
+      if (priority > best_priority) {
+        best_priority = priority;
+        fanning = v;
+      }
+    }
+
+    // dead end: go back to recently used vertices or scan for the next vertex with live triangles
+    while (fanning < 0 && !dead_end.empty()) {
+      const int v = dead_end.back();
+      dead_end.pop_back();
+      if (live_triangles[v] > 0) {
+        fanning = v;
+      }
+    }
+
+    while (fanning < 0 && scan_cursor < num_vertices) {
+      if (live_triangles[scan_cursor] > 0) {
+        fanning = scan_cursor;
+      }
+      scan_cursor++;
+    }
+  }
+
+  return optimized;
+}
+
+int optimize_vertex_fetch(std::vector<int>& indices, int num_vertices, std::vector<int>& remap) {
+  remap.assign(num_vertices, -1);
+
+  int num_referenced = 0;
+  for (auto& index : indices) {
+    if (remap[index] < 0) {
+      remap[index] = num_referenced++;
+    }
+    index = remap[index];
+  }
+
+  return num_referenced;
+}
+
+std::vector<char> remap_vertex_buffer(const void* data, int stride, int num_vertices, const std::vector<int>& remap, int new_num_vertices) {
+  std::vector<char> buffer(static_cast<size_t>(stride) * new_num_vertices);
+  for (int i = 0; i < num_vertices; i++) {
+    if (remap[i] >= 0) {
+      std::memcpy(buffer.data() + static_cast<size_t>(stride) * remap[i], reinterpret_cast<const char*>(data) + static_cast<size_t>(stride) * i, stride);
+    }
+  }
+  return buffer;
+}
+
+OptimizedMesh optimize_mesh(
+  const void* vertices,
+  int vertex_stride,
+  const void* normals,
+  int normal_stride,
+  const void* colors,
+  int color_stride,
+  const void* tex_coords,
+  int tex_coord_stride,
+  int num_vertices,
+  const int* indices,
+  int num_indices) {
+  //
+  OptimizedMesh mesh;
+  mesh.vertex_stride = vertex_stride;
+  mesh.normal_stride = normal_stride;
+  mesh.color_stride = color_stride;
+  mesh.tex_coord_stride = tex_coord_stride;
+
+  const void* attributes[] = {vertices, normals, colors, tex_coords};
+  const int strides[] = {vertex_stride, normal_stride, color_stride, tex_coord_stride};
+  const int sizes[] = {sizeof(float) * 3, sizeof(float) * 3, sizeof(float) * 4, sizeof(float) * 2};
+  std::vector<char>* outputs[] = {&mesh.vertices, &mesh.normals, &mesh.colors, &mesh.tex_coords};
+
+  std::vector<VertexAttribute> vertex_attributes;
+  for (int i = 0; i < 4; i++) {
+    if (attributes[i]) {
+      vertex_attributes.push_back(VertexAttribute{attributes[i], strides[i], sizes[i]});
+    }
+  }
+
+  const int num_unique_vertices = deduplicate_vertices(vertex_attributes, num_vertices, mesh.vertex_remap);
+  mesh.indices.resize(num_indices / 3 * 3);
+  for (int i = 0; i < mesh.indices.size(); i++) {
+    mesh.indices[i] = mesh.vertex_remap[indices[i]];
+  }
+
+  mesh.indices = optimize_vertex_cache(mesh.indices, num_unique_vertices);
+
+  std::vector<int> fetch_remap;
+  mesh.num_vertices = optimize_vertex_fetch(mesh.indices, num_unique_vertices, fetch_remap);
+  for (auto& index : mesh.vertex_remap) {
+    index = fetch_remap[index];
+  }
+
+  for (int i = 0; i < 4; i++) {
+    if (attributes[i]) {
+      *outputs[i] = remap_vertex_buffer(attributes[i], strides[i], num_vertices, mesh.vertex_remap, mesh.num_vertices);
+    }
+  }
+
+  if (mesh.num_vertices <= 65536) {
+    mesh.short_indices.assign(mesh.indices.begin(), mesh.indices.end());
+  }
+
+  return mesh;
+}
+
+}  // namespace glk
@@ -0,0 +1,380 @@
+#include <glk/mesh_simplification.hpp>
+
+#include <queue>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+#include <Eigen/Geometry>
+
+namespace glk {
+
+namespace {
+
+/**
+ * @brief Area-weighted sum of plane quadrics (symmetric 4x4 matrix stored as its upper triangle)
+ */
+struct Quadric {
+  Quadric() : a00(0), a01(0), a02(0), a03(0), a11(0), a12(0), a13(0), a22(0), a23(0), a33(0), weight(0) {}
+
+  Quadric(const Eigen::Vector3d& n, double d, double w)
+  : a00(w * n.x() * n.x()),
+    a01(w * n.x() * n.y()),
+    a02(w * n.x() * n.z()),
+    a03(w * n.x() * d),
+    a11(w * n.y() * n.y()),
+    a12(w * n.y() * n.z()),
+    a13(w * n.y() * d),
+    a22(w * n.z() * n.z()),
+    a23(w * n.z() * d),
+    a33(w * d * d),
+    weight(w) {}
+
+  Quadric& operator+=(const Quadric& q) {
+    a00 += q.a00;
+    a01 += q.a01;
+    a02 += q.a02;
+    a03 += q.a03;
+    a11 += q.a11;
+    a12 += q.a12;
+    a13 += q.a13;
+    a22 += q.a22;
+    a23 += q.a23;
+    a33 += q.a33;
+    weight += q.weight;
+    return *this;
+  }
+
+  Quadric operator+(const Quadric& q) const {
+    Quadric sum = *this;
+    return sum += q;
+  }
+
+  // weighted sum of squared distances to the planes
+  double eval(const Eigen::Vector3d& p) const {
+    const double x = p.x(), y = p.y(), z = p.z();
+    const double e = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z + a03 * x + a13 * y + a23 * z) + a33;
+    return std::max(0.0, e);
+  }
+
+  // RMS distance to the planes
+  double rms(const Eigen::Vector3d& p) const { return weight > 0.0 ? std::sqrt(eval(p) / weight) : 0.0; }
+
+  double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+  double weight;
+};
+
+struct Collapse {
+  double cost;
+  int from;
+  int to;
+  std::uint32_t from_version;
+  std::uint32_t to_version;
+
+  // std::priority_queue pops the largest element
+  bool operator<(const Collapse& rhs) const { return cost > rhs.cost; }
+};
+
+/**
+ * @brief Greedy half-edge collapse simplifier. Collapses can be continued after intermediate results are taken.
+ */
+class MeshSimplifier {
+public:
+  MeshSimplifier(const Eigen::Vector3f* vertices, int num_vertices, const std::vector<int>& indices)
+  : points(num_vertices),
+    quadrics(num_vertices),
+    locked(num_vertices, 0),
+    versions(num_vertices, 0),
+    vertex_triangles(num_vertices),
+    num_live_triangles(0),
+    max_error(0.0) {
+    // quadrics are computed around the center for numerical stability
+    Eigen::Vector3d min_pt = Eigen::Vector3d::Constant(std::numeric_limits<double>::max());
+    Eigen::Vector3d max_pt = Eigen::Vector3d::Constant(std::numeric_limits<double>::lowest());
+    for (int i = 0; i < num_vertices; i++) {
+      min_pt = min_pt.cwiseMin(vertices[i].cast<double>());
+      max_pt = max_pt.cwiseMax(vertices[i].cast<double>());
+    }
+    const Eigen::Vector3d center = num_vertices ? Eigen::Vector3d(0.5 * (min_pt + max_pt)) : Eigen::Vector3d::Zero();
+    for (int i = 0; i < num_vertices; i++) {
+      points[i] = vertices[i].cast<double>() - center;
+    }
+
+    triangles.assign(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+    live.resize(triangles.size() / 3, 0);
+
+    std::vector<std::uint64_t> edges;
+    edges.reserve(triangles.size());
+    for (int t = 0; t < live.size(); t++) {
+      const int* tri = triangles.data() + t * 3;
+      const bool valid = std::all_of(tri, tri + 3, [=](int i) { return i >= 0 && i < num_vertices; });
+      if (!valid || tri[0] == tri[1] || tri[1] == tri[2] || tri[2] == tri[0]) {
+        continue;
+      }
+
+      live[t] = 1;
+      num_live_triangles++;
+
+      const Eigen::Vector3d normal = (points[tri[1]] - points[tri[0]]).cross(points[tri[2]] - points[tri[0]]);
+      const double norm = normal.norm();
+      const Quadric quadric = norm > 0.0 ? Quadric(normal / norm, -normal.dot(points[tri[0]]) / norm, 0.5 * norm) : Quadric();
+
+      for (int i = 0; i < 3; i++) {
+        quadrics[tri[i]] += quadric;
+        vertex_triangles[tri[i]].push_back(t);
+
+        const int a = std::min(tri[i], tri[(i + 1) % 3]);
+        const int b = std::max(tri[i], tri[(i + 1) % 3]);
+        edges.push_back((static_cast<std::uint64_t>(a) << 32) | static_cast<std::uint32_t>(b));
+      }
+    }
+
+    // vertices on border and non-manifold edges are locked
+    std::sort(edges.begin(), edges.end());
+    for (size_t begin = 0, end = 0; begin < edges.size(); begin = end) {
+      while (end < edges.size() && edges[end] == edges[begin]) {
+        end++;
+      }
+
+      if (end - begin != 2) {
+        locked[edges[begin] >> 32] = 1;
+        locked[edges[begin] & 0xFFFFFFFF] = 1;
+      }
+    }
+
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    for (const auto edge : edges) {
+      push_edge(edge >> 32, edge & 0xFFFFFFFF);
+    }
+  }
+
+  /// Collapse edges until the number of triangles reaches the target (or no edge can be collapsed, or cancel becomes true)
+  void simplify(int target_num_triangles, const std::atomic_bool* cancel = nullptr) {
+    while (num_live_triangles > target_num_triangles && !queue.empty()) {
+      if (cancel && cancel->load(std::memory_order_relaxed)) {
+        break;
+      }
+
+      const Collapse c = queue.top();
+      queue.pop();
+
+      if (versions[c.from] != c.from_version || versions[c.to] != c.to_version) {
+        continue;
+      }
+
+      if (!collapsible(c.from, c.to)) {
+        continue;
+      }
+
+      max_error = std::max(max_error, (quadrics[c.from] + quadrics[c.to]).rms(points[c.to]));
+      collapse(c.from, c.to);
+    }
+  }
+
+  int num_triangles() const { return num_live_triangles; }
+  float error() const { return max_error; }
+
+  std::vector<int> indices() const {
+    std::vector<int> indices;
+    indices.reserve(num_live_triangles * 3);
+    for (int t = 0; t < live.size(); t++) {
+      if (live[t]) {
+        indices.insert(indices.end(), triangles.begin() + t * 3, triangles.begin() + t * 3 + 3);
+      }
+    }
+    return indices;
+  }
+
+private:
+  void push_edge(int a, int b) {
+    if (locked[a] && locked[b]) {
+      return;
+    }
+
+    const Quadric quadric = quadrics[a] + quadrics[b];
+    const double cost_ab = locked[a] ? std::numeric_limits<double>::max() : quadric.eval(points[b]);
+    const double cost_ba = locked[b] ? std::numeric_limits<double>::max() : quadric.eval(points[a]);
+
+    if (cost_ab <= cost_ba) {
+      queue.push(Collapse{cost_ab, a, b, versions[a], versions[b]});
+    } else {
+      queue.push(Collapse{cost_ba, b, a, versions[b], versions[a]});
+    }
+  }
+
+  // sorted unique neighbors of a vertex
+  void neighbors(int v, std::vector<int>& result) const {
+    result.clear();
+    for (const int t : vertex_triangles[v]) {
+      if (!live[t]) {
+        continue;
+      }
+      for (int i = 0; i < 3; i++) {
+        if (triangles[t * 3 + i] != v) {
+          result.push_back(triangles[t * 3 + i]);
+        }
+      }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+  }
+
+  // check the link condition and triangle flips
+  bool collapsible(int from, int to) {
+    int num_shared_triangles = 0;
+    for (const int t : vertex_triangles[from]) {
+      if (!live[t]) {
+        continue;
+      }
+
+      const int* tri = triangles.data() + t * 3;
+      if (tri[0] == to || tri[1] == to || tri[2] == to) {
+        num_shared_triangles++;
+        continue;
+      }
+
+      Eigen::Vector3d p[3];
+      for (int i = 0; i < 3; i++) {
+        p[i] = points[tri[i] == from ? to : tri[i]];
+      }
+
+      const Eigen::Vector3d n0 = (points[tri[1]] - points[tri[0]]).cross(points[tri[2]] - points[tri[0]]);
+      const Eigen::Vector3d n1 = (p[1] - p[0]).cross(p[2] - p[0]);
+      if (n0.dot(n1) <= 0.1 * n0.norm() * n1.norm()) {
+        return false;
+      }
+    }
+
+    // vertices adjacent to both ends must be the opposite vertices of the shared triangles
+    neighbors(from, from_neighbors);
+    neighbors(to, to_neighbors);
+    int num_shared_neighbors = 0;
+    for (size_t i = 0, j = 0; i < from_neighbors.size() && j < to_neighbors.size();) {
+      if (from_neighbors[i] < to_neighbors[j]) {
+        i++;
+      } else if (to_neighbors[j] < from_neighbors[i]) {
+        j++;
+      } else {
+        num_shared_neighbors++;
+        i++;
+        j++;
+      }
+    }
+
+    return num_shared_neighbors <= num_shared_triangles;
+  }
+
+  void collapse(int from, int to) {
+    auto& to_triangles = vertex_triangles[to];
+    for (const int t : vertex_triangles[from]) {
+      if (!live[t]) {
+        continue;
+      }
+
+      int* tri = triangles.data() + t * 3;
+      if (tri[0] == to || tri[1] == to || tri[2] == to) {
+        live[t] = 0;
+        num_live_triangles--;
+        continue;
+      }
+
+      std::replace(tri, tri + 3, from, to);
+      to_triangles.push_back(t);
+    }
+
+    quadrics[to] += quadrics[from];
+    std::vector<int>().swap(vertex_triangles[from]);
+    to_triangles.erase(std::remove_if(to_triangles.begin(), to_triangles.end(), [this](int t) { return !live[t]; }), to_triangles.end());
+
+    // invalidate queued collapses of both vertices and requeue edges around the remaining vertex
+    versions[from]++;
+    versions[to]++;
+    neighbors(to, to_neighbors);
+    for (const int neighbor : to_neighbors) {
+      push_edge(to, neighbor);
+    }
+  }
+
+private:
+  std::vector<Eigen::Vector3d> points;
+  std::vector<Quadric> quadrics;
+  std::vector<char> locked;
+  std::vector<std::uint32_t> versions;
+
+  std::vector<int> triangles;
+  std::vector<char> live;
+  std::vector<std::vector<int>> vertex_triangles;
+
+  std::priority_queue<Collapse> queue;
+  int num_live_triangles;
+  double max_error;
+
+  std::vector<int> from_neighbors;
+  std::vector<int> to_neighbors;
+};
+
+}  // namespace
+
+std::vector<int> simplify_mesh(const Eigen::Vector3f* vertices, int num_vertices, const std::vector<int>& indices, int target_num_indices, float* error) {
+  MeshSimplifier simplifier(vertices, num_vertices, indices);
+  simplifier.simplify(target_num_indices / 3);
+
+  if (error) {
+    *error = simplifier.error();
+  }
+  return simplifier.indices();
+}
+
+MeshLODChain generate_lods(const Eigen::Vector3f* vertices, int num_vertices, const std::vector<int>& indices, const MeshLODOptions& options) {
+  MeshLODChain chain;
+  chain.center.setZero();
+  chain.radius = 0.0f;
+
+  if (num_vertices == 0) {
+    return chain;
+  }
+
+  Eigen::Vector3f min_pt = vertices[0];
+  Eigen::Vector3f max_pt = vertices[0];
+  for (int i = 1; i < num_vertices; i++) {
+    min_pt = min_pt.cwiseMin(vertices[i]);
+    max_pt = max_pt.cwiseMax(vertices[i]);
+  }
+  chain.center = 0.5f * (min_pt + max_pt);
+  for (int i = 0; i < num_vertices; i++) {
+    chain.radius = std::max(chain.radius, (vertices[i] - chain.center).norm());
+  }
+
+  const int num_triangles = indices.size() / 3;
+  if (num_triangles * options.reduction_ratio < options.min_triangles) {
+    return chain;
+  }
+
+  MeshSimplifier simplifier(vertices, num_vertices, indices);
+  int last_num_triangles = simplifier.num_triangles();
+  double target_num_triangles = last_num_triangles;
+
+  for (int level = 0; level < options.max_levels; level++) {
+    target_num_triangles *= options.reduction_ratio;
+    if (target_num_triangles < options.min_triangles) {
+      break;
+    }
+
+    simplifier.simplify(static_cast<int>(target_num_triangles), options.cancel);
+    if (options.cancel && *options.cancel) {
+      break;
+    }
+
+    // stop if the remaining edges cannot be collapsed
+    if (simplifier.num_triangles() > 0.9 * last_num_triangles) {
+      break;
+    }
+
+    last_num_triangles = simplifier.num_triangles();
+    chain.levels.push_back(MeshLOD{simplifier.indices(), simplifier.error()});
+  }
+
+  return chain;
+}
+
+}  // namespace glk
@@ -1,6 +1,7 @@
 #include <glk/normal_distributions.hpp>
 
 #include <glk/mesh.hpp>
+#include <glk/mesh_optimization.hpp>
 #include <glk/primitives/icosahedron.hpp>
 
 namespace glk {
@@ -12,6 +13,15 @@ NormalDistributions::NormalDistributions(const Eigen::Matrix<T, D, 1>* means, co
   icosahedron.subdivide();
   icosahedron.spherize();
 
+  // reorder the sphere for vertex cache hits once (replicated spheres keep the order)
+  std::vector<int> sphere_remap;
+  icosahedron.indices = glk::optimize_vertex_cache(icosahedron.indices, icosahedron.vertices.size());
+  glk::optimize_vertex_fetch(icosahedron.indices, icosahedron.vertices.size(), sphere_remap);
+  const auto sphere_points = icosahedron.vertices;
+  for (int i = 0; i < sphere_points.size(); i++) {
+    icosahedron.vertices[sphere_remap[i]] = sphere_points[i];
+  }
+
   Eigen::Matrix<float, 4, -1> sphere_vertices = Eigen::Matrix<float, 4, -1>::Ones(4, icosahedron.vertices.size());
   sphere_vertices.topRows(3) = Eigen::Map<Eigen::Matrix<float, 3, -1>>(icosahedron.vertices[0].data(), 3, icosahedron.vertices.size());
   Eigen::ArrayXi sphere_indices = Eigen::Map<Eigen::ArrayXi>(icosahedron.indices.data(), icosahedron.indices.size());
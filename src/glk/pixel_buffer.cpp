@@ -1,6 +1,7 @@
 #include <glk/pixel_buffer.hpp>
 
 #include <iostream>
+#include <glk/gpu_memory_tracker.hpp>
 
 namespace glk {
 
@@ -9,12 +10,14 @@ PixelBuffer::PixelBuffer(const Eigen::Vector2i& size, int bytes_per_pixel) : wid
   glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffer);
 
   glBufferData(GL_PIXEL_PACK_BUFFER, width * height * bytes_per_pixel, 0, GL_DYNAMIC_COPY);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, width * height * bytes_per_pixel);
 
   glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 }
 
 PixelBuffer::~PixelBuffer() {
   glDeleteBuffers(1, &pixel_buffer);
+  GpuMemoryTracker::instance()->remove_all(this);
 }
 
 void PixelBuffer::copy_from_texture(const glk::Texture& texture, GLuint format, GLuint type) {
@@ -0,0 +1,390 @@
+#include <glk/point_index.hpp>
+
+#include <queue>
+#include <thread>
+#include <limits>
+#include <algorithm>
+#include <Eigen/Geometry>
+
+namespace glk {
+
+namespace {
+
+const unsigned int max_leaf_size = 32;
+
+// Plane (n, d) such that n.dot(p) + d >= 0 is inside, extracted from rows of projection_view_matrix
+std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f>> frustum_planes(const Eigen::Matrix4f& projection_view_matrix) {
+  std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f>> planes;
+  for (int i = 0; i < 3; i++) {
+    planes.push_back(projection_view_matrix.row(3).transpose() + projection_view_matrix.row(i).transpose());
+    planes.push_back(projection_view_matrix.row(3).transpose() - projection_view_matrix.row(i).transpose());
+  }
+  return planes;
+}
+
+// -1 : box is outside of a plane, 1 : box is inside of all planes, 0 : box intersects with planes
+template <typename Planes>
+int classify_box(const Planes& planes, const Eigen::Vector3f& min, const Eigen::Vector3f& max) {
+  int result = 1;
+  for (const auto& plane : planes) {
+    const Eigen::Vector3f n = plane.template head<3>();
+    const Eigen::Vector3f p = (n.array() >= 0.0f).select(max, min);  // farthest corner along n
+    const Eigen::Vector3f q = (n.array() >= 0.0f).select(min, max);  // nearest corner along n
+
+    if (n.dot(p) + plane[3] < 0.0f) {
+      return -1;
+    }
+    if (n.dot(q) + plane[3] < 0.0f) {
+      result = 0;
+    }
+  }
+  return result;
+}
+
+bool inside_polygon(const Eigen::Vector2f& p, const std::vector<Eigen::Vector2f, Eigen::aligned_allocator<Eigen::Vector2f>>& polygon) {
+  bool inside = false;
+  for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+    const auto& a = polygon[i];
+    const auto& b = polygon[j];
+    if ((a.y() > p.y()) != (b.y() > p.y()) && p.x() < (b.x() - a.x()) * (p.y() - a.y()) / (b.y() - a.y()) + a.x()) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+}  // namespace
+
+PointIndex::PointIndex(const float* points, int stride, int num_points, int num_threads) {
+  init(points, stride, num_points, num_threads);
+}
+
+void PointIndex::init(const float* points, int stride, int num_points, int num_threads) {
+  entries.resize(num_points);
+  for (int i = 0; i < num_points; i++) {
+    entries[i].pt = Eigen::Map<const Eigen::Vector3f>(reinterpret_cast<const float*>(reinterpret_cast<const char*>(points) + stride * static_cast<size_t>(i)));
+    entries[i].index = i;
+  }
+
+  // all leaves are at the same depth (points are split at the median)
+  int depth = 0;
+  while ((static_cast<size_t>(num_points) >> depth) > max_leaf_size) {
+    depth++;
+  }
+  nodes.resize((2 << depth) - 1);
+
+  if (num_threads <= 0) {
+    num_threads = std::max<int>(1, std::thread::hardware_concurrency());
+  }
+  int parallel_depth = 0;
+  while ((1 << parallel_depth) < num_threads && parallel_depth < depth) {
+    parallel_depth++;
+  }
+
+  build(0, 0, 0, num_points, parallel_depth);
+}
+
+void PointIndex::build(int node, int depth, unsigned int first, unsigned int count, int parallel_depth) {
+  Node& n = nodes[node];
+  n.first = first;
+  n.count = count;
+  n.min.setConstant(std::numeric_limits<float>::max());
+  n.max.setConstant(std::numeric_limits<float>::lowest());
+  for (unsigned int i = first; i < first + count; i++) {
+    n.min = n.min.cwiseMin(entries[i].pt);
+    n.max = n.max.cwiseMax(entries[i].pt);
+  }
+
+  if (is_leaf(node)) {
+    return;
+  }
+
+  // split at the median along the longest axis
+  int axis;
+  (n.max - n.min).maxCoeff(&axis);
+  const unsigned int left_count = count / 2;
+  std::nth_element(entries.begin() + first, entries.begin() + first + left_count, entries.begin() + first + count, [=](const Entry& lhs, const Entry& rhs) {
+    return lhs.pt[axis] < rhs.pt[axis];
+  });
+
+  if (depth < parallel_depth) {
+    std::thread thread([=] { build(2 * node + 1, depth + 1, first, left_count, parallel_depth); });
+    build(2 * node + 2, depth + 1, first + left_count, count - left_count, parallel_depth);
+    thread.join();
+  } else {
+    build(2 * node + 1, depth + 1, first, left_count, parallel_depth);
+    build(2 * node + 2, depth + 1, first + left_count, count - left_count, parallel_depth);
+  }
+}
+
+template <typename Visit, typename Leaf>
+void PointIndex::traverse(const Visit& visit, const Leaf& leaf) const {
+  if (entries.empty()) {
+    return;
+  }
+
+  std::vector<int> stack = {0};
+  while (!stack.empty()) {
+    const int node = stack.back();
+    stack.pop_back();
+
+    if (!visit(node)) {
+      continue;
+    }
+
+    if (is_leaf(node)) {
+      leaf(node);
+    } else {
+      stack.push_back(2 * node + 2);
+      stack.push_back(2 * node + 1);
+    }
+  }
+}
+
+int PointIndex::pick(const Eigen::Vector3f& origin, const Eigen::Vector3f& direction, float radius, float radius_per_distance) const {
+  const Eigen::Vector3f dir = direction.normalized();
+  const Eigen::Array3f inv_dir = (dir.array().abs() > 1e-12f).select(dir.array().inverse(), Eigen::Array3f::Constant(1e12f));
+
+  int best_index = -1;
+  float best_t = std::numeric_limits<float>::max();
+
+  const auto visit = [&](int node) {
+    const Node& n = nodes[node];
+    // the hit radius in the box is bounded by the radius at the farthest corner
+    const float max_t = (n.min - origin).cwiseAbs().cwiseMax((n.max - origin).cwiseAbs()).norm();
+    const float r = radius + radius_per_distance * max_t;
+
+    const Eigen::Array3f t0 = (n.min.array() - r - origin.array()) * inv_dir;
+    const Eigen::Array3f t1 = (n.max.array() + r - origin.array()) * inv_dir;
+    const float t_enter = std::max(t0.min(t1).maxCoeff(), 0.0f);
+    const float t_exit = t0.max(t1).minCoeff();
+    return t_enter <= t_exit && t_enter < best_t;
+  };
+
+  const auto leaf = [&](int node) {
+    const Node& n = nodes[node];
+    for (unsigned int i = n.first; i < n.first + n.count; i++) {
+      const Eigen::Vector3f d = entries[i].pt - origin;
+      const float t = d.dot(dir);
+      if (t < 0.0f || t >= best_t) {
+        continue;
+      }
+
+      const float r = radius + radius_per_distance * t;
+      if ((d - t * dir).squaredNorm() <= r * r) {
+        best_t = t;
+        best_index = entries[i].index;
+      }
+    }
+  };
+
+  traverse(visit, leaf);
+  return best_index;
+}
+
+std::vector<unsigned int> PointIndex::query_aabb(const Eigen::Vector3f& min, const Eigen::Vector3f& max) const {
+  std::vector<unsigned int> indices;
+
+  const auto visit = [&](int node) {
+    const Node& n = nodes[node];
+    if ((n.max.array() < min.array()).any() || (n.min.array() > max.array()).any()) {
+      return false;
+    }
+
+    // the node is entirely inside of the box
+    if ((n.min.array() >= min.array()).all() && (n.max.array() <= max.array()).all()) {
+      for (unsigned int i = n.first; i < n.first + n.count; i++) {
+        indices.push_back(entries[i].index);
+      }
+      return false;
+    }
+    return true;
+  };
+
+  const auto leaf = [&](int node) {
+    const Node& n = nodes[node];
+    for (unsigned int i = n.first; i < n.first + n.count; i++) {
+      if ((entries[i].pt.array() >= min.array()).all() && (entries[i].pt.array() <= max.array()).all()) {
+        indices.push_back(entries[i].index);
+      }
+    }
+  };
+
+  traverse(visit, leaf);
+  return indices;
+}
+
+std::vector<unsigned int> PointIndex::query_obb(const Eigen::Matrix4f& model_matrix) const {
+  // faces of the unit cube in the world frame (n.dot(p) + d >= 0 is inside)
+  const Eigen::Matrix4f inv_model_matrix = model_matrix.inverse();
+  std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f>> planes;
+  for (int i = 0; i < 3; i++) {
+    planes.push_back(Eigen::Vector4f::UnitW() * 0.5f - inv_model_matrix.row(i).transpose());
+    planes.push_back(Eigen::Vector4f::UnitW() * 0.5f + inv_model_matrix.row(i).transpose());
+  }
+
+  std::vector<unsigned int> indices;
+
+  const auto visit = [&](int node) {
+    const Node& n = nodes[node];
+    const int c = classify_box(planes, n.min, n.max);
+    if (c == 1) {
+      for (unsigned int i = n.first; i < n.first + n.count; i++) {
+        indices.push_back(entries[i].index);
+      }
+    }
+    return c == 0;
+  };
+
+  const auto leaf = [&](int node) {
+    const Node& n = nodes[node];
+    for (unsigned int i = n.first; i < n.first + n.count; i++) {
+      const Eigen::Vector3f pt = (inv_model_matrix * entries[i].pt.homogeneous()).head<3>();
+      if ((pt.array().abs() <= 0.5f).all()) {
+        indices.push_back(entries[i].index);
+      }
+    }
+  };
+
+  traverse(visit, leaf);
+  return indices;
+}
+
+std::vector<unsigned int> PointIndex::query_frustum(const Eigen::Matrix4f& projection_view_matrix) const {
+  const auto planes = frustum_planes(projection_view_matrix);
+  std::vector<unsigned int> indices;
+
+  const auto visit = [&](int node) {
+    const Node& n = nodes[node];
+    const int c = classify_box(planes, n.min, n.max);
+    if (c == 1) {
+      for (unsigned int i = n.first; i < n.first + n.count; i++) {
+        indices.push_back(entries[i].index);
+      }
+    }
+    return c == 0;
+  };
+
+  const auto leaf = [&](int node) {
+    const Node& n = nodes[node];
+    for (unsigned int i = n.first; i < n.first + n.count; i++) {
+      const Eigen::Vector4f p = projection_view_matrix * entries[i].pt.homogeneous();
+      if ((p.head<3>().array().abs() <= p.w()).all()) {
+        indices.push_back(entries[i].index);
+      }
+    }
+  };
+
+  traverse(visit, leaf);
+  return indices;
+}
+
+std::vector<unsigned int> PointIndex::query_lasso(
+  const Eigen::Matrix4f& projection_view_matrix,
+  const std::vector<Eigen::Vector2f, Eigen::aligned_allocator<Eigen::Vector2f>>& polygon) const {
+  std::vector<unsigned int> indices;
+  if (polygon.size() < 3) {
+    return indices;
+  }
+
+  // frustum of the bounding rectangle of the polygon
+  Eigen::Vector2f poly_min = Eigen::Vector2f::Constant(std::numeric_limits<float>::max());
+  Eigen::Vector2f poly_max = Eigen::Vector2f::Constant(std::numeric_limits<float>::lowest());
+  for (const auto& p : polygon) {
+    poly_min = poly_min.cwiseMin(p);
+    poly_max = poly_max.cwiseMax(p);
+  }
+
+  auto planes = frustum_planes(projection_view_matrix);
+  for (int i = 0; i < 2; i++) {
+    planes[i * 2] = projection_view_matrix.row(i).transpose() - poly_min[i] * projection_view_matrix.row(3).transpose();
+    planes[i * 2 + 1] = poly_max[i] * projection_view_matrix.row(3).transpose() - projection_view_matrix.row(i).transpose();
+  }
+
+  const auto visit = [&](int node) {
+    const Node& n = nodes[node];
+    return classify_box(planes, n.min, n.max) >= 0;
+  };
+
+  const auto leaf = [&](int node) {
+    const Node& n = nodes[node];
+    for (unsigned int i = n.first; i < n.first + n.count; i++) {
+      const Eigen::Vector4f p = projection_view_matrix * entries[i].pt.homogeneous();
+      if ((p.head<3>().array().abs() > p.w()).any()) {
+        continue;
+      }
+
+      if (inside_polygon(p.head<2>() / p.w(), polygon)) {
+        indices.push_back(entries[i].index);
+      }
+    }
+  };
+
+  traverse(visit, leaf);
+  return indices;
+}
+
+int PointIndex::knn(const Eigen::Vector3f& query, int k, std::vector<unsigned int>& k_indices, std::vector<float>& k_sq_dists) const {
+  k_indices.clear();
+  k_sq_dists.clear();
+  if (k <= 0 || entries.empty()) {
+    return 0;
+  }
+
+  // max heap of (sq_dist, index)
+  std::priority_queue<std::pair<float, unsigned int>> neighbors;
+  const auto worst = [&] { return neighbors.size() < static_cast<size_t>(k) ? std::numeric_limits<float>::max() : neighbors.top().first; };
+
+  // depth first search visiting the nearer child first
+  std::vector<std::pair<float, int>> stack = {{0.0f, 0}};
+  while (!stack.empty()) {
+    const auto [sq_dist, node] = stack.back();
+    stack.pop_back();
+    if (sq_dist > worst()) {
+      continue;
+    }
+
+    const Node& n = nodes[node];
+    if (is_leaf(node)) {
+      for (unsigned int i = n.first; i < n.first + n.count; i++) {
+        const float d = (entries[i].pt - query).squaredNorm();
+        if (d < worst()) {
+          neighbors.emplace(d, entries[i].index);
+          if (neighbors.size() > static_cast<size_t>(k)) {
+            neighbors.pop();
+          }
+        }
+      }
+      continue;
+    }
+
+    const auto box_sq_dist = [&](int child) {
+      const Node& c = nodes[child];
+      return (c.min - query).cwiseMax(query - c.max).cwiseMax(0.0f).squaredNorm();
+    };
+
+    const int left = 2 * node + 1;
+    const int right = 2 * node + 2;
+    const float left_dist = box_sq_dist(left);
+    const float right_dist = box_sq_dist(right);
+    if (left_dist < right_dist) {
+      stack.emplace_back(right_dist, right);
+      stack.emplace_back(left_dist, left);
+    } else {
+      stack.emplace_back(left_dist, left);
+      stack.emplace_back(right_dist, right);
+    }
+  }
+
+  k_indices.resize(neighbors.size());
+  k_sq_dists.resize(neighbors.size());
+  for (int i = neighbors.size() - 1; i >= 0; i--) {
+    k_sq_dists[i] = neighbors.top().first;
+    k_indices[i] = neighbors.top().second;
+    neighbors.pop();
+  }
+
+  return k_indices.size();
+}
+
+}  // namespace glk
@@ -0,0 +1,179 @@
+#include <glk/point_selection_buffer.hpp>
+
+#include <iostream>
+#include <glk/path.hpp>
+#include <glk/glsl_shader.hpp>
+#include <glk/pointcloud_buffer.hpp>
+#include <glk/console_colors.hpp>
+#include <glk/gpu_memory_tracker.hpp>
+
+namespace glk {
+
+PointSelectionBuffer::PointSelectionBuffer(const std::shared_ptr<const glk::PointCloudBuffer>& cloud_buffer)
+: cloud_buffer(cloud_buffer),
+  ebo(0),
+  command_buffer(0),
+  polygon_buffer(0),
+  polygon_capacity(0) {
+  using namespace glk::console;
+
+  selection_shader.reset(new glk::GLSLShader());
+  if (!selection_shader->attach_source(get_data_path() + "/shader/point_selection.comp", GL_COMPUTE_SHADER) || !selection_shader->link_program()) {
+    std::cerr << bold_yellow << "warning: failed to build the point selection compute shader (GPU selection is disabled)" << reset << std::endl;
+    selection_shader.reset();
+  }
+
+  const size_t num_points = cloud_buffer->size();
+  glGenBuffers(1, &ebo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * std::max<size_t>(1, num_points), nullptr, GL_DYNAMIC_COPY);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+  glGenBuffers(1, &command_buffer);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_COPY);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, sizeof(unsigned int) * std::max<size_t>(1, num_points) + sizeof(DrawElementsIndirectCommand));
+  clear();
+}
+
+PointSelectionBuffer::~PointSelectionBuffer() {
+  glDeleteBuffers(1, &ebo);
+  glDeleteBuffers(1, &command_buffer);
+  if (polygon_buffer) {
+    glDeleteBuffers(1, &polygon_buffer);
+  }
+
+  GpuMemoryTracker::instance()->remove_all(this);
+}
+
+void PointSelectionBuffer::clear() {
+  const DrawElementsIndirectCommand command = {0, 1, 0, 0, 0};
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+  glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(command), &command);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void PointSelectionBuffer::select_obb(const Eigen::Matrix4f& model_matrix, bool invert) {
+  if (!selection_shader) {
+    return;
+  }
+
+  selection_shader->use();
+  selection_shader->set_uniform("inv_model_matrix", Eigen::Matrix4f(model_matrix.inverse()));
+  select(Mode::OBB, invert);
+}
+
+void PointSelectionBuffer::select_sphere(const Eigen::Vector3f& center, float radius, bool invert) {
+  if (!selection_shader) {
+    return;
+  }
+
+  selection_shader->use();
+  selection_shader->set_uniform("sphere", Eigen::Vector4f(center.x(), center.y(), center.z(), radius));
+  select(Mode::SPHERE, invert);
+}
+
+void PointSelectionBuffer::select_lasso(
+  const Eigen::Matrix4f& projection_view_matrix,
+  const std::vector<Eigen::Vector2f, Eigen::aligned_allocator<Eigen::Vector2f>>& polygon,
+  bool invert) {
+  if (!selection_shader) {
+    return;
+  }
+
+  if (polygon_capacity < static_cast<int>(polygon.size())) {
+    if (polygon_buffer) {
+      glDeleteBuffers(1, &polygon_buffer);
+      GpuMemoryTracker::instance()->remove(this, GpuMemoryTracker::Category::BUFFER, sizeof(Eigen::Vector2f) * polygon_capacity);
+    }
+
+    polygon_capacity = polygon.size() * 2;
+    glGenBuffers(1, &polygon_buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, polygon_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Eigen::Vector2f) * polygon_capacity, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, sizeof(Eigen::Vector2f) * polygon_capacity);
+  }
+
+  if (!polygon.empty()) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, polygon_buffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(Eigen::Vector2f) * polygon.size(), polygon.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  }
+
+  selection_shader->use();
+  selection_shader->set_uniform("projection_view_matrix", projection_view_matrix);
+  selection_shader->set_uniform("num_polygon_vertices", polygon.size() < 3 ? 0 : static_cast<int>(polygon.size()));
+  select(Mode::LASSO, invert);
+}
+
+void PointSelectionBuffer::select(Mode mode, bool invert) {
+  clear();
+
+  const int num_points = cloud_buffer->size();
+  if (num_points == 0) {
+    return;
+  }
+
+  // evicted points must be on the GPU to be tested
+  cloud_buffer->restore();
+
+  selection_shader->set_uniform("num_points", num_points);
+  selection_shader->set_uniform("point_stride", static_cast<int>(cloud_buffer->get_stride() / sizeof(float)));
+  selection_shader->set_uniform("point_offset", static_cast<int>(cloud_buffer->vbo_offset() / sizeof(float)));
+  selection_shader->set_uniform("selection_mode", static_cast<int>(mode));
+  selection_shader->set_uniform("invert_selection", static_cast<int>(invert));
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, cloud_buffer->vbo_id());
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, ebo);
+  if (polygon_buffer) {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, polygon_buffer);
+  }
+  // the count field of the draw command is the first word of the buffer
+  glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, command_buffer);
+
+  glDispatchCompute((num_points + 255) / 256, 1, 1);
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT | GL_ATOMIC_COUNTER_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+  for (int i = 0; i < 3; i++) {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, 0);
+  }
+  glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, 0);
+  selection_shader->unuse();
+}
+
+int PointSelectionBuffer::num_selected() const {
+  DrawElementsIndirectCommand command;
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+  glGetBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(command), &command);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  return command.count;
+}
+
+std::vector<unsigned int> PointSelectionBuffer::read_indices() const {
+  std::vector<unsigned int> indices(num_selected());
+  if (indices.empty()) {
+    return indices;
+  }
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+  glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(unsigned int) * indices.size(), indices.data());
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  return indices;
+}
+
+void PointSelectionBuffer::draw(glk::GLSLShader& shader) const {
+  cloud_buffer->bind(shader);
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+  glDrawElementsIndirect(GL_POINTS, GL_UNSIGNED_INT, nullptr);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+  cloud_buffer->unbind(shader);
+}
+
+}  // namespace glk
@@ -0,0 +1,320 @@
+#include <glk/pointcloud_batch.hpp>
+
+#include <random>
+#include <numeric>
+#include <iostream>
+#include <algorithm>
+#include <glk/path.hpp>
+#include <glk/console_colors.hpp>
+#include <glk/gpu_memory_tracker.hpp>
+
+namespace glk {
+
+PointCloudBatch::PointCloudBatch(bool with_colors)
+: with_colors(with_colors),
+  total_points(0),
+  points_capacity(0),
+  clouds_capacity(0),
+  commands_dirty(false),
+  matrices_dirty(false),
+  bounds_dirty(false),
+  vbo(0),
+  cbo(0),
+  index_buffer(0),
+  matrices_buffer(0),
+  commands_buffer(0),
+  lod_pixels(0.0),
+  min_lod_ratio(1.0),
+  bounds_buffer(0),
+  culled_commands_buffer(0) {
+  glGenVertexArrays(1, &vao);
+}
+
+PointCloudBatch::~PointCloudBatch() {
+  for (GLuint buffer : {vbo, cbo, index_buffer, matrices_buffer, commands_buffer, bounds_buffer, culled_commands_buffer}) {
+    if (buffer) {
+      glDeleteBuffers(1, &buffer);
+    }
+  }
+  glDeleteVertexArrays(1, &vao);
+
+  GpuMemoryTracker::instance()->remove_all(this);
+}
+
+void PointCloudBatch::reserve_points(size_t num_points) {
+  if (num_points <= points_capacity) {
+    return;
+  }
+
+  const size_t capacity = std::max<size_t>({num_points, points_capacity * 2, 8192});
+  GpuMemoryTracker::grow_buffer(this, vbo, sizeof(float) * 3 * points_capacity, sizeof(float) * 3 * capacity);
+  if (with_colors) {
+    GpuMemoryTracker::grow_buffer(this, cbo, sizeof(float) * 4 * points_capacity, sizeof(float) * 4 * capacity);
+  }
+  points_capacity = capacity;
+}
+
+void PointCloudBatch::reserve_clouds(size_t num_clouds) {
+  if (num_clouds <= clouds_capacity) {
+    return;
+  }
+
+  const size_t capacity = std::max<size_t>({num_clouds, clouds_capacity * 2, 64});
+  GpuMemoryTracker::grow_buffer(this, matrices_buffer, sizeof(Eigen::Matrix4f) * clouds_capacity, sizeof(Eigen::Matrix4f) * capacity);
+  GpuMemoryTracker::grow_buffer(this, commands_buffer, sizeof(DrawArraysIndirectCommand) * clouds_capacity, sizeof(DrawArraysIndirectCommand) * capacity);
+  GpuMemoryTracker::grow_buffer(this, bounds_buffer, sizeof(Eigen::Vector4f) * 2 * clouds_capacity, sizeof(Eigen::Vector4f) * 2 * capacity);
+  GpuMemoryTracker::grow_buffer(this, culled_commands_buffer, sizeof(DrawArraysIndirectCommand) * clouds_capacity, sizeof(DrawArraysIndirectCommand) * capacity);
+
+  // the index buffer is constant (cloud i reads index i through its base instance)
+  std::vector<GLuint> indices(capacity);
+  std::iota(indices.begin(), indices.end(), 0);
+  if (index_buffer) {
+    glDeleteBuffers(1, &index_buffer);
+    GpuMemoryTracker::instance()->remove(this, GpuMemoryTracker::Category::BUFFER, sizeof(GLuint) * clouds_capacity);
+  }
+  glGenBuffers(1, &index_buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, index_buffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(GLuint) * capacity, indices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, sizeof(GLuint) * capacity);
+
+  clouds_capacity = capacity;
+  commands_dirty = matrices_dirty = bounds_dirty = true;
+}
+
+int PointCloudBatch::add(const float* points, int stride, const float* colors, int num_points, const Eigen::Matrix4f& model_matrix) {
+  reserve_points(total_points + num_points);
+  reserve_clouds(commands.size() + 1);
+
+  Eigen::Vector3f min_pt = Eigen::Vector3f::Zero();
+  Eigen::Vector3f max_pt = Eigen::Vector3f::Zero();
+
+  if (num_points) {
+    // points are packed into vec3 and always shuffled so that LOD selection works even if it is enabled after adding clouds
+    std::vector<int> order(num_points);
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937 mt(commands.size());
+    std::shuffle(order.begin(), order.end(), mt);
+
+    std::vector<Eigen::Vector3f> packed(num_points);
+    for (int i = 0; i < num_points; i++) {
+      packed[i] = Eigen::Map<const Eigen::Vector3f>(reinterpret_cast<const float*>(reinterpret_cast<const char*>(points) + stride * order[i]));
+    }
+
+    min_pt = max_pt = packed[0];
+    for (const auto& pt : packed) {
+      min_pt = min_pt.cwiseMin(pt);
+      max_pt = max_pt.cwiseMax(pt);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, sizeof(float) * 3 * total_points, sizeof(float) * 3 * num_points, packed.data());
+
+    if (with_colors) {
+      std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f>> packed_colors(num_points, Eigen::Vector4f::Ones());
+      if (colors) {
+        for (int i = 0; i < num_points; i++) {
+          packed_colors[i] = Eigen::Map<const Eigen::Vector4f>(colors + 4 * order[i]);
+        }
+      }
+
+      glBindBuffer(GL_ARRAY_BUFFER, cbo);
+      glBufferSubData(GL_ARRAY_BUFFER, sizeof(float) * 4 * total_points, sizeof(float) * 4 * num_points, packed_colors.data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  const int id = commands.size();
+  commands.push_back(DrawArraysIndirectCommand{static_cast<GLuint>(num_points), 1, static_cast<GLuint>(total_points), static_cast<GLuint>(id)});
+  model_matrices.push_back(model_matrix);
+  bounds.push_back((Eigen::Vector4f() << min_pt, 1.0f).finished());
+  bounds.push_back((Eigen::Vector4f() << max_pt, 1.0f).finished());
+  total_points += num_points;
+
+  commands_dirty = matrices_dirty = bounds_dirty = true;
+  return id;
+}
+
+void PointCloudBatch::set_model_matrix(int id, const Eigen::Matrix4f& model_matrix) {
+  model_matrices[id] = model_matrix;
+  matrices_dirty = true;
+}
+
+void PointCloudBatch::set_visible(int id, bool visible) {
+  commands[id].instance_count = visible ? 1 : 0;
+  commands_dirty = true;
+}
+
+/**
+ * @brief Upload modified commands and model matrices (only the small per-cloud buffers are re-uploaded)
+ */
+void PointCloudBatch::upload() const {
+  if (commands_dirty) {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands_buffer);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(DrawArraysIndirectCommand) * commands.size(), commands.data());
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    commands_dirty = false;
+  }
+
+  if (matrices_dirty) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, matrices_buffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(Eigen::Matrix4f) * model_matrices.size(), model_matrices.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    matrices_dirty = false;
+  }
+
+  if (bounds_dirty) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, bounds_buffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(Eigen::Vector4f) * bounds.size(), bounds.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    bounds_dirty = false;
+  }
+}
+
+bool PointCloudBatch::enable_gpu_culling(double lod_pixels, double min_lod_ratio) {
+  using namespace glk::console;
+
+  this->lod_pixels = lod_pixels;
+  this->min_lod_ratio = std::max(1e-3, std::min(min_lod_ratio, 1.0));
+
+  if (culling_shader) {
+    return true;
+  }
+
+  culling_shader.reset(new glk::GLSLShader());
+  if (!culling_shader->attach_source(get_data_path() + "/shader/batch_culling.comp", GL_COMPUTE_SHADER) || !culling_shader->link_program()) {
+    std::cerr << bold_yellow << "warning: failed to build the batch culling compute shader (GPU culling is disabled)" << reset << std::endl;
+    culling_shader.reset();
+    return false;
+  }
+
+  culled_count.reset(new glk::AtomicCounters(1));
+  return true;
+}
+
+void PointCloudBatch::disable_gpu_culling() {
+  culling_shader.reset();
+  culled_count.reset();
+  lod_pixels = 0.0;
+}
+
+int PointCloudBatch::num_drawn_clouds() const {
+  return culled_count ? culled_count->get_value() : commands.size();
+}
+
+/**
+ * @brief Write the commands of visible clouds into culled_commands_buffer and their count into culled_count
+ */
+void PointCloudBatch::cull(glk::GLSLShader& shader) const {
+  const Eigen::Matrix4f model_matrix = shader.get_uniform_cache_safe<Eigen::Matrix4f>("model_matrix").value_or(Eigen::Matrix4f::Identity());
+
+  culling_shader->use();
+  culling_shader->set_uniform("model_matrix", model_matrix);
+  culling_shader->set_uniform("num_clouds", static_cast<int>(commands.size()));
+  culling_shader->set_uniform("lod_pixels", static_cast<float>(lod_pixels));
+  culling_shader->set_uniform("min_lod_ratio", static_cast<float>(min_lod_ratio));
+
+  culled_count->reset();
+  culled_count->bind(0);
+
+  // without glMultiDrawArraysIndirectCount, all the commands are drawn and the ones not written in this pass must be empty
+  if (!gl3wIsSupported(4, 6)) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, culled_commands_buffer);
+    glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, sizeof(DrawArraysIndirectCommand) * commands.size(), GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  }
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, matrices_buffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, bounds_buffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commands_buffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, culled_commands_buffer);
+
+  glDispatchCompute((commands.size() + 63) / 64, 1, 1);
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_ATOMIC_COUNTER_BARRIER_BIT);
+
+  for (int i = 1; i < 4; i++) {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, 0);
+  }
+  culled_count->unbind();
+
+  shader.use();
+}
+
+void PointCloudBatch::draw(glk::GLSLShader& shader) const {
+  if (commands.empty() || total_points == 0) {
+    return;
+  }
+
+  upload();
+
+  // queried directly to avoid warnings for shaders without batching support
+  const GLint batch_index_loc = glGetAttribLocation(shader.id(), "vert_batch_index");
+  if (batch_index_loc >= 0 && culling_shader) {
+    cull(shader);
+  }
+
+  const GLint position_loc = shader.attrib("vert_position");
+  const GLint color_loc = with_colors ? shader.attrib("vert_color") : -1;
+
+  glBindVertexArray(vao);
+  glEnableVertexAttribArray(position_loc);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glVertexAttribPointer(position_loc, 3, GL_FLOAT, GL_FALSE, 0, 0);
+
+  if (color_loc >= 0) {
+    glEnableVertexAttribArray(color_loc);
+    glBindBuffer(GL_ARRAY_BUFFER, cbo);
+    glVertexAttribPointer(color_loc, 4, GL_FLOAT, GL_FALSE, 0, 0);
+  }
+
+  if (batch_index_loc >= 0) {
+    glEnableVertexAttribArray(batch_index_loc);
+    glBindBuffer(GL_ARRAY_BUFFER, index_buffer);
+    glVertexAttribIPointer(batch_index_loc, 1, GL_UNSIGNED_INT, 0, 0);
+    glVertexAttribDivisor(batch_index_loc, 1);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, matrices_buffer);
+    shader.set_uniform("batch_enabled", 1);
+
+    if (!culling_shader) {
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands_buffer);
+      glMultiDrawArraysIndirect(GL_POINTS, nullptr, commands.size(), 0);
+    } else if (gl3wIsSupported(4, 6)) {
+      // the number of commands is given by the atomic counter (GL 4.6)
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culled_commands_buffer);
+      glBindBuffer(GL_PARAMETER_BUFFER, culled_count->id());
+      glMultiDrawArraysIndirectCount(GL_POINTS, nullptr, 0, commands.size(), 0);
+      glBindBuffer(GL_PARAMETER_BUFFER, 0);
+    } else {
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culled_commands_buffer);
+      glMultiDrawArraysIndirect(GL_POINTS, nullptr, commands.size(), 0);
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    shader.set_uniform("batch_enabled", 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+    glDisableVertexAttribArray(batch_index_loc);
+  } else {
+    // fallback for shaders without batching support
+    const Eigen::Matrix4f model_matrix = shader.get_uniform_cache_safe<Eigen::Matrix4f>("model_matrix").value_or(Eigen::Matrix4f::Identity());
+    for (int i = 0; i < commands.size(); i++) {
+      if (!commands[i].instance_count || !commands[i].count) {
+        continue;
+      }
+
+      shader.set_uniform("model_matrix", (model_matrix * model_matrices[i]).eval());
+      glDrawArrays(GL_POINTS, commands[i].first, commands[i].count);
+    }
+    shader.set_uniform("model_matrix", model_matrix);
+  }
+
+  glDisableVertexAttribArray(position_loc);
+  if (color_loc >= 0) {
+    glDisableVertexAttribArray(color_loc);
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+}  // namespace glk
@@ -1,12 +1,18 @@
 #include <glk/pointcloud_buffer.hpp>
 
 #include <random>
+#include <algorithm>
 #include <numeric>
 #include <iostream>
 #include <glk/colormap.hpp>
+#include <glk/gpu_memory_tracker.hpp>
+#include <glk/uniform_buffer.hpp>
+#include <glk/console_colors.hpp>
 
 namespace glk {
 
+using namespace glk::console;
+
 PointCloudBuffer::PointCloudBuffer(int stride, int num_points) {
   this->stride = stride;
   this->num_points = num_points;
@@ -17,10 +23,15 @@ PointCloudBuffer::PointCloudBuffer(int stride, int num_points) {
   glGenBuffers(1, &vbo);
   glBindBuffer(GL_ARRAY_BUFFER, vbo);
   glBufferData(GL_ARRAY_BUFFER, stride * num_points, nullptr, GL_STATIC_DRAW);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, stride * num_points);
+  GpuMemoryTracker::instance()->set_evictable(this, num_points > 0);
 
   rendering_count = 0;
   points_rendering_budget = 8192;
   ebo = 0;
+  vertices_offset = 0;
+  streamed = false;
+  expired_warned = false;
 }
 
 PointCloudBuffer::PointCloudBuffer(const float* data, int stride, int num_points) {
@@ -33,6 +44,28 @@ PointCloudBuffer::PointCloudBuffer(const float* data, int stride, int num_points
   glGenBuffers(1, &vbo);
   glBindBuffer(GL_ARRAY_BUFFER, vbo);
   glBufferData(GL_ARRAY_BUFFER, stride * num_points, data, GL_STATIC_DRAW);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, stride * num_points);
+  GpuMemoryTracker::instance()->set_evictable(this, num_points > 0);
+
+  rendering_count = 0;
+  points_rendering_budget = 8192;
+  ebo = 0;
+  vertices_offset = 0;
+  streamed = false;
+  expired_warned = false;
+}
+
+PointCloudBuffer::PointCloudBuffer(const StreamingBufferArena::Range& range, int stride, int num_points) {
+  this->stride = stride;
+  this->num_points = range.valid() ? num_points : 0;
+
+  glGenVertexArrays(1, &vao);
+
+  vbo = range.buffer;
+  vertices_offset = range.offset;
+  streamed = true;
+  streamed_ranges.push_back(range);
+  expired_warned = false;
 
   rendering_count = 0;
   points_rendering_budget = 8192;
@@ -56,13 +89,19 @@ PointCloudBuffer::PointCloudBuffer(const Eigen::Vector4d* points, int num_points
 PointCloudBuffer::~PointCloudBuffer() {
   glDeleteVertexArrays(1, &vao);
   for (const auto& aux : aux_buffers) {
-    glDeleteBuffers(1, &aux.buffer);
+    if (aux.owned) {
+      glDeleteBuffers(1, &aux.buffer);
+    }
+  }
+  if (!streamed) {
+    glDeleteBuffers(1, &vbo);
   }
-  glDeleteBuffers(1, &vbo);
 
   if (ebo) {
     glDeleteBuffers(1, &ebo);
   }
+
+  GpuMemoryTracker::instance()->remove_all(this);
 }
 
 void PointCloudBuffer::add_intensity(glk::COLORMAP colormap, const std::vector<float>& intensities, float scale) {
@@ -113,10 +152,14 @@ void PointCloudBuffer::add_intensity(glk::COLORMAP colormap, const float* data,
 
 void PointCloudBuffer::add_buffer(const std::string& attribute_name, int dim, const float* data, int stride, int num_points) {
   assert(this->num_points == num_points);
+  restore();
 
   auto found = std::find_if(aux_buffers.begin(), aux_buffers.end(), [&](const AuxBufferData& aux) { return aux.attribute_name == attribute_name; });
   if (found != aux_buffers.end()) {
-    glDeleteBuffers(1, &found->buffer);
+    if (found->owned) {
+      glDeleteBuffers(1, &found->buffer);
+      GpuMemoryTracker::instance()->remove(this, GpuMemoryTracker::Category::BUFFER, found->stride * num_points);
+    }
     aux_buffers.erase(found);
   }
 
@@ -126,14 +169,36 @@ void PointCloudBuffer::add_buffer(const std::string& attribute_name, int dim, co
   glGenBuffers(1, &buffer_id);
   glBindBuffer(GL_ARRAY_BUFFER, buffer_id);
   glBufferData(GL_ARRAY_BUFFER, stride * num_points, data, GL_STATIC_DRAW);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, stride * num_points);
 
   aux_buffers.push_back(AuxBufferData{attribute_name, dim, stride, buffer_id});
 }
 
+void PointCloudBuffer::add_buffer(const std::string& attribute_name, int dim, const StreamingBufferArena::Range& range, int stride) {
+  if (!range.valid()) {
+    return;
+  }
+  restore();
+
+  auto found = std::find_if(aux_buffers.begin(), aux_buffers.end(), [&](const AuxBufferData& aux) { return aux.attribute_name == attribute_name; });
+  if (found != aux_buffers.end()) {
+    if (found->owned) {
+      glDeleteBuffers(1, &found->buffer);
+      GpuMemoryTracker::instance()->remove(this, GpuMemoryTracker::Category::BUFFER, found->stride * num_points);
+    }
+    aux_buffers.erase(found);
+  }
+
+  aux_buffers.push_back(AuxBufferData{attribute_name, dim, stride, range.buffer, range.offset, false});
+  streamed_ranges.push_back(range);
+  GpuMemoryTracker::instance()->set_evictable(this, evictable());
+}
+
 void PointCloudBuffer::enable_partial_rendering(int points_budget) {
   if (ebo) {
     disable_partial_rendering();
   }
+  restore();
 
   this->points_rendering_budget = points_budget;
 
@@ -153,6 +218,7 @@ void PointCloudBuffer::enable_partial_rendering(int points_budget) {
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * num_points, indices.data(), GL_STATIC_DRAW);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, sizeof(unsigned int) * num_points);
 }
 
 void PointCloudBuffer::disable_partial_rendering() {
@@ -160,7 +226,9 @@ void PointCloudBuffer::disable_partial_rendering() {
     return;
   }
 
+  restore();
   glDeleteBuffers(1, &ebo);
+  GpuMemoryTracker::instance()->remove(this, GpuMemoryTracker::Category::BUFFER, sizeof(unsigned int) * num_points);
   ebo = 0;
   rendering_count = 0;
 }
@@ -169,18 +237,20 @@ void PointCloudBuffer::bind(glk::GLSLShader& shader) const {
   if (num_points == 0) {
     return;
   }
+  restore();
+
   const GLint position_loc = shader.attrib("vert_position");
 
   glBindVertexArray(vao);
   glEnableVertexAttribArray(position_loc);
   glBindBuffer(GL_ARRAY_BUFFER, vbo);
-  glVertexAttribPointer(position_loc, 3, GL_FLOAT, GL_FALSE, stride, 0);
+  glVertexAttribPointer(position_loc, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(vertices_offset));
 
   for (const auto& aux : aux_buffers) {
     GLint attrib_loc = shader.attrib(aux.attribute_name);
     glEnableVertexAttribArray(attrib_loc);
     glBindBuffer(GL_ARRAY_BUFFER, aux.buffer);
-    glVertexAttribPointer(attrib_loc, aux.dim, GL_FLOAT, GL_FALSE, aux.stride, 0);
+    glVertexAttribPointer(attrib_loc, aux.dim, GL_FLOAT, GL_FALSE, aux.stride, reinterpret_cast<void*>(aux.offset));
   }
 }
 
@@ -202,30 +272,94 @@ void PointCloudBuffer::draw(glk::GLSLShader& shader) const {
     return;
   }
 
+  // the arena may have recycled the ranges for newer data
+  if (StreamingBufferArena::expired(streamed_ranges)) {
+    if (!expired_warned) {
+      std::cerr << bold_yellow << "warning: PointCloudBuffer references expired StreamingBufferArena ranges (streamed drawables must be re-created every frame)" << reset << std::endl;
+      expired_warned = true;
+    }
+    return;
+  }
+
   bind(shader);
 
   if (!ebo) {
     glDrawArrays(GL_POINTS, 0, num_points);
   } else {
-    const int offset = ((rendering_count++) * points_rendering_budget) % num_points;
-    const int count = std::max(points_rendering_budget, num_points - offset);
+    // budget scale of the canvas being rendered (adaptive quality, see glk::FrameUniformBlock::render_params)
+    const float budget_scale = std::max(1e-3f, std::min(glk::bound_frame_block().render_params.y(), 1.0f));
+    const int budget = std::max<int>(1, points_rendering_budget * budget_scale);
+    const int offset = (static_cast<size_t>(rendering_count++) * budget) % num_points;
+    const int count = std::min(budget, num_points - offset);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glDrawElements(GL_POINTS, points_rendering_budget, GL_UNSIGNED_INT, (void*)(offset * sizeof(unsigned int)));
+    glDrawElements(GL_POINTS, count, GL_UNSIGNED_INT, (void*)(offset * sizeof(unsigned int)));
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
   }
 
   unbind(shader);
 }
 
+bool PointCloudBuffer::evictable() const {
+  // arena ranges are recycled every few frames and need not be evicted
+  const bool has_streamed_buffers = streamed || std::any_of(aux_buffers.begin(), aux_buffers.end(), [](const AuxBufferData& aux) { return !aux.owned; });
+  return num_points > 0 && !has_streamed_buffers;
+}
+
+bool PointCloudBuffer::evict() const {
+  if (evicted() || !evictable()) {
+    return false;
+  }
+
+  evicted_data.push_back(GpuMemoryTracker::evict_buffer(vbo));
+  for (const auto& aux : aux_buffers) {
+    evicted_data.push_back(GpuMemoryTracker::evict_buffer(aux.buffer));
+  }
+  if (ebo) {
+    evicted_data.push_back(GpuMemoryTracker::evict_buffer(ebo));
+  }
+
+  size_t bytes = 0;
+  for (const auto& data : evicted_data) {
+    bytes += data->size();
+  }
+  GpuMemoryTracker::instance()->remove(this, GpuMemoryTracker::Category::BUFFER, bytes);
+
+  return true;
+}
+
+void PointCloudBuffer::restore() const {
+  if (!evicted()) {
+    return;
+  }
+
+  size_t bytes = 0;
+  auto data = evicted_data.begin();
+  GpuMemoryTracker::restore_buffer(vbo, **data);
+  bytes += (*data++)->size();
+  for (const auto& aux : aux_buffers) {
+    GpuMemoryTracker::restore_buffer(aux.buffer, **data);
+    bytes += (*data++)->size();
+  }
+  if (ebo) {
+    GpuMemoryTracker::restore_buffer(ebo, **data);
+    bytes += (*data++)->size();
+  }
+
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, bytes);
+  evicted_data.clear();
+}
+
 GLuint PointCloudBuffer::vba_id() const {
   return vao;
 }
 GLuint PointCloudBuffer::vbo_id() const {
+  restore();
   return vbo;
 }
 
 GLuint PointCloudBuffer::ebo_id() const {
+  restore();
   return ebo;
 }
 
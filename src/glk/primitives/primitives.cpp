@@ -1,11 +1,14 @@
 #include <glk/primitives/primitives.hpp>
 
+#include <chrono>
+#include <algorithm>
 #include <iostream>
 #include <glk/path.hpp>
 #include <glk/mesh.hpp>
 #include <glk/lines.hpp>
 #include <glk/thin_lines.hpp>
 #include <glk/mesh_utils.hpp>
+#include <glk/mesh_optimization.hpp>
 #include <glk/console_colors.hpp>
 
 #include <glk/primitives/grid.hpp>
@@ -22,69 +25,295 @@ using namespace glk::console;
 
 Primitives* Primitives::instance_ = nullptr;
 
+/**
+ * @brief CPU-side geometry of a primitive (generated in background threads)
+ */
+struct PrimitiveGeometry {
+  std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f>> vertices;
+  std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f>> normals;
+  std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f>> colors;
+  std::vector<int> indices;
+
+  OptimizedMesh optimized;  // optimized triangle mesh (num_vertices = 0 for other primitives)
+};
+
+namespace {
+
+// wireframe primitives share the geometry of solid ones
+Primitives::PrimitiveType geometry_type(Primitives::PrimitiveType type) {
+  switch (type) {
+    default:
+      return type;
+    case Primitives::WIRE_ICOSAHEDRON:
+      return Primitives::ICOSAHEDRON;
+    case Primitives::WIRE_SPHERE:
+      return Primitives::SPHERE;
+    case Primitives::WIRE_CUBE:
+      return Primitives::CUBE;
+    case Primitives::WIRE_CONE:
+      return Primitives::CONE;
+    case Primitives::WIRE_BUNNY:
+      return Primitives::BUNNY;
+  }
+}
+
+// optimize triangle meshes on the generating thread so that only the upload is left to the GL thread
+void optimize(PrimitiveGeometry& geometry) {
+  if (geometry.indices.size() < 3) {
+    return;
+  }
+
+  const void* normals = geometry.normals.empty() ? nullptr : geometry.normals.data();
+  geometry.optimized = optimize_mesh(
+    geometry.vertices.data(),
+    sizeof(float) * 3,
+    normals,
+    sizeof(float) * 3,
+    nullptr,
+    0,
+    nullptr,
+    0,
+    geometry.vertices.size(),
+    geometry.indices.data(),
+    geometry.indices.size());
+}
+
+std::shared_ptr<const PrimitiveGeometry> generate_sphere(int subdivision_level) {
+  glk::Icosahedron icosahedron;
+  for (int i = 0; i < subdivision_level; i++) {
+    icosahedron.subdivide();
+  }
+  icosahedron.spherize();
+
+  auto geometry = std::make_shared<PrimitiveGeometry>();
+  geometry->vertices = std::move(icosahedron.vertices);
+  geometry->normals = std::move(icosahedron.normals);
+  geometry->indices = std::move(icosahedron.indices);
+  optimize(*geometry);
+  return geometry;
+}
+
+template <typename Shape>
+std::shared_ptr<const PrimitiveGeometry> generate_flat(const Shape& shape) {
+  glk::Flatize flat(shape.vertices, shape.indices);
+
+  auto geometry = std::make_shared<PrimitiveGeometry>();
+  geometry->vertices = std::move(flat.vertices);
+  geometry->normals = std::move(flat.normals);
+  geometry->indices = std::move(flat.indices);
+  optimize(*geometry);
+  return geometry;
+}
+
+std::shared_ptr<const PrimitiveGeometry> generate_geometry(Primitives::PrimitiveType type) {
+  auto geometry = std::make_shared<PrimitiveGeometry>();
+
+  switch (type) {
+    default:
+      break;
+    case Primitives::ICOSAHEDRON:
+      return generate_flat(glk::Icosahedron());
+    case Primitives::SPHERE:
+      return generate_sphere(2);
+    case Primitives::CUBE:
+      return generate_flat(glk::Cube());
+    case Primitives::CONE:
+      return generate_flat(glk::Cone());
+    case Primitives::GRID:
+      geometry->vertices = glk::Grid().vertices;
+      break;
+    case Primitives::BUNNY: {
+      auto ply = load_ply(get_data_path() + "/models/bunny.ply");
+      if (ply) {
+        geometry->vertices = std::move(ply->vertices);
+        geometry->normals = std::move(ply->normals);
+        geometry->indices = std::move(ply->indices);
+        optimize(*geometry);
+      }
+    } break;
+    case Primitives::COORDINATE_SYSTEM:
+    case Primitives::SOLID_COORDINATE_SYSTEM: {
+      glk::CoordinateSystem coord;
+      geometry->vertices = std::move(coord.vertices);
+      geometry->colors = std::move(coord.colors);
+    } break;
+    case Primitives::WIRE_FRUSTUM: {
+      glk::Frustum frustum(0.6f, 0.4f, 0.5f);
+      geometry->vertices = std::move(frustum.vertices);
+      geometry->normals = std::move(frustum.normals);
+      geometry->indices = std::move(frustum.indices);
+    } break;
+  }
+
+  return geometry;
+}
+
+// create the GL object of a primitive (GL thread)
+std::shared_ptr<glk::Drawable> create_drawable(Primitives::PrimitiveType type, const PrimitiveGeometry& geometry) {
+  const bool wireframe = int(type) >= Primitives::WIRE_ICOSAHEDRON;
+
+  switch (type) {
+    default:
+      std::cerr << bold_red << "error : unknown primitive type " << type << reset << std::endl;
+      return nullptr;
+    case Primitives::ICOSAHEDRON:
+    case Primitives::WIRE_ICOSAHEDRON:
+    case Primitives::SPHERE:
+    case Primitives::WIRE_SPHERE:
+    case Primitives::CUBE:
+    case Primitives::WIRE_CUBE:
+    case Primitives::CONE:
+    case Primitives::WIRE_CONE:
+    case Primitives::BUNNY:
+    case Primitives::WIRE_BUNNY:
+      // optimized on the generating thread (solid and wireframe primitives share the result)
+      if (geometry.optimized.num_vertices) {
+        return std::make_shared<glk::Mesh>(geometry.optimized, wireframe);
+      }
+      return std::make_shared<glk::Mesh>(geometry.vertices, geometry.normals, geometry.indices, wireframe);
+    case Primitives::WIRE_FRUSTUM:
+      return std::make_shared<glk::Mesh>(geometry.vertices, geometry.normals, geometry.indices, true);
+    case Primitives::GRID:
+      return std::make_shared<glk::Lines>(0.01f, geometry.vertices);
+    case Primitives::COORDINATE_SYSTEM: {
+      auto lines = std::make_shared<glk::ThinLines>(geometry.vertices, geometry.colors);
+      lines->set_line_width(2.5f);
+      return lines;
+    }
+    case Primitives::SOLID_COORDINATE_SYSTEM:
+      return std::make_shared<glk::Lines>(0.01f, geometry.vertices, geometry.colors);
+  }
+}
+
+int validate_sphere_level(int subdivision_level) {
+  const int level = std::max(0, std::min(subdivision_level, Primitives::MAX_SPHERE_SUBDIVISION_LEVEL));
+  if (level != subdivision_level) {
+    std::cerr << bold_yellow << "warning: sphere subdivision level " << subdivision_level << " is clamped to " << level << reset << std::endl;
+  }
+  return level;
+}
+
+bool is_ready(const std::shared_future<std::shared_ptr<const PrimitiveGeometry>>& future) {
+  return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+}  // namespace
+
+Primitives::GeometryFuture& Primitives::request_geometry(PrimitiveType type, bool async) {
+  auto& geometry = geometries[geometry_type(type)];
+  if (!geometry.valid()) {
+    // deferred geometry is generated in the thread calling get()
+    geometry = std::async(async ? std::launch::async : std::launch::deferred, [type] { return generate_geometry(geometry_type(type)); }).share();
+  }
+  return geometry;
+}
+
+Primitives::GeometryFuture& Primitives::request_sphere_geometry(int subdivision_level, bool async) {
+  // level 2 is the SPHERE primitive
+  if (subdivision_level == 2) {
+    return request_geometry(SPHERE, async);
+  }
+
+  auto& geometry = sphere_geometries[subdivision_level];
+  if (!geometry.valid()) {
+    geometry = std::async(async ? std::launch::async : std::launch::deferred, [=] { return generate_sphere(subdivision_level); }).share();
+  }
+  return geometry;
+}
+
 const glk::Drawable& Primitives::create_primitive(PrimitiveType type) {
   if (meshes[type] == nullptr) {
-    bool wireframe = int(type) >= WIRE_ICOSAHEDRON;
-
-    switch (type) {
-      default:
-        std::cerr << bold_red << "error : unknown primitive type " << type << reset << std::endl;
-        break;
-      case ICOSAHEDRON:
-      case WIRE_ICOSAHEDRON: {
-        glk::Icosahedron icosahedron;
-        glk::Flatize flat(icosahedron.vertices, icosahedron.indices);
-        meshes[type].reset(new glk::Mesh(flat.vertices, flat.normals, flat.indices, wireframe));
-      } break;
-      case SPHERE:
-      case WIRE_SPHERE: {
-        glk::Icosahedron icosahedron;
-        icosahedron.subdivide();
-        icosahedron.subdivide();
-        icosahedron.spherize();
-        meshes[type].reset(new glk::Mesh(icosahedron.vertices, icosahedron.normals, icosahedron.indices, wireframe));
-      } break;
-      case CUBE:
-      case WIRE_CUBE: {
-        glk::Cube cube;
-        glk::Flatize flat(cube.vertices, cube.indices);
-        meshes[type].reset(new glk::Mesh(flat.vertices, flat.normals, flat.indices, wireframe));
-      } break;
-      case CONE:
-      case WIRE_CONE: {
-        glk::Cone cone;
-        glk::Flatize flat(cone.vertices, cone.indices);
-        meshes[type].reset(new glk::Mesh(flat.vertices, flat.normals, flat.indices, wireframe));
-      } break;
-      case GRID: {
-        glk::Grid grid;
-        meshes[type].reset(new glk::Lines(0.01f, grid.vertices));
-      } break;
-      case BUNNY:
-      case WIRE_BUNNY: {
-        auto ply = load_ply(get_data_path() + "/models/bunny.ply");
-        meshes[type].reset(new glk::Mesh(ply->vertices, ply->normals, ply->indices, wireframe));
-      } break;
-      case COORDINATE_SYSTEM: {
-        glk::CoordinateSystem coord;
-        auto lines = std::make_shared<glk::ThinLines>(coord.vertices, coord.colors);
-        lines->set_line_width(2.5f);
-        meshes[type] = lines;
-      } break;
-      case SOLID_COORDINATE_SYSTEM: {
-        glk::CoordinateSystem coord;
-        meshes[type].reset(new glk::Lines(0.01f, coord.vertices, coord.colors));
-      } break;
-      case WIRE_FRUSTUM: {
-        glk::Frustum frustum(0.6f, 0.4f, 0.5f);
-        meshes[type].reset(new glk::Mesh(frustum.vertices, frustum.normals, frustum.indices, true));
-      } break;
-    }
+    // waits for the geometry if it is being generated in the background
+    meshes[type] = create_drawable(type, *request_geometry(type, false).get());
   }
 
   return *meshes[type];
 }
 
+const glk::Drawable& Primitives::create_sphere(int subdivision_level, bool wireframe) {
+  if (subdivision_level == 2) {
+    return create_primitive(wireframe ? WIRE_SPHERE : SPHERE);
+  }
+
+  auto& sphere = spheres[std::make_pair(subdivision_level, wireframe)];
+  if (sphere == nullptr) {
+    const auto geometry = request_sphere_geometry(subdivision_level, false).get();
+    sphere = std::make_shared<glk::Mesh>(geometry->optimized, wireframe);
+  }
+
+  return *sphere;
+}
+
+void Primitives::prewarm(bool wait) {
+  for (int i = 0; i < NUM_PRIMITIVES; i++) {
+    if (meshes[i] == nullptr) {
+      request_geometry(static_cast<PrimitiveType>(i), true);
+    }
+  }
+  uploads_pending = true;
+
+  if (wait) {
+    for (int i = 0; i < NUM_PRIMITIVES; i++) {
+      create_primitive(static_cast<PrimitiveType>(i));
+    }
+  }
+}
+
+void Primitives::prewarm_sphere(int subdivision_level) {
+  request_sphere_geometry(validate_sphere_level(subdivision_level), true);
+  uploads_pending = true;
+}
+
+void Primitives::upload_prewarmed() {
+  if (!uploads_pending) {
+    return;
+  }
+
+  uploads_pending = false;
+  for (int i = 0; i < NUM_PRIMITIVES; i++) {
+    const auto& geometry = geometries[geometry_type(static_cast<PrimitiveType>(i))];
+    if (meshes[i] || !geometry.valid()) {
+      continue;
+    }
+
+    // deferred (not prewarmed) geometry is not ready until it is requested
+    if (is_ready(geometry)) {
+      create_primitive(static_cast<PrimitiveType>(i));
+    } else if (geometry.wait_for(std::chrono::seconds(0)) != std::future_status::deferred) {
+      uploads_pending = true;
+    }
+  }
+
+  for (const auto& sphere_geometry : sphere_geometries) {
+    for (bool wireframe : {false, true}) {
+      if (spheres.count(std::make_pair(sphere_geometry.first, wireframe))) {
+        continue;
+      }
+
+      if (is_ready(sphere_geometry.second)) {
+        create_sphere(sphere_geometry.first, wireframe);
+      } else if (sphere_geometry.second.wait_for(std::chrono::seconds(0)) != std::future_status::deferred) {
+        uploads_pending = true;
+      }
+    }
+  }
+}
+
+void Primitives::wait_prewarm() {
+  const auto wait = [](const GeometryFuture& geometry) {
+    if (geometry.valid() && geometry.wait_for(std::chrono::seconds(0)) != std::future_status::deferred) {
+      geometry.wait();
+    }
+  };
+
+  for (const auto& geometry : geometries) {
+    wait(geometry);
+  }
+  for (const auto& sphere_geometry : sphere_geometries) {
+    wait(sphere_geometry.second);
+  }
+}
+
 class PrimitiveWrapper : public glk::Drawable {
 public:
   PrimitiveWrapper(const glk::Drawable& primitive) : primitive(primitive) {}
@@ -99,4 +328,8 @@ std::shared_ptr<glk::Drawable> Primitives::create_primitive_ptr(PrimitiveType ty
   return std::make_shared<PrimitiveWrapper>(primitive(type));
 }
 
+std::shared_ptr<glk::Drawable> Primitives::create_sphere_ptr(int subdivision_level, bool wireframe) {
+  return std::make_shared<PrimitiveWrapper>(create_sphere(validate_sphere_level(subdivision_level), wireframe));
+}
+
 }  // namespace glk
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include <glk/render_target_pool.hpp>
+
+#include <algorithm>
+#include <glk/gpu_memory_tracker.hpp>
+
+namespace glk {
+
+RenderTargetPool* RenderTargetPool::instance_ = nullptr;
+
+RenderTargetPool::RenderTargetPool() : frame_count(0) {}
+
+RenderTargetPool* RenderTargetPool::instance() {
+  if (instance_ == nullptr) {
+    instance_ = new RenderTargetPool();
+  }
+  return instance_;
+}
+
+std::shared_ptr<Texture> RenderTargetPool::acquire(const Eigen::Vector2i& size, GLenum internal_format, GLenum format, GLenum type, GLenum filter_mode) {
+  // prefer the most recently released target so that a pass tends to get the same texture every frame
+  Target* found = nullptr;
+  for (auto& target : targets) {
+    if (target.in_use || target.internal_format != internal_format || target.texture->size() != size) {
+      continue;
+    }
+
+    if (found == nullptr || target.last_used > found->last_used) {
+      found = &target;
+    }
+  }
+
+  if (found == nullptr) {
+    targets.push_back(Target{std::make_shared<Texture>(size, internal_format, format, type), internal_format, false, frame_count});
+    found = &targets.back();
+  }
+
+  found->in_use = true;
+  found->last_used = frame_count;
+  found->texture->set_filer_mode(filter_mode);
+  return found->texture;
+}
+
+void RenderTargetPool::release(const std::shared_ptr<Texture>& texture) {
+  if (!texture) {
+    return;
+  }
+
+  auto found = std::find_if(targets.begin(), targets.end(), [&](const Target& target) { return target.texture == texture; });
+  if (found != targets.end()) {
+    found->in_use = false;
+    found->last_used = frame_count;
+  }
+}
+
+void RenderTargetPool::new_frame(int max_unused_frames) {
+  frame_count++;
+
+  // targets still attached to a frame buffer (use_count > 1) are kept until the frame buffer is re-attached or destroyed
+  targets.erase(
+    std::remove_if(
+      targets.begin(),
+      targets.end(),
+      [&](const Target& target) { return !target.in_use && frame_count - target.last_used > max_unused_frames && target.texture.use_count() == 1; }),
+    targets.end());
+}
+
+void RenderTargetPool::clear() {
+  targets.erase(std::remove_if(targets.begin(), targets.end(), [](const Target& target) { return !target.in_use; }), targets.end());
+}
+
+int RenderTargetPool::num_free_targets() const {
+  return std::count_if(targets.begin(), targets.end(), [](const Target& target) { return !target.in_use; });
+}
+
+size_t RenderTargetPool::memory_usage() const {
+  size_t bytes = 0;
+  for (const auto& target : targets) {
+    bytes += GpuMemoryTracker::bytes_per_pixel(target.internal_format) * target.texture->size().prod();
+  }
+  return bytes;
+}
+
+}  // namespace glk
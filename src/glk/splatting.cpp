@@ -86,8 +86,6 @@ void Splatting::draw(glk::GLSLShader& shader_) const {
   shader->set_uniform("colormap_axis", shader_.get_uniform_cache<Eigen::Vector3f>("colormap_axis"));
 
   shader->set_uniform("model_matrix", shader_.get_uniform_cache<Eigen::Matrix4f>("model_matrix"));
-  shader->set_uniform("view_matrix", shader_.get_uniform_cache<Eigen::Matrix4f>("view_matrix"));
-  shader->set_uniform("projection_matrix", shader_.get_uniform_cache<Eigen::Matrix4f>("projection_matrix"));
   shader->set_uniform("material_color", shader_.get_uniform_cache<Eigen::Vector4f>("material_color"));
 
   glDisable(GL_CULL_FACE);
@@ -0,0 +1,202 @@
+#include <glk/streaming_buffer_arena.hpp>
+
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+#include <glk/console_colors.hpp>
+#include <glk/gpu_memory_tracker.hpp>
+
+namespace glk {
+
+using namespace glk::console;
+
+size_t StreamingRing::allocate(size_t size, size_t alignment) {
+  if (size == 0 || size > ring_capacity) {
+    return npos;
+  }
+
+  if (used_bytes == 0) {
+    head = 0;
+  }
+
+  size_t offset = (head + alignment - 1) / alignment * alignment;
+  size_t required = offset - head + size;
+
+  // wrap around (the rest of the buffer is wasted until the frame is released)
+  if (offset + size > ring_capacity) {
+    offset = 0;
+    required = ring_capacity - head + size;
+  }
+
+  if (used_bytes + required > ring_capacity) {
+    return npos;
+  }
+
+  head = offset + size;
+  used_bytes += required;
+  frame_bytes += required;
+  return offset;
+}
+
+size_t StreamingRing::close_frame() {
+  const size_t bytes = frame_bytes;
+  frame_bytes = 0;
+  return bytes;
+}
+
+void StreamingRing::release(size_t bytes) {
+  used_bytes -= std::min(bytes, used_bytes);
+}
+
+StreamingBufferArena* StreamingBufferArena::instance_ = nullptr;
+
+StreamingBufferArena* StreamingBufferArena::instance() {
+  if (instance_ == nullptr) {
+    instance_ = new StreamingBufferArena();
+  }
+  return instance_;
+}
+
+StreamingBufferArena::StreamingBufferArena(size_t capacity)
+: init_failed(false),
+  buffer(0),
+  mapped(nullptr),
+  ring(capacity),
+  current_frame(1),
+  last_released_frame(0) {}
+
+StreamingBufferArena::~StreamingBufferArena() {
+  for (const auto& segment : segments) {
+    glDeleteSync(segment.fence);
+  }
+
+  if (buffer) {
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+    GpuMemoryTracker::instance()->remove_all(this);
+  }
+}
+
+bool StreamingBufferArena::available() const {
+  return !init_failed && glBufferStorage != nullptr;
+}
+
+bool StreamingBufferArena::init_buffer() {
+  if (buffer) {
+    return true;
+  }
+
+  if (!available()) {
+    if (!init_failed) {
+      std::cerr << bold_yellow << "warning: glBufferStorage is not supported (streaming buffer arena is disabled)" << reset << std::endl;
+    }
+    init_failed = true;
+    return false;
+  }
+
+  const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  glBufferStorage(GL_ARRAY_BUFFER, ring.capacity(), nullptr, flags);
+  mapped = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, ring.capacity(), flags));
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  if (!mapped) {
+    std::cerr << bold_red << "error: failed to map the streaming buffer arena" << reset << std::endl;
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+    init_failed = true;
+    return false;
+  }
+
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, ring.capacity());
+  return true;
+}
+
+/**
+ * @brief Release the space of the oldest frame in flight
+ * @param wait  If true, block until the GPU finishes the frame
+ * @return true if a frame has been released
+ */
+bool StreamingBufferArena::retire(bool wait) {
+  if (segments.empty()) {
+    return false;
+  }
+
+  auto& segment = segments.front();
+  GLenum result = glClientWaitSync(segment.fence, 0, 0);
+  while (wait && result == GL_TIMEOUT_EXPIRED) {
+    result = glClientWaitSync(segment.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+  }
+
+  if (result == GL_TIMEOUT_EXPIRED) {
+    return false;
+  }
+
+  glDeleteSync(segment.fence);
+  ring.release(segment.bytes);
+  last_released_frame = segment.frame;
+  segments.pop_front();
+  return true;
+}
+
+StreamingBufferArena::Range StreamingBufferArena::allocate(size_t size, size_t alignment) {
+  if (size == 0 || size > ring.capacity() || !init_buffer()) {
+    return Range();
+  }
+
+  while (retire(false)) {
+  }
+
+  while (true) {
+    const size_t offset = ring.allocate(size, alignment);
+    if (offset != StreamingRing::npos) {
+      Range range;
+      range.buffer = buffer;
+      range.offset = offset;
+      range.size = size;
+      range.data = mapped + offset;
+      range.arena = this;
+      range.frame = current_frame;
+      return range;
+    }
+
+    if (!retire(true)) {
+      // the current frame alone exhausts the arena
+      std::cerr << bold_yellow << "warning: streaming buffer arena is full (" << ring.used() << " / " << ring.capacity() << " bytes)" << reset << std::endl;
+      return Range();
+    }
+  }
+}
+
+StreamingBufferArena::Range StreamingBufferArena::write(const void* data, size_t size, size_t alignment) {
+  Range range = allocate(size, alignment);
+  if (range.valid()) {
+    std::memcpy(range.data, data, size);
+  }
+  return range;
+}
+
+bool StreamingBufferArena::expired(const std::vector<Range>& ranges) {
+  for (const auto& range : ranges) {
+    if (range.expired()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void StreamingBufferArena::new_frame() {
+  if (ring.frame_used()) {
+    segments.push_back(Segment{glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), ring.close_frame(), current_frame});
+  }
+  current_frame++;
+
+  while (retire(false)) {
+  }
+}
+
+}  // namespace glk
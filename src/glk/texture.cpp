@@ -1,11 +1,14 @@
 #include <glk/texture.hpp>
 
+#include <glk/gpu_memory_tracker.hpp>
+
 namespace glk {
 
 Texture::Texture(const Eigen::Vector2i& size, GLuint internal_format, GLuint format, GLuint type, const void* pixels) : width(size[0]), height(size[1]), internal_format(internal_format), format(format), type(type) {
   glGenTextures(1, &texture);
   glBindTexture(GL_TEXTURE_2D, texture);
   glTexImage2D(GL_TEXTURE_2D, 0, internal_format, size[0], size[1], 0, format, type, pixels);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::TEXTURE, GpuMemoryTracker::bytes_per_pixel(internal_format) * width * height);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -15,6 +18,7 @@ Texture::Texture(const Eigen::Vector2i& size, GLuint internal_format, GLuint for
 
 Texture::~Texture() {
   glDeleteTextures(1, &texture);
+  GpuMemoryTracker::instance()->remove_all(this);
 }
 
 GLuint Texture::id() const {
@@ -26,6 +30,7 @@ Eigen::Vector2i Texture::size() const {
 }
 
 void Texture::set_size(const Eigen::Vector2i& size) {
+  GpuMemoryTracker::instance()->remove_all(this);
   width = size[0];
   height = size[1];
 
@@ -34,6 +39,7 @@ void Texture::set_size(const Eigen::Vector2i& size) {
   glGenTextures(1, &texture);
   glBindTexture(GL_TEXTURE_2D, texture);
   glTexImage2D(GL_TEXTURE_2D, 0, internal_format, size[0], size[1], 0, format, type, 0);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::TEXTURE, GpuMemoryTracker::bytes_per_pixel(internal_format) * width * height);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -96,6 +102,7 @@ Texture1D::Texture1D(int width, GLuint internal_format, GLuint format, GLuint ty
   glGenTextures(1, &texture);
   glBindTexture(GL_TEXTURE_1D, texture);
   glTexImage1D(GL_TEXTURE_1D, 0, internal_format, width, 0, format, type, pixels);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::TEXTURE, GpuMemoryTracker::bytes_per_pixel(internal_format) * width);
   glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -104,6 +111,7 @@ Texture1D::Texture1D(int width, GLuint internal_format, GLuint format, GLuint ty
 
 Texture1D::~Texture1D() {
   glDeleteTextures(1, &texture);
+  GpuMemoryTracker::instance()->remove_all(this);
 }
 
 GLuint Texture1D::id() const {
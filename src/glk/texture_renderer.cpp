@@ -1,6 +1,7 @@
 #include <glk/texture_renderer.hpp>
 
 #include <glk/path.hpp>
+#include <glk/gpu_memory_tracker.hpp>
 #include <glk/effects/plain_rendering.hpp>
 
 namespace glk {
@@ -20,6 +21,7 @@ TextureRenderer::TextureRenderer() {
   glGenBuffers(1, &vbo);
   glBindBuffer(GL_ARRAY_BUFFER, vbo);
   glBufferData(GL_ARRAY_BUFFER, sizeof(GL_FLOAT) * 3 * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, sizeof(GL_FLOAT) * 3 * vertices.size());
 
   glBindVertexArray(vao);
 
@@ -32,6 +34,7 @@ TextureRenderer::TextureRenderer() {
 TextureRenderer::~TextureRenderer() {
   glDeleteVertexArrays(1, &vao);
   glDeleteBuffers(1, &vbo);
+  GpuMemoryTracker::instance()->remove_all(this);
 }
 
 void TextureRenderer::draw(const glk::Texture& color_texture) {
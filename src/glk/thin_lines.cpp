@@ -2,9 +2,13 @@
 
 #include <iostream>
 #include <Eigen/Geometry>
+#include <glk/uniform_buffer.hpp>
+#include <glk/console_colors.hpp>
 
 namespace glk {
 
+using namespace glk::console;
+
 ThinLines::ThinLines(const float* vertices, int num_vertices, bool line_strip) : ThinLines(vertices, nullptr, num_vertices, nullptr, 0, line_strip) {}
 
 ThinLines::ThinLines(const float* vertices, const float* colors, int num_vertices, bool line_strip) : ThinLines(vertices, colors, num_vertices, nullptr, 0, line_strip) {}
@@ -15,6 +19,9 @@ ThinLines::ThinLines(const float* vertices, const float* colors, int num_vertice
   this->mode = line_strip ? GL_LINE_STRIP : GL_LINES;
 
   vao = vbo = cbo = ebo = 0;
+  streamed = false;
+  expired_warned = false;
+  vbo_offset = cbo_offset = 0;
 
   glGenVertexArrays(1, &vao);
   glBindVertexArray(vao);
@@ -22,17 +29,20 @@ ThinLines::ThinLines(const float* vertices, const float* colors, int num_vertice
   glGenBuffers(1, &vbo);
   glBindBuffer(GL_ARRAY_BUFFER, vbo);
   glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 3 * num_vertices, vertices, GL_STATIC_DRAW);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, sizeof(float) * 3 * num_vertices);
 
   if (colors) {
     glGenBuffers(1, &cbo);
     glBindBuffer(GL_ARRAY_BUFFER, cbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 4 * num_vertices, colors, GL_STATIC_DRAW);
+    GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, sizeof(float) * 4 * num_vertices);
   }
 
   if (indices) {
     glGenBuffers(1, &ebo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * num_indices, indices, GL_STATIC_DRAW);
+    GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, sizeof(unsigned int) * num_indices);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
   }
 
@@ -40,34 +50,72 @@ ThinLines::ThinLines(const float* vertices, const float* colors, int num_vertice
   glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+ThinLines::ThinLines(const StreamingBufferArena::Range& vertices, const StreamingBufferArena::Range& colors, int num_vertices, bool line_strip)
+: line_width(1.0f) {
+  this->num_vertices = vertices.valid() ? num_vertices : 0;
+  this->num_indices = 0;
+  this->mode = line_strip ? GL_LINE_STRIP : GL_LINES;
+
+  glGenVertexArrays(1, &vao);
+
+  streamed = true;
+  vbo = vertices.buffer;
+  cbo = colors.buffer;
+  ebo = 0;
+  vbo_offset = vertices.offset;
+  cbo_offset = colors.offset;
+
+  streamed_ranges = {vertices, colors};
+  expired_warned = false;
+}
+
 ThinLines::~ThinLines() {
-  if (cbo) {
-    glDeleteBuffers(1, &cbo);
-  }
-  if (ebo) {
-    glDeleteBuffers(1, &ebo);
+  if (!streamed) {
+    if (cbo) {
+      glDeleteBuffers(1, &cbo);
+    }
+    if (ebo) {
+      glDeleteBuffers(1, &ebo);
+    }
+
+    glDeleteBuffers(1, &vbo);
   }
-
-  glDeleteBuffers(1, &vbo);
   glDeleteVertexArrays(1, &vao);
+
+  GpuMemoryTracker::instance()->remove_all(this);
 }
 
 void ThinLines::draw(glk::GLSLShader& shader) const {
+  if (num_vertices == 0) {
+    return;
+  }
+
+  // the arena may have recycled the ranges for newer data
+  if (StreamingBufferArena::expired(streamed_ranges)) {
+    if (!expired_warned) {
+      std::cerr << bold_yellow << "warning: ThinLines references expired StreamingBufferArena ranges (streamed drawables must be re-created every frame)" << reset << std::endl;
+      expired_warned = true;
+    }
+    return;
+  }
+
   GLint position_loc = shader.attrib("vert_position");
   GLint color_loc = shader.attrib("vert_color");
 
-  glLineWidth(line_width);
+  // line widths are given in window pixels and scaled to the canvas frame buffer resolution (see guik::GLCanvas::set_render_scale())
+  const float render_scale = glk::bound_frame_block().render_params.x();
+  glLineWidth(line_width * (render_scale > 0.0f ? render_scale : 1.0f));
 
   glBindVertexArray(vao);
 
   glEnableVertexAttribArray(position_loc);
   glBindBuffer(GL_ARRAY_BUFFER, vbo);
-  glVertexAttribPointer(position_loc, 3, GL_FLOAT, GL_FALSE, 0, 0);
+  glVertexAttribPointer(position_loc, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void*>(vbo_offset));
 
   if (cbo) {
     glEnableVertexAttribArray(color_loc);
     glBindBuffer(GL_ARRAY_BUFFER, cbo);
-    glVertexAttribPointer(color_loc, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    glVertexAttribPointer(color_loc, 4, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void*>(cbo_offset));
   }
 
   if (!ebo) {
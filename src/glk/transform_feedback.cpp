@@ -1,5 +1,7 @@
 #include <glk/transform_feedback.hpp>
 
+#include <glk/gpu_memory_tracker.hpp>
+
 namespace glk {
 
 TransformFeedback::TransformFeedback(size_t buffer_size, GLenum usage) {
@@ -8,6 +10,7 @@ TransformFeedback::TransformFeedback(size_t buffer_size, GLenum usage) {
   glGenBuffers(1, &tbo);
   glBindBuffer(GL_ARRAY_BUFFER, tbo);
   glBufferData(GL_ARRAY_BUFFER, buffer_size, nullptr, usage);
+  GpuMemoryTracker::instance()->add(this, GpuMemoryTracker::Category::BUFFER, buffer_size);
 
   glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, feedback);
   glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, tbo);
@@ -17,6 +20,7 @@ TransformFeedback::TransformFeedback(size_t buffer_size, GLenum usage) {
 TransformFeedback::~TransformFeedback() {
   glDeleteTransformFeedbacks(1, &feedback);
   glDeleteBuffers(1, &tbo);
+  GpuMemoryTracker::instance()->remove_all(this);
 }
 
 GLuint TransformFeedback::id() const {
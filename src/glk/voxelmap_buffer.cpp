@@ -0,0 +1,218 @@
+#include <glk/voxelmap_buffer.hpp>
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <glk/glsl_shader.hpp>
+#include <glk/gpu_memory_tracker.hpp>
+
+namespace glk {
+
+VoxelMapBuffer::VoxelMapBuffer(double resolution, Representative representative)
+: voxel_resolution(resolution),
+  inv_resolution(1.0 / resolution),
+  representative(representative),
+  intensity_colormap(glk::COLORMAP::TURBO),
+  intensity_scale(1.0f),
+  with_colors(false),
+  capacity(0),
+  vao(0),
+  vbo(0),
+  cbo(0) {}
+
+VoxelMapBuffer::~VoxelMapBuffer() {
+  for (GLuint buffer : {vbo, cbo}) {
+    if (buffer) {
+      glDeleteBuffers(1, &buffer);
+    }
+  }
+  if (vao) {
+    glDeleteVertexArrays(1, &vao);
+  }
+
+  GpuMemoryTracker::instance()->remove_all(this);
+}
+
+void VoxelMapBuffer::set_intensity_colormap(glk::COLORMAP colormap, float scale) {
+  intensity_colormap = colormap;
+  intensity_scale = scale;
+}
+
+void VoxelMapBuffer::insert(const float* points, int stride, int num_points, const float* colors, const float* intensities) {
+  if ((colors || intensities) && !with_colors) {
+    // voxels inserted before are white
+    with_colors = true;
+    voxel_colors.resize(voxel_points.size(), Eigen::Vector4f::Ones());
+    for (size_t voxel = 0; voxel < voxel_points.size(); voxel++) {
+      mark_dirty(voxel);
+    }
+  }
+
+  for (int i = 0; i < num_points; i++) {
+    const Eigen::Vector3f pt = Eigen::Map<const Eigen::Vector3f>(reinterpret_cast<const float*>(reinterpret_cast<const char*>(points) + stride * static_cast<size_t>(i)));
+
+    // converting NaN or out-of-range values to int is undefined
+    const Eigen::Array3d scaled = (pt.cast<double>() * inv_resolution).array().floor();
+    if (!scaled.allFinite() || (scaled < std::numeric_limits<int>::min()).any() || (scaled > std::numeric_limits<int>::max()).any()) {
+      continue;
+    }
+    const Eigen::Vector3i coord = scaled.cast<int>();
+    const float intensity = intensities ? intensities[i] : std::numeric_limits<float>::quiet_NaN();
+
+    Eigen::Vector4f color = Eigen::Vector4f::Ones();
+    if (colors) {
+      color = Eigen::Map<const Eigen::Vector4f>(colors + 4 * i);
+    } else if (intensities) {
+      color = glk::colormapf(intensity_colormap, intensity_scale * intensity);
+    }
+
+    const auto inserted = voxels.emplace(coord, voxel_points.size());
+    const size_t voxel = inserted.first->second;
+
+    if (inserted.second) {
+      num_voxel_points.push_back(1);
+      voxel_points.push_back(pt);
+      voxel_intensities.push_back(intensity);
+      if (with_colors) {
+        voxel_colors.push_back(color);
+      }
+
+      dirty_flags.push_back(false);
+      mark_dirty(voxel);
+      continue;
+    }
+
+    if (representative == Representative::FIRST) {
+      continue;
+    }
+
+    const int n = ++num_voxel_points[voxel];
+    if (representative == Representative::LATEST) {
+      // a batch without colors and intensities keeps the color of the voxel
+      voxel_points[voxel] = pt;
+      if (intensities) {
+        voxel_intensities[voxel] = intensity;
+      }
+      if (with_colors && (colors || intensities)) {
+        voxel_colors[voxel] = color;
+      }
+    } else {
+      // running mean
+      const float w = 1.0f / n;
+      voxel_points[voxel] += w * (pt - voxel_points[voxel]);
+      if (with_colors) {
+        if (colors) {
+          voxel_colors[voxel] += w * (color - voxel_colors[voxel]);
+        } else if (intensities) {
+          const float mean = std::isnan(voxel_intensities[voxel]) ? intensity : voxel_intensities[voxel] + w * (intensity - voxel_intensities[voxel]);
+          voxel_intensities[voxel] = mean;
+          voxel_colors[voxel] = glk::colormapf(intensity_colormap, intensity_scale * mean);
+        }
+      }
+    }
+
+    mark_dirty(voxel);
+  }
+}
+
+void VoxelMapBuffer::mark_dirty(size_t voxel) {
+  if (!dirty_flags[voxel]) {
+    dirty_flags[voxel] = true;
+    dirty_voxels.push_back(voxel);
+  }
+}
+
+void VoxelMapBuffer::clear() {
+  voxels.clear();
+  num_voxel_points.clear();
+  voxel_points.clear();
+  voxel_colors.clear();
+  voxel_intensities.clear();
+  dirty_voxels.clear();
+  dirty_flags.clear();
+}
+
+/**
+ * @brief Upload voxels modified after the last upload (buffers grow geometrically and keep their content)
+ */
+void VoxelMapBuffer::upload() const {
+  if (voxel_points.size() > capacity) {
+    const size_t new_capacity = std::max<size_t>({voxel_points.size(), capacity * 2, 8192});
+    GpuMemoryTracker::grow_buffer(this, vbo, sizeof(Eigen::Vector3f) * capacity, sizeof(Eigen::Vector3f) * new_capacity);
+    if (with_colors) {
+      GpuMemoryTracker::grow_buffer(this, cbo, sizeof(Eigen::Vector4f) * capacity, sizeof(Eigen::Vector4f) * new_capacity);
+    }
+    capacity = new_capacity;
+  }
+
+  if (with_colors && !cbo) {
+    GpuMemoryTracker::grow_buffer(this, cbo, 0, sizeof(Eigen::Vector4f) * capacity);
+  }
+
+  if (dirty_voxels.empty()) {
+    return;
+  }
+
+  // runs separated by small gaps are merged to reduce the number of upload calls
+  const int max_gap = 32;
+  std::sort(dirty_voxels.begin(), dirty_voxels.end());
+
+  for (size_t i = 0; i < dirty_voxels.size();) {
+    const size_t begin = dirty_voxels[i];
+    size_t end = begin + 1;
+    for (i++; i < dirty_voxels.size() && dirty_voxels[i] <= end + max_gap; i++) {
+      end = dirty_voxels[i] + 1;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, sizeof(Eigen::Vector3f) * begin, sizeof(Eigen::Vector3f) * (end - begin), voxel_points.data() + begin);
+
+    if (with_colors) {
+      glBindBuffer(GL_ARRAY_BUFFER, cbo);
+      glBufferSubData(GL_ARRAY_BUFFER, sizeof(Eigen::Vector4f) * begin, sizeof(Eigen::Vector4f) * (end - begin), voxel_colors.data() + begin);
+    }
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  for (const int voxel : dirty_voxels) {
+    dirty_flags[voxel] = false;
+  }
+  dirty_voxels.clear();
+}
+
+void VoxelMapBuffer::draw(glk::GLSLShader& shader) const {
+  if (voxel_points.empty()) {
+    return;
+  }
+
+  upload();
+  if (!vao) {
+    glGenVertexArrays(1, &vao);
+  }
+
+  const GLint position_loc = shader.attrib("vert_position");
+  const GLint color_loc = with_colors ? shader.attrib("vert_color") : -1;
+
+  glBindVertexArray(vao);
+  glEnableVertexAttribArray(position_loc);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glVertexAttribPointer(position_loc, 3, GL_FLOAT, GL_FALSE, 0, 0);
+
+  if (color_loc >= 0) {
+    glEnableVertexAttribArray(color_loc);
+    glBindBuffer(GL_ARRAY_BUFFER, cbo);
+    glVertexAttribPointer(color_loc, 4, GL_FLOAT, GL_FALSE, 0, 0);
+  }
+
+  glDrawArrays(GL_POINTS, 0, voxel_points.size());
+
+  glDisableVertexAttribArray(position_loc);
+  if (color_loc >= 0) {
+    glDisableVertexAttribArray(color_loc);
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+}  // namespace glk
@@ -0,0 +1,111 @@
+#include <guik/adaptive_quality_controller.hpp>
+
+#include <algorithm>
+
+namespace guik {
+
+AdaptiveQualityController::AdaptiveQualityController(double target_frame_time_msec, int num_frames_in_flight)
+: target_msec(target_frame_time_msec),
+  raise_ratio(0.7),
+  smoothing(0.1),
+  lower_cooldown(30),
+  raise_cooldown(60),
+  current_level(0),
+  cooldown(0),
+  frame_index(0),
+  measuring(false),
+  smoothed_msec(-1.0) {
+  // render scale is reduced last because it is the most visible degradation
+  levels = {
+    {1.0, glk::ScreenEffectQuality(16, 6, 15), 1.0},
+    {1.0, glk::ScreenEffectQuality(12, 5, 15), 0.75},
+    {0.85, glk::ScreenEffectQuality(8, 4, 12), 0.5},
+    {0.7, glk::ScreenEffectQuality(8, 3, 12), 0.35},
+    {0.6, glk::ScreenEffectQuality(6, 3, 10), 0.25},
+    {0.5, glk::ScreenEffectQuality(4, 2, 10), 0.15},
+  };
+
+  slots.resize(std::max(2, num_frames_in_flight));
+  for (auto& slot : slots) {
+    glGenQueries(2, slot.queries);
+    slot.pending = false;
+  }
+}
+
+AdaptiveQualityController::~AdaptiveQualityController() {
+  for (auto& slot : slots) {
+    glDeleteQueries(2, slot.queries);
+  }
+}
+
+void AdaptiveQualityController::set_target_frame_time(double msec) {
+  target_msec = std::max(1.0, msec);
+  cooldown = 0;
+}
+
+void AdaptiveQualityController::begin_frame() {
+  // skip measuring this frame if the result of the slot has not been collected yet
+  auto& slot = slots[frame_index % slots.size()];
+  measuring = !slot.pending;
+  if (measuring) {
+    glQueryCounter(slot.queries[0], GL_TIMESTAMP);
+  }
+}
+
+void AdaptiveQualityController::end_frame() {
+  auto& slot = slots[frame_index % slots.size()];
+  if (measuring) {
+    glQueryCounter(slot.queries[1], GL_TIMESTAMP);
+    slot.pending = true;
+  }
+
+  measuring = false;
+  frame_index++;
+}
+
+bool AdaptiveQualityController::update() {
+  for (auto& slot : slots) {
+    if (!slot.pending) {
+      continue;
+    }
+
+    GLint available = 0;
+    glGetQueryObjectiv(slot.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+      continue;
+    }
+
+    GLuint64 t0, t1;
+    glGetQueryObjectui64v(slot.queries[0], GL_QUERY_RESULT, &t0);
+    glGetQueryObjectui64v(slot.queries[1], GL_QUERY_RESULT, &t1);
+    slot.pending = false;
+
+    const double msec = (t1 - t0) / 1e6;
+    smoothed_msec = smoothed_msec < 0.0 ? msec : (1.0 - smoothing) * smoothed_msec + smoothing * msec;
+  }
+
+  if (cooldown > 0) {
+    cooldown--;
+    return false;
+  }
+
+  if (smoothed_msec < 0.0) {
+    return false;
+  }
+
+  if (smoothed_msec > target_msec && current_level < levels.size() - 1) {
+    current_level++;
+    cooldown = lower_cooldown;
+    return true;
+  }
+
+  if (smoothed_msec < target_msec * raise_ratio && current_level > 0) {
+    current_level--;
+    cooldown = raise_cooldown;
+    return true;
+  }
+
+  return false;
+}
+
+}  // namespace guik
@@ -57,15 +57,10 @@ void BasicProjectionControl::load(std::istream& ist) {
     projection_mode = 0;
   }
 
-  std::cout << token << std::endl;
   ist >> token >> fovy;
-  std::cout << token << std::endl;
   ist >> token >> width;
-  std::cout << token << std::endl;
   ist >> token >> near;
-  std::cout << token << std::endl;
   ist >> token >> far;
-  std::cout << token << std::endl;
 }
 
 void BasicProjectionControl::save(std::ostream& ost) const {
@@ -4,6 +4,7 @@
 #include <GLFW/glfw3.h>
 
 #include <imgui.h>
+#include <chrono>
 #include <iostream>
 
 #include <glm/glm.hpp>
@@ -15,9 +16,11 @@
 #include <glk/glsl_shader.hpp>
 #include <glk/frame_buffer.hpp>
 #include <glk/texture_renderer.hpp>
+#include <glk/pointcloud_buffer.hpp>
 #include <glk/effects/plain_rendering.hpp>
 #include <glk/console_colors.hpp>
 
+#include <guik/adaptive_quality_controller.hpp>
 #include <guik/viewer/light_viewer.hpp>
 #include <guik/camera/camera_control.hpp>
 #include <guik/camera/basic_projection_control.hpp>
@@ -32,8 +35,9 @@ using namespace glk::console;
  *
  * @param size
  */
-GLCanvas::GLCanvas(const Eigen::Vector2i& size, const std::string& shader_name) : size(size), clear_color(0.27f, 0.27f, 0.27f, 1.0f) {
+GLCanvas::GLCanvas(const Eigen::Vector2i& size, const std::string& shader_name) : size(size), clear_color(0.27f, 0.27f, 0.27f, 1.0f), render_scale(1.0) {
   frame_buffer.reset(new glk::FrameBuffer(size, 1));
+  frame_block.reset(new glk::UniformBuffer(sizeof(glk::FrameUniformBlock)));
   shader.reset(new glk::GLSLShader());
   if (!shader->init(glk::get_data_path() + "/shader/" + shader_name)) {
     shader.reset();
@@ -70,12 +74,26 @@ GLCanvas::GLCanvas(const Eigen::Vector2i& size, const std::string& shader_name)
 
   texture_renderer.reset(new glk::TextureRenderer());
 
+  // resampling to the screen resolution (falls back to the plain texture rendering if not available)
+  resample_shader.reset(new glk::GLSLShader());
+  if (resample_shader->init(glk::get_data_path() + "/shader/texture.vert", glk::get_data_path() + "/shader/resample.frag")) {
+    resample_shader->use();
+    resample_shader->set_uniform("color_sampler", 0);
+    resample_shader->set_uniform("depth_sampler", 1);
+    resample_shader->set_uniform("depth_sigma", 0.05f);
+    resample_shader->unuse();
+  } else {
+    resample_shader.reset();
+  }
+
   normal_buffer_id = info_buffer_id = dynamic_flag_buffer_id = 0;
   last_projection_view_matrix.setIdentity();
 
   partial_rendering_clear_thresh = 1e-6;
 }
 
+GLCanvas::~GLCanvas() {}
+
 /**
  * @brief
  *
@@ -122,9 +140,14 @@ void GLCanvas::set_colormap(glk::COLORMAP colormap_type) {
 
 void GLCanvas::set_effect(const std::shared_ptr<glk::ScreenEffect>& effect) {
   screen_effect = effect;
-  screen_effect->set_size(size);
+  screen_effect->set_size(render_size());
+  if (quality_controller) {
+    user_effect_quality = screen_effect->get_quality();
+    screen_effect->set_quality(quality_controller->settings().effect_quality);
+  }
+
   if (!screen_effect_buffer) {
-    screen_effect_buffer.reset(new glk::FrameBuffer(size, 1, false));
+    screen_effect_buffer.reset(new glk::FrameBuffer(render_size(), 1, false));
   }
 }
 
@@ -199,15 +222,104 @@ void GLCanvas::set_size(const Eigen::Vector2i& size) {
   this->size = size;
 
   projection_control->set_size(size);
-  frame_buffer->set_size(size);
+  resize_buffers();
+}
+
+/**
+ * @brief Resize the internal frame buffer and screen effect targets to render_size()
+ */
+void GLCanvas::resize_buffers() {
+  const Eigen::Vector2i buffer_size = render_size();
+  frame_buffer->set_size(buffer_size);
 
   if (screen_effect) {
-    screen_effect->set_size(size);
+    screen_effect->set_size(buffer_size);
   }
 
   if (screen_effect_buffer) {
-    screen_effect_buffer->set_size(size);
+    screen_effect_buffer->set_size(buffer_size);
   }
+
+  // resized buffers have undefined contents (force clearing them for partial rendering)
+  last_projection_view_matrix.setZero();
+}
+
+void GLCanvas::set_render_scale(double scale) {
+  scale = std::max(0.25, std::min(scale, 2.0));
+  if (scale == render_scale) {
+    return;
+  }
+
+  render_scale = scale;
+  resize_buffers();
+}
+
+double GLCanvas::get_render_scale() const {
+  return render_scale;
+}
+
+Eigen::Vector2i GLCanvas::render_size() const {
+  const double scale = render_scale * (quality_controller ? quality_controller->settings().render_scale : 1.0);
+  return (size.cast<double>() * scale).array().round().cast<int>().max(1);
+}
+
+void GLCanvas::enable_adaptive_quality(double target_frame_time_msec) {
+  if (quality_controller) {
+    quality_controller->set_target_frame_time(target_frame_time_msec);
+    return;
+  }
+
+  if (screen_effect) {
+    user_effect_quality = screen_effect->get_quality();
+  }
+
+  quality_controller.reset(new AdaptiveQualityController(target_frame_time_msec));
+  apply_quality_settings();
+}
+
+void GLCanvas::disable_adaptive_quality() {
+  if (!quality_controller) {
+    return;
+  }
+
+  quality_controller.reset();
+  apply_quality_settings();
+
+  // Give the screen effect back the quality it had before the controller took over
+  if (screen_effect) {
+    screen_effect->set_quality(user_effect_quality);
+  }
+}
+
+bool GLCanvas::adaptive_quality_enabled() const {
+  return quality_controller != nullptr;
+}
+
+const AdaptiveQualityController* GLCanvas::adaptive_quality() const {
+  return quality_controller.get();
+}
+
+/**
+ * @brief Apply the current quality level of the adaptive quality controller.
+ *        The points budget scale is passed to the shader in bind().
+ */
+void GLCanvas::apply_quality_settings() {
+  if (frame_buffer->size() != render_size()) {
+    resize_buffers();
+  }
+
+  if (screen_effect && quality_controller) {
+    screen_effect->set_quality(quality_controller->settings().effect_quality);
+  }
+}
+
+/**
+ * @brief Convert a window (canvas) pixel coordinate to the corresponding frame buffer pixel coordinate
+ */
+Eigen::Vector2i GLCanvas::window_to_render(const Eigen::Vector2i& p) const {
+  const Eigen::Vector2i buffer_size = frame_buffer->size();
+  const Eigen::Array2d scale = buffer_size.cast<double>().array() / size.cast<double>().array();
+  return (p.cast<double>().array() * scale).cast<int>();
 }
 
 /**
@@ -224,6 +336,13 @@ void GLCanvas::set_clear_color(const Eigen::Vector4f& color) {
  *
  */
 void GLCanvas::bind() {
+  if (quality_controller) {
+    if (quality_controller->update()) {
+      apply_quality_settings();
+    }
+    quality_controller->begin_frame();
+  }
+
   frame_buffer->bind();
   glDisable(GL_SCISSOR_TEST);
 
@@ -237,7 +356,11 @@ void GLCanvas::bind() {
     last_projection_view_matrix = projection_view_matrix;
   }
 
+  // camera data are shared with all programs (drawables and screen effects) through the frame uniform block
+  update_frame_block(view_matrix, projection_matrix);
+
   shader->use();
+  // plain uniforms are kept for custom shaders that do not declare FrameBlock
   shader->set_uniform("view_matrix", view_matrix);
   shader->set_uniform("inv_view_matrix", view_matrix.inverse().eval());
   shader->set_uniform("projection_matrix", projection_matrix);
@@ -306,6 +429,31 @@ void GLCanvas::bind() {
   glBindTexture(GL_TEXTURE_2D, colormap->id());
 }
 
+/**
+ * @brief Upload the per-frame uniform block and bind it to UniformBlockBinding::FRAME
+ */
+void GLCanvas::update_frame_block(const Eigen::Matrix4f& view_matrix, const Eigen::Matrix4f& projection_matrix) {
+  static const auto t0 = std::chrono::steady_clock::now();
+  const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  const Eigen::Vector2f buffer_size = frame_buffer->size().cast<float>();
+
+  glk::FrameUniformBlock block;
+  block.view_matrix = view_matrix;
+  block.inv_view_matrix = view_matrix.inverse();
+  block.projection_matrix = projection_matrix;
+  block.inv_projection_matrix = projection_matrix.inverse();
+  block.projection_view_matrix = projection_matrix * view_matrix;
+  block.inv_projection_view_matrix = block.projection_view_matrix.inverse();
+  block.viewport << buffer_size, buffer_size.cwiseInverse();
+  block.view_point_time << block.inv_view_matrix.block<3, 1>(0, 3), static_cast<float>(time);
+  block.render_params << buffer_size.x() / std::max(1, size[0]), quality_controller ? quality_controller->settings().points_budget_scale : 1.0f, 0.0f, 0.0f;
+
+  frame_block->update(&block);
+  glk::bind_frame_block(*frame_block, block);
+  frame_block_data = block;
+}
+
 /**
  * @brief
  *
@@ -321,6 +469,9 @@ void GLCanvas::unbind() {
   frame_buffer->unbind();
 
   if (screen_effect) {
+    // another canvas may have been rendered in between
+    glk::bind_frame_block(*frame_block, frame_block_data);
+
     glk::TextureRendererInput::Ptr input(new glk::TextureRendererInput());
     input->set("view_matrix", camera_control->view_matrix());
     input->set("projection_matrix", projection_control->projection_matrix());
@@ -341,6 +492,10 @@ void GLCanvas::unbind() {
     glEnable(GL_SCISSOR_TEST);
     frame_buffer->unbind();
   }
+
+  if (quality_controller) {
+    quality_controller->end_frame();
+  }
 }
 
 /**
@@ -391,11 +546,61 @@ void GLCanvas::unbind_second() {
 void GLCanvas::render_to_screen(int color_buffer_id) {
   glDisable(GL_SCISSOR_TEST);
   glDisable(GL_DEPTH_TEST);
-  texture_renderer->draw(frame_buffer->color(color_buffer_id));
+  if (color_buffer_id == 0 && resample_shader && frame_buffer->size() != size) {
+    draw_resampled();
+  } else {
+    texture_renderer->draw(frame_buffer->color(color_buffer_id));
+  }
   glEnable(GL_SCISSOR_TEST);
   glEnable(GL_DEPTH_TEST);
 }
 
+/**
+ * @brief
+ *
+ */
+const glk::Texture& GLCanvas::resolve_color_buffer() {
+  if (!resample_shader || frame_buffer->size() == size) {
+    return frame_buffer->color();
+  }
+
+  if (!resolve_buffer) {
+    resolve_buffer.reset(new glk::FrameBuffer(size, 1, false));
+  } else if (resolve_buffer->size() != size) {
+    resolve_buffer->set_size(size);
+  }
+
+  resolve_buffer->bind();
+  glDisable(GL_SCISSOR_TEST);
+  glDisable(GL_DEPTH_TEST);
+  draw_resampled();
+  glEnable(GL_SCISSOR_TEST);
+  resolve_buffer->unbind();
+
+  return resolve_buffer->color();
+}
+
+/**
+ * @brief Resample the main color buffer to the current viewport with the depth buffer as a guide
+ */
+void GLCanvas::draw_resampled() {
+  resample_shader->use();
+  resample_shader->set_uniform("inv_projection_matrix", projection_control->projection_matrix().inverse().eval());
+
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, frame_buffer->depth().id());
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, frame_buffer->color().id());
+
+  texture_renderer->draw_plain(*resample_shader);
+
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  resample_shader->unuse();
+}
+
 /**
  * @brief
  *
@@ -478,10 +683,14 @@ Eigen::Vector4i GLCanvas::pick_info(const Eigen::Vector2i& p, int window) const
     }
   }
 
+  // the frame buffer may have a different resolution from the canvas (render scale)
+  const Eigen::Vector2i buffer_size = frame_buffer->size();
+  const Eigen::Vector2i p_buffer = window_to_render(p);
+
   std::sort(ps.begin(), ps.end(), [=](const Eigen::Vector2i& lhs, const Eigen::Vector2i& rhs) { return lhs.norm() < rhs.norm(); });
   for (int i = 0; i < ps.size(); i++) {
-    Eigen::Vector2i p_ = p + ps[i];
-    int index = ((size[1] - p[1]) * size[0] + p_[0]) * 4;
+    Eigen::Vector2i p_ = (p_buffer + ps[i]).cwiseMax(0).cwiseMin(buffer_size - Eigen::Vector2i::Ones());
+    int index = ((buffer_size[1] - 1 - p_[1]) * buffer_size[0] + p_[0]) * 4;
     Eigen::Vector4i info = Eigen::Map<Eigen::Vector4i>(&pixels[index]);
 
     if ((info.array() != -1).any()) {
@@ -514,10 +723,13 @@ float GLCanvas::pick_depth(const Eigen::Vector2i& p, int window) const {
     }
   }
 
+  const Eigen::Vector2i buffer_size = frame_buffer->size();
+  const Eigen::Vector2i p_buffer = window_to_render(p);
+
   std::sort(ps.begin(), ps.end(), [=](const Eigen::Vector2i& lhs, const Eigen::Vector2i& rhs) { return lhs.norm() < rhs.norm(); });
   for (int i = 0; i < ps.size(); i++) {
-    Eigen::Vector2i p_ = p + ps[i];
-    int index = ((size[1] - p[1]) * size[0] + p_[0]);
+    Eigen::Vector2i p_ = (p_buffer + ps[i]).cwiseMax(0).cwiseMin(buffer_size - Eigen::Vector2i::Ones());
+    int index = ((buffer_size[1] - 1 - p_[1]) * buffer_size[0] + p_[0]);
     float depth = pixels[index];
 
     if (depth < 1.0f) {
@@ -0,0 +1,514 @@
+#include <guik/viewer/command_trace.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <typeinfo>
+
+#include <glk/mesh.hpp>
+#include <glk/pointcloud_buffer.hpp>
+#include <glk/primitives/primitives.hpp>
+#include <glk/console_colors.hpp>
+#include <guik/viewer/light_viewer_context.hpp>
+#include <guik/camera/basic_projection_control.hpp>
+#include <guik/camera/orbit_camera_control_xy.hpp>
+#include <guik/camera/orbit_camera_control_xz.hpp>
+#include <guik/camera/topdown_camera_control.hpp>
+#include <guik/camera/arcball_camera_control.hpp>
+#include <guik/camera/static_camera_control.hpp>
+
+namespace guik {
+
+using namespace glk::console;
+
+namespace {
+
+const char TRACE_MAGIC[4] = {'I', 'R', 'C', 'T'};
+const std::uint32_t TRACE_VERSION = 1;
+
+// record types
+enum RecordType : std::uint8_t { GEOMETRY = 1, UPDATE = 2, REMOVE = 3, CLEAR = 4, CAMERA = 5, FRAME = 6 };
+// geometry kinds
+enum GeometryKind : std::uint8_t { UNSUPPORTED = 0, PRIMITIVE = 1, POINTS = 2, MESH = 3 };
+// shader parameter types
+enum ParamType : std::uint8_t { INT = 0, FLOAT, VEC2F, VEC3F, VEC4F, VEC2I, VEC3I, VEC4I, MAT4F, MAT4D, INT_ARRAY, FLOAT_ARRAY };
+
+template <typename T>
+void write(std::ostream& ost, const T& value) {
+  ost.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T read(std::istream& ist) {
+  T value = T();
+  ist.read(reinterpret_cast<char*>(&value), sizeof(T));
+  return value;
+}
+
+void write_bytes(std::ostream& ost, const void* data, std::uint64_t size) {
+  write(ost, size);
+  ost.write(reinterpret_cast<const char*>(data), size);
+}
+
+std::vector<char> read_bytes(std::istream& ist) {
+  std::vector<char> data(read<std::uint64_t>(ist));
+  ist.read(data.data(), data.size());
+  return data;
+}
+
+void write_string(std::ostream& ost, const std::string& str) {
+  write_bytes(ost, str.data(), str.size());
+}
+
+std::string read_string(std::istream& ist) {
+  const auto data = read_bytes(ist);
+  return std::string(data.begin(), data.end());
+}
+
+// Eigen fixed-size matrices and scalars are written as raw arrays
+template <typename T>
+void write_value(std::ostream& ost, const T& value) {
+  write(ost, value);
+}
+
+template <typename T>
+void write_value(std::ostream& ost, const std::vector<T>& values) {
+  write_bytes(ost, values.data(), sizeof(T) * values.size());
+}
+
+template <typename T>
+void read_value(std::istream& ist, T& value) {
+  value = read<T>(ist);
+}
+
+template <typename T>
+void read_value(std::istream& ist, std::vector<T>& values) {
+  const auto data = read_bytes(ist);
+  values.resize(data.size() / sizeof(T));
+  std::copy(data.begin(), data.begin() + sizeof(T) * values.size(), reinterpret_cast<char*>(values.data()));
+}
+
+template <typename T>
+bool write_param(std::ostream& ost, const ShaderParameterInterface& param, ParamType type) {
+  auto p = dynamic_cast<const ShaderParameter<T>*>(&param);
+  if (p == nullptr) {
+    return false;
+  }
+
+  write_string(ost, param.name);
+  write(ost, type);
+  write_value(ost, p->value);
+  return true;
+}
+
+template <typename T>
+ShaderParameterInterface::Ptr read_param(std::istream& ist, const std::string& name) {
+  T value;
+  read_value(ist, value);
+  return glk::make_shared<ShaderParameter<T>>(name, value);
+}
+
+// size = 0 reads the entire buffer
+std::vector<char> read_buffer(GLuint buffer, size_t offset = 0, size_t size = 0) {
+  if (size == 0) {
+    size = glk::GpuMemoryTracker::buffer_size(buffer) - offset;
+  }
+  std::vector<char> data(size);
+
+  glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+  glGetBufferSubData(GL_COPY_READ_BUFFER, offset, size, data.data());
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+  return data;
+}
+
+}  // namespace
+
+/**
+ * CommandRecorder
+ */
+CommandRecorder::CommandRecorder(const std::string& filename)
+: ofs(filename, std::ios::binary),
+  start_time(std::chrono::steady_clock::now()),
+  frame_count(0),
+  geometry_count(0) {
+  if (!ofs) {
+    std::cerr << bold_red << "error: failed to open " << filename << reset << std::endl;
+    return;
+  }
+
+  ofs.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+  write(ofs, TRACE_VERSION);
+}
+
+CommandRecorder::~CommandRecorder() {}
+
+void CommandRecorder::write_header(std::uint8_t type) {
+  const std::uint64_t time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+  write(ofs, type);
+  write(ofs, time_ns);
+}
+
+void CommandRecorder::record_update(const std::string& name, const glk::Drawable::ConstPtr& drawable, const ShaderSetting& shader_setting) {
+  std::lock_guard<std::mutex> lock(mutex);
+  const std::uint32_t geometry_id = record_geometry(drawable);
+
+  std::stringstream sst;
+  std::uint32_t num_params = 0;
+  for (const auto& param : shader_setting.params) {
+    const bool written = write_param<int>(sst, *param, INT) || write_param<float>(sst, *param, FLOAT) ||                       //
+                         write_param<Eigen::Vector2f>(sst, *param, VEC2F) || write_param<Eigen::Vector3f>(sst, *param, VEC3F) ||  //
+                         write_param<Eigen::Vector4f>(sst, *param, VEC4F) || write_param<Eigen::Vector2i>(sst, *param, VEC2I) ||  //
+                         write_param<Eigen::Vector3i>(sst, *param, VEC3I) || write_param<Eigen::Vector4i>(sst, *param, VEC4I) ||  //
+                         write_param<Eigen::Matrix4f>(sst, *param, MAT4F) || write_param<Eigen::Matrix4d>(sst, *param, MAT4D) ||  //
+                         write_param<std::vector<int>>(sst, *param, INT_ARRAY) || write_param<std::vector<float>>(sst, *param, FLOAT_ARRAY);
+    if (written) {
+      num_params++;
+    } else {
+      std::cerr << bold_yellow << "warning: shader parameter " << param->name << " of " << name << " is not recorded (unsupported type)" << reset << std::endl;
+    }
+  }
+
+  write_header(UPDATE);
+  write_string(ofs, name);
+  write(ofs, geometry_id);
+  write<std::uint8_t>(ofs, shader_setting.transparent);
+  write(ofs, num_params);
+
+  const std::string params_data = sst.str();
+  ofs.write(params_data.data(), params_data.size());
+}
+
+void CommandRecorder::record_remove(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex);
+  write_header(REMOVE);
+  write_string(ofs, name);
+}
+
+void CommandRecorder::record_clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  write_header(CLEAR);
+}
+
+void CommandRecorder::record_frame(const Eigen::Vector2i& canvas_size, const CameraControl& camera_control, const ProjectionControl& projection_control) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  // same text format as "Save Camera" of the viewer UI
+  std::stringstream sst;
+  sst << "ProjectionControl: " << projection_control.name() << std::endl;
+  sst << projection_control << std::endl;
+  sst << "CameraControl: " << camera_control.name() << std::endl;
+  sst << camera_control << std::endl;
+
+  std::string camera_state = sst.str();
+  if (camera_state != last_camera_state) {
+    write_header(CAMERA);
+    write_string(ofs, camera_state);
+    last_camera_state = std::move(camera_state);
+  }
+
+  write_header(FRAME);
+  write<std::int32_t>(ofs, canvas_size[0]);
+  write<std::int32_t>(ofs, canvas_size[1]);
+  frame_count++;
+}
+
+std::uint32_t CommandRecorder::record_geometry(const glk::Drawable::ConstPtr& drawable) {
+  if (!drawable) {
+    return 0;
+  }
+
+  auto found = geometry_ids.find(drawable.get());
+  if (found != geometry_ids.end() && !found->second.first.expired()) {
+    return found->second.second;
+  }
+
+  // drop entries of released drawables so that the map does not grow indefinitely
+  for (auto itr = geometry_ids.begin(); itr != geometry_ids.end();) {
+    itr = itr->second.first.expired() ? geometry_ids.erase(itr) : std::next(itr);
+  }
+
+  const std::uint32_t geometry_id = ++geometry_count;
+  geometry_ids[drawable.get()] = std::make_pair(std::weak_ptr<const glk::Drawable>(drawable), geometry_id);
+
+  write_header(GEOMETRY);
+  write(ofs, geometry_id);
+
+  const auto primitive_type = glk::Primitives::type_of(drawable.get());
+  if (primitive_type != glk::Primitives::NUM_PRIMITIVES) {
+    write(ofs, PRIMITIVE);
+    write<std::int32_t>(ofs, primitive_type);
+    return geometry_id;
+  }
+
+  if (auto cloud = dynamic_cast<const glk::PointCloudBuffer*>(drawable.get())) {
+    // vbo_id() restores evicted buffers (streamed clouds reference a range of a StreamingBufferArena buffer)
+    const int num_points = cloud->size();
+    std::vector<char> points;
+    if (!cloud->is_streamed()) {
+      points = read_buffer(cloud->vbo_id());
+    } else if (num_points) {
+      points = read_buffer(cloud->vbo_id(), cloud->vbo_offset(), cloud->get_stride() * num_points);
+    }
+
+    write(ofs, POINTS);
+    write<std::int32_t>(ofs, num_points);
+    write<std::int32_t>(ofs, num_points ? points.size() / num_points : 0);
+    write_bytes(ofs, points.data(), points.size());
+
+    write<std::int32_t>(ofs, cloud->get_aux_size());
+    for (int i = 0; i < cloud->get_aux_size(); i++) {
+      const auto& aux = cloud->get_aux_buffer(i);
+      const auto data = aux.owned ? read_buffer(aux.buffer) : read_buffer(aux.buffer, aux.offset, aux.stride * num_points);
+      write_string(ofs, aux.attribute_name);
+      write<std::int32_t>(ofs, aux.dim);
+      write<std::int32_t>(ofs, aux.stride);
+      write_bytes(ofs, data.data(), data.size());
+    }
+
+    write<std::int32_t>(ofs, cloud->ebo_id() ? cloud->get_points_rendering_budget() : 0);
+    return geometry_id;
+  }
+
+  if (auto mesh = dynamic_cast<const glk::Mesh*>(drawable.get())) {
+    write(ofs, MESH);
+    write<std::int32_t>(ofs, mesh->get_num_vertices());
+    write<std::int32_t>(ofs, mesh->get_num_indices());
+    write<std::uint8_t>(ofs, mesh->is_wireframe());
+
+    // vertices, normals, colors, tex_coords, indices (empty if not given)
+    for (const GLuint buffer : {mesh->vbo_id(), mesh->nbo_id(), mesh->cbo_id(), mesh->tbo_id()}) {
+      const auto data = buffer ? read_buffer(buffer) : std::vector<char>();
+      write_bytes(ofs, data.data(), data.size());
+    }
+
+    // indices are always recorded as 32-bit
+    auto indices = read_buffer(mesh->ebo_id());
+    if (mesh->get_index_type() == GL_UNSIGNED_SHORT) {
+      std::vector<std::uint16_t> short_indices(indices.size() / sizeof(std::uint16_t));
+      std::memcpy(short_indices.data(), indices.data(), indices.size());
+
+      const std::vector<std::uint32_t> long_indices(short_indices.begin(), short_indices.end());
+      indices.resize(long_indices.size() * sizeof(std::uint32_t));
+      std::memcpy(indices.data(), long_indices.data(), indices.size());
+    }
+    write_bytes(ofs, indices.data(), indices.size());
+    return geometry_id;
+  }
+
+  write(ofs, UNSUPPORTED);
+  write_string(ofs, typeid(*drawable).name());
+  return geometry_id;
+}
+
+/**
+ * CommandReplayer
+ */
+CommandReplayer::CommandReplayer(const std::string& filename) : ifs(filename, std::ios::binary), frame_count(0), unsupported_count(0), canvas_size(0, 0) {
+  if (!ifs) {
+    std::cerr << bold_red << "error: failed to open " << filename << reset << std::endl;
+    return;
+  }
+
+  char magic[4];
+  ifs.read(magic, sizeof(magic));
+  const auto version = read<std::uint32_t>(ifs);
+  if (!ifs || !std::equal(magic, magic + 4, TRACE_MAGIC) || version != TRACE_VERSION) {
+    std::cerr << bold_red << "error: " << filename << " is not a valid command trace (version " << TRACE_VERSION << ")" << reset << std::endl;
+    ifs.setstate(std::ios::failbit);
+  }
+}
+
+CommandReplayer::~CommandReplayer() {}
+
+bool CommandReplayer::next_frame(LightViewerContext* context) {
+  while (ifs) {
+    const auto type = read<std::uint8_t>(ifs);
+    read<std::uint64_t>(ifs);  // timestamp
+    if (!ifs) {
+      break;
+    }
+
+    switch (type) {
+      case GEOMETRY: {
+        const auto geometry_id = read<std::uint32_t>(ifs);
+        geometries[geometry_id] = read_geometry();
+      } break;
+
+      case UPDATE: {
+        const std::string name = read_string(ifs);
+        const auto geometry_id = read<std::uint32_t>(ifs);
+
+        ShaderSetting shader_setting;
+        shader_setting.transparent = read<std::uint8_t>(ifs);
+        shader_setting.params.clear();
+
+        const auto num_params = read<std::uint32_t>(ifs);
+        for (int i = 0; i < num_params; i++) {
+          const std::string param_name = read_string(ifs);
+          switch (read<std::uint8_t>(ifs)) {
+            // clang-format off
+            case INT: shader_setting.params.push_back(read_param<int>(ifs, param_name)); break;
+            case FLOAT: shader_setting.params.push_back(read_param<float>(ifs, param_name)); break;
+            case VEC2F: shader_setting.params.push_back(read_param<Eigen::Vector2f>(ifs, param_name)); break;
+            case VEC3F: shader_setting.params.push_back(read_param<Eigen::Vector3f>(ifs, param_name)); break;
+            case VEC4F: shader_setting.params.push_back(read_param<Eigen::Vector4f>(ifs, param_name)); break;
+            case VEC2I: shader_setting.params.push_back(read_param<Eigen::Vector2i>(ifs, param_name)); break;
+            case VEC3I: shader_setting.params.push_back(read_param<Eigen::Vector3i>(ifs, param_name)); break;
+            case VEC4I: shader_setting.params.push_back(read_param<Eigen::Vector4i>(ifs, param_name)); break;
+            case MAT4F: shader_setting.params.push_back(read_param<Eigen::Matrix4f>(ifs, param_name)); break;
+            case MAT4D: shader_setting.params.push_back(read_param<Eigen::Matrix4d>(ifs, param_name)); break;
+            case INT_ARRAY: shader_setting.params.push_back(read_param<std::vector<int>>(ifs, param_name)); break;
+            case FLOAT_ARRAY: shader_setting.params.push_back(read_param<std::vector<float>>(ifs, param_name)); break;
+            // clang-format on
+            default:
+              std::cerr << bold_red << "error: corrupted command trace (unknown shader parameter type)" << reset << std::endl;
+              ifs.setstate(std::ios::failbit);
+              return false;
+          }
+        }
+
+        auto found = geometries.find(geometry_id);
+        if (found != geometries.end() && found->second) {
+          context->update_drawable(name, found->second, shader_setting);
+        }
+      } break;
+
+      case REMOVE:
+        context->remove_drawable(read_string(ifs));
+        break;
+
+      case CLEAR:
+        context->clear_drawables();
+        break;
+
+      case CAMERA:
+        apply_camera(context, read_string(ifs));
+        break;
+
+      case FRAME:
+        canvas_size[0] = read<std::int32_t>(ifs);
+        canvas_size[1] = read<std::int32_t>(ifs);
+        frame_count++;
+        return static_cast<bool>(ifs);
+
+      default:
+        std::cerr << bold_red << "error: corrupted command trace (unknown record type " << static_cast<int>(type) << ")" << reset << std::endl;
+        ifs.setstate(std::ios::failbit);
+        return false;
+    }
+  }
+
+  return false;
+}
+
+bool CommandReplayer::seek(LightViewerContext* context, long frame) {
+  while (frame_count < frame) {
+    if (!next_frame(context)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+glk::Drawable::ConstPtr CommandReplayer::read_geometry() {
+  switch (read<std::uint8_t>(ifs)) {
+    case PRIMITIVE:
+      return glk::Primitives::primitive_ptr(static_cast<glk::Primitives::PrimitiveType>(read<std::int32_t>(ifs)));
+
+    case POINTS: {
+      const int num_points = read<std::int32_t>(ifs);
+      const int stride = read<std::int32_t>(ifs);
+      const auto points = read_bytes(ifs);
+      auto cloud = std::make_shared<glk::PointCloudBuffer>(reinterpret_cast<const float*>(points.data()), stride, num_points);
+
+      const int num_aux = read<std::int32_t>(ifs);
+      for (int i = 0; i < num_aux; i++) {
+        const std::string attribute_name = read_string(ifs);
+        const int dim = read<std::int32_t>(ifs);
+        const int aux_stride = read<std::int32_t>(ifs);
+        const auto data = read_bytes(ifs);
+        cloud->add_buffer(attribute_name, dim, reinterpret_cast<const float*>(data.data()), aux_stride, num_points);
+      }
+
+      const int points_budget = read<std::int32_t>(ifs);
+      if (points_budget > 0) {
+        cloud->enable_partial_rendering(points_budget);
+      }
+      return cloud;
+    }
+
+    case MESH: {
+      const int num_vertices = read<std::int32_t>(ifs);
+      const int num_indices = read<std::int32_t>(ifs);
+      const bool wireframe = read<std::uint8_t>(ifs);
+
+      std::vector<char> buffers[5];
+      for (auto& buffer : buffers) {
+        buffer = read_bytes(ifs);
+      }
+
+      const auto data = [&](int i) { return buffers[i].empty() ? nullptr : buffers[i].data(); };
+      const auto stride = [&](int i) { return num_vertices ? static_cast<int>(buffers[i].size() / num_vertices) : 0; };
+      return std::make_shared<glk::Mesh>(data(0), stride(0), data(1), stride(1), data(2), stride(2), data(3), stride(3), num_vertices, data(4), num_indices, wireframe);
+    }
+
+    default: {
+      const std::string type_name = read_string(ifs);
+      std::cerr << bold_yellow << "warning: drawable type " << type_name << " is not supported by the replayer" << reset << std::endl;
+      unsupported_count++;
+      return nullptr;
+    }
+  }
+}
+
+void CommandReplayer::apply_camera(LightViewerContext* context, const std::string& camera_state) {
+  std::stringstream sst(camera_state);
+
+  std::string line;
+  while (std::getline(sst, line)) {
+    std::stringstream line_sst(line);
+    std::string token, type;
+    line_sst >> token >> type;
+
+    if (token == "ProjectionControl:") {
+      if (type != "PERSPECTIVE" && type != "ORTHOGONAL") {
+        continue;
+      }
+
+      auto projection_control = std::dynamic_pointer_cast<guik::BasicProjectionControl>(context->get_projection_control());
+      if (!projection_control) {
+        projection_control = std::make_shared<guik::BasicProjectionControl>(context->canvas_size());
+      }
+
+      // BasicProjectionControl::load() reads the header line by itself
+      std::stringstream proj_sst(camera_state.substr(static_cast<size_t>(sst.tellg()) - line.size() - 1));
+      proj_sst >> (*projection_control);
+      context->set_projection_control(projection_control);
+    } else if (token == "CameraControl:") {
+      std::shared_ptr<guik::CameraControl> camera_control = context->get_camera_control();
+      if (!camera_control || camera_control->name() != type) {
+        if (type == "OrbitCameraControlXY") {
+          camera_control.reset(new guik::OrbitCameraControlXY());
+        } else if (type == "OrbitCameraControlXZ") {
+          camera_control.reset(new guik::OrbitCameraControlXZ());
+        } else if (type == "TopDownCameraControl") {
+          camera_control.reset(new guik::TopDownCameraControl());
+        } else if (type == "ArcBallCameraControl") {
+          camera_control.reset(new guik::ArcBallCameraControl());
+        } else if (type == "StaticCameraControl") {
+          camera_control.reset(new guik::StaticCameraControl());
+        } else {
+          std::cerr << bold_yellow << "warning: unknown camera control type(" << type << ")" << reset << std::endl;
+          return;
+        }
+      }
+
+      sst >> (*camera_control);
+      context->set_camera_control(camera_control);
+      return;
+    }
+  }
+}
+
+}  // namespace guik
@@ -1,27 +1,25 @@
 #include <guik/viewer/info_window.hpp>
 
-#include <regex>
-#include <chrono>
 #include <boost/format.hpp>
-#if BOOST_VERSION >= 107100
-#include <boost/process.hpp>
-#else
-#include <boost/process/io.hpp>
-#include <boost/process/pipe.hpp>
-#include <boost/process/child.hpp>
-#endif
 
-#include <boost/algorithm/string.hpp>
+#include <implot.h>
+#include <portable-file-dialogs.h>
+#include <glk/frame_profiler.hpp>
+#include <glk/gpu_memory_tracker.hpp>
+#include <glk/render_target_pool.hpp>
 
 namespace guik {
 
 LightViewer::InfoWindow::InfoWindow() {
   show_cpu_info = show_gpu_info = true;
-  async_cpu_info = std::async(std::launch::async, []() { return std::string("No CPU info"); });
-  async_gpu_info = std::async(std::launch::async, []() { return std::string("No GPU info"); });
+  show_profiler = false;
+  plot_gpu_time = true;
+  monitor.reset(new SystemMonitor());
 }
 
-LightViewer::InfoWindow::~InfoWindow() {}
+LightViewer::InfoWindow::~InfoWindow() {
+  glk::FrameProfiler::instance()->set_enabled(false);
+}
 
 bool LightViewer::InfoWindow::draw_ui() {
   bool show_window = true;
@@ -30,27 +28,30 @@ bool LightViewer::InfoWindow::draw_ui() {
   ImGui::Checkbox("CPU", &show_cpu_info);
   ImGui::SameLine();
   ImGui::Checkbox("GPU", &show_gpu_info);
+  ImGui::SameLine();
+  if(ImGui::Checkbox("Profiler", &show_profiler)) {
+    glk::FrameProfiler::instance()->set_enabled(show_profiler);
+  }
   ImGui::Separator();
   ImGui::Text("FPS:%.1f", ImGui::GetIO().Framerate);
 
-  if(show_cpu_info) {
-    ImGui::Separator();
-    if(async_cpu_info.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
-      cpu_info = async_cpu_info.get();
-      async_cpu_info = std::async(std::launch::async, [this]() { return get_cpu_info(); });
-    }
+  if(show_cpu_info || show_gpu_info) {
+    monitor->update();
+  }
 
-    ImGui::Text("%s", cpu_info.c_str());
+  if(show_cpu_info && !monitor->empty()) {
+    ImGui::Separator();
+    draw_cpu_ui();
   }
 
-  if(show_gpu_info) {
+  if(show_gpu_info && !monitor->empty()) {
     ImGui::Separator();
-    if(async_gpu_info.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
-      gpu_info = async_gpu_info.get();
-      async_gpu_info = std::async(std::launch::async, [this]() { return get_gpu_info(); });
-    }
+    draw_gpu_ui();
+  }
 
-    ImGui::Text("%s", gpu_info.c_str());
+  if(show_profiler) {
+    ImGui::Separator();
+    draw_profiler_ui();
   }
 
   ImGui::End();
@@ -58,70 +59,130 @@ bool LightViewer::InfoWindow::draw_ui() {
   return show_window;
 }
 
-std::string LightViewer::InfoWindow::get_cpu_info() const {
-  boost::process::ipstream pipe_stream;
-  boost::process::child c("vmstat 1 2 --unit M -a", boost::process::std_out > pipe_stream);
-
-  std::stringstream sst;
-
-  std::string line;
-  while(pipe_stream && std::getline(pipe_stream, line) && !line.empty()) {
-    std::regex pattern("([0-9]+)(\\s+[0-9]+){16}");
-    std::smatch matched;
+void LightViewer::InfoWindow::draw_profiler_ui() {
+  auto profiler = glk::FrameProfiler::instance();
 
-    if(!std::regex_search(line, matched, pattern)) {
-      continue;
+  ImGui::Checkbox("GPU time", &plot_gpu_time);
+  ImGui::SameLine();
+  if(ImGui::Button("Clear")) {
+    profiler->clear();
+  }
+  ImGui::SameLine();
+  if(ImGui::Button("Save JSON")) {
+    std::string filename = pfd::save_file("select the destination path", "/tmp/frame_profile.json").result();
+    if(!filename.empty()) {
+      profiler->save_json(filename);
+    }
+  }
+  ImGui::SameLine();
+  if(ImGui::Button("Save trace")) {
+    std::string filename = pfd::save_file("select the destination path", "/tmp/frame_trace.json").result();
+    if(!filename.empty()) {
+      profiler->save_chrome_trace(filename);
     }
+  }
 
-    std::stringstream line_sst(line);
-    std::vector<int> values(16);
-    for(int i = 0; i < values.size(); i++) {
-      line_sst >> values[i];
+  // reorder the ring buffers from the oldest to the latest for plotting
+  const int size = profiler->history_size();
+  const auto unroll = [&](const std::vector<float>& ring) {
+    std::vector<float> values(size);
+    for(int i = 0; i < size; i++) {
+      values[i] = ring[(profiler->history_offset() - size + i + ring.size()) % ring.size()];
     }
+    return values;
+  };
 
-    sst.str("");
-    int mem_free = values[3];
-    int mem_inact = values[4];
-    int mem_active = values[5];
-    double mem_percent = 100 * (mem_active) / static_cast<double>(mem_free + mem_inact + mem_active);
-    int cpu_idle = values[14];
+  const auto& labels = profiler->labels();
+  if(ImPlot::BeginPlot("##frame_profiler", ImVec2(480, 240), ImPlotFlags_NoTitle)) {
+    ImPlot::SetupAxes("frame", "msec", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
 
-    sst << boost::format("CPU %2d %%  Memory %02d %% (%5d Mb / %5d Mb)") % (100 - cpu_idle) % static_cast<int>(mem_percent) % (mem_active) % (mem_free + mem_inact + mem_active);
-  }
-  c.wait();
-  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    if(size) {
+      const auto frame_times = unroll(profiler->frame_time_history());
+      ImPlot::PlotLine("frame (cpu)", frame_times.data(), size);
 
-  if(sst.str().empty()) {
-    return "Failed to retrieve CPU info";
+      for(const auto& label : labels) {
+        const auto values = unroll(plot_gpu_time ? profiler->gpu_time_history(label) : profiler->cpu_time_history(label));
+        ImPlot::PlotLine(label.c_str(), values.data(), size);
+      }
+    }
+
+    ImPlot::EndPlot();
   }
 
-  return sst.str();
+  for(const auto& label : labels) {
+    ImGui::Text("%-32s cpu %7.3f msec  gpu %7.3f msec", label.c_str(), profiler->average_cpu_time(label), profiler->average_gpu_time(label));
+  }
+  ImGui::Text("dropped frames:%ld", profiler->num_dropped_frames());
 }
 
-std::string LightViewer::InfoWindow::get_gpu_info() const {
-  boost::process::ipstream pipe_stream;
-  boost::process::child c("nvidia-smi --query-gpu=index,name,utilization.gpu,utilization.memory,memory.used,memory.total --format=csv,noheader", boost::process::std_out > pipe_stream);
+void LightViewer::InfoWindow::draw_cpu_ui() {
+  const auto& latest = monitor->latest();
+  const double mem_used_mb = latest.mem_used_kb / 1024.0;
+  const double mem_total_mb = latest.mem_total_kb / 1024.0;
+  const double mem_percent = latest.mem_total_kb > 0 ? 100.0 * latest.mem_used_kb / latest.mem_total_kb : 0.0;
+
+  ImGui::Text("%s", (boost::format("CPU %5.1f %%  Memory %4.1f %% (%.0f Mb / %.0f Mb)  RSS %.0f Mb") % latest.cpu_usage % mem_percent % mem_used_mb % mem_total_mb % (latest.process_rss_kb / 1024.0)).str().c_str());
 
-  std::stringstream sst;
+  const auto& history = monitor->history();
+  std::vector<float> cpu_usage(history.size());
+  std::vector<float> mem_usage(history.size());
+  for(int i = 0; i < history.size(); i++) {
+    cpu_usage[i] = std::max(0.0, history[i].cpu_usage);
+    mem_usage[i] = history[i].mem_total_kb > 0 ? 100.0 * history[i].mem_used_kb / history[i].mem_total_kb : 0.0;
+  }
 
-  std::string line;
-  while(pipe_stream && std::getline(pipe_stream, line) && !line.empty()) {
-    std::vector<std::string> tokens;
-    boost::split(tokens, line, boost::is_any_of(","));
+  if(ImPlot::BeginPlot("##cpu_usage", ImVec2(480, 120), ImPlotFlags_NoTitle)) {
+    ImPlot::SetupAxes("sample", "%", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_None);
+    ImPlot::SetupAxisLimits(ImAxis_Y1, 0.0, 100.0, ImPlotCond_Always);
+    ImPlot::PlotLine("CPU", cpu_usage.data(), cpu_usage.size());
+    ImPlot::PlotLine("Memory", mem_usage.data(), mem_usage.size());
+    ImPlot::EndPlot();
+  }
+}
 
-    if(tokens.size() != 6) {
-      continue;
+void LightViewer::InfoWindow::draw_gpu_ui() {
+  auto tracker = glk::GpuMemoryTracker::instance();
+  const double buffers_mb = tracker->total(glk::GpuMemoryTracker::Category::BUFFER) / 1024.0 / 1024.0;
+  const double textures_mb = tracker->total(glk::GpuMemoryTracker::Category::TEXTURE) / 1024.0 / 1024.0;
+  ImGui::Text("%s", (boost::format("Tracked %.1f Mb (buffers %.1f Mb / textures %.1f Mb)") % (buffers_mb + textures_mb) % buffers_mb % textures_mb).str().c_str());
+
+  auto pool = glk::RenderTargetPool::instance();
+  ImGui::Text("%s", (boost::format("Render targets %d (%d free) %.1f Mb") % pool->num_targets() % pool->num_free_targets() % (pool->memory_usage() / 1024.0 / 1024.0)).str().c_str());
+
+  if(ImGui::CollapsingHeader("drawables")) {
+    const auto usages = LightViewer::instance()->drawable_memory_usage();
+    std::vector<std::pair<std::string, size_t>> sorted(usages.begin(), usages.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& lhs, const auto& rhs) { return lhs.second > rhs.second; });
+    for(int i = 0; i < std::min<int>(sorted.size(), 16); i++) {
+      ImGui::Text("%-32s %8.2f Mb", sorted[i].first.c_str(), sorted[i].second / 1024.0 / 1024.0);
     }
+  }
 
-    sst << boost::format("%5s %20s : GPU %5s    Memory (%10s / %10s)\n") % tokens[0] % tokens[1] % tokens[2] % tokens[4] % tokens[5];
+  if(!monitor->gpu_memory_info_available()) {
+    ImGui::Text("GPU memory info is not available (GL_NVX_gpu_memory_info / GL_ATI_meminfo)");
+    return;
   }
-  c.wait();
-  std::this_thread::sleep_for(std::chrono::milliseconds(500));
 
-  if(sst.str().empty()) {
-    return "Failed to retrieve GPU info";
+  const auto& latest = monitor->latest();
+  if(latest.gpu_total_kb > 0) {
+    const double used_mb = (latest.gpu_total_kb - latest.gpu_free_kb) / 1024.0;
+    const double total_mb = latest.gpu_total_kb / 1024.0;
+    ImGui::Text("%s", (boost::format("GPU Memory %4.1f %% (%.0f Mb / %.0f Mb)") % (100.0 * used_mb / total_mb) % used_mb % total_mb).str().c_str());
+  } else {
+    ImGui::Text("%s", (boost::format("GPU Memory free %.0f Mb") % (latest.gpu_free_kb / 1024.0)).str().c_str());
   }
 
-  return sst.str();
+  const auto& history = monitor->history();
+  std::vector<float> gpu_free(history.size());
+  for(int i = 0; i < history.size(); i++) {
+    gpu_free[i] = history[i].gpu_free_kb / 1024.0;
+  }
+
+  if(ImPlot::BeginPlot("##gpu_memory", ImVec2(480, 120), ImPlotFlags_NoTitle)) {
+    ImPlot::SetupAxes("sample", "Mb", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+    ImPlot::PlotLine("free", gpu_free.data(), gpu_free.size());
+    ImPlot::EndPlot();
+  }
 }
-}  // namespace guik
\ No newline at end of file
+
+}  // namespace guik
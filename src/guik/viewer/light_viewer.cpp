@@ -11,6 +11,9 @@
 
 #include <glk/io/png_io.hpp>
 #include <glk/glsl_shader.hpp>
+#include <glk/frame_profiler.hpp>
+#include <glk/render_target_pool.hpp>
+#include <glk/streaming_buffer_arena.hpp>
 #include <glk/primitives/primitives.hpp>
 #include <glk/console_colors.hpp>
 #include <guik/viewer/viewer_ui.hpp>
@@ -22,7 +25,10 @@ std::shared_ptr<LightViewer> LightViewer::inst;
 
 LightViewer::LightViewer() : Application(), LightViewerContext("main"), max_texts_size(32) {}
 
-LightViewer::~LightViewer() {}
+LightViewer::~LightViewer() {
+  // primitive geometry generated in the background must not outlive the viewer (it may still be loading data files)
+  glk::Primitives::instance()->wait_prewarm();
+}
 
 bool LightViewer::init(const Eigen::Vector2i& size, const char* glsl_version, bool background) {
   Application::init(size, glsl_version, background);
@@ -34,6 +40,9 @@ bool LightViewer::init(const Eigen::Vector2i& size, const char* glsl_version, bo
     return false;
   }
 
+  // generate primitive geometry in the background while the first frames are rendered
+  glk::Primitives::instance()->prewarm();
+
   return true;
 }
 
@@ -46,6 +55,12 @@ void LightViewer::framebuffer_size_callback(const Eigen::Vector2i& size) {
 }
 
 void LightViewer::draw_ui() {
+  // a profiler frame spans from draw_ui() (sub viewers are rendered here) to draw_gl() of the next frame
+  glk::FrameProfiler::instance()->new_frame();
+  glk::RenderTargetPool::instance()->new_frame();
+  glk::StreamingBufferArena::instance()->new_frame();
+  glk::Primitives::instance()->upload_prewarmed();
+
   std::unique_lock<std::mutex> lock(invoke_requests_mutex);
   while(!invoke_requests.empty()) {
     invoke_requests.front()();
@@ -94,10 +109,12 @@ void LightViewer::draw_ui() {
   // screen shot
   if(ImGui::GetIO().KeysDown[GLFW_KEY_J]) {
     invoke_after_rendering([this] {
-      auto bytes = canvas->frame_buffer->color().read_pixels<unsigned char>(GL_RGBA, GL_UNSIGNED_BYTE);
+      // resampled to the canvas size (supersampled if the render scale is larger than 1)
+      const auto& color_buffer = canvas->resolve_color_buffer();
+      auto bytes = color_buffer.read_pixels<unsigned char>(GL_RGBA, GL_UNSIGNED_BYTE);
       std::vector<unsigned char> flipped(bytes.size(), 255);
 
-      Eigen::Vector2i size = canvas->frame_buffer->color().size();
+      Eigen::Vector2i size = color_buffer.size();
       for(int y = 0; y < size[1]; y++) {
         int y_ = size[1] - y - 1;
         for(int x = 0; x < size[0]; x++) {
@@ -110,7 +127,7 @@ void LightViewer::draw_ui() {
       double time =
           std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count() / 1e9;
       std::string filename = (boost::format("/tmp/ss_%.6f.png") % time).str();
-      if(glk::save_png(filename, canvas->size[0], canvas->size[1], flipped)) {
+      if(glk::save_png(filename, size[0], size[1], flipped)) {
         std::cout << "screen shot saved:" << filename << std::endl;
       } else {
         std::cout << "failed to save screen shot" << std::endl;
@@ -211,7 +228,10 @@ void LightViewer::draw_ui() {
 
 void LightViewer::draw_gl() {
   LightViewerContext::draw_gl();
+
+  glk::FrameProfiler::instance()->push("render_to_screen");
   canvas->render_to_screen();
+  glk::FrameProfiler::instance()->pop();
 
   std::unique_lock<std::mutex> lock(post_render_invoke_requests_mutex);
   while(!post_render_invoke_requests.empty()) {
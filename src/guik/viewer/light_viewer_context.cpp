@@ -3,6 +3,8 @@
 #include <boost/algorithm/string.hpp>
 
 #include <ImGuizmo.h>
+#include <glk/frame_profiler.hpp>
+#include <glk/gpu_memory_tracker.hpp>
 #include <glk/primitives/primitives.hpp>
 
 #include <guik/viewer/light_viewer.hpp>
@@ -17,6 +19,8 @@ LightViewerContext::LightViewerContext(const std::string& context_name) : contex
   draw_xy_grid = true;
   decimal_rendering = false;
   last_projection_view_matrix.setIdentity();
+  frame_count = 0;
+  gpu_memory_budget = 0;
 }
 
 LightViewerContext::~LightViewerContext() {}
@@ -57,6 +61,9 @@ void LightViewerContext::clear() {
   sub_ui_callbacks.clear();
   drawable_filters.clear();
   drawables.clear();
+  if (recorder) {
+    recorder->record_clear();
+  }
 
   std::lock_guard<std::mutex> lock(sub_texts_mutex);
   sub_texts.clear();
@@ -141,6 +148,14 @@ void LightViewerContext::draw_ui() {
 }
 
 void LightViewerContext::draw_gl() {
+  auto profiler = glk::FrameProfiler::instance();
+  glk::FrameProfiler::Scope prof_scope(context_name);
+
+  if (recorder) {
+    recorder->record_frame(canvas->size, *canvas->camera_control, *canvas->projection_control);
+  }
+
+  profiler->push(context_name, "filter", false);
   std::vector<std::pair<guik::ShaderSetting::Ptr, glk::Drawable::ConstPtr>> active_drawables;
   for (const auto& itr : drawables) {
     bool draw = true;
@@ -154,11 +169,17 @@ void LightViewerContext::draw_gl() {
     const auto& drawable = itr.second.second;
     if (draw && drawable) {
       active_drawables.push_back(itr.second);
+      drawable_last_drawn[itr.first] = frame_count;
     }
   }
 
+  profiler->pop();
+
+  profiler->push(context_name, "bind");
   canvas->bind();
+  profiler->pop();
 
+  profiler->push(context_name, "grid");
   global_shader_setting.set(*canvas->shader);
   canvas->shader->set_uniform("model_matrix", Eigen::Matrix4f::Identity().eval());
   canvas->shader->set_uniform("color_mode", 1);
@@ -166,7 +187,9 @@ void LightViewerContext::draw_gl() {
     canvas->shader->set_uniform("material_color", Eigen::Vector4f(0.6f, 0.6f, 0.6f, 1.0f));
     glk::Primitives::instance()->primitive(glk::Primitives::GRID).draw(*canvas->shader);
   }
+  profiler->pop();
 
+  profiler->push(context_name, "opaque");
   bool transparent_exists = false;
   for (const auto& drawable : active_drawables) {
     if (!drawable.first->transparent) {
@@ -177,9 +200,14 @@ void LightViewerContext::draw_gl() {
     }
   }
 
+  profiler->pop();
+
+  profiler->push(context_name, "effect");
   canvas->unbind();
+  profiler->pop();
 
   if (transparent_exists) {
+    profiler->push(context_name, "transparent");
     glEnable(GL_CULL_FACE);
     glCullFace(GL_BACK);
 
@@ -199,6 +227,49 @@ void LightViewerContext::draw_gl() {
     canvas->unbind_second();
 
     glDisable(GL_CULL_FACE);
+    profiler->pop();
+  }
+
+  glk::GpuMemoryTracker::instance()->poll_evicted_buffers();
+  if (gpu_memory_budget) {
+    evict_drawables();
+  }
+  frame_count++;
+}
+
+/**
+ * @brief Evict least recently drawn drawables until the GPU memory held by evictable drawables fits in the budget.
+ *        Memory that cannot be evicted (render targets, textures, lines, ...) is not counted.
+ *        Drawables drawn in the current frame are never evicted. Evicted drawables are re-uploaded when they are drawn again.
+ */
+void LightViewerContext::evict_drawables() {
+  // running total of the buffers of all evictable drawables (see glk::GpuMemoryTracker::set_evictable())
+  const auto tracker = glk::GpuMemoryTracker::instance();
+  if (tracker->total_evictable() <= gpu_memory_budget) {
+    return;
+  }
+
+  std::vector<std::pair<long, const glk::Drawable*>> candidates;
+  for (auto itr = drawable_last_drawn.begin(); itr != drawable_last_drawn.end();) {
+    auto found = drawables.find(itr->first);
+    if (found == drawables.end()) {
+      itr = drawable_last_drawn.erase(itr);
+      continue;
+    }
+
+    const auto& drawable = found->second.second;
+    if (itr->second != frame_count && drawable && drawable->evictable() && !drawable->evicted()) {
+      candidates.emplace_back(itr->second, drawable.get());
+    }
+    itr++;
+  }
+
+  std::sort(candidates.begin(), candidates.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+  for (const auto& candidate : candidates) {
+    if (tracker->total_evictable() <= gpu_memory_budget) {
+      break;
+    }
+    candidate.second->evict();
   }
 }
 
@@ -242,6 +313,22 @@ void LightViewerContext::enable_partial_rendering(double clear_thresh) {
   canvas->enable_partial_rendering(clear_thresh);
 }
 
+void LightViewerContext::set_render_scale(double scale) {
+  canvas->set_render_scale(scale);
+}
+
+double LightViewerContext::get_render_scale() const {
+  return canvas->get_render_scale();
+}
+
+void LightViewerContext::enable_adaptive_quality(double target_frame_time_msec) {
+  canvas->enable_adaptive_quality(target_frame_time_msec);
+}
+
+void LightViewerContext::disable_adaptive_quality() {
+  canvas->disable_adaptive_quality();
+}
+
 bool LightViewerContext::normal_buffer_enabled() const {
   return canvas->normal_buffer_enabled();
 }
@@ -254,6 +341,10 @@ bool LightViewerContext::partial_rendering_enabled() const {
   return canvas->partial_rendering_enabled();
 }
 
+bool LightViewerContext::adaptive_quality_enabled() const {
+  return canvas->adaptive_quality_enabled();
+}
+
 const glk::Texture& LightViewerContext::color_buffer() const {
   return canvas->color_buffer();
 }
@@ -276,11 +367,17 @@ const glk::Texture& LightViewerContext::dynamic_flag_buffer() const {
 
 void LightViewerContext::clear_drawables() {
   drawables.clear();
+  if (recorder) {
+    recorder->record_clear();
+  }
 }
 
 void LightViewerContext::clear_drawables(const std::function<bool(const std::string&)>& fn) {
   for (auto it = drawables.begin(); it != drawables.end();) {
     if (fn(it->first)) {
+      if (recorder) {
+        recorder->record_remove(it->first);
+      }
       it = drawables.erase(it);
     } else {
       it++;
@@ -300,12 +397,18 @@ void LightViewerContext::remove_drawable(const std::string& name) {
   auto found = drawables.find(name);
   if (found != drawables.end()) {
     drawables.erase(found);
+    if (recorder) {
+      recorder->record_remove(name);
+    }
   }
 }
 
 void LightViewerContext::remove_drawable(const std::regex& regex) {
   for (auto itr = drawables.begin(); itr != drawables.end();) {
     if (std::regex_match(itr->first, regex)) {
+      if (recorder) {
+        recorder->record_remove(itr->first);
+      }
       itr = drawables.erase(itr);
     } else {
       itr++;
@@ -315,6 +418,39 @@ void LightViewerContext::remove_drawable(const std::regex& regex) {
 
 void LightViewerContext::update_drawable(const std::string& name, const glk::Drawable::ConstPtr& drawable, const ShaderSetting& shader_setting) {
   drawables[name] = std::make_pair(std::make_shared<ShaderSetting>(shader_setting), drawable);
+  if (recorder) {
+    recorder->record_update(name, drawable, shader_setting);
+  }
+}
+
+std::unordered_map<std::string, size_t> LightViewerContext::drawable_memory_usage() const {
+  std::unordered_map<std::string, size_t> usages;
+  for (const auto& drawable : drawables) {
+    usages[drawable.first] = drawable.second.second ? drawable.second.second->memory_usage() : 0;
+  }
+  return usages;
+}
+
+void LightViewerContext::set_gpu_memory_budget(size_t budget_bytes) {
+  gpu_memory_budget = budget_bytes;
+}
+
+bool LightViewerContext::start_recording(const std::string& filename) {
+  recorder.reset(new CommandRecorder(filename));
+  if (!recorder->ok()) {
+    recorder.reset();
+    return false;
+  }
+
+  // the current scene is recorded as the initial state of the trace
+  for (const auto& drawable : drawables) {
+    recorder->record_update(drawable.first, drawable.second.second, *drawable.second.first);
+  }
+  return true;
+}
+
+void LightViewerContext::stop_recording() {
+  recorder.reset();
 }
 
 void LightViewerContext::clear_drawable_filters() {
@@ -0,0 +1,165 @@
+#include <guik/viewer/system_monitor.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <GL/gl3w.h>
+
+#ifndef GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX
+#define GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX 0x9047
+#define GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX 0x9048
+#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#endif
+
+#ifndef GL_TEXTURE_FREE_MEMORY_ATI
+#define GL_VBO_FREE_MEMORY_ATI 0x87FB
+#define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+#endif
+
+namespace guik {
+
+SystemMonitor::SystemMonitor(double interval_sec, int max_history)
+: interval_sec(interval_sec),
+  max_history(max_history),
+  start_time(std::chrono::steady_clock::now()),
+  gl_nvx_meminfo(false),
+  gl_ati_meminfo(false),
+  last_busy_jiffies(0),
+  last_total_jiffies(0) {
+  GLint num_extensions = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+  for (int i = 0; i < num_extensions; i++) {
+    const char* ext = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+    if (ext == nullptr) {
+      continue;
+    }
+
+    gl_nvx_meminfo |= std::strcmp(ext, "GL_NVX_gpu_memory_info") == 0;
+    gl_ati_meminfo |= std::strcmp(ext, "GL_ATI_meminfo") == 0;
+  }
+
+  read_cpu_jiffies(last_busy_jiffies, last_total_jiffies);
+}
+
+SystemMonitor::~SystemMonitor() {}
+
+bool SystemMonitor::update() {
+  if (!samples.empty()) {
+    const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    if (t - samples.back().time < interval_sec) {
+      return false;
+    }
+  }
+
+  sample();
+  return true;
+}
+
+const SystemMonitor::Sample& SystemMonitor::sample() {
+  Sample sample;
+  sample.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  sample.cpu_usage = -1.0;
+  sample.mem_total_kb = sample.mem_used_kb = sample.process_rss_kb = -1;
+  sample.gpu_total_kb = sample.gpu_free_kb = -1;
+
+  std::uint64_t busy, total;
+  if (read_cpu_jiffies(busy, total)) {
+    if (total > last_total_jiffies) {
+      sample.cpu_usage = 100.0 * (busy - last_busy_jiffies) / (total - last_total_jiffies);
+    }
+    last_busy_jiffies = busy;
+    last_total_jiffies = total;
+  }
+
+  read_meminfo(sample);
+  read_process_status(sample);
+  read_gpu_meminfo(sample);
+
+  samples.push_back(sample);
+  while (samples.size() > max_history) {
+    samples.pop_front();
+  }
+
+  return samples.back();
+}
+
+bool SystemMonitor::read_cpu_jiffies(std::uint64_t& busy, std::uint64_t& total) const {
+  std::ifstream ifs("/proc/stat");
+  std::string line;
+  if (!ifs || !std::getline(ifs, line) || line.compare(0, 4, "cpu ") != 0) {
+    return false;
+  }
+
+  // cpu user nice system idle iowait irq softirq steal
+  std::stringstream sst(line.substr(4));
+  std::uint64_t values[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  for (int i = 0; i < 8 && sst >> values[i]; i++) {
+  }
+
+  const std::uint64_t idle = values[3] + values[4];
+  total = 0;
+  for (const auto value : values) {
+    total += value;
+  }
+  busy = total - idle;
+
+  return true;
+}
+
+void SystemMonitor::read_meminfo(Sample& sample) const {
+  std::ifstream ifs("/proc/meminfo");
+
+  std::int64_t mem_available = -1;
+  std::string line;
+  while (std::getline(ifs, line)) {
+    // some lines (e.g., HugePages_Total) have no unit
+    std::stringstream sst(line);
+    std::string key;
+    std::int64_t value;
+    if (!(sst >> key >> value)) {
+      continue;
+    }
+
+    if (key == "MemTotal:") {
+      sample.mem_total_kb = value;
+    } else if (key == "MemAvailable:") {
+      mem_available = value;
+    }
+
+    if (sample.mem_total_kb >= 0 && mem_available >= 0) {
+      sample.mem_used_kb = sample.mem_total_kb - mem_available;
+      break;
+    }
+  }
+}
+
+void SystemMonitor::read_process_status(Sample& sample) const {
+  std::ifstream ifs("/proc/self/status");
+
+  std::string line;
+  while (std::getline(ifs, line)) {
+    if (line.compare(0, 6, "VmRSS:") == 0) {
+      std::stringstream sst(line.substr(6));
+      sst >> sample.process_rss_kb;
+      break;
+    }
+  }
+}
+
+void SystemMonitor::read_gpu_meminfo(Sample& sample) const {
+  if (gl_nvx_meminfo) {
+    GLint total_kb = 0;
+    GLint free_kb = 0;
+    glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &total_kb);
+    glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &free_kb);
+    sample.gpu_total_kb = total_kb;
+    sample.gpu_free_kb = free_kb;
+  } else if (gl_ati_meminfo) {
+    // [0] total free memory in the pool, [1] largest free block, [2] total auxiliary free memory, [3] largest auxiliary free block
+    GLint texture_free[4] = {0, 0, 0, 0};
+    glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, texture_free);
+    sample.gpu_free_kb = texture_free[0];
+  }
+}
+
+}  // namespace guik
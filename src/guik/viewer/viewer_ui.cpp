@@ -10,6 +10,7 @@
 #include <glk/effects/screen_scape_attribute_estimation.hpp>
 
 #include <guik/recent_files.hpp>
+#include <guik/adaptive_quality_controller.hpp>
 #include <guik/camera/basic_projection_control.hpp>
 #include <guik/camera/orbit_camera_control_xy.hpp>
 #include <guik/camera/orbit_camera_control_xz.hpp>
@@ -32,6 +33,8 @@ public:
     auto_range = false;
 
     effect_mode = 0;
+    ao_quality = 0;
+    target_frame_time = 16.6f;
   }
 
   ~DisplaySettingWindow() {}
@@ -112,6 +115,40 @@ public:
       } else if (effect_modes[effect_mode] == std::string("SSLI_SPLAT")) {
         viewer->set_screen_effect(std::make_shared<glk::ScreenSpaceLighting>(viewer->canvas_size(), true));
       }
+      ao_quality = 0;
+    }
+
+    if (effect_modes[effect_mode] == std::string("SSAO") || effect_modes[effect_mode] == std::string("SSLI")) {
+      std::vector<const char*> ao_qualities = {"FULL", "HALF", "HALF_TEMPORAL", "QUARTER_TEMPORAL"};
+      if (ImGui::Combo("AO quality", &ao_quality, ao_qualities.data(), ao_qualities.size())) {
+        const int downsample = ao_quality == 0 ? 1 : (ao_quality == 3 ? 4 : 2);
+        const bool temporal = ao_quality >= 2;
+
+        if (auto ssao = std::dynamic_pointer_cast<glk::ScreenSpaceAmbientOcclusion>(viewer->get_screen_effect())) {
+          ssao->set_occlusion_downsample(downsample);
+          ssao->set_temporal_occlusion(temporal);
+        } else if (auto ssli = std::dynamic_pointer_cast<glk::ScreenSpaceLighting>(viewer->get_screen_effect())) {
+          ssli->set_occlusion_downsample(downsample);
+          ssli->set_temporal_occlusion(temporal);
+        }
+      }
+    }
+
+    float render_scale = viewer->get_render_scale();
+    if (ImGui::SliderFloat("Render scale", &render_scale, 0.25f, 2.0f)) {
+      viewer->set_render_scale(render_scale);
+    }
+
+    bool adaptive_quality = viewer->adaptive_quality_enabled();
+    if (ImGui::Checkbox("Adaptive quality", &adaptive_quality)) {
+      adaptive_quality ? viewer->enable_adaptive_quality(target_frame_time) : viewer->disable_adaptive_quality();
+    }
+
+    if (auto controller = viewer->canvas->adaptive_quality()) {
+      if (ImGui::DragFloat("Target frame time [msec]", &target_frame_time, 0.1f, 1.0f, 100.0f)) {
+        viewer->enable_adaptive_quality(target_frame_time);
+      }
+      ImGui::Text("level:%d/%d  GPU:%.2f[msec]  scale:%.2f", controller->level(), controller->num_levels() - 1, controller->gpu_time(), controller->settings().render_scale);
     }
 
     if (effect_modes[effect_mode] == std::string("SSLI")) {
@@ -129,6 +166,11 @@ public:
           ssli->set_roughness(roughness);
         }
 
+        bool tiled_light_culling = ssli->tiled_light_culling_enabled();
+        if (ImGui::Checkbox("Tiled light culling", &tiled_light_culling)) {
+          ssli->set_tiled_light_culling(tiled_light_culling);
+        }
+
         for (int i = 0; i < ssli->num_lights(); i++) {
           const float max_color_magnitude = 3.0f;
           bool directional = ssli->is_light_directional(i);
@@ -188,6 +230,8 @@ private:
   bool auto_range;
 
   int effect_mode;
+  int ao_quality;
+  float target_frame_time;
 };
 
 /**
@@ -661,6 +705,16 @@ bool LightViewer::ViewerUI::draw_main_menu_bar() {
 
   if (ImGui::BeginMenu("Utility")) {
     point_picking_window->menu_item();
+
+    if (!viewer->recording() && ImGui::MenuItem("Start Recording Trace")) {
+      std::string filename = pfd::save_file("select the destination path", "/tmp/viewer.trace").result();
+      if (!filename.empty()) {
+        viewer->start_recording(filename);
+      }
+    }
+    if (viewer->recording() && ImGui::MenuItem("Stop Recording Trace")) {
+      viewer->stop_recording();
+    }
     ImGui::EndMenu();
   }
 
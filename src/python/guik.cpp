@@ -160,6 +160,8 @@ void define_guik(py::module_& m) {
     .def("set_screen_effect", &guik::LightViewerContext::set_screen_effect, "")
     .def("enable_normal_buffer", &guik::LightViewerContext::enable_normal_buffer, "")
     .def("enable_info_buffer", &guik::LightViewerContext::enable_info_buffer, "")
+    .def("set_render_scale", &guik::LightViewerContext::set_render_scale, "", py::arg("scale"))
+    .def("get_render_scale", &guik::LightViewerContext::get_render_scale, "")
     .def("use_orbit_camera_control", &guik::LightViewerContext::use_orbit_camera_control, "", py::arg("distance") = 80.0, py::arg("theta") = 0.0, py::arg("phi") = -60.0 * M_PI / 180.0)
     .def("use_orbit_camera_control_xz", &guik::LightViewerContext::use_orbit_camera_control_xz, "", py::arg("distance") = 80.0, py::arg("theta") = 0.0, py::arg("phi") = 0.0)
     .def("use_topdown_camera_control", &guik::LightViewerContext::use_topdown_camera_control, "", py::arg("distance") = 80.0, py::arg("theta") = 0.0)
@@ -204,6 +206,8 @@ void define_guik(py::module_& m) {
     .def("set_screen_effect", &guik::LightViewer::set_screen_effect, "")
     .def("enable_normal_buffer", &guik::LightViewer::enable_normal_buffer, "")
     .def("enable_info_buffer", &guik::LightViewer::enable_info_buffer, "")
+    .def("set_render_scale", &guik::LightViewer::set_render_scale, "", py::arg("scale"))
+    .def("get_render_scale", &guik::LightViewer::get_render_scale, "")
     .def("use_orbit_camera_control", &guik::LightViewer::use_orbit_camera_control, "", py::arg("distance") = 80.0, py::arg("theta") = 0.0, py::arg("phi") = -60.0 * M_PI / 180.0)
     .def("use_orbit_camera_control_xz", &guik::LightViewer::use_orbit_camera_control_xz, "", py::arg("distance") = 80.0, py::arg("theta") = 0.0, py::arg("phi") = 0.0)
     .def("use_topdown_camera_control", &guik::LightViewer::use_topdown_camera_control, "", py::arg("distance") = 80.0, py::arg("theta") = 0.0)
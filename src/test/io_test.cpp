@@ -0,0 +1,203 @@
+#include <cmath>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include <glk/io/ply_io.hpp>
+#include <glk/io/point_cache_io.hpp>
+
+#include "test.hpp"
+
+namespace {
+
+glk::PLYData create_ply(int num_vertices, int num_faces, std::mt19937& mt) {
+  std::uniform_real_distribution<float> udist(0.0f, 1.0f);
+  std::uniform_int_distribution<int> index_dist(0, num_vertices - 1);
+
+  glk::PLYData ply;
+  for (int i = 0; i < num_vertices; i++) {
+    ply.vertices.emplace_back(udist(mt) * 10.0f - 5.0f, udist(mt) * 10.0f - 5.0f, udist(mt) * 2.0f);
+    ply.normals.emplace_back(Eigen::Vector3f(udist(mt) - 0.5f, udist(mt) - 0.5f, 1.0f).normalized());
+    ply.colors.emplace_back(udist(mt), udist(mt), udist(mt), 1.0f);
+    ply.intensities.emplace_back(i);
+  }
+  for (int i = 0; i < num_faces * 3; i++) {
+    ply.indices.emplace_back(index_dist(mt));
+  }
+  return ply;
+}
+
+template <typename Points>
+bool approx(const Points& lhs, const Points& rhs, float tol) {
+  if (lhs.size() != rhs.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < lhs.size(); i++) {
+    if (!lhs[i].isApprox(rhs[i], tol) && (lhs[i] - rhs[i]).cwiseAbs().maxCoeff() > tol) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// the loader flips the face winding (v0, v1, v2) -> (v2, v1, v0)
+bool same_faces(const std::vector<int>& written, const std::vector<int>& loaded) {
+  if (written.size() != loaded.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < written.size(); i += 3) {
+    if (written[i] != loaded[i + 2] || written[i + 1] != loaded[i + 1] || written[i + 2] != loaded[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void test_ply(test::Checker& checker, const glk::PLYData& ply) {
+  glk::PLYLoadOptions load_options;
+  load_options.estimate_normals = false;
+
+  const std::string filename = "glk_io_test.ply";
+
+  // ascii (written with the default stream precision)
+  {
+    TEST_CHECK(checker, glk::save_ply_ascii(filename, ply));
+    const auto loaded = glk::load_ply(filename, load_options);
+    TEST_CHECK(checker, loaded != nullptr);
+    if (loaded) {
+      TEST_CHECK(checker, approx(loaded->vertices, ply.vertices, 1e-4f));
+      TEST_CHECK(checker, approx(loaded->normals, ply.normals, 1e-4f));
+      TEST_CHECK(checker, approx(loaded->colors, ply.colors, 1e-4f));
+      TEST_CHECK(checker, loaded->intensities == ply.intensities);
+      TEST_CHECK(checker, same_faces(ply.indices, loaded->indices));
+    }
+  }
+
+  // binary (exact except uchar colors)
+  for (int uchar_colors = 0; uchar_colors < 2; uchar_colors++) {
+    for (int compact_indices = 0; compact_indices < 2; compact_indices++) {
+      for (int use_mmap = 0; use_mmap < 2; use_mmap++) {
+        glk::PLYWriteOptions options;
+        options.uchar_colors = uchar_colors;
+        options.compact_indices = compact_indices;
+        options.use_mmap = use_mmap;
+
+        TEST_CHECK(checker, glk::save_ply_binary(filename, ply, options));
+        const auto loaded = glk::load_ply(filename, load_options);
+        TEST_CHECK(checker, loaded != nullptr);
+        if (!loaded) {
+          continue;
+        }
+
+        TEST_CHECK(checker, loaded->vertices == ply.vertices);
+        TEST_CHECK(checker, loaded->normals == ply.normals);
+        TEST_CHECK(checker, approx(loaded->colors, ply.colors, uchar_colors ? 0.5f / 255.0f + 1e-6f : 0.0f));
+        TEST_CHECK(checker, loaded->intensities == ply.intensities);
+        TEST_CHECK(checker, same_faces(ply.indices, loaded->indices));
+      }
+    }
+  }
+
+  std::remove(filename.c_str());
+}
+
+void test_point_cache(test::Checker& checker, const glk::PLYData& ply, double chunk_size) {
+  const std::string filename = "glk_io_test.glkc";
+
+  glk::PointCacheOptions options;
+  options.chunk_size = chunk_size;
+  TEST_CHECK(checker, glk::save_point_cache(filename, ply, options));
+
+  const auto cache = glk::PointCache::load(filename);
+  TEST_CHECK(checker, cache != nullptr);
+  if (!cache) {
+    return;
+  }
+
+  const size_t n = ply.vertices.size();
+  TEST_CHECK(checker, cache->size() == n);
+  TEST_CHECK(checker, cache->vertices() && cache->normals() && cache->colors() && cache->intensities());
+  if (cache->size() != n || !cache->vertices() || !cache->normals() || !cache->colors() || !cache->intensities()) {
+    return;
+  }
+
+  // intensities hold the original point indices: points may be reordered, but attributes must move together
+  std::vector<int> order(n);
+  bool attributes_match = true;
+  for (size_t i = 0; i < n; i++) {
+    const int original = static_cast<int>(cache->intensities()[i]);
+    order[i] = original;
+    if (original < 0 || original >= n) {
+      attributes_match = false;
+      continue;
+    }
+    attributes_match &= cache->vertices()[i] == ply.vertices[original];
+    attributes_match &= cache->normals()[i] == ply.normals[original];
+    attributes_match &= cache->colors()[i] == ply.colors[original];
+  }
+  TEST_CHECK(checker, attributes_match);
+
+  std::sort(order.begin(), order.end());
+  std::vector<int> identity(n);
+  std::iota(identity.begin(), identity.end(), 0);
+  TEST_CHECK(checker, order == identity);
+
+  // bounding box
+  Eigen::Vector3f min = Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+  Eigen::Vector3f max = Eigen::Vector3f::Constant(std::numeric_limits<float>::lowest());
+  for (const auto& pt : ply.vertices) {
+    min = min.cwiseMin(pt);
+    max = max.cwiseMax(pt);
+  }
+  TEST_CHECK(checker, cache->has_bbox() && cache->bbox_min() == min && cache->bbox_max() == max);
+
+  if (chunk_size <= 0.0) {
+    TEST_CHECK(checker, cache->num_chunks() == 0);
+  } else {
+    // chunks cover all points contiguously and their bounding boxes contain their points
+    TEST_CHECK(checker, cache->num_chunks() > 1);
+    size_t first = 0;
+    bool chunks_valid = true;
+    for (size_t i = 0; i < cache->num_chunks(); i++) {
+      const auto& chunk = cache->chunks()[i];
+      chunks_valid &= chunk.first == first && chunk.count > 0;
+      for (size_t j = chunk.first; j < chunk.first + chunk.count && j < n; j++) {
+        const auto& pt = cache->vertices()[j];
+        for (int k = 0; k < 3; k++) {
+          chunks_valid &= chunk.min[k] <= pt[k] && pt[k] <= chunk.max[k];
+        }
+      }
+      chunks_valid &= (Eigen::Map<const Eigen::Vector3f>(chunk.max) - Eigen::Map<const Eigen::Vector3f>(chunk.min)).maxCoeff() <= chunk_size;
+
+      size_t prev_count = chunk.count;
+      for (int level = 0; level < cache->num_lod_levels(); level++) {
+        const size_t count = cache->lod_count(i, level);
+        chunks_valid &= count > 0 && count <= prev_count;
+        prev_count = count;
+      }
+
+      first += chunk.count;
+    }
+    TEST_CHECK(checker, chunks_valid);
+    TEST_CHECK(checker, first == n);
+  }
+
+  std::remove(filename.c_str());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  test::Checker checker("io_test");
+
+  std::mt19937 mt(42);
+  const auto ply = create_ply(2048, 1024, mt);
+
+  test_ply(checker, ply);
+  test_point_cache(checker, ply, 0.0);
+  test_point_cache(checker, ply, 1.0);
+
+  return checker.result();
+}
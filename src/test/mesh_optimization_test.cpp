@@ -0,0 +1,148 @@
+#include <array>
+#include <cmath>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <glk/mesh_optimization.hpp>
+#include <glk/primitives/icosahedron.hpp>
+
+#include "test.hpp"
+
+namespace {
+
+// triangle with its smallest index first (preserves the winding)
+std::array<int, 3> canonical_triangle(int a, int b, int c) {
+  if (b < a && b < c) {
+    return {b, c, a};
+  }
+  if (c < a && c < b) {
+    return {c, a, b};
+  }
+  return {a, b, c};
+}
+
+std::vector<std::array<int, 3>> triangle_set(const std::vector<int>& indices) {
+  std::vector<std::array<int, 3>> triangles;
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    triangles.push_back(canonical_triangle(indices[i], indices[i + 1], indices[i + 2]));
+  }
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  test::Checker checker("mesh_optimization_test");
+
+  glk::Icosahedron icosahedron;
+  for (int i = 0; i < 3; i++) {
+    icosahedron.subdivide();
+  }
+  icosahedron.spherize();
+
+  const auto& vertices = icosahedron.vertices;
+  const auto& indices = icosahedron.indices;
+
+  // unshared copy of the mesh (each triangle has its own vertices)
+  std::vector<Eigen::Vector3f> flat_vertices;
+  std::vector<int> flat_indices;
+  for (int index : indices) {
+    flat_indices.push_back(flat_vertices.size());
+    flat_vertices.push_back(vertices[index]);
+  }
+
+  // deduplicate_vertices merges bitwise identical vertices and keeps distinct ones apart
+  {
+    std::vector<int> remap;
+    const std::vector<glk::VertexAttribute> attributes = {{flat_vertices.data(), sizeof(Eigen::Vector3f), sizeof(Eigen::Vector3f)}};
+    const int num_unique = glk::deduplicate_vertices(attributes, flat_vertices.size(), remap);
+
+    TEST_CHECK(checker, num_unique == vertices.size());
+    TEST_CHECK(checker, remap.size() == flat_vertices.size());
+
+    bool remap_valid = true;
+    std::vector<Eigen::Vector3f> unique_vertices(num_unique, Eigen::Vector3f::Constant(std::nanf("")));
+    for (size_t i = 0; i < remap.size(); i++) {
+      remap_valid &= remap[i] >= 0 && remap[i] < num_unique;
+      if (remap[i] < 0 || remap[i] >= num_unique) {
+        continue;
+      }
+      if (unique_vertices[remap[i]].array().isNaN().any()) {
+        unique_vertices[remap[i]] = flat_vertices[i];
+      }
+      remap_valid &= std::memcmp(unique_vertices[remap[i]].data(), flat_vertices[i].data(), sizeof(Eigen::Vector3f)) == 0;
+    }
+    for (size_t i = 0; i < flat_vertices.size(); i++) {
+      for (size_t j = i + 1; j < flat_vertices.size() && j < i + 64; j++) {
+        remap_valid &= (remap[i] == remap[j]) == (flat_vertices[i] == flat_vertices[j]);
+      }
+    }
+    TEST_CHECK(checker, remap_valid);
+  }
+
+  // optimize_vertex_cache only reorders triangles (and rotates their vertices) and does not make the cache worse
+  {
+    const auto optimized = glk::optimize_vertex_cache(indices, vertices.size());
+    TEST_CHECK(checker, optimized.size() == indices.size());
+    TEST_CHECK(checker, triangle_set(optimized) == triangle_set(indices));
+    TEST_CHECK(checker, glk::compute_acmr(optimized) <= glk::compute_acmr(indices));
+  }
+
+  // optimize_mesh keeps the triangles at the same positions
+  {
+    const auto mesh = glk::optimize_mesh(
+      flat_vertices.data(),
+      sizeof(Eigen::Vector3f),
+      nullptr,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      0,
+      flat_vertices.size(),
+      flat_indices.data(),
+      flat_indices.size());
+
+    TEST_CHECK(checker, mesh.num_vertices == vertices.size());
+    TEST_CHECK(checker, mesh.indices.size() == flat_indices.size());
+    TEST_CHECK(checker, mesh.vertices.size() == sizeof(Eigen::Vector3f) * mesh.num_vertices);
+    TEST_CHECK(checker, mesh.normals.empty() && mesh.colors.empty() && mesh.tex_coords.empty());
+    TEST_CHECK(checker, mesh.short_indices.size() == mesh.indices.size());
+
+    // vertex positions of each triangle, rotated to start with the smallest vertex
+    const auto triangle_positions = [](const char* data, const std::vector<int>& indices) {
+      std::vector<std::array<float, 9>> triangles;
+      for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        std::array<std::array<float, 3>, 3> v;
+        for (int j = 0; j < 3; j++) {
+          std::memcpy(v[j].data(), data + sizeof(Eigen::Vector3f) * indices[i + j], sizeof(Eigen::Vector3f));
+        }
+        const int first = std::min_element(v.begin(), v.end()) - v.begin();
+        std::array<float, 9> triangle;
+        for (int j = 0; j < 3; j++) {
+          std::copy(v[(first + j) % 3].begin(), v[(first + j) % 3].end(), triangle.begin() + j * 3);
+        }
+        triangles.push_back(triangle);
+      }
+      std::sort(triangles.begin(), triangles.end());
+      return triangles;
+    };
+
+    const auto expected = triangle_positions(reinterpret_cast<const char*>(flat_vertices.data()), flat_indices);
+    TEST_CHECK(checker, triangle_positions(mesh.vertices.data(), mesh.indices) == expected);
+
+    bool remap_valid = true;
+    for (size_t i = 0; i < flat_vertices.size(); i++) {
+      const int r = mesh.vertex_remap[i];
+      remap_valid &= r >= 0 && r < mesh.num_vertices;
+      remap_valid &= r < 0 || r >= mesh.num_vertices || std::memcmp(mesh.vertices.data() + sizeof(Eigen::Vector3f) * r, flat_vertices[i].data(), sizeof(Eigen::Vector3f)) == 0;
+    }
+    for (size_t i = 0; i < mesh.indices.size(); i++) {
+      remap_valid &= mesh.short_indices[i] == mesh.indices[i];
+    }
+    TEST_CHECK(checker, remap_valid);
+  }
+
+  return checker.result();
+}
@@ -0,0 +1,104 @@
+#include <cmath>
+#include <atomic>
+#include <vector>
+#include <Eigen/Geometry>
+#include <glk/mesh_simplification.hpp>
+#include <glk/primitives/icosahedron.hpp>
+
+#include "test.hpp"
+
+namespace {
+
+// indices refer to existing vertices and no triangle is collapsed
+bool valid_triangles(const std::vector<int>& indices, int num_vertices) {
+  if (indices.size() % 3) {
+    return false;
+  }
+
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    for (int j = 0; j < 3; j++) {
+      if (indices[i + j] < 0 || indices[i + j] >= num_vertices) {
+        return false;
+      }
+    }
+    if (indices[i] == indices[i + 1] || indices[i + 1] == indices[i + 2] || indices[i + 2] == indices[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// triangles of a sphere keep facing outwards
+bool outward_facing(const Eigen::Vector3f* vertices, const std::vector<int>& indices) {
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    const Eigen::Vector3f& v0 = vertices[indices[i]];
+    const Eigen::Vector3f& v1 = vertices[indices[i + 1]];
+    const Eigen::Vector3f& v2 = vertices[indices[i + 2]];
+    if ((v1 - v0).cross(v2 - v0).dot(v0 + v1 + v2) <= 0.0f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  test::Checker checker("mesh_simplification_test");
+
+  glk::Icosahedron icosahedron;
+  for (int i = 0; i < 5; i++) {
+    icosahedron.subdivide();
+  }
+  icosahedron.spherize();
+
+  const auto& vertices = icosahedron.vertices;
+  const auto& indices = icosahedron.indices;
+  const int num_vertices = vertices.size();
+
+  // simplify_mesh
+  {
+    float error = -1.0f;
+    const int target = indices.size() / 4 / 3 * 3;
+    const auto simplified = glk::simplify_mesh(vertices.data(), num_vertices, indices, target, &error);
+
+    TEST_CHECK(checker, valid_triangles(simplified, num_vertices));
+    TEST_CHECK(checker, simplified.size() < indices.size());
+    TEST_CHECK(checker, simplified.size() <= target * 1.1);
+    TEST_CHECK(checker, std::isfinite(error) && error >= 0.0f && error < 0.1f);
+    TEST_CHECK(checker, outward_facing(vertices.data(), simplified));
+  }
+
+  // generate_lods
+  {
+    glk::MeshLODOptions options;
+    const auto chain = glk::generate_lods(vertices.data(), num_vertices, indices, options);
+
+    TEST_CHECK(checker, !chain.levels.empty() && chain.levels.size() <= options.max_levels);
+    TEST_CHECK(checker, chain.center.norm() < 1e-3f && std::abs(chain.radius - 1.0f) < 1e-3f);
+
+    bool levels_valid = true;
+    size_t prev_size = indices.size();
+    float prev_error = 0.0f;
+    for (const auto& level : chain.levels) {
+      levels_valid &= valid_triangles(level.indices, num_vertices);
+      levels_valid &= outward_facing(vertices.data(), level.indices);
+      levels_valid &= level.indices.size() < prev_size && level.indices.size() / 3 >= options.min_triangles;
+      levels_valid &= std::isfinite(level.error) && level.error >= prev_error;
+      prev_size = level.indices.size();
+      prev_error = level.error;
+    }
+    TEST_CHECK(checker, levels_valid);
+  }
+
+  // cancellation stops the generation
+  {
+    std::atomic_bool cancel(true);
+    glk::MeshLODOptions options;
+    options.cancel = &cancel;
+    const auto chain = glk::generate_lods(vertices.data(), num_vertices, indices, options);
+    TEST_CHECK(checker, chain.levels.empty());
+  }
+
+  return checker.result();
+}
@@ -0,0 +1,142 @@
+#include <cmath>
+#include <random>
+#include <vector>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include <Eigen/Geometry>
+#include <glk/point_index.hpp>
+
+#include "test.hpp"
+
+namespace {
+
+std::vector<unsigned int> sorted(std::vector<unsigned int> indices) {
+  std::sort(indices.begin(), indices.end());
+  return indices;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  test::Checker checker("point_index_test");
+
+  std::mt19937 mt(42);
+  std::uniform_real_distribution<float> udist(-10.0f, 10.0f);
+
+  std::vector<Eigen::Vector3f> points(10000);
+  for (auto& pt : points) {
+    pt = Eigen::Vector3f(udist(mt), udist(mt), udist(mt) * 0.2f);
+  }
+
+  for (int num_threads : {1, 4}) {
+    const glk::PointIndex index(points, num_threads);
+    TEST_CHECK(checker, index.size() == points.size());
+
+    // knn
+    bool knn_valid = true;
+    for (int i = 0; i < 50; i++) {
+      const Eigen::Vector3f query(udist(mt), udist(mt), udist(mt) * 0.2f);
+      const int k = 1 + i % 20;
+
+      std::vector<float> sq_dists(points.size());
+      for (size_t j = 0; j < points.size(); j++) {
+        sq_dists[j] = (points[j] - query).squaredNorm();
+      }
+      std::vector<float> expected = sq_dists;
+      std::partial_sort(expected.begin(), expected.begin() + k, expected.end());
+
+      std::vector<unsigned int> k_indices;
+      std::vector<float> k_sq_dists;
+      knn_valid &= index.knn(query, k, k_indices, k_sq_dists) == k;
+      knn_valid &= k_indices.size() == k && k_sq_dists.size() == k;
+      for (int j = 0; j < k && j < k_indices.size(); j++) {
+        knn_valid &= k_sq_dists[j] == expected[j];
+        knn_valid &= sq_dists[k_indices[j]] == k_sq_dists[j];
+      }
+    }
+    TEST_CHECK(checker, knn_valid);
+
+    // axis-aligned box
+    bool aabb_valid = true;
+    for (int i = 0; i < 50; i++) {
+      const Eigen::Vector3f a(udist(mt), udist(mt), udist(mt) * 0.2f);
+      const Eigen::Vector3f b(udist(mt), udist(mt), udist(mt) * 0.2f);
+      const Eigen::Vector3f min = a.cwiseMin(b);
+      const Eigen::Vector3f max = a.cwiseMax(b);
+
+      std::vector<unsigned int> expected;
+      for (size_t j = 0; j < points.size(); j++) {
+        if ((points[j].array() >= min.array()).all() && (points[j].array() <= max.array()).all()) {
+          expected.push_back(j);
+        }
+      }
+      aabb_valid &= sorted(index.query_aabb(min, max)) == expected;
+    }
+    TEST_CHECK(checker, aabb_valid);
+
+    // oriented box
+    bool obb_valid = true;
+    for (int i = 0; i < 20; i++) {
+      Eigen::Affine3f model = Eigen::Affine3f::Identity();
+      model.translation() = Eigen::Vector3f(udist(mt), udist(mt), 0.0f);
+      model.linear() = Eigen::AngleAxisf(udist(mt), Eigen::Vector3f(udist(mt), udist(mt), udist(mt)).normalized()).toRotationMatrix();
+      model = model * Eigen::Scaling(Eigen::Vector3f(5.0f, 3.0f, 2.0f));
+
+      const Eigen::Matrix4f inv_model = model.matrix().inverse();
+      std::vector<unsigned int> expected;
+      for (size_t j = 0; j < points.size(); j++) {
+        const Eigen::Vector3f pt = (inv_model * points[j].homogeneous()).head<3>();
+        if ((pt.array().abs() <= 0.5f).all()) {
+          expected.push_back(j);
+        }
+      }
+      obb_valid &= sorted(index.query_obb(model.matrix())) == expected;
+    }
+    TEST_CHECK(checker, obb_valid);
+
+    // ray picking: the hit closest along the ray
+    bool pick_valid = true;
+    int num_hits = 0;
+    for (int i = 0; i < 50; i++) {
+      const Eigen::Vector3f origin(udist(mt), udist(mt), 20.0f);
+      const Eigen::Vector3f direction = (Eigen::Vector3f(udist(mt), udist(mt), 0.0f) - origin).normalized();
+      const float radius = 0.05f;
+      const float radius_per_distance = 0.002f;
+
+      int expected = -1;
+      float expected_t = std::numeric_limits<float>::max();
+      for (size_t j = 0; j < points.size(); j++) {
+        const Eigen::Vector3f d = points[j] - origin;
+        const float t = d.dot(direction);
+        const float r = radius + radius_per_distance * t;
+        if (t >= 0.0f && t < expected_t && (d - t * direction).squaredNorm() <= r * r) {
+          expected = j;
+          expected_t = t;
+        }
+      }
+
+      const int picked = index.pick(origin, direction, radius, radius_per_distance);
+      pick_valid &= (picked < 0) == (expected < 0);
+      if (picked >= 0 && expected >= 0) {
+        num_hits++;
+        pick_valid &= std::abs((points[picked] - origin).dot(direction) - expected_t) < 1e-5f;
+      }
+    }
+    TEST_CHECK(checker, pick_valid);
+    TEST_CHECK(checker, num_hits > 0);
+  }
+
+  // empty index
+  {
+    const glk::PointIndex index(std::vector<Eigen::Vector3f>(), 1);
+    std::vector<unsigned int> k_indices;
+    std::vector<float> k_sq_dists;
+    TEST_CHECK(checker, index.size() == 0);
+    TEST_CHECK(checker, index.knn(Eigen::Vector3f::Zero(), 5, k_indices, k_sq_dists) == 0);
+    TEST_CHECK(checker, index.query_aabb(Eigen::Vector3f::Constant(-1.0f), Eigen::Vector3f::Constant(1.0f)).empty());
+    TEST_CHECK(checker, index.pick(Eigen::Vector3f::Zero(), Eigen::Vector3f::UnitX(), 1.0f) == -1);
+  }
+
+  return checker.result();
+}
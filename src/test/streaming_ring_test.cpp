@@ -0,0 +1,115 @@
+#include <deque>
+#include <random>
+#include <vector>
+#include <glk/streaming_buffer_arena.hpp>
+
+#include "test.hpp"
+
+int main(int argc, char** argv) {
+  test::Checker checker("streaming_ring_test");
+
+  // aligned allocations in a frame
+  {
+    glk::StreamingRing ring(1024);
+    TEST_CHECK(checker, ring.allocate(100, 16) == 0);
+    TEST_CHECK(checker, ring.allocate(100, 16) == 112);
+    TEST_CHECK(checker, ring.used() == 212);
+    TEST_CHECK(checker, ring.frame_used() == 212);
+
+    TEST_CHECK(checker, ring.close_frame() == 212);
+    TEST_CHECK(checker, ring.frame_used() == 0);
+    ring.release(212);
+    TEST_CHECK(checker, ring.used() == 0);
+
+    // an empty ring restarts from the beginning
+    TEST_CHECK(checker, ring.allocate(64, 16) == 0);
+
+    TEST_CHECK(checker, ring.allocate(0, 16) == glk::StreamingRing::npos);
+    TEST_CHECK(checker, ring.allocate(2048, 16) == glk::StreamingRing::npos);
+  }
+
+  // wrap around
+  {
+    glk::StreamingRing ring(1024);
+    TEST_CHECK(checker, ring.allocate(600, 16) == 0);
+    const size_t frame_a = ring.close_frame();
+
+    TEST_CHECK(checker, ring.allocate(300, 16) == 608);
+    // does not fit at the end, and the beginning is still used by frame A
+    TEST_CHECK(checker, ring.allocate(200, 16) == glk::StreamingRing::npos);
+
+    ring.release(frame_a);
+    TEST_CHECK(checker, ring.allocate(200, 16) == 0);
+    // the unused tail [908, 1024) is counted until the frame is released
+    TEST_CHECK(checker, ring.used() == 308 + 116 + 200);
+  }
+
+  // random frames: live allocations never overlap and stay in the buffer
+  {
+    struct Allocation {
+      size_t offset;
+      size_t size;
+    };
+
+    const size_t capacity = 1 << 16;
+    const int frames_in_flight = 3;
+
+    glk::StreamingRing ring(capacity);
+    std::mt19937 mt(42);
+    std::uniform_int_distribution<size_t> size_dist(1, capacity / 16);
+    std::uniform_int_distribution<int> count_dist(0, 12);
+
+    std::deque<std::pair<size_t, std::vector<Allocation>>> frames;  // closed frames (bytes, allocations)
+    bool valid = true;
+    int num_allocations = 0;
+    int num_failures = 0;
+
+    for (int frame = 0; frame < 2000; frame++) {
+      std::vector<Allocation> allocations;
+      const int count = count_dist(mt);
+      for (int i = 0; i < count; i++) {
+        const size_t size = size_dist(mt);
+        const size_t alignment = size_t(1) << (mt() % 8);
+        const size_t offset = ring.allocate(size, alignment);
+        if (offset == glk::StreamingRing::npos) {
+          num_failures++;
+          continue;
+        }
+        num_allocations++;
+
+        valid &= offset % alignment == 0;
+        valid &= offset + size <= capacity;
+        valid &= ring.used() <= capacity;
+
+        const auto overlaps = [&](const Allocation& a) { return offset < a.offset + a.size && a.offset < offset + size; };
+        for (const auto& a : allocations) {
+          valid &= !overlaps(a);
+        }
+        for (const auto& f : frames) {
+          for (const auto& a : f.second) {
+            valid &= !overlaps(a);
+          }
+        }
+
+        allocations.push_back(Allocation{offset, size});
+      }
+
+      frames.emplace_back(ring.close_frame(), std::move(allocations));
+      while (frames.size() > frames_in_flight) {
+        ring.release(frames.front().first);
+        frames.pop_front();
+      }
+    }
+
+    while (!frames.empty()) {
+      ring.release(frames.front().first);
+      frames.pop_front();
+    }
+
+    TEST_CHECK(checker, valid);
+    TEST_CHECK(checker, num_allocations > 0 && num_failures > 0);  // both paths are exercised
+    TEST_CHECK(checker, ring.used() == 0);
+  }
+
+  return checker.result();
+}
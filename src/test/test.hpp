@@ -0,0 +1,40 @@
+#ifndef GLK_TEST_HPP
+#define GLK_TEST_HPP
+
+#include <iostream>
+#include <glk/console_colors.hpp>
+
+namespace test {
+
+/**
+ * @brief Minimal check helper for the behaviour tests in src/test (pure CPU, no GL context is created).
+ *        Each test is an executable that returns a non-zero code when any check fails.
+ */
+class Checker {
+public:
+  Checker(const char* name) : name(name), num_checks(0), num_failures(0) {}
+
+  void check(bool condition, const char* expr, const char* file, int line) {
+    num_checks++;
+    if (!condition) {
+      num_failures++;
+      std::cerr << glk::console::bold_red << "error: " << file << ":" << line << ": check failed: " << expr << glk::console::reset << std::endl;
+    }
+  }
+
+  int result() const {
+    std::cout << name << ": " << (num_checks - num_failures) << " / " << num_checks << " checks passed" << std::endl;
+    return num_failures ? 1 : 0;
+  }
+
+private:
+  const char* name;
+  int num_checks;
+  int num_failures;
+};
+
+}  // namespace test
+
+#define TEST_CHECK(checker, expr) (checker).check(static_cast<bool>(expr), #expr, __FILE__, __LINE__)
+
+#endif
@@ -0,0 +1,89 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <glk/voxelmap_buffer.hpp>
+
+#include "test.hpp"
+
+int main(int argc, char** argv) {
+  test::Checker checker("voxelmap_test");
+
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const float inf = std::numeric_limits<float>::infinity();
+
+  // the first two points share a voxel, and the last three points are skipped
+  const std::vector<Eigen::Vector3f> points = {
+    Eigen::Vector3f(0.1f, 0.2f, 0.3f),
+    Eigen::Vector3f(0.7f, 0.8f, 0.9f),
+    Eigen::Vector3f(1.5f, 0.5f, 0.5f),
+    Eigen::Vector3f(-0.5f, 0.5f, 0.5f),
+    Eigen::Vector3f(nan, 0.0f, 0.0f),
+    Eigen::Vector3f(0.0f, inf, 0.0f),
+    Eigen::Vector3f(0.0f, 0.0f, 1e30f)};
+
+  const auto representatives = {
+    glk::VoxelMapBuffer::Representative::FIRST,
+    glk::VoxelMapBuffer::Representative::CENTROID,
+    glk::VoxelMapBuffer::Representative::LATEST};
+
+  for (const auto representative : representatives) {
+    glk::VoxelMapBuffer voxelmap(1.0, representative);
+    voxelmap.insert(points);
+
+    TEST_CHECK(checker, voxelmap.size() == 3);
+    if (voxelmap.size() != 3) {
+      continue;
+    }
+
+    // voxels are stored in the order of their first insertion
+    const auto& voxel_points = voxelmap.points();
+    TEST_CHECK(checker, voxel_points[1] == points[2]);
+    TEST_CHECK(checker, voxel_points[2] == points[3]);
+
+    switch (representative) {
+      case glk::VoxelMapBuffer::Representative::FIRST:
+        TEST_CHECK(checker, voxel_points[0] == points[0]);
+        break;
+      case glk::VoxelMapBuffer::Representative::CENTROID:
+        TEST_CHECK(checker, voxel_points[0].isApprox(Eigen::Vector3f(0.4f, 0.5f, 0.6f), 1e-6f));
+        break;
+      case glk::VoxelMapBuffer::Representative::LATEST:
+        TEST_CHECK(checker, voxel_points[0] == points[1]);
+        break;
+    }
+
+    // a second batch updates the existing voxel (except for FIRST)
+    const std::vector<Eigen::Vector3f> batch = {Eigen::Vector3f(0.4f, 0.5f, 0.6f), Eigen::Vector3f(0.5f, 0.5f, -0.5f)};
+    voxelmap.insert(batch, std::vector<float>{1.0f, 2.0f});
+    TEST_CHECK(checker, voxelmap.size() == 4);
+    TEST_CHECK(checker, voxelmap.points().back() == batch[1]);
+
+    switch (representative) {
+      case glk::VoxelMapBuffer::Representative::FIRST:
+        TEST_CHECK(checker, voxelmap.points()[0] == points[0]);
+        break;
+      case glk::VoxelMapBuffer::Representative::CENTROID:
+        TEST_CHECK(checker, voxelmap.points()[0].isApprox(Eigen::Vector3f(0.4f, 0.5f, 0.6f), 1e-6f));
+        break;
+      case glk::VoxelMapBuffer::Representative::LATEST:
+        TEST_CHECK(checker, voxelmap.points()[0] == batch[0]);
+        break;
+    }
+
+    voxelmap.clear();
+    TEST_CHECK(checker, voxelmap.size() == 0 && voxelmap.points().empty());
+
+    voxelmap.insert(points);
+    TEST_CHECK(checker, voxelmap.size() == 3);
+  }
+
+  // resolution
+  {
+    glk::VoxelMapBuffer voxelmap(0.1);
+    voxelmap.insert(points);
+    TEST_CHECK(checker, voxelmap.resolution() == 0.1);
+    TEST_CHECK(checker, voxelmap.size() == 4);
+  }
+
+  return checker.result();
+}